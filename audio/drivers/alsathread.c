@@ -21,7 +21,7 @@
 #include <alsa/asoundlib.h>
 
 #include <rthreads/rthreads.h>
-#include <queues/fifo_queue.h>
+#include <queues/spsc_queue.h>
 #include <string/stdstring.h>
 
 #include "../../retroarch.h"
@@ -42,9 +42,8 @@ typedef struct alsa_thread
    size_t period_size;
    snd_pcm_uframes_t period_frames;
 
-   fifo_buffer_t *buffer;
+   spsc_buffer_t *buffer;
    sthread_t *worker_thread;
-   slock_t *fifo_lock;
    scond_t *cond;
    slock_t *cond_lock;
 } alsa_thread_t;
@@ -65,12 +64,13 @@ static void alsa_worker_thread(void *data)
       size_t avail;
       size_t fifo_size;
       snd_pcm_sframes_t frames;
-      slock_lock(alsa->fifo_lock);
-      avail = fifo_read_avail(alsa->buffer);
+      avail     = spsc_read_avail(alsa->buffer);
       fifo_size = MIN(alsa->period_size, avail);
-      fifo_read(alsa->buffer, buf, fifo_size);
+      spsc_read(alsa->buffer, buf, fifo_size);
+
+      slock_lock(alsa->cond_lock);
       scond_signal(alsa->cond);
-      slock_unlock(alsa->fifo_lock);
+      slock_unlock(alsa->cond_lock);
 
       /* If underrun, fill rest with silence. */
       memset(buf + fifo_size, 0, alsa->period_size - fifo_size);
@@ -137,11 +137,9 @@ static void alsa_thread_free(void *data)
          sthread_join(alsa->worker_thread);
       }
       if (alsa->buffer)
-         fifo_free(alsa->buffer);
+         spsc_free(alsa->buffer);
       if (alsa->cond)
          scond_free(alsa->cond);
-      if (alsa->fifo_lock)
-         slock_free(alsa->fifo_lock);
       if (alsa->cond_lock)
          slock_free(alsa->cond_lock);
       if (alsa->pcm)
@@ -214,11 +212,10 @@ static void *alsa_thread_init(const char *device,
    snd_pcm_hw_params_free(params);
    snd_pcm_sw_params_free(sw_params);
 
-   alsa->fifo_lock = slock_new();
    alsa->cond_lock = slock_new();
    alsa->cond = scond_new();
-   alsa->buffer = fifo_new(alsa->buffer_size);
-   if (!alsa->fifo_lock || !alsa->cond_lock || !alsa->cond || !alsa->buffer)
+   alsa->buffer = spsc_new(alsa->buffer_size);
+   if (!alsa->cond_lock || !alsa->cond || !alsa->buffer)
       goto error;
 
    alsa->worker_thread = sthread_create(alsa_worker_thread, alsa);
@@ -252,15 +249,10 @@ static ssize_t alsa_thread_write(void *data, const void *buf, size_t size)
 
    if (alsa->nonblock)
    {
-      size_t avail;
-      size_t write_amt;
-
-      slock_lock(alsa->fifo_lock);
-      avail           = fifo_write_avail(alsa->buffer);
-      write_amt       = MIN(avail, size);
+      size_t avail     = spsc_write_avail(alsa->buffer);
+      size_t write_amt = MIN(avail, size);
 
-      fifo_write(alsa->buffer, buf, write_amt);
-      slock_unlock(alsa->fifo_lock);
+      spsc_write(alsa->buffer, buf, write_amt);
 
       return write_amt;
    }
@@ -269,24 +261,22 @@ static ssize_t alsa_thread_write(void *data, const void *buf, size_t size)
       size_t written = 0;
       while (written < size && !alsa->thread_dead)
       {
-         size_t avail;
-         slock_lock(alsa->fifo_lock);
-         avail = fifo_write_avail(alsa->buffer);
+         size_t avail = spsc_write_avail(alsa->buffer);
 
          if (avail == 0)
          {
-            slock_unlock(alsa->fifo_lock);
             slock_lock(alsa->cond_lock);
-            if (!alsa->thread_dead)
+            /* Check again, the worker only signals while
+             * holding cond_lock. */
+            if (!alsa->thread_dead && spsc_write_avail(alsa->buffer) == 0)
                scond_wait(alsa->cond, alsa->cond_lock);
             slock_unlock(alsa->cond_lock);
          }
          else
          {
             size_t write_amt = MIN(size - written, avail);
-            fifo_write(alsa->buffer,
+            spsc_write(alsa->buffer,
                   (const char*)buf + written, write_amt);
-            slock_unlock(alsa->fifo_lock);
             written += write_amt;
          }
       }
@@ -294,6 +284,38 @@ static ssize_t alsa_thread_write(void *data, const void *buf, size_t size)
    }
 }
 
+static ssize_t alsa_thread_write_begin(void *data, void **buf, size_t size)
+{
+   spsc_region_t regions[2];
+   alsa_thread_t *alsa = (alsa_thread_t*)data;
+
+   if (!alsa->nonblock)
+   {
+      while (!alsa->thread_dead && spsc_write_avail(alsa->buffer) == 0)
+      {
+         slock_lock(alsa->cond_lock);
+         if (!alsa->thread_dead && spsc_write_avail(alsa->buffer) == 0)
+            scond_wait(alsa->cond, alsa->cond_lock);
+         slock_unlock(alsa->cond_lock);
+      }
+   }
+
+   if (alsa->thread_dead)
+      return -1;
+
+   /* Only the part up to the end of the ring, the frontend
+    * asks again for the rest. */
+   spsc_write_regions(alsa->buffer, size, regions);
+   *buf = regions[0].data;
+   return regions[0].size;
+}
+
+static void alsa_thread_write_end(void *data, size_t size)
+{
+   alsa_thread_t *alsa = (alsa_thread_t*)data;
+   spsc_write_commit(alsa->buffer, size);
+}
+
 static bool alsa_thread_alive(void *data)
 {
    alsa_thread_t *alsa = (alsa_thread_t*)data;
@@ -329,14 +351,10 @@ static bool alsa_thread_start(void *data, bool is_shutdown)
 static size_t alsa_thread_write_avail(void *data)
 {
    alsa_thread_t *alsa = (alsa_thread_t*)data;
-   size_t val;
 
    if (alsa->thread_dead)
       return 0;
-   slock_lock(alsa->fifo_lock);
-   val = fifo_write_avail(alsa->buffer);
-   slock_unlock(alsa->fifo_lock);
-   return val;
+   return spsc_write_avail(alsa->buffer);
 }
 
 static size_t alsa_thread_buffer_size(void *data)
@@ -417,4 +435,6 @@ audio_driver_t audio_alsathread = {
    alsa_thread_device_list_free,
    alsa_thread_write_avail,
    alsa_thread_buffer_size,
+   alsa_thread_write_begin,
+   alsa_thread_write_end,
 };
@@ -20,10 +20,10 @@
 
 #include <jack/jack.h>
 #include <jack/types.h>
-#include <jack/ringbuffer.h>
 
 #include <boolean.h>
 #include <rthreads/rthreads.h>
+#include <queues/spsc_queue.h>
 
 #include "../../retroarch.h"
 #include "../../configuration.h"
@@ -35,7 +35,7 @@ typedef struct jack
 {
    jack_client_t *client;
    jack_port_t *ports[2];
-   jack_ringbuffer_t *buffer[2];
+   spsc_buffer_t *buffer[2];
    volatile bool shutdown;
    bool nonblock;
    bool is_paused;
@@ -61,8 +61,8 @@ static int process_cb(jack_nframes_t nframes, void *data)
       return 0;
    }
 
-   avail[0]  = jack_ringbuffer_read_space(jd->buffer[0]);
-   avail[1]  = jack_ringbuffer_read_space(jd->buffer[1]);
+   avail[0]  = spsc_read_avail(jd->buffer[0]);
+   avail[1]  = spsc_read_avail(jd->buffer[1]);
    min_avail = ((avail[0] < avail[1]) ? avail[0] : avail[1]) / sizeof(jack_default_audio_sample_t);
 
    if (min_avail > nframes)
@@ -73,7 +73,7 @@ static int process_cb(jack_nframes_t nframes, void *data)
       jack_nframes_t f;
       jack_default_audio_sample_t *out = (jack_default_audio_sample_t*)jack_port_get_buffer(jd->ports[i], nframes);
 
-      jack_ringbuffer_read(jd->buffer[i], (char*)out, min_avail * sizeof(jack_default_audio_sample_t));
+      spsc_read(jd->buffer[i], out, min_avail * sizeof(jack_default_audio_sample_t));
 
       for (f = min_avail; f < nframes; f++)
          out[f] = 0.0f;
@@ -195,7 +195,7 @@ static void *ja_init(const char *device, unsigned rate, unsigned latency,
    RARCH_LOG("[JACK]: Internal buffer size: %d frames.\n", (int)(bufsize / sizeof(jack_default_audio_sample_t)));
    for (i = 0; i < 2; i++)
    {
-      jd->buffer[i] = jack_ringbuffer_create(bufsize);
+      jd->buffer[i] = spsc_new(bufsize);
       if (jd->buffer[i] == NULL)
       {
          RARCH_ERR("[JACK]: Failed to create buffers.\n");
@@ -235,20 +235,36 @@ error:
    return NULL;
 }
 
-static size_t write_buffer(jack_t *jd, const float *buf, size_t size)
+/* Deinterleaves straight into the ring buffers. Every write is
+ * a whole number of samples, so the regions stay sample aligned. */
+static void deinterleave(spsc_buffer_t *buffer, const float *in,
+      size_t frames)
 {
    int i;
-   size_t j, written = 0;
-   jack_default_audio_sample_t out_deinterleaved_buffer[2][AUDIO_CHUNK_SIZE_NONBLOCKING * AUDIO_MAX_RATIO];
-   size_t frames = FRAMES(size);
+   spsc_region_t regions[2];
+   size_t size = frames * sizeof(jack_default_audio_sample_t);
 
-   /* Avoid buffer overflow if a DSP plugin generated a huge number of frames. */
-   if (frames > AUDIO_CHUNK_SIZE_NONBLOCKING * AUDIO_MAX_RATIO)
-      frames = AUDIO_CHUNK_SIZE_NONBLOCKING * AUDIO_MAX_RATIO;
+   spsc_write_regions(buffer, size, regions);
 
    for (i = 0; i < 2; i++)
-      for (j = 0; j < frames; j++)
-         out_deinterleaved_buffer[i][j] = buf[j * 2 + i];
+   {
+      size_t j;
+      jack_default_audio_sample_t *out =
+         (jack_default_audio_sample_t*)regions[i].data;
+      size_t count = regions[i].size / sizeof(jack_default_audio_sample_t);
+
+      for (j = 0; j < count; j++, in += 2)
+         out[j] = *in;
+   }
+
+   spsc_write_commit(buffer, size);
+}
+
+static size_t write_buffer(jack_t *jd, const float *buf, size_t size)
+{
+   int i;
+   size_t written = 0;
+   size_t frames  = FRAMES(size);
 
    while (written < frames)
    {
@@ -256,8 +272,8 @@ static size_t write_buffer(jack_t *jd, const float *buf, size_t size)
       if (jd->shutdown)
          return 0;
 
-      avail[0] = jack_ringbuffer_write_space(jd->buffer[0]);
-      avail[1] = jack_ringbuffer_write_space(jd->buffer[1]);
+      avail[0] = spsc_write_avail(jd->buffer[0]);
+      avail[1] = spsc_write_avail(jd->buffer[1]);
 
       min_avail = avail[0] < avail[1] ? avail[0] : avail[1];
       min_avail /= sizeof(float);
@@ -267,10 +283,8 @@ static size_t write_buffer(jack_t *jd, const float *buf, size_t size)
       if (write_frames > 0)
       {
          for (i = 0; i < 2; i++)
-         {
-            jack_ringbuffer_write(jd->buffer[i], (const char*)&out_deinterleaved_buffer[i][written],
-                  write_frames * sizeof(jack_default_audio_sample_t));
-         }
+            deinterleave(jd->buffer[i], buf + written * 2 + i,
+                  write_frames);
          written += write_frames;
       }
 #ifdef HAVE_THREADS
@@ -341,8 +355,7 @@ static void ja_free(void *data)
    }
 
    for (i = 0; i < 2; i++)
-      if (jd->buffer[i] != NULL)
-         jack_ringbuffer_free(jd->buffer[i]);
+      spsc_free(jd->buffer[i]);
 
 #ifdef HAVE_THREADS
    if (jd->cond_lock)
@@ -362,7 +375,7 @@ static bool ja_use_float(void *data)
 static size_t ja_write_avail(void *data)
 {
    jack_t *jd = (jack_t*)data;
-   return jack_ringbuffer_write_space(jd->buffer[0]);
+   return spsc_write_avail(jd->buffer[0]);
 }
 
 static size_t ja_buffer_size(void *data)
@@ -21,7 +21,7 @@
 
 #include <boolean.h>
 #include <rthreads/rthreads.h>
-#include <queues/fifo_queue.h>
+#include <queues/spsc_queue.h>
 #include <retro_inline.h>
 #include <retro_math.h>
 
@@ -40,18 +40,20 @@ typedef struct sdl_audio
    slock_t *lock;
    scond_t *cond;
 #endif
-   fifo_buffer_t *buffer;
+   spsc_buffer_t *buffer;
 } sdl_audio_t;
 
 static void sdl_audio_cb(void *data, Uint8 *stream, int len)
 {
    sdl_audio_t  *sdl = (sdl_audio_t*)data;
-   size_t      avail = fifo_read_avail(sdl->buffer);
+   size_t      avail = spsc_read_avail(sdl->buffer);
    size_t write_size = len > (int)avail ? avail : len;
 
-   fifo_read(sdl->buffer, stream, write_size);
+   spsc_read(sdl->buffer, stream, write_size);
 #ifdef HAVE_THREADS
+   slock_lock(sdl->lock);
    scond_signal(sdl->cond);
+   slock_unlock(sdl->lock);
 #endif
 
    /* If underrun, fill rest with silence. */
@@ -125,11 +127,11 @@ static void *sdl_audio_init(const char *device,
    /* Create a buffer twice as big as needed and prefill the buffer. */
    bufsize     = out.samples * 4 * sizeof(int16_t);
    tmp         = calloc(1, bufsize);
-   sdl->buffer = fifo_new(bufsize);
+   sdl->buffer = spsc_new(bufsize);
 
    if (tmp)
    {
-      fifo_write(sdl->buffer, tmp, bufsize);
+      spsc_write(sdl->buffer, tmp, bufsize);
       free(tmp);
    }
 
@@ -148,13 +150,10 @@ static ssize_t sdl_audio_write(void *data, const void *buf, size_t size)
 
    if (sdl->nonblock)
    {
-      size_t avail, write_amt;
+      size_t avail     = spsc_write_avail(sdl->buffer);
+      size_t write_amt = avail > size ? size : avail;
 
-      SDL_LockAudio();
-      avail = fifo_write_avail(sdl->buffer);
-      write_amt = avail > size ? size : avail;
-      fifo_write(sdl->buffer, buf, write_amt);
-      SDL_UnlockAudio();
+      spsc_write(sdl->buffer, buf, write_amt);
       ret = write_amt;
    }
    else
@@ -163,25 +162,23 @@ static ssize_t sdl_audio_write(void *data, const void *buf, size_t size)
 
       while (written < size)
       {
-         size_t avail;
-
-         SDL_LockAudio();
-         avail = fifo_write_avail(sdl->buffer);
+         size_t avail = spsc_write_avail(sdl->buffer);
 
          if (avail == 0)
          {
-            SDL_UnlockAudio();
 #ifdef HAVE_THREADS
             slock_lock(sdl->lock);
-            scond_wait(sdl->cond, sdl->lock);
+            /* Check again, the callback only signals while
+             * holding the lock. */
+            if (spsc_write_avail(sdl->buffer) == 0)
+               scond_wait(sdl->cond, sdl->lock);
             slock_unlock(sdl->lock);
 #endif
          }
          else
          {
             size_t write_amt = size - written > avail ? avail : size - written;
-            fifo_write(sdl->buffer, (const char*)buf + written, write_amt);
-            SDL_UnlockAudio();
+            spsc_write(sdl->buffer, (const char*)buf + written, write_amt);
             written += write_amt;
          }
       }
@@ -191,6 +188,37 @@ static ssize_t sdl_audio_write(void *data, const void *buf, size_t size)
    return ret;
 }
 
+static ssize_t sdl_audio_write_begin(void *data, void **buf, size_t size)
+{
+   spsc_region_t regions[2];
+   sdl_audio_t *sdl = (sdl_audio_t*)data;
+
+   if (!sdl->nonblock)
+   {
+      while (spsc_write_avail(sdl->buffer) == 0)
+      {
+#ifdef HAVE_THREADS
+         slock_lock(sdl->lock);
+         if (spsc_write_avail(sdl->buffer) == 0)
+            scond_wait(sdl->cond, sdl->lock);
+         slock_unlock(sdl->lock);
+#endif
+      }
+   }
+
+   /* Only the part up to the end of the ring, the frontend
+    * asks again for the rest. */
+   spsc_write_regions(sdl->buffer, size, regions);
+   *buf = regions[0].data;
+   return regions[0].size;
+}
+
+static void sdl_audio_write_end(void *data, size_t size)
+{
+   sdl_audio_t *sdl = (sdl_audio_t*)data;
+   spsc_write_commit(sdl->buffer, size);
+}
+
 static bool sdl_audio_stop(void *data)
 {
    sdl_audio_t *sdl = (sdl_audio_t*)data;
@@ -232,7 +260,7 @@ static void sdl_audio_free(void *data)
 
    if (sdl)
    {
-      fifo_free(sdl->buffer);
+      spsc_free(sdl->buffer);
 #ifdef HAVE_THREADS
       slock_free(sdl->lock);
       scond_free(sdl->cond);
@@ -271,5 +299,7 @@ audio_driver_t audio_sdl = {
    NULL,
    NULL,
    sdl_audio_write_avail,
-   NULL
+   NULL,
+   sdl_audio_write_begin,
+   sdl_audio_write_end
 };
@@ -854,6 +854,10 @@ static const bool playlist_sort_alphabetical = true;
 /* File format to use when writing playlists to disk */
 static const bool playlist_use_old_format = false;
 
+/* Append playlist changes to a journal next to the
+ * playlist file instead of rewriting the whole file */
+static const bool playlist_use_journal = false;
+
 #ifdef HAVE_MENU
 /* Specify when to display 'core name' inline on playlist entries */
 static const unsigned playlist_show_inline_core_name = PLAYLIST_INLINE_CORE_DISPLAY_HIST_FAV;
@@ -866,6 +870,10 @@ static const unsigned playlist_entry_remove_enable = PLAYLIST_ENTRY_REMOVE_ENABL
 
 static const bool scan_without_core_match      = false;
 
+/* Number of threads hashing files during a content scan.
+ * 0 picks one per CPU core. */
+#define DEFAULT_SCAN_WORKER_THREADS 0
+
 #ifdef __WINRT__
 /* Be paranoid about WinRT file I/O performance, and leave this disabled by
  * default */
@@ -981,7 +989,7 @@ static enum resampler_quality audio_resampler_quality_level = RESAMPLER_QUALITY_
 #elif defined(PSP) || defined(_3DS) || defined(VITA) || defined(PS2)
 static enum resampler_quality audio_resampler_quality_level = RESAMPLER_QUALITY_LOWEST;
 #else
-static enum resampler_quality audio_resampler_quality_level = RESAMPLER_QUALITY_NORMAL;
+static enum resampler_quality audio_resampler_quality_level = RESAMPLER_QUALITY_HIGHEST;
 #endif
 
 /* MIDI */
@@ -356,6 +356,7 @@ typedef struct settings
 
       bool sustained_performance_mode;
       bool playlist_use_old_format;
+      bool playlist_use_journal;
       bool content_runtime_log;
       bool content_runtime_log_aggregate;
 
@@ -466,6 +467,7 @@ typedef struct settings
       unsigned bundle_assets_extract_version_current;
       unsigned bundle_assets_extract_last_version;
       unsigned content_history_size;
+      unsigned scan_worker_threads;
       unsigned frontend_log_level;
       unsigned libretro_log_level;
       unsigned rewind_granularity;
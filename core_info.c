@@ -15,13 +15,27 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
+
 #include <compat/strl.h>
 #include <string/stdstring.h>
+#include <encodings/crc32.h>
+#include <encodings/utf.h>
 #include <file/config_file.h>
 #include <file/file_path.h>
 #include <lists/dir_list.h>
 #include <file/archive_file.h>
 #include <streams/file_stream.h>
+#include <retro_miscellaneous.h>
+
+/* The cache needs the modification time of the .info files,
+ * which the VFS layer does not report. Without it, every
+ * .info file gets parsed every time. */
+#if (defined(_WIN32) && !defined(_XBOX) && !defined(__WINRT__)) || defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+#define HAVE_CORE_INFO_CACHE
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -94,131 +108,124 @@ static void core_info_list_resolve_all_extensions(
 #endif
 }
 
-static void core_info_list_resolve_all_firmware(
-      core_info_list_t *core_info_list)
+static void core_info_resolve_firmware(core_info_t *info,
+      config_file_t *config)
 {
-   size_t i;
    unsigned c;
+   unsigned count                  = 0;
+   core_info_firmware_t *firmware  = NULL;
 
-   for (i = 0; i < core_info_list->count; i++)
-   {
-      unsigned count                  = 0;
-      core_info_firmware_t *firmware  = NULL;
-      core_info_t *info               = (core_info_t*)&core_info_list->list[i];
-      config_file_t *config           = (config_file_t*)info->config_data;
-
-      if (!config || !config_get_uint(config, "firmware_count", &count))
-         continue;
+   if (!config_get_uint(config, "firmware_count", &count))
+      return;
 
-      firmware = (core_info_firmware_t*)calloc(count, sizeof(*firmware));
+   firmware = (core_info_firmware_t*)calloc(count, sizeof(*firmware));
 
-      if (!firmware)
-         continue;
+   if (!firmware)
+      return;
 
-      info->firmware = firmware;
+   info->firmware = firmware;
 
-      for (c = 0; c < count; c++)
+   for (c = 0; c < count; c++)
+   {
+      char path_key[64];
+      char desc_key[64];
+      char opt_key[64];
+      bool tmp_bool     = false;
+      char *tmp         = NULL;
+      path_key[0]       = desc_key[0] = opt_key[0] = '\0';
+
+      snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
+      snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
+      snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
+
+      if (config_get_string(config, path_key, &tmp) && !string_is_empty(tmp))
       {
-         char path_key[64];
-         char desc_key[64];
-         char opt_key[64];
-         bool tmp_bool     = false;
-         char *tmp         = NULL;
-         path_key[0]       = desc_key[0] = opt_key[0] = '\0';
-
-         snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
-         snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
-         snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
-
-         if (config_get_string(config, path_key, &tmp) && !string_is_empty(tmp))
-         {
-            info->firmware[c].path = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(config, desc_key, &tmp) && !string_is_empty(tmp))
-         {
-            info->firmware[c].desc = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (tmp)
-            free(tmp);
+         info->firmware[c].path = strdup(tmp);
+         free(tmp);
+         tmp = NULL;
+      }
+      if (config_get_string(config, desc_key, &tmp) && !string_is_empty(tmp))
+      {
+         info->firmware[c].desc = strdup(tmp);
+         free(tmp);
          tmp = NULL;
-         if (config_get_bool(config, opt_key , &tmp_bool))
-            info->firmware[c].optional = tmp_bool;
       }
+      if (tmp)
+         free(tmp);
+      tmp = NULL;
+      if (config_get_bool(config, opt_key , &tmp_bool))
+         info->firmware[c].optional = tmp_bool;
    }
 }
 
-static void core_info_list_free(core_info_list_t *core_info_list)
+static void core_info_free(core_info_t *info)
 {
-   size_t i, j;
-
-   if (!core_info_list)
-      return;
-
-   for (i = 0; i < core_info_list->count; i++)
+   size_t j;
+
+   free(info->path);
+   free(info->core_name);
+   free(info->systemname);
+   free(info->system_id);
+   free(info->system_manufacturer);
+   free(info->display_name);
+   free(info->display_version);
+   free(info->supported_extensions);
+   free(info->authors);
+   free(info->permissions);
+   free(info->licenses);
+   free(info->categories);
+   free(info->databases);
+   free(info->notes);
+   free(info->required_hw_api);
+   string_list_free(info->supported_extensions_list);
+   string_list_free(info->authors_list);
+   string_list_free(info->note_list);
+   string_list_free(info->permissions_list);
+   string_list_free(info->licenses_list);
+   string_list_free(info->categories_list);
+   string_list_free(info->databases_list);
+   string_list_free(info->required_hw_api_list);
+
+   if (info->firmware)
    {
-      core_info_t *info = (core_info_t*)&core_info_list->list[i];
-
-      free(info->path);
-      free(info->core_name);
-      free(info->systemname);
-      free(info->system_id);
-      free(info->system_manufacturer);
-      free(info->display_name);
-      free(info->display_version);
-      free(info->supported_extensions);
-      free(info->authors);
-      free(info->permissions);
-      free(info->licenses);
-      free(info->categories);
-      free(info->databases);
-      free(info->notes);
-      free(info->required_hw_api);
-      string_list_free(info->supported_extensions_list);
-      string_list_free(info->authors_list);
-      string_list_free(info->note_list);
-      string_list_free(info->permissions_list);
-      string_list_free(info->licenses_list);
-      string_list_free(info->categories_list);
-      string_list_free(info->databases_list);
-      string_list_free(info->required_hw_api_list);
-      config_file_free((config_file_t*)info->config_data);
-
       for (j = 0; j < info->firmware_count; j++)
       {
          free(info->firmware[j].path);
          free(info->firmware[j].desc);
       }
-      free(info->firmware);
    }
+   free(info->firmware);
+}
+
+static void core_info_list_free(core_info_list_t *core_info_list)
+{
+   size_t i;
+
+   if (!core_info_list)
+      return;
+
+   for (i = 0; i < core_info_list->count; i++)
+      core_info_free(&core_info_list->list[i]);
 
    free(core_info_list->all_ext);
    free(core_info_list->list);
    free(core_info_list);
 }
 
-static config_file_t *core_info_list_iterate(
-      const char *current_path,
-      const char *path_basedir)
+static void core_info_get_info_path(const char *current_path,
+      const char *path_basedir, char *s, size_t len)
 {
-   size_t info_path_base_size = PATH_MAX_LENGTH * sizeof(char);
-   char *info_path_base       = NULL;
-   char *info_path            = NULL;
-   config_file_t *conf        = NULL;
+   char *info_path_base = (char*)malloc(len);
 
-   if (!current_path)
-      return NULL;
-
-   info_path_base             = (char*)malloc(info_path_base_size);
+   if (!info_path_base)
+   {
+      *s = '\0';
+      return;
+   }
 
    info_path_base[0] = '\0';
 
-   fill_pathname_base_noext(info_path_base,
-         current_path,
-         info_path_base_size);
+   fill_pathname_base_noext(info_path_base, current_path, len);
 
 #if defined(RARCH_MOBILE) || (defined(RARCH_CONSOLE) && !defined(PSP) && !defined(_3DS) && !defined(VITA) && !defined(PS2) && !defined(HW_WUP))
    {
@@ -229,15 +236,29 @@ static config_file_t *core_info_list_iterate(
 #endif
 
    strlcat(info_path_base,
-         file_path_str(FILE_PATH_CORE_INFO_EXTENSION),
-         info_path_base_size);
+         file_path_str(FILE_PATH_CORE_INFO_EXTENSION), len);
 
-   info_path = (char*)malloc(info_path_base_size);
-   fill_pathname_join(info_path,
-         path_basedir,
-         info_path_base, info_path_base_size);
+   fill_pathname_join(s, path_basedir, info_path_base, len);
    free(info_path_base);
-   info_path_base = NULL;
+}
+
+static config_file_t *core_info_list_iterate(
+      const char *current_path,
+      const char *path_basedir)
+{
+   size_t info_path_size = PATH_MAX_LENGTH * sizeof(char);
+   char *info_path       = NULL;
+   config_file_t *conf   = NULL;
+
+   if (!current_path)
+      return NULL;
+
+   info_path = (char*)malloc(info_path_size);
+   if (!info_path)
+      return NULL;
+
+   core_info_get_info_path(current_path, path_basedir,
+         info_path, info_path_size);
 
    if (path_is_valid(info_path))
       conf = config_file_new_from_path_to_string(info_path);
@@ -246,18 +267,498 @@ static config_file_t *core_info_list_iterate(
    return conf;
 }
 
+/* Splits the '|' separated members into their lists. */
+static void core_info_resolve_lists(core_info_t *info)
+{
+   if (info->supported_extensions)
+      info->supported_extensions_list =
+         string_split(info->supported_extensions, "|");
+   if (info->authors)
+      info->authors_list     = string_split(info->authors, "|");
+   if (info->permissions)
+      info->permissions_list = string_split(info->permissions, "|");
+   if (info->licenses)
+      info->licenses_list    = string_split(info->licenses, "|");
+   if (info->categories)
+      info->categories_list  = string_split(info->categories, "|");
+   if (info->databases)
+      info->databases_list   = string_split(info->databases, "|");
+   if (info->notes)
+      info->note_list        = string_split(info->notes, "|");
+   if (info->required_hw_api)
+      info->required_hw_api_list =
+         string_split(info->required_hw_api, "|");
+}
+
+static const struct
+{
+   const char *key;
+   size_t offset;
+} core_info_strings[] = {
+   { "display_name",         offsetof(core_info_t, display_name)         },
+   { "display_version",      offsetof(core_info_t, display_version)      },
+   { "corename",             offsetof(core_info_t, core_name)            },
+   { "systemname",           offsetof(core_info_t, systemname)           },
+   { "systemid",             offsetof(core_info_t, system_id)            },
+   { "manufacturer",         offsetof(core_info_t, system_manufacturer)  },
+   { "supported_extensions", offsetof(core_info_t, supported_extensions) },
+   { "authors",              offsetof(core_info_t, authors)              },
+   { "permissions",          offsetof(core_info_t, permissions)          },
+   { "license",              offsetof(core_info_t, licenses)             },
+   { "categories",           offsetof(core_info_t, categories)           },
+   { "database",             offsetof(core_info_t, databases)            },
+   { "notes",                offsetof(core_info_t, notes)                },
+   { "required_hw_api",      offsetof(core_info_t, required_hw_api)      },
+};
+
+#define CORE_INFO_STRING(info, i) \
+   (*(char**)((uint8_t*)(info) + core_info_strings[i].offset))
+
+static void core_info_parse_config(core_info_t *info, config_file_t *conf)
+{
+   size_t i;
+   unsigned count = 0;
+   bool tmp_bool  = false;
+
+   for (i = 0; i < ARRAY_SIZE(core_info_strings); i++)
+   {
+      char *tmp = NULL;
+
+      if (config_get_string(conf, core_info_strings[i].key, &tmp)
+            && !string_is_empty(tmp))
+         CORE_INFO_STRING(info, i) = strdup(tmp);
+
+      if (tmp)
+         free(tmp);
+   }
+
+   config_get_uint(conf, "firmware_count", &count);
+   info->firmware_count = count;
+
+   if (config_get_bool(conf, "supports_no_game", &tmp_bool))
+      info->supports_no_game = tmp_bool;
+
+   if (config_get_bool(conf, "database_match_archive_member", &tmp_bool))
+      info->database_match_archive_member = tmp_bool;
+
+   core_info_resolve_lists(info);
+   core_info_resolve_firmware(info, conf);
+
+   info->has_info = true;
+}
+
+#define CORE_INFO_CACHE_MAGIC   0x52414349 /* RACI */
+#define CORE_INFO_CACHE_VERSION 1
+#define CORE_INFO_CACHE_NULL    0xffffffff
+
+/* What a cached entry is valid for. */
+typedef struct
+{
+   char *info_path;
+   int64_t mtime;
+   int64_t size;
+} core_info_cache_key_t;
+
+typedef struct
+{
+   /* info_path points into the cache data */
+   core_info_cache_key_t key;
+   size_t offset;
+   size_t len;
+} core_info_cache_entry_t;
+
+typedef struct
+{
+   uint8_t *data;
+   size_t len;
+   core_info_cache_entry_t *entries;
+   size_t count;
+   size_t hits;
+} core_info_cache_t;
+
+typedef struct
+{
+   const uint8_t *data;
+   size_t len;
+   size_t pos;
+   bool error;
+} core_info_cache_reader_t;
+
+static bool core_info_file_stat(const char *path,
+      int64_t *mtime, int64_t *size)
+{
+#if defined(HAVE_CORE_INFO_CACHE) && defined(_WIN32)
+   struct _stat buf;
+#if defined(LEGACY_WIN32)
+   char *path_local = utf8_to_local_string_alloc(path);
+   int ret          = path_local ? _stat(path_local, &buf) : -1;
+
+   if (path_local)
+      free(path_local);
+#else
+   wchar_t *path_wide = utf8_to_utf16_string_alloc(path);
+   int ret            = path_wide ? _wstat(path_wide, &buf) : -1;
+
+   if (path_wide)
+      free(path_wide);
+#endif
+
+   if (ret != 0)
+      return false;
+
+   *mtime = (int64_t)buf.st_mtime;
+   *size  = (int64_t)buf.st_size;
+   return true;
+#elif defined(HAVE_CORE_INFO_CACHE)
+   struct stat buf;
+
+   if (stat(path, &buf) != 0)
+      return false;
+
+   *mtime = (int64_t)buf.st_mtime;
+   *size  = (int64_t)buf.st_size;
+   return true;
+#else
+   *mtime = 0;
+   *size  = 0;
+   return path_is_valid(path);
+#endif
+}
+
+#ifdef HAVE_CORE_INFO_CACHE
+/* Whether a failed cache write was already reported */
+static bool core_info_cache_warned = false;
+
+static void core_info_cache_read_bytes(core_info_cache_reader_t *reader,
+      void *s, size_t len)
+{
+   if (reader->error || reader->len - reader->pos < len)
+   {
+      reader->error = true;
+      memset(s, 0, len);
+      return;
+   }
+
+   memcpy(s, reader->data + reader->pos, len);
+   reader->pos += len;
+}
+
+static uint32_t core_info_cache_read_uint(core_info_cache_reader_t *reader)
+{
+   uint32_t val;
+   core_info_cache_read_bytes(reader, &val, sizeof(val));
+   return val;
+}
+
+/* Strings are stored with their length and a terminating NUL,
+ * so the returned pointer can be used in place. */
+static const char *core_info_cache_read_string(
+      core_info_cache_reader_t *reader)
+{
+   const char *str = NULL;
+   uint32_t len    = core_info_cache_read_uint(reader);
+
+   if (reader->error || len == CORE_INFO_CACHE_NULL)
+      return NULL;
+
+   if (reader->len - reader->pos <= len
+         || reader->data[reader->pos + len] != '\0')
+   {
+      reader->error = true;
+      return NULL;
+   }
+
+   str          = (const char*)reader->data + reader->pos;
+   reader->pos += len + 1;
+   return str;
+}
+
+static char *core_info_cache_read_strdup(core_info_cache_reader_t *reader)
+{
+   const char *str = core_info_cache_read_string(reader);
+   return str ? strdup(str) : NULL;
+}
+
+static void core_info_cache_free(core_info_cache_t *cache)
+{
+   free(cache->data);
+   free(cache->entries);
+   memset(cache, 0, sizeof(*cache));
+}
+
+/* Reads the cache in one go and indexes its entries. Leaves
+ * the cache empty if the file is missing, stale or damaged. */
+static void core_info_cache_read(core_info_cache_t *cache, const char *path)
+{
+   size_t i;
+   uint32_t header[4];
+   void *data                      = NULL;
+   int64_t len                     = 0;
+   core_info_cache_reader_t reader = {0};
+
+   memset(cache, 0, sizeof(*cache));
+
+   if (!path_is_valid(path)
+         || !filestream_read_file(path, &data, &len)
+         || len < (int64_t)sizeof(header))
+   {
+      free(data);
+      return;
+   }
+
+   cache->data = (uint8_t*)data;
+   cache->len  = (size_t)len;
+   reader.data = cache->data;
+   reader.len  = cache->len;
+
+   core_info_cache_read_bytes(&reader, header, sizeof(header));
+
+   if (     header[0] != CORE_INFO_CACHE_MAGIC
+         || header[1] != CORE_INFO_CACHE_VERSION
+         || header[3] != encoding_crc32(0, cache->data + reader.pos,
+            cache->len - reader.pos)
+         || header[2] > (cache->len - reader.pos) / 16)
+      goto error;
+
+   cache->entries = (core_info_cache_entry_t*)
+      calloc(header[2], sizeof(*cache->entries));
+   if (!cache->entries && header[2])
+      goto error;
+
+   for (i = 0; i < header[2]; i++)
+   {
+      core_info_cache_entry_t *entry = &cache->entries[i];
+
+      entry->key.info_path = (char*)core_info_cache_read_string(&reader);
+      core_info_cache_read_bytes(&reader,
+            &entry->key.mtime, sizeof(entry->key.mtime));
+      core_info_cache_read_bytes(&reader,
+            &entry->key.size, sizeof(entry->key.size));
+      entry->len           = core_info_cache_read_uint(&reader);
+      entry->offset        = reader.pos;
+
+      if (     reader.error
+            || !entry->key.info_path
+            || reader.len - reader.pos < entry->len)
+         goto error;
+
+      reader.pos += entry->len;
+   }
+
+   cache->count = header[2];
+   return;
+
+error:
+   RARCH_WARN("[Core Info]: Ignoring invalid cache: %s\n", path);
+   core_info_cache_free(cache);
+}
+
+/* Fills in info from the cache if it has an up to date entry
+ * for info_path. Entries come in the same order the cores were
+ * listed in last time, so most lookups hit the first try. */
+static bool core_info_cache_get(core_info_cache_t *cache,
+      const core_info_cache_key_t *key, core_info_t *info)
+{
+   size_t i, j;
+   uint32_t count;
+   core_info_t tmp;
+   core_info_cache_reader_t reader = {0};
+   const core_info_cache_entry_t *entry = NULL;
+
+   for (i = 0; i < cache->count; i++)
+   {
+      const core_info_cache_entry_t *cur =
+         &cache->entries[(cache->hits + i) % cache->count];
+
+      if (string_is_equal(cur->key.info_path, key->info_path))
+      {
+         entry = cur;
+         break;
+      }
+   }
+
+   if (     !entry
+         || entry->key.mtime != key->mtime
+         || entry->key.size  != key->size)
+      return false;
+
+   memset(&tmp, 0, sizeof(tmp));
+   reader.data = cache->data;
+   reader.len  = entry->offset + entry->len;
+   reader.pos  = entry->offset;
+
+   for (i = 0; i < ARRAY_SIZE(core_info_strings); i++)
+      CORE_INFO_STRING(&tmp, i) = core_info_cache_read_strdup(&reader);
+
+   tmp.supports_no_game              = core_info_cache_read_uint(&reader) != 0;
+   tmp.database_match_archive_member = core_info_cache_read_uint(&reader) != 0;
+   tmp.firmware_count                = core_info_cache_read_uint(&reader);
+   count                             = core_info_cache_read_uint(&reader);
+
+   if (!reader.error && count)
+   {
+      if (count > (reader.len - reader.pos) / 12)
+         reader.error = true;
+      else if (!(tmp.firmware = (core_info_firmware_t*)
+               calloc(count, sizeof(*tmp.firmware))))
+         reader.error = true;
+   }
+
+   for (j = 0; j < count && !reader.error; j++)
+   {
+      tmp.firmware[j].path     = core_info_cache_read_strdup(&reader);
+      tmp.firmware[j].desc     = core_info_cache_read_strdup(&reader);
+      tmp.firmware[j].optional = core_info_cache_read_uint(&reader) != 0;
+   }
+
+   if (reader.error)
+   {
+      if (tmp.firmware_count > count)
+         tmp.firmware_count = count;
+      core_info_free(&tmp);
+      return false;
+   }
+
+   core_info_resolve_lists(&tmp);
+   tmp.has_info = true;
+   *info        = tmp;
+
+   cache->hits++;
+   return true;
+}
+
+static size_t core_info_cache_write_bytes(uint8_t *s, size_t pos,
+      const void *data, size_t len)
+{
+   if (s)
+      memcpy(s + pos, data, len);
+   return pos + len;
+}
+
+static size_t core_info_cache_write_uint(uint8_t *s, size_t pos,
+      uint32_t val)
+{
+   return core_info_cache_write_bytes(s, pos, &val, sizeof(val));
+}
+
+static size_t core_info_cache_write_string(uint8_t *s, size_t pos,
+      const char *str)
+{
+   if (!str)
+      return core_info_cache_write_uint(s, pos, CORE_INFO_CACHE_NULL);
+
+   pos = core_info_cache_write_uint(s, pos, (uint32_t)strlen(str));
+   return core_info_cache_write_bytes(s, pos, str, strlen(str) + 1);
+}
+
+/* Writes one entry to s at pos, or just measures it if s is NULL.
+ * Returns the position after the entry. */
+static size_t core_info_cache_write_entry(uint8_t *s, size_t pos,
+      const core_info_cache_key_t *key, const core_info_t *info)
+{
+   size_t i, start;
+   /* firmware_count may be larger than what could be allocated */
+   uint32_t count = info->firmware ? (uint32_t)info->firmware_count : 0;
+
+   pos   = core_info_cache_write_string(s, pos, key->info_path);
+   pos   = core_info_cache_write_bytes(s, pos,
+         &key->mtime, sizeof(key->mtime));
+   pos   = core_info_cache_write_bytes(s, pos,
+         &key->size, sizeof(key->size));
+   pos   = core_info_cache_write_uint(s, pos, 0);
+   start = pos;
+
+   for (i = 0; i < ARRAY_SIZE(core_info_strings); i++)
+      pos = core_info_cache_write_string(s, pos,
+            CORE_INFO_STRING(info, i));
+
+   pos = core_info_cache_write_uint(s, pos, info->supports_no_game);
+   pos = core_info_cache_write_uint(s, pos,
+         info->database_match_archive_member);
+   pos = core_info_cache_write_uint(s, pos, (uint32_t)info->firmware_count);
+   pos = core_info_cache_write_uint(s, pos, count);
+
+   for (i = 0; i < count; i++)
+   {
+      pos = core_info_cache_write_string(s, pos, info->firmware[i].path);
+      pos = core_info_cache_write_string(s, pos, info->firmware[i].desc);
+      pos = core_info_cache_write_uint(s, pos, info->firmware[i].optional);
+   }
+
+   /* Now that the length is known */
+   core_info_cache_write_uint(s, start - sizeof(uint32_t),
+         (uint32_t)(pos - start));
+   return pos;
+}
+
+static void core_info_cache_write(const char *path,
+      const core_info_list_t *core_info_list,
+      const core_info_cache_key_t *keys)
+{
+   size_t i;
+   uint32_t header[4];
+   uint8_t *data = NULL;
+   size_t len    = sizeof(header);
+
+   header[0] = CORE_INFO_CACHE_MAGIC;
+   header[1] = CORE_INFO_CACHE_VERSION;
+   header[2] = 0;
+
+   for (i = 0; i < core_info_list->count; i++)
+   {
+      if (!keys[i].info_path)
+         continue;
+      len = core_info_cache_write_entry(NULL, len,
+            &keys[i], &core_info_list->list[i]);
+      header[2]++;
+   }
+
+   if (!(data = (uint8_t*)malloc(len)))
+      return;
+
+   for (i = 0, len = sizeof(header); i < core_info_list->count; i++)
+   {
+      if (!keys[i].info_path)
+         continue;
+      len = core_info_cache_write_entry(data, len,
+            &keys[i], &core_info_list->list[i]);
+   }
+
+   header[3] = encoding_crc32(0, data + sizeof(header), len - sizeof(header));
+   memcpy(data, header, sizeof(header));
+
+   /* The cache is only an optimisation, so don't keep
+    * complaining about a directory that isn't writable */
+   if (!filestream_write_file(path, data, len) && !core_info_cache_warned)
+   {
+      RARCH_WARN("[Core Info]: Could not write cache: %s\n", path);
+      core_info_cache_warned = true;
+   }
+
+   free(data);
+}
+#endif
+
 static core_info_list_t *core_info_list_new(const char *path,
       const char *libretro_info_dir,
+      const char *cache_dir,
       const char *exts,
       bool dir_show_hidden_files)
 {
    size_t i;
    core_info_t *core_info           = NULL;
    core_info_list_t *core_info_list = NULL;
+   core_info_cache_key_t *keys      = NULL;
    const char       *path_basedir   = libretro_info_dir;
    struct string_list *contents     = string_list_new();
    bool                          ok = dir_list_append(contents, path, exts,
          false, dir_show_hidden_files, false, false);
+   char info_path[PATH_MAX_LENGTH];
+#ifdef HAVE_CORE_INFO_CACHE
+   char cache_path[PATH_MAX_LENGTH];
+   core_info_cache_t cache;
+   bool cache_dirty                 = false;
+#endif
 
 #if defined(__WINRT__) || defined(WINAPI_FAMILY) && WINAPI_FAMILY == WINAPI_FAMILY_PHONE_APP
    /* UWP: browse the optional packages for additional cores */
@@ -287,8 +788,11 @@ static core_info_list_t *core_info_list_new(const char *path,
    }
 
    core_info = (core_info_t*)calloc(contents->size, sizeof(*core_info));
-   if (!core_info)
+   keys      = (core_info_cache_key_t*)calloc(contents->size, sizeof(*keys));
+   if (!core_info || !keys)
    {
+      free(core_info);
+      free(keys);
       core_info_list_free(core_info_list);
       string_list_free(contents);
       return NULL;
@@ -297,170 +801,52 @@ static core_info_list_t *core_info_list_new(const char *path,
    core_info_list->list  = core_info;
    core_info_list->count = contents->size;
 
+#ifdef HAVE_CORE_INFO_CACHE
+   cache_path[0] = '\0';
+   if (!string_is_empty(cache_dir))
+      fill_pathname_join(cache_path, cache_dir,
+            file_path_str(FILE_PATH_CORE_INFO_CACHE), sizeof(cache_path));
+   core_info_cache_read(&cache, cache_path);
+#endif
+
    for (i = 0; i < contents->size; i++)
    {
       const char *base_path = contents->elems[i].data;
-      config_file_t *conf   = core_info_list_iterate(base_path,
-            path_basedir);
-
-      if (conf)
-      {
-         char *tmp           = NULL;
-
-         if (config_get_string(conf, "display_name", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].display_name = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(conf, "display_version", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].display_version = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-         if (config_get_string(conf, "corename", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].core_name = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "systemname", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].systemname = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "systemid", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].system_id = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "manufacturer", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].system_manufacturer = strdup(tmp);
-            free(tmp);
-            tmp = NULL;
-         }
-
-         {
-            unsigned count      = 0;
-            config_get_uint(conf, "firmware_count", &count);
-            core_info[i].firmware_count = count;
-         }
-
-         if (config_get_string(conf, "supported_extensions", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].supported_extensions      = strdup(tmp);
-            core_info[i].supported_extensions_list =
-               string_split(core_info[i].supported_extensions, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "authors", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].authors      = strdup(tmp);
-            core_info[i].authors_list =
-               string_split(core_info[i].authors, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "permissions", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].permissions      = strdup(tmp);
-            core_info[i].permissions_list =
-               string_split(core_info[i].permissions, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "license", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].licenses      = strdup(tmp);
-            core_info[i].licenses_list =
-               string_split(core_info[i].licenses, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
 
-         if (config_get_string(conf, "categories", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].categories      = strdup(tmp);
-            core_info[i].categories_list =
-               string_split(core_info[i].categories, "|");
+      info_path[0] = '\0';
 
-            free(tmp);
-            tmp = NULL;
-         }
+      if (base_path)
+         core_info_get_info_path(base_path, path_basedir,
+               info_path, sizeof(info_path));
 
-         if (config_get_string(conf, "database", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].databases      = strdup(tmp);
-            core_info[i].databases_list =
-               string_split(core_info[i].databases, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (config_get_string(conf, "notes", &tmp)
-               && !string_is_empty(tmp))
-         {
-            core_info[i].notes     = strdup(tmp);
-            core_info[i].note_list = string_split(core_info[i].notes, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
+      if (     !string_is_empty(info_path)
+            && core_info_file_stat(info_path,
+               &keys[i].mtime, &keys[i].size))
+      {
+         keys[i].info_path = info_path;
 
-         if (config_get_string(conf, "required_hw_api", &tmp)
-               && !string_is_empty(tmp))
+#ifdef HAVE_CORE_INFO_CACHE
+         if (!core_info_cache_get(&cache, &keys[i], &core_info[i]))
+#endif
          {
-            core_info[i].required_hw_api = strdup(tmp);
-            core_info[i].required_hw_api_list = string_split(core_info[i].required_hw_api, "|");
-
-            free(tmp);
-            tmp = NULL;
-         }
-
-         if (tmp)
-            free(tmp);
-         tmp    = NULL;
+            config_file_t *conf = config_file_new_from_path_to_string(
+                  info_path);
 
-         {
-            bool tmp_bool       = false;
-            if (config_get_bool(conf, "supports_no_game",
-                     &tmp_bool))
-               core_info[i].supports_no_game = tmp_bool;
-
-            if (config_get_bool(conf, "database_match_archive_member",
-                     &tmp_bool))
-               core_info[i].database_match_archive_member = tmp_bool;
+            if (conf)
+            {
+               core_info_parse_config(&core_info[i], conf);
+               config_file_free(conf);
+            }
+#ifdef HAVE_CORE_INFO_CACHE
+            cache_dirty = true;
+#endif
          }
 
-         core_info[i].config_data = conf;
+         /* Only cache what could be read */
+         if (core_info[i].has_info)
+            keys[i].info_path = strdup(info_path);
+         else
+            keys[i].info_path = NULL;
       }
 
       if (!string_is_empty(base_path))
@@ -471,11 +857,19 @@ static core_info_list_t *core_info_list_new(const char *path,
             strdup(path_basename(core_info[i].path));
    }
 
-   if (core_info_list)
-   {
-      core_info_list_resolve_all_extensions(core_info_list);
-      core_info_list_resolve_all_firmware(core_info_list);
-   }
+#ifdef HAVE_CORE_INFO_CACHE
+   /* Also rewrite it when cores were removed */
+   if (     !string_is_empty(cache_path)
+         && (cache_dirty || cache.hits != cache.count))
+      core_info_cache_write(cache_path, core_info_list, keys);
+   core_info_cache_free(&cache);
+#endif
+
+   core_info_list_resolve_all_extensions(core_info_list);
+
+   for (i = 0; i < contents->size; i++)
+      free(keys[i].info_path);
+   free(keys);
 
    string_list_free(contents);
    return core_info_list;
@@ -653,10 +1047,11 @@ void core_info_deinit_list(void)
 }
 
 bool core_info_init_list(const char *path_info, const char *dir_cores,
-      const char *exts, bool dir_show_hidden_files)
+      const char *dir_cache, const char *exts, bool dir_show_hidden_files)
 {
    if (!(core_info_curr_list = core_info_list_new(dir_cores,
                !string_is_empty(path_info) ? path_info : dir_cores,
+               dir_cache,
                exts,
                dir_show_hidden_files)))
       return false;
@@ -830,11 +1225,7 @@ size_t core_info_list_num_info_files(core_info_list_t *core_info_list)
       return 0;
 
    for (i = 0; i < core_info_list->count; i++)
-   {
-      config_file_t *conf = (config_file_t*)
-         core_info_list->list[i].config_data;
-      num += !!conf;
-   }
+      num += core_info_list->list[i].has_info;
 
    return num;
 }
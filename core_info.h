@@ -39,9 +39,10 @@ typedef struct
 {
    bool supports_no_game;
    bool database_match_archive_member;
+   /* Set when the core has a .info file. */
+   bool has_info;
    size_t firmware_count;
    char *path;
-   void *config_data;
    char *display_name;
    char *display_version;
    char *core_name;
@@ -124,8 +125,9 @@ bool core_info_get_current_core(core_info_t **core);
 
 void core_info_deinit_list(void);
 
+/* Parsed info files are cached in dir_cache, if not NULL or empty. */
 bool core_info_init_list(const char *path_info, const char *dir_cores,
-      const char *exts, bool show_hidden_files);
+      const char *dir_cache, const char *exts, bool show_hidden_files);
 
 bool core_info_get_list(core_info_list_t **core);
 
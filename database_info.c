@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <compat/strl.h>
 #include <retro_endianness.h>
@@ -24,6 +25,7 @@
 #include <lists/string_list.h>
 #include <lists/dir_list.h>
 #include <string/stdstring.h>
+#include <rhash.h>
 
 #include "libretro-db/libretrodb.h"
 
@@ -538,6 +540,27 @@ end:
    return database_info_list;
 }
 
+bool database_info_create_indexes(const char *rdb_path)
+{
+   int rv           = -1;
+   libretrodb_t *db = libretrodb_new();
+
+   if (!db)
+      return false;
+
+   if (libretrodb_open(rdb_path, db) == 0)
+   {
+      if ((rv = libretrodb_create_indexes(db)) != 0)
+         RARCH_WARN("Could not index database \"%s\" (%d).\n",
+               rdb_path, rv);
+      libretrodb_close(db);
+   }
+
+   libretrodb_free(db);
+
+   return rv == 0;
+}
+
 void database_info_list_free(database_info_list_t *database_info_list)
 {
    size_t i;
@@ -591,3 +614,376 @@ void database_info_list_free(database_info_list_t *database_info_list)
 
    free(database_info_list->list);
 }
+
+typedef struct database_info_index_entry
+{
+   uint32_t crc32;
+   uint32_t serial_hash;
+   unsigned db;
+   size_t next_crc;
+   size_t next_serial;
+   char *name;
+   char *serial;
+} database_info_index_entry_t;
+
+/* Entries are chained through their index + 1, so that 0 ends
+ * a bucket. Chains are kept in database order. */
+struct database_info_index
+{
+   size_t count;
+   size_t capacity;
+   size_t mask;
+   size_t *crc_buckets;
+   size_t *serial_buckets;
+   uint32_t *db_hashes;
+   struct string_list *dbs;
+   database_info_index_entry_t *entries;
+};
+
+static bool database_info_index_key_is(
+      const struct rmsgpack_dom_value *key, const char *name)
+{
+   size_t len = strlen(name);
+   return key->val.string.len == len
+      && memcmp(key->val.string.buff, name, len) == 0;
+}
+
+static char *database_info_index_strdup(
+      const struct rmsgpack_dom_value *val)
+{
+   char *s = NULL;
+
+   if (!val || !val->val.string.len)
+      return NULL;
+
+   if ((s = (char*)malloc(val->val.string.len + 1)))
+   {
+      memcpy(s, val->val.string.buff, val->val.string.len);
+      s[val->val.string.len] = '\0';
+   }
+
+   return s;
+}
+
+/* @item is a view into the database, its strings and binaries
+ * are not NUL terminated. */
+static bool database_info_index_add_item(database_info_index_t *index,
+      unsigned db, struct rmsgpack_dom_value *item)
+{
+   unsigned i;
+   database_info_index_entry_t *entry     = NULL;
+   uint32_t crc32                         = 0;
+   const struct rmsgpack_dom_value *name   = NULL;
+   const struct rmsgpack_dom_value *serial = NULL;
+
+   if (item->type != RDT_MAP)
+      return true;
+
+   for (i = 0; i < item->val.map.len; i++)
+   {
+      struct rmsgpack_dom_value *key = &item->val.map.items[i].key;
+      struct rmsgpack_dom_value *val = &item->val.map.items[i].value;
+
+      if (key->type != RDT_STRING)
+         continue;
+
+      if (database_info_index_key_is(key, "crc"))
+      {
+         if (val->type == RDT_BINARY && val->val.binary.len == 4)
+            crc32 = ((uint32_t)(uint8_t)val->val.binary.buff[0] << 24)
+                  | ((uint32_t)(uint8_t)val->val.binary.buff[1] << 16)
+                  | ((uint32_t)(uint8_t)val->val.binary.buff[2] << 8)
+                  |  (uint32_t)(uint8_t)val->val.binary.buff[3];
+      }
+      /* Serials are stored as binaries, which share their
+       * layout with strings. */
+      else if (val->type != RDT_STRING && val->type != RDT_BINARY)
+         continue;
+      else if (database_info_index_key_is(key, "name"))
+         name   = val;
+      else if (database_info_index_key_is(key, "serial"))
+         serial = val;
+   }
+
+   if (serial && !serial->val.string.len)
+      serial = NULL;
+
+   if (!crc32 && !serial)
+      return true;
+
+   if (index->count == index->capacity)
+   {
+      size_t capacity = index->capacity ? index->capacity * 2 : 1024;
+      database_info_index_entry_t *entries =
+         (database_info_index_entry_t*)realloc(index->entries,
+               capacity * sizeof(*entries));
+
+      if (!entries)
+         return false;
+
+      index->entries  = entries;
+      index->capacity = capacity;
+   }
+
+   entry              = &index->entries[index->count++];
+   entry->crc32       = crc32;
+   entry->serial_hash = 0;
+   entry->db          = db;
+   entry->next_crc    = 0;
+   entry->next_serial = 0;
+   entry->name        = database_info_index_strdup(name);
+   entry->serial      = database_info_index_strdup(serial);
+
+   if (entry->serial)
+      entry->serial_hash = djb2_calculate(entry->serial);
+
+   return true;
+}
+
+database_info_index_t *database_info_index_new(
+      const struct string_list *rdb_paths)
+{
+   size_t i;
+   size_t buckets               = 1;
+   database_info_index_t *index = NULL;
+
+   if (!rdb_paths)
+      return NULL;
+
+   index = (database_info_index_t*)calloc(1, sizeof(*index));
+
+   if (!index)
+      return NULL;
+
+   index->dbs       = string_list_new();
+   index->db_hashes = (uint32_t*)calloc(rdb_paths->size + 1,
+         sizeof(*index->db_hashes));
+
+   if (!index->dbs || !index->db_hashes)
+      goto error;
+
+   for (i = 0; i < rdb_paths->size; i++)
+   {
+      union string_list_elem_attr attr;
+      struct rmsgpack_dom_value item;
+      const char *path         = rdb_paths->elems[i].data;
+      libretrodb_t *db         = libretrodb_new();
+      libretrodb_cursor_t *cur = libretrodb_cursor_new();
+      bool ok                  = true;
+
+      attr.i = 0;
+
+      if (!string_list_append(index->dbs, path, attr))
+         ok = false;
+      index->db_hashes[i] = djb2_calculate(path);
+
+      if (ok && db && cur && database_cursor_open(db, cur, path, NULL) == 0)
+      {
+         /* Only the few fields kept are copied out of each record */
+         while (ok && libretrodb_cursor_read_view(cur, &item) == 0)
+            ok = database_info_index_add_item(index, (unsigned)i, &item);
+         database_cursor_close(db, cur);
+      }
+
+      if (db)
+         libretrodb_free(db);
+      if (cur)
+         libretrodb_cursor_free(cur);
+
+      if (!ok)
+         goto error;
+   }
+
+   while (buckets < index->count)
+      buckets <<= 1;
+
+   index->mask           = buckets - 1;
+   index->crc_buckets    = (size_t*)calloc(buckets, sizeof(size_t));
+   index->serial_buckets = (size_t*)calloc(buckets, sizeof(size_t));
+
+   if (!index->crc_buckets || !index->serial_buckets)
+      goto error;
+
+   /* Link back to front so that each chain comes out in
+    * database order. */
+   for (i = index->count; i-- > 0; )
+   {
+      database_info_index_entry_t *entry = &index->entries[i];
+
+      if (entry->crc32)
+      {
+         size_t *bucket  = &index->crc_buckets[entry->crc32 & index->mask];
+         entry->next_crc = *bucket;
+         *bucket         = i + 1;
+      }
+
+      if (entry->serial)
+      {
+         size_t *bucket     =
+            &index->serial_buckets[entry->serial_hash & index->mask];
+         entry->next_serial = *bucket;
+         *bucket            = i + 1;
+      }
+   }
+
+   RARCH_LOG("Indexed %u database entries from %u databases.\n",
+         (unsigned)index->count, (unsigned)rdb_paths->size);
+
+   return index;
+
+error:
+   database_info_index_free(index);
+   return NULL;
+}
+
+void database_info_index_free(database_info_index_t *index)
+{
+   size_t i;
+
+   if (!index)
+      return;
+
+   for (i = 0; i < index->count; i++)
+   {
+      if (index->entries[i].name)
+         free(index->entries[i].name);
+      if (index->entries[i].serial)
+         free(index->entries[i].serial);
+   }
+
+   if (index->dbs)
+      string_list_free(index->dbs);
+   free(index->entries);
+   free(index->crc_buckets);
+   free(index->serial_buckets);
+   free(index->db_hashes);
+   free(index);
+}
+
+static int database_info_index_find_db(
+      const database_info_index_t *index, const char *rdb_path)
+{
+   size_t i;
+   uint32_t hash = djb2_calculate(rdb_path);
+
+   for (i = 0; i < index->dbs->size; i++)
+      if (     index->db_hashes[i] == hash
+            && string_is_equal(index->dbs->elems[i].data, rdb_path))
+         return (int)i;
+
+   return -1;
+}
+
+static bool database_info_index_push(database_info_list_t **list,
+      const database_info_index_entry_t *entry)
+{
+   database_info_t *info     = NULL;
+   database_info_t *new_list = NULL;
+
+   if (!*list)
+   {
+      *list = (database_info_list_t*)calloc(1, sizeof(**list));
+      if (!*list)
+         return false;
+   }
+
+   new_list = (database_info_t*)realloc((*list)->list,
+         ((*list)->count + 1) * sizeof(database_info_t));
+
+   if (!new_list)
+      return false;
+
+   (*list)->list = new_list;
+   info          = &new_list[(*list)->count++];
+
+   memset(info, 0, sizeof(*info));
+   info->analog_supported = -1;
+   info->rumble_supported = -1;
+   info->coop_supported   = -1;
+   info->crc32            = entry->crc32;
+   info->name             = entry->name   ? strdup(entry->name)   : NULL;
+   info->serial           = entry->serial ? strdup(entry->serial) : NULL;
+
+   return true;
+}
+
+database_info_list_t *database_info_index_find_crc(
+      const database_info_index_t *index, const char *rdb_path,
+      uint32_t crc, uint32_t archive_crc)
+{
+   database_info_list_t *list = NULL;
+   size_t next_crc            = 0;
+   size_t next_archive        = 0;
+   int db                     = 0;
+
+   if (!index || !index->count || string_is_empty(rdb_path))
+      return NULL;
+
+   if ((db = database_info_index_find_db(index, rdb_path)) < 0)
+      return NULL;
+
+   if (crc)
+      next_crc     = index->crc_buckets[crc & index->mask];
+   /* Both values may hash to the same chain; walk it once. */
+   if (archive_crc && (!crc || ((archive_crc ^ crc) & index->mask)))
+      next_archive = index->crc_buckets[archive_crc & index->mask];
+
+   /* Merge both chains, keeping database order. */
+   while (next_crc || next_archive)
+   {
+      const database_info_index_entry_t *entry = NULL;
+
+      if (next_crc && (!next_archive || next_crc < next_archive))
+      {
+         entry    = &index->entries[next_crc - 1];
+         next_crc = entry->next_crc;
+      }
+      else
+      {
+         entry        = &index->entries[next_archive - 1];
+         next_archive = entry->next_crc;
+      }
+
+      if (     entry->db == (unsigned)db
+            && (entry->crc32 == crc || entry->crc32 == archive_crc))
+         if (!database_info_index_push(&list, entry))
+            break;
+   }
+
+   return list;
+}
+
+database_info_list_t *database_info_index_find_serial(
+      const database_info_index_t *index, const char *rdb_path,
+      const char *serial)
+{
+   size_t next;
+   uint32_t hash;
+   database_info_list_t *list = NULL;
+   int db                     = 0;
+
+   if (!index || !index->count
+         || string_is_empty(rdb_path) || string_is_empty(serial))
+      return NULL;
+
+   if ((db = database_info_index_find_db(index, rdb_path)) < 0)
+      return NULL;
+
+   hash = djb2_calculate(serial);
+   next = index->serial_buckets[hash & index->mask];
+
+   while (next)
+   {
+      const database_info_index_entry_t *entry = &index->entries[next - 1];
+
+      if (     entry->db == (unsigned)db
+            && entry->serial_hash == hash
+            && string_is_equal(entry->serial, serial))
+         if (!database_info_index_push(&list, entry))
+            break;
+
+      next = entry->next_serial;
+   }
+
+   return list;
+}
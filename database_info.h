@@ -125,6 +125,10 @@ database_info_list_t *database_info_list_new(const char *rdb_path,
 
 void database_info_list_free(database_info_list_t *list);
 
+/* Adds the crc, serial, name and rom_name indexes that the database
+ * at @rdb_path is missing, see libretrodb_create_indexes(). */
+bool database_info_create_indexes(const char *rdb_path);
+
 database_info_handle_t *database_info_dir_init(const char *dir,
       enum database_type type, retro_task_t *task,
       bool show_hidden_files);
@@ -141,6 +145,27 @@ int database_info_build_query_enum(
  * memory after it is no longer required. */
 char *bin_to_hex_alloc(const uint8_t *data, size_t len);
 
+typedef struct database_info_index database_info_index_t;
+
+/* Loads the crc and serial of every entry of the given databases
+ * into hash tables, so that content can be matched without
+ * compiling a query and walking each database. */
+database_info_index_t *database_info_index_new(
+      const struct string_list *rdb_paths);
+
+void database_info_index_free(database_info_index_t *index);
+
+/* Returns the entries of one database whose crc matches either
+ * value, in database order, or NULL if there are none. Only the
+ * name, serial and crc32 fields of the entries are set. */
+database_info_list_t *database_info_index_find_crc(
+      const database_info_index_t *index, const char *rdb_path,
+      uint32_t crc, uint32_t archive_crc);
+
+database_info_list_t *database_info_index_find_serial(
+      const database_info_index_t *index, const char *rdb_path,
+      const char *serial);
+
 RETRO_END_DECLS
 
 #endif /* CORE_INFO_H_ */
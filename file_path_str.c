@@ -206,6 +206,9 @@ const char *file_path_str(enum file_path_enum enum_idx)
       case FILE_PATH_CORE_OPTIONS_CONFIG:
          str = "retroarch-core-options.cfg";
          break;
+      case FILE_PATH_CORE_INFO_CACHE:
+         str = "core_info.cache";
+         break;
       case FILE_PATH_MAIN_CONFIG:
          str = "retroarch.cfg";
          break;
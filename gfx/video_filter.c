@@ -43,45 +43,184 @@ struct rarch_soft_plug
    const struct softfilter_implementation *impl;
 };
 
+/* Each worker thread gets this many work packets per frame, so a
+ * thread that finishes its share early can pick up rows that would
+ * otherwise hold up the frame on a slower one. */
+#define SOFTFILTER_PACKETS_PER_THREAD 4
+
 #ifdef HAVE_THREADS
 #include <rthreads/rthreads.h>
 
-struct filter_thread_data
+#if defined(_MSC_VER)
+#ifdef _XBOX
+#include <xtl.h>
+#else
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#endif
+
+/* Hands out the next work packet index of the frame. */
+#if defined(__GNUC__) || defined(__clang__)
+#define FILTER_NEXT_PACKET(pool) \
+   __sync_fetch_and_add(&(pool)->next, 1)
+#elif defined(_MSC_VER)
+#define FILTER_NEXT_PACKET(pool) \
+   ((unsigned)InterlockedIncrement((volatile LONG*)&(pool)->next) - 1)
+#endif
+
+/* Worker threads stay around for the lifetime of the filter. Every
+ * frame bumps the generation and wakes them all, then the threads
+ * and the caller pull packets off a shared counter until none are
+ * left. The caller returns once every worker has checked back in. */
+struct filter_thread_pool
 {
-   sthread_t *thread;
-   const struct softfilter_work_packet *packet;
-   scond_t *cond;
+   sthread_t **threads;
+   unsigned num_threads;
+
    slock_t *lock;
-   void *userdata;
+   scond_t *cond;
+   scond_t *done_cond;
+   unsigned generation;
+   unsigned busy;
    bool die;
-   bool done;
+
+   const struct softfilter_work_packet *packets;
+   unsigned num_packets;
+   void *userdata;
+   volatile unsigned next;
 };
 
+static void filter_thread_pool_run(struct filter_thread_pool *pool)
+{
+   for (;;)
+   {
+      unsigned i;
+#ifdef FILTER_NEXT_PACKET
+      i = FILTER_NEXT_PACKET(pool);
+#else
+      slock_lock(pool->lock);
+      i = pool->next++;
+      slock_unlock(pool->lock);
+#endif
+      if (i >= pool->num_packets)
+         break;
+
+      if (pool->packets[i].work)
+         pool->packets[i].work(pool->userdata,
+               pool->packets[i].thread_data);
+   }
+}
+
 static void filter_thread_loop(void *data)
 {
-   struct filter_thread_data *thr = (struct filter_thread_data*)data;
+   struct filter_thread_pool *pool = (struct filter_thread_pool*)data;
+   unsigned generation             = 0;
 
    for (;;)
    {
-      bool die;
-      slock_lock(thr->lock);
-      while (thr->done && !thr->die)
-         scond_wait(thr->cond, thr->lock);
-      die = thr->die;
-      slock_unlock(thr->lock);
-
-      if (die)
+      slock_lock(pool->lock);
+      while (pool->generation == generation && !pool->die)
+         scond_wait(pool->cond, pool->lock);
+      if (pool->die)
+      {
+         slock_unlock(pool->lock);
          break;
+      }
+      generation = pool->generation;
+      slock_unlock(pool->lock);
 
-      if (thr->packet && thr->packet->work)
-         thr->packet->work(thr->userdata, thr->packet->thread_data);
+      filter_thread_pool_run(pool);
 
-      slock_lock(thr->lock);
-      thr->done = true;
-      scond_signal(thr->cond);
-      slock_unlock(thr->lock);
+      slock_lock(pool->lock);
+      if (--pool->busy == 0)
+         scond_signal(pool->done_cond);
+      slock_unlock(pool->lock);
    }
 }
+
+static void filter_thread_pool_free(struct filter_thread_pool *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   if (pool->threads)
+   {
+      slock_lock(pool->lock);
+      pool->die = true;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+
+      for (i = 0; i < pool->num_threads; i++)
+         if (pool->threads[i])
+            sthread_join(pool->threads[i]);
+      free(pool->threads);
+   }
+
+   if (pool->lock)
+      slock_free(pool->lock);
+   if (pool->cond)
+      scond_free(pool->cond);
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+   free(pool);
+}
+
+static struct filter_thread_pool *filter_thread_pool_new(
+      unsigned num_threads, const struct softfilter_work_packet *packets,
+      unsigned num_packets, void *userdata)
+{
+   struct filter_thread_pool *pool = (struct filter_thread_pool*)
+      calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->packets     = packets;
+   pool->num_packets = num_packets;
+   pool->userdata    = userdata;
+   pool->lock        = slock_new();
+   pool->cond        = scond_new();
+   pool->done_cond   = scond_new();
+   pool->threads     = (sthread_t**)calloc(num_threads, sizeof(*pool->threads));
+
+   if (!pool->lock || !pool->cond || !pool->done_cond || !pool->threads)
+      goto error;
+
+   for (; pool->num_threads < num_threads; pool->num_threads++)
+   {
+      pool->threads[pool->num_threads] = sthread_create(
+            filter_thread_loop, pool);
+      if (!pool->threads[pool->num_threads])
+         goto error;
+   }
+
+   return pool;
+
+error:
+   filter_thread_pool_free(pool);
+   return NULL;
+}
+
+static void filter_thread_pool_process(struct filter_thread_pool *pool)
+{
+   slock_lock(pool->lock);
+   pool->next = 0;
+   pool->busy = pool->num_threads;
+   pool->generation++;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+
+   /* Work on the frame here too instead of just waiting on it */
+   filter_thread_pool_run(pool);
+
+   slock_lock(pool->lock);
+   while (pool->busy)
+      scond_wait(pool->done_cond, pool->lock);
+   slock_unlock(pool->lock);
+}
 #endif
 
 struct rarch_softfilter
@@ -98,10 +237,10 @@ struct rarch_softfilter
    enum retro_pixel_format pix_fmt, out_pix_fmt;
 
    struct softfilter_work_packet *packets;
-   unsigned threads;
+   unsigned num_packets;
 
 #ifdef HAVE_THREADS
-   struct filter_thread_data *thread_data;
+   struct filter_thread_pool *pool;
 #endif
 };
 
@@ -134,12 +273,10 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       softfilter_simd_mask_t cpu_features,
       unsigned threads)
 {
-   unsigned input_fmts, input_fmt, output_fmts, i = 0;
+   unsigned input_fmts, input_fmt, output_fmts;
    struct config_file_userdata userdata;
    char key[64], name[64];
 
-   (void)i;
-
    key[0] = name[0] = '\0';
 
    snprintf(key, sizeof(key), "filter");
@@ -207,29 +344,41 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    filt->max_width = max_width;
    filt->max_height = max_height;
 
+   if (threads == RARCH_SOFTFILTER_THREADS_AUTO)
+      threads = cpu_features_get_core_amount();
+#ifndef HAVE_THREADS
+   threads = 1;
+#endif
+   if (!threads)
+      threads = 1;
+
+   /* The filter splits the frame into as many work packets as it
+    * is given here, or fewer if it cannot be split that far. */
    filt->impl_data = filt->impl->create(
          &softfilter_config, input_fmt, input_fmt, max_width, max_height,
-         threads != RARCH_SOFTFILTER_THREADS_AUTO ? threads :
-         cpu_features_get_core_amount(), cpu_features,
-         &userdata);
+         threads > 1 ? threads * SOFTFILTER_PACKETS_PER_THREAD : 1,
+         cpu_features, &userdata);
    if (!filt->impl_data)
    {
       RARCH_ERR("Failed to create softfilter state.\n");
       return false;
    }
 
-   threads = filt->impl->query_num_threads(filt->impl_data);
-   if (!threads)
+   filt->num_packets = filt->impl->query_num_threads(filt->impl_data);
+   if (!filt->num_packets)
    {
       RARCH_ERR("Invalid number of threads.\n");
       return false;
    }
 
-   filt->threads = threads;
-   RARCH_LOG("Using %u threads for softfilter.\n", threads);
+   if (threads > filt->num_packets)
+      threads = filt->num_packets;
+
+   RARCH_LOG("Using %u threads and %u work packets for softfilter.\n",
+         threads, filt->num_packets);
 
    filt->packets = (struct softfilter_work_packet*)
-      calloc(threads, sizeof(*filt->packets));
+      calloc(filt->num_packets, sizeof(*filt->packets));
    if (!filt->packets)
    {
       RARCH_ERR("Failed to allocate softfilter packets.\n");
@@ -237,26 +386,16 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    }
 
 #ifdef HAVE_THREADS
-   filt->thread_data = (struct filter_thread_data*)
-      calloc(threads, sizeof(*filt->thread_data));
-   if (!filt->thread_data)
-      return false;
-
-   for (i = 0; i < threads; i++)
+   /* The thread calling rarch_softfilter_process() is one of them */
+   if (threads > 1)
    {
-      filt->thread_data[i].userdata = filt->impl_data;
-      filt->thread_data[i].done = true;
-
-      filt->thread_data[i].lock = slock_new();
-      if (!filt->thread_data[i].lock)
-         return false;
-      filt->thread_data[i].cond = scond_new();
-      if (!filt->thread_data[i].cond)
-         return false;
-      filt->thread_data[i].thread = sthread_create(
-            filter_thread_loop, &filt->thread_data[i]);
-      if (!filt->thread_data[i].thread)
+      filt->pool = filter_thread_pool_new(threads - 1, filt->packets,
+            filt->num_packets, filt->impl_data);
+      if (!filt->pool)
+      {
+         RARCH_ERR("Failed to create softfilter threads.\n");
          return false;
+      }
    }
 #endif
 
@@ -461,6 +600,10 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    if (!filt)
       return;
 
+#ifdef HAVE_THREADS
+   filter_thread_pool_free(filt->pool);
+#endif
+
    free(filt->packets);
    if (filt->impl && filt->impl_data)
       filt->impl->destroy(filt->impl_data);
@@ -474,22 +617,6 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    free(filt->plugs);
 #endif
 
-#ifdef HAVE_THREADS
-   for (i = 0; i < filt->threads; i++)
-   {
-      if (!filt->thread_data[i].thread)
-         continue;
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].die = true;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
-      sthread_join(filt->thread_data[i].thread);
-      slock_free(filt->thread_data[i].lock);
-      scond_free(filt->thread_data[i].cond);
-   }
-   free(filt->thread_data);
-#endif
-
    if (filt->conf)
       config_file_free(filt->conf);
 
@@ -533,32 +660,14 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
             output, output_stride, input, width, height, input_stride);
 
 #ifdef HAVE_THREADS
-   /* Fire off workers */
-   for (i = 0; i < filt->threads; i++)
-   {
-#if 0
-      RARCH_LOG("Firing off filter thread %u ...\n", i);
-#endif
-      filt->thread_data[i].packet = &filt->packets[i];
-      slock_lock(filt->thread_data[i].lock);
-      filt->thread_data[i].done = false;
-      scond_signal(filt->thread_data[i].cond);
-      slock_unlock(filt->thread_data[i].lock);
-   }
-
-   /* Wait for workers */
-   for (i = 0; i < filt->threads; i++)
+   if (filt->pool)
    {
-#if 0
-      RARCH_LOG("Waiting for filter thread %u ...\n", i);
-#endif
-      slock_lock(filt->thread_data[i].lock);
-      while (!filt->thread_data[i].done)
-         scond_wait(filt->thread_data[i].cond, filt->thread_data[i].lock);
-      slock_unlock(filt->thread_data[i].lock);
+      filter_thread_pool_process(filt->pool);
+      return;
    }
-#else
-   for (i = 0; i < filt->threads; i++)
-      filt->packets[i].work(filt->impl_data, filt->packets[i].thread_data);
 #endif
+
+   for (i = 0; i < filt->num_packets; i++)
+      if (filt->packets[i].work)
+         filt->packets[i].work(filt->impl_data, filt->packets[i].thread_data);
 }
@@ -232,7 +232,7 @@ static void *twoxbr_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -538,7 +538,7 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
       int first, int last, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned nextline, finish;
+   unsigned finish, y;
    uint32_t pg_red_mask      = RED_MASK8888;
    uint32_t pg_green_mask    = GREEN_MASK8888;
    uint32_t pg_blue_mask     = BLUE_MASK8888;
@@ -548,10 +548,14 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
 
    (void)filt;
 
-   nextline = (last) ? 0 : src_stride;
-
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Clamp the rows reached above and below to the frame */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2) ? prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
 
@@ -559,14 +563,14 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
       {
          uint32_t E[4];
          uint32_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint32_t A1 = *(in - nextline - nextline - 1);
-         uint32_t B1 = *(in - nextline - nextline);
-         uint32_t C1 = *(in - nextline - nextline + 1);
-         uint32_t A0 = *(in - nextline - 2);
-         uint32_t PA = *(in - nextline - 1);
-         uint32_t PB = *(in - nextline);
-         uint32_t PC = *(in - nextline + 1);
-         uint32_t C4 = *(in - nextline + 2);
+         uint32_t A1 = *(in - prevline2 - 1);
+         uint32_t B1 = *(in - prevline2);
+         uint32_t C1 = *(in - prevline2 + 1);
+         uint32_t A0 = *(in - prevline - 2);
+         uint32_t PA = *(in - prevline - 1);
+         uint32_t PB = *(in - prevline);
+         uint32_t PC = *(in - prevline + 1);
+         uint32_t C4 = *(in - prevline + 2);
          uint32_t D0 = *(in - 2);
          uint32_t PD = *(in - 1);
          uint32_t PE = *(in);
@@ -577,9 +581,9 @@ static void twoxbr_generic_xrgb8888(void *data, unsigned width, unsigned height,
          uint32_t PH = *(in + nextline);
          uint32_t _PI = *(in + nextline + 1);
          uint32_t I4 = *(in + nextline + 2);
-         uint32_t G5 = *(in + nextline + nextline - 1);
-         uint32_t H5 = *(in + nextline + nextline);
-         uint32_t I5 = *(in + nextline + nextline + 1);
+         uint32_t G5 = *(in + nextline2 - 1);
+         uint32_t H5 = *(in + nextline2);
+         uint32_t I5 = *(in + nextline2 + 1);
 
          /*
           * Map of the pixels:          A1 B1 C1
@@ -601,16 +605,21 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
       int first, int last, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
+   unsigned finish, y;
    struct filter_data *filt = (struct filter_data*)data;
    uint16_t pg_red_mask     = RED_MASK565;
    uint16_t pg_green_mask   = GREEN_MASK565;
    uint16_t pg_blue_mask    = BLUE_MASK565;
    uint16_t pg_lbmask       = PG_LBMASK565;
-   unsigned nextline        = (last) ? 0 : src_stride;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Clamp the rows reached above and below to the frame */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned prevline2 = (first && y < 2) ? prevline : prevline + src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
 
@@ -618,14 +627,14 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
       {
          uint16_t E[4];
          uint16_t ex, e, i, ke, ki, ex2, ex3, px;
-         uint16_t A1 = *(in - nextline - nextline - 1);
-         uint16_t B1 = *(in - nextline - nextline);
-         uint16_t C1 = *(in - nextline - nextline + 1);
-         uint16_t A0 = *(in - nextline - 2);
-         uint16_t PA = *(in - nextline - 1);
-         uint16_t PB = *(in - nextline);
-         uint16_t PC = *(in - nextline + 1);
-         uint16_t C4 = *(in - nextline + 2);
+         uint16_t A1 = *(in - prevline2 - 1);
+         uint16_t B1 = *(in - prevline2);
+         uint16_t C1 = *(in - prevline2 + 1);
+         uint16_t A0 = *(in - prevline - 2);
+         uint16_t PA = *(in - prevline - 1);
+         uint16_t PB = *(in - prevline);
+         uint16_t PC = *(in - prevline + 1);
+         uint16_t C4 = *(in - prevline + 2);
          uint16_t D0 = *(in - 2);
          uint16_t PD = *(in - 1);
          uint16_t PE = *(in);
@@ -636,9 +645,9 @@ static void twoxbr_generic_rgb565(void *data, unsigned width, unsigned height,
          uint16_t PH = *(in + nextline);
          uint16_t _PI = *(in + nextline + 1);
          uint16_t I4 = *(in + nextline + 2);
-         uint16_t G5 = *(in + nextline + nextline - 1);
-         uint16_t H5 = *(in + nextline + nextline);
-         uint16_t I5 = *(in + nextline + nextline + 1);
+         uint16_t G5 = *(in + nextline2 - 1);
+         uint16_t H5 = *(in + nextline2);
+         uint16_t I5 = *(in + nextline2 + 1);
 
          /*
           * Map of the pixels:          A1 B1 C1
@@ -702,8 +711,11 @@ static void twoxbr_generic_packets(void *data,
       struct softfilter_thread_data *thr =
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      /* Bands start on even rows, so each one is at least two rows
+       * tall, which is as far as the filter reads past its ends. */
+      unsigned y_start = ((height >> 1) * i / filt->threads) << 1;
+      unsigned y_end   = (i + 1 == filt->threads) ? height
+         : ((height >> 1) * (i + 1) / filt->threads) << 1;
 
       thr->out_data = (uint8_t*)output + y_start *
          TWOXBR_SCALE * output_stride;
@@ -715,7 +727,7 @@ static void twoxbr_generic_packets(void *data,
 
       /* Workers need to know if they can access
        * pixels outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
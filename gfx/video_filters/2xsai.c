@@ -76,7 +76,7 @@ static void *twoxsai_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -118,12 +118,12 @@ static void twoxsai_generic_destroy(void *data)
 
 #define twoxsai_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)));
 
-#define twoxsai_declare_variables(typename_t, in, nextline) \
+#define twoxsai_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product, product1, product2; \
-         typename_t colorI = *(in - nextline - 1); \
-         typename_t colorE = *(in - nextline + 0); \
-         typename_t colorF = *(in - nextline + 1); \
-         typename_t colorJ = *(in - nextline + 2); \
+         typename_t colorI = *(in - prevline - 1); \
+         typename_t colorE = *(in - prevline + 0); \
+         typename_t colorF = *(in - prevline + 1); \
+         typename_t colorJ = *(in - prevline + 2); \
          typename_t colorG = *(in - 1); \
          typename_t colorA = *(in + 0); \
          typename_t colorB = *(in + 1); \
@@ -132,9 +132,9 @@ static void twoxsai_generic_destroy(void *data)
          typename_t colorC = *(in + nextline + 0); \
          typename_t colorD = *(in + nextline + 1); \
          typename_t colorL = *(in + nextline + 2); \
-         typename_t colorM = *(in + nextline + nextline - 1); \
-         typename_t colorN = *(in + nextline + nextline + 0); \
-         typename_t colorO = *(in + nextline + nextline + 1);
+         typename_t colorM = *(in + nextline2 - 1); \
+         typename_t colorN = *(in + nextline2 + 0); \
+         typename_t colorO = *(in + nextline2 + 1);
 
 #ifndef twoxsai_function
 #define twoxsai_function(result_cb, interpolate_cb, interpolate2_cb) \
@@ -228,17 +228,21 @@ static void twoxsai_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Clamp the rows reached above and below to the frame */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint32_t, in, nextline);
+         twoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -260,17 +264,21 @@ static void twoxsai_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Clamp the rows reached above and below to the frame */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         twoxsai_declare_variables(uint16_t, in, nextline);
+         twoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          /*
           * Map of the pixels:           I|E F|J
@@ -334,8 +342,11 @@ static void twoxsai_generic_packets(void *data,
       struct softfilter_thread_data *thr =
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      /* Bands start on even rows, so each one is at least two rows
+       * tall, which is as far as the filter reads past its ends. */
+      unsigned y_start = ((height >> 1) * i / filt->threads) << 1;
+      unsigned y_end   = (i + 1 == filt->threads) ? height
+         : ((height >> 1) * (i + 1) / filt->threads) << 1;
       thr->out_data = (uint8_t*)output + y_start *
          TWOXSAI_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
@@ -347,7 +358,7 @@ static void twoxsai_generic_packets(void *data,
       /* Workers need to know if they can access pixels
        * outside their given buffer.
        */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
@@ -74,7 +74,7 @@ static void *lq2x_generic_create(const struct softfilter_config *config,
       return NULL;
    filt->workers = (struct softfilter_thread_data*)
       calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
    if (!filt->workers)
    {
@@ -113,8 +113,8 @@ static void lq2x_generic_rgb565(unsigned width, unsigned height,
 
    for(y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      int prevline = (y == 0 && first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
@@ -158,8 +158,8 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
 
    for(y = 0; y < height; y++)
    {
-      int prevline = (y == 0 ? 0 : src_stride);
-      int nextline = (y == height - 1 || last) ? 0 : src_stride;
+      int prevline = (y == 0 && first) ? 0 : src_stride;
+      int nextline = (y == height - 1 && last) ? 0 : src_stride;
 
       for(x = 0; x < width; x++)
       {
@@ -250,7 +250,7 @@ static void lq2x_generic_packets(void *data,
 
       /* Workers need to know if they can access pixels
        * outside their given buffer. */
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
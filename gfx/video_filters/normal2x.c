@@ -75,8 +75,10 @@ static void *normal2x_generic_create(const struct softfilter_config *config,
    if (!filt) {
       return NULL;
    }
-   /* Apparently the code is not thread-safe,
-    * so force single threaded operation... */
+   /* Plain pixel doubling is bound by memory bandwidth, so
+    * splitting the frame across threads gains next to nothing.
+    * Run single threaded, which lets packets() fill only the
+    * first packet. */
    filt->workers = (struct softfilter_thread_data*)calloc(1, sizeof(struct softfilter_thread_data));
    filt->threads = 1;
    filt->in_fmt  = in_fmt;
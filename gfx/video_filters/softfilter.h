@@ -116,7 +116,11 @@ typedef unsigned (*softfilter_query_input_formats_t)(void);
 typedef unsigned (*softfilter_query_output_formats_t)(unsigned input_format);
 
 /* In softfilter_process_t, the softfilter implementation
- * submits work units to a worker thread pool. */
+ * submits work units to a worker thread pool.
+ *
+ * Packets of a frame can run in any order and on any thread of
+ * the pool, so each one has to produce the same output no matter
+ * how the frame was split up. */
 typedef void (*softfilter_work_t)(void *data, void *thread_data);
 struct softfilter_work_packet
 {
@@ -128,7 +132,10 @@ struct softfilter_work_packet
  * maximum possible input size.
  *
  * Input sizes can very per call to softfilter_process_t, but they
- * will never be larger than the maximum. */
+ * will never be larger than the maximum.
+ *
+ * threads is the number of work packets the frame should be split
+ * into. It is usually a few times the number of worker threads. */
 typedef void *(*softfilter_create_t)(const struct softfilter_config *config,
       unsigned in_fmt, unsigned out_fmt,
       unsigned max_width, unsigned max_height,
@@ -154,9 +161,9 @@ typedef void (*softfilter_get_work_packets_t)(void *data,
       void *output, size_t output_stride,
       const void *input, unsigned width, unsigned height, size_t input_stride);
 
-/* Returns the number of worker threads the filter will use.
+/* Returns the number of work packets the filter submits per frame.
  * This can differ from the value passed to create() instead the filter
- * cannot be parallelized, etc. The number of threads must be less-or-equal
+ * cannot be parallelized, etc. The number of packets must be less-or-equal
  * compared to the value passed to create(). */
 typedef unsigned (*softfilter_query_num_threads_t)(void *data);
 
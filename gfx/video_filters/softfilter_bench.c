@@ -0,0 +1,222 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2018 - The RetroArch team
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs every filter config in this directory through the frontend's
+ * softfilter code over a synthetic frame, once for each thread count
+ * up to the number of cores, or the given maximum. Reports the throughput in output
+ * megapixels per second and whether the output matches the single
+ * threaded run. Build with 'make bench' and run from this directory.
+ *
+ * Usage: softfilter_bench [width] [height] [frames] [max threads] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#include <boolean.h>
+#include <features/features_cpu.h>
+
+#include "../video_filter.h"
+
+/* Filters read a couple of pixels past the frame on every side */
+#define BENCH_BORDER 4
+
+static const char *bench_filters[] = {
+   "Blargg_NTSC_SNES_Composite.filt",
+   "2xBR.filt",
+   "2xSaI.filt",
+   "Darken.filt",
+   "EPX.filt",
+   "LQ2x.filt",
+   "Normal2x.filt",
+   "Phosphor2x.filt",
+   "Scale2x.filt",
+   "Scanline2x.filt",
+   "Super2xSaI.filt",
+   "SuperEagle.filt",
+};
+
+static const struct
+{
+   const char *name;
+   enum retro_pixel_format fmt;
+   unsigned bpp;
+} bench_formats[] = {
+   { "RGB565",   RETRO_PIXEL_FORMAT_RGB565,   2 },
+   { "XRGB8888", RETRO_PIXEL_FORMAT_XRGB8888, 4 },
+};
+
+/* video_filter.c logs through these */
+void RARCH_LOG(const char *fmt, ...) { (void)fmt; }
+void RARCH_WARN(const char *fmt, ...) { (void)fmt; }
+void RARCH_ERR(const char *fmt, ...) { (void)fmt; }
+
+/* Flat areas with hard edges between them, so the edge detecting
+ * filters take all of their paths. */
+static void bench_fill(uint8_t *frame, size_t pitch, unsigned bpp,
+      unsigned width, unsigned height)
+{
+   static const uint32_t palette[8] = {
+      0x000000, 0xffffff, 0xff0000, 0x00ff00,
+      0x0000ff, 0xffff00, 0x808080, 0x104080,
+   };
+   unsigned x, y;
+
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         uint32_t hash  = ((x / 3) * 73856093u) ^ ((y / 2) * 19349663u);
+         uint32_t color = palette[(hash >> 7) & 7];
+
+         if (bpp == 2)
+            ((uint16_t*)(frame + y * pitch))[x] = (uint16_t)(
+                  ((color >> 8) & 0xf800) | ((color >> 5) & 0x07e0)
+                  | ((color >> 3) & 0x001f));
+         else
+            ((uint32_t*)(frame + y * pitch))[x] = color;
+      }
+   }
+}
+
+/* Returns output megapixels per second, or 0 if the filter
+ * does not take this format. */
+static double bench_run(const char *path, unsigned f, unsigned threads,
+      const uint8_t *in, size_t in_pitch, unsigned width, unsigned height,
+      unsigned frames, uint8_t *out, size_t out_pitch,
+      unsigned *out_width, unsigned *out_height, unsigned *out_bpp)
+{
+   unsigned i;
+   retro_time_t start, total;
+   rarch_softfilter_t *filt = rarch_softfilter_new(path, threads,
+         bench_formats[f].fmt, width, height);
+
+   if (!filt)
+      return 0.0;
+
+   rarch_softfilter_get_output_size(filt, out_width, out_height,
+         width, height);
+   *out_bpp = rarch_softfilter_get_output_format(filt)
+      == RETRO_PIXEL_FORMAT_XRGB8888 ? 4 : 2;
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < frames; i++)
+      rarch_softfilter_process(filt, out, out_pitch,
+            in, width, height, in_pitch);
+   total = cpu_features_get_time_usec() - start;
+
+   rarch_softfilter_free(filt);
+
+   return (double)*out_width * *out_height * frames / (total ? total : 1);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, f, threads;
+   size_t in_pitch, out_pitch, out_size;
+   uint8_t *in_buf, *out, *ref;
+   unsigned width  = 256;
+   unsigned height = 224;
+   unsigned frames = 300;
+   unsigned cores  = cpu_features_get_core_amount();
+
+   if (argc > 1)
+      width  = (unsigned)strtoul(argv[1], NULL, 10);
+   if (argc > 2)
+      height = (unsigned)strtoul(argv[2], NULL, 10);
+   if (argc > 3)
+      frames = (unsigned)strtoul(argv[3], NULL, 10);
+   if (argc > 4)
+      cores  = (unsigned)strtoul(argv[4], NULL, 10);
+
+   if (!width || !height || !frames || !cores)
+   {
+      fprintf(stderr, "Usage: %s [width] [height] [frames] [max threads]\n",
+            argv[0]);
+      return 1;
+   }
+
+   /* Every filter here scales by 2 at most, Blargg NTSC a bit more
+    * horizontally. Leave room for the widest one. */
+   in_pitch  = (width + 2 * BENCH_BORDER) * 4;
+   out_pitch = (width * 4 + 16) * 4;
+   out_size  = out_pitch * height * 2;
+   in_buf    = (uint8_t*)calloc(height + 2 * BENCH_BORDER, in_pitch);
+   out       = (uint8_t*)malloc(out_size);
+   ref       = (uint8_t*)malloc(out_size);
+
+   if (!in_buf || !out || !ref)
+      return 1;
+
+   printf("%ux%u, %u frames, up to %u threads\n\n",
+         width, height, frames, cores);
+   printf("%-32s %-9s %7s %10s %8s %7s\n",
+         "filter", "format", "threads", "Mpix/s", "speedup", "output");
+
+   for (i = 0; i < sizeof(bench_filters) / sizeof(bench_filters[0]); i++)
+   {
+      for (f = 0; f < sizeof(bench_formats) / sizeof(bench_formats[0]); f++)
+      {
+         const uint8_t *in = in_buf + BENCH_BORDER * in_pitch
+            + BENCH_BORDER * bench_formats[f].bpp;
+         double base       = 0.0;
+
+         memset(in_buf, 0, (height + 2 * BENCH_BORDER) * in_pitch);
+         bench_fill((uint8_t*)in, in_pitch, bench_formats[f].bpp,
+               width, height);
+
+         for (threads = 1;; threads = threads * 2 < cores
+               ? threads * 2 : cores)
+         {
+            unsigned y, out_width = 0, out_height = 0, out_bpp = 0;
+            bool same = true;
+            double mpix;
+
+            memset(out, 0, out_size);
+            mpix = bench_run(bench_filters[i], f, threads, in, in_pitch,
+                  width, height, frames, out, out_pitch,
+                  &out_width, &out_height, &out_bpp);
+
+            if (mpix == 0.0)
+               break;
+
+            if (threads == 1)
+            {
+               base = mpix;
+               memcpy(ref, out, out_size);
+            }
+
+            for (y = 0; y < out_height; y++)
+               if (memcmp(out + y * out_pitch, ref + y * out_pitch,
+                        out_width * out_bpp))
+                  same = false;
+
+            printf("%-32s %-9s %7u %10.1f %7.2fx %7s\n",
+                  bench_filters[i], bench_formats[f].name, threads,
+                  mpix, mpix / base, same ? "same" : "DIFFERS");
+
+            if (threads == cores)
+               break;
+         }
+      }
+   }
+
+   free(in_buf);
+   free(out);
+   free(ref);
+   return 0;
+}
@@ -77,7 +77,7 @@ static void *supertwoxsai_generic_create(const struct softfilter_config *config,
    (void)userdata;
 
    filt->workers = (struct softfilter_thread_data*)calloc(threads, sizeof(struct softfilter_thread_data));
-   filt->threads = 1;
+   filt->threads = threads;
    filt->in_fmt  = in_fmt;
 
    if (!filt->workers)
@@ -117,12 +117,12 @@ static void supertwoxsai_generic_destroy(void *data)
 #define supertwoxsai_result(A, B, C, D) (((A) != (C) || (A) != (D)) - ((B) != (C) || (B) != (D)))
 
 #ifndef supertwoxsai_declare_variables
-#define supertwoxsai_declare_variables(typename_t, in, nextline) \
+#define supertwoxsai_declare_variables(typename_t, in, prevline, nextline, nextline2) \
          typename_t product1a, product1b, product2a, product2b; \
-         const typename_t colorB0 = *(in - nextline - 1); \
-         const typename_t colorB1 = *(in - nextline + 0); \
-         const typename_t colorB2 = *(in - nextline + 1); \
-         const typename_t colorB3 = *(in - nextline + 2); \
+         const typename_t colorB0 = *(in - prevline - 1); \
+         const typename_t colorB1 = *(in - prevline + 0); \
+         const typename_t colorB2 = *(in - prevline + 1); \
+         const typename_t colorB3 = *(in - prevline + 2); \
          const typename_t color4  = *(in - 1); \
          const typename_t color5  = *(in + 0); \
          const typename_t color6  = *(in + 1); \
@@ -131,10 +131,10 @@ static void supertwoxsai_generic_destroy(void *data)
          const typename_t color2  = *(in + nextline + 0); \
          const typename_t color3  = *(in + nextline + 1); \
          const typename_t colorS1 = *(in + nextline + 2); \
-         const typename_t colorA0 = *(in + nextline + nextline - 1); \
-         const typename_t colorA1 = *(in + nextline + nextline + 0); \
-         const typename_t colorA2 = *(in + nextline + nextline + 1); \
-         const typename_t colorA3 = *(in + nextline + nextline + 2)
+         const typename_t colorA0 = *(in + nextline2 - 1); \
+         const typename_t colorA1 = *(in + nextline2 + 0); \
+         const typename_t colorA2 = *(in + nextline2 + 1); \
+         const typename_t colorA3 = *(in + nextline2 + 2)
 #endif
 
 #ifndef supertwoxsai_function
@@ -204,17 +204,21 @@ static void supertwoxsai_generic_xrgb8888(unsigned width, unsigned height,
       int first, int last, uint32_t *src,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Clamp the rows reached above and below to the frame */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint32_t *in  = (uint32_t*)src;
       uint32_t *out = (uint32_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supertwoxsai_declare_variables(uint32_t, in, nextline);
+         supertwoxsai_declare_variables(uint32_t, in, prevline, nextline, nextline2);
 
          //---------------------------    B1 B2
          //                             4  5  6 S2
@@ -234,17 +238,21 @@ static void supertwoxsai_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
-   unsigned finish;
-   unsigned nextline = (last) ? 0 : src_stride;
+   unsigned finish, y;
 
-   for (; height; height--)
+   for (y = 0; y < height; y++)
    {
+      /* Clamp the rows reached above and below to the frame */
+      unsigned prevline  = (first && y == 0) ? 0 : src_stride;
+      unsigned nextline  = (last && y + 1 >= height) ? 0 : src_stride;
+      unsigned nextline2 = (last && y + 2 >= height)
+         ? nextline : nextline + src_stride;
       uint16_t *in  = (uint16_t*)src;
       uint16_t *out = (uint16_t*)dst;
 
       for (finish = width; finish; finish -= 1)
       {
-         supertwoxsai_declare_variables(uint16_t, in, nextline);
+         supertwoxsai_declare_variables(uint16_t, in, prevline, nextline, nextline2);
 
          //---------------------------    B1 B2
          //                             4  5  6 S2
@@ -302,8 +310,11 @@ static void supertwoxsai_generic_packets(void *data,
    {
       struct softfilter_thread_data *thr = (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      /* Bands start on even rows, so each one is at least two rows
+       * tall, which is as far as the filter reads past its ends. */
+      unsigned y_start = ((height >> 1) * i / filt->threads) << 1;
+      unsigned y_end   = (i + 1 == filt->threads) ? height
+         : ((height >> 1) * (i + 1) / filt->threads) << 1;
       thr->out_data = (uint8_t*)output + y_start * SUPERTWOXSAI_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
@@ -312,7 +323,7 @@ static void supertwoxsai_generic_packets(void *data,
       thr->height = y_end - y_start;
 
       // Workers need to know if they can access pixels outside their given buffer.
-      thr->first = y_start;
+      thr->first = y_start == 0;
       thr->last = y_end == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
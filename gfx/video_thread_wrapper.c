@@ -145,6 +145,20 @@ struct thread_packet
    } data;
 };
 
+/* One of the three frame buffers handed from the user
+ * thread to the driver thread. */
+struct thread_frame
+{
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   uint64_t count;
+   /* No new data, the driver redraws what it has */
+   bool dupe;
+   char msg[255];
+};
+
 struct thread_video
 {
    slock_t *lock;
@@ -202,17 +216,21 @@ struct thread_video
    struct video_viewport vp;
    struct video_viewport read_vp; /* Last viewport reported to caller. */
 
+   /* Triple buffered: the user thread fills the write buffer
+    * while the driver thread draws the read buffer, and the
+    * newest complete frame waits in the ready buffer. Filling and
+    * drawing happen without a lock, only swapping the indices
+    * takes thr->lock. */
    struct
    {
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
+      struct thread_frame buffers[3];
+      unsigned write;
+      unsigned ready;
+      unsigned read;
+      /* The ready buffer holds a frame that hasn't been drawn */
       bool updated;
       bool within_thread;
-      uint64_t count;
-      char msg[255];
    } frame;
 
    video_driver_t video_thread;
@@ -568,7 +586,15 @@ static void video_thread_loop(void *data)
       while (thr->send_cmd == CMD_VIDEO_NONE && !thr->frame.updated)
          scond_wait(thr->cond_thread, thr->lock);
       if (thr->frame.updated)
-         updated = true;
+      {
+         /* Take the newest frame and hand back the one drawn last */
+         unsigned read      = thr->frame.read;
+         thr->frame.read    = thr->frame.ready;
+         thr->frame.ready   = read;
+         thr->frame.updated = false;
+         updated            = true;
+         scond_signal(thr->cond_cmd);
+      }
 
       /* To avoid race condition where send_cmd is updated
        * right after the switch is checked. */
@@ -582,6 +608,7 @@ static void video_thread_loop(void *data)
       if (updated)
       {
          struct video_viewport vp;
+         struct thread_frame *frame = &thr->frame.buffers[thr->frame.read];
          bool                 ret = false;
          bool               alive = false;
          bool               focus = false;
@@ -604,9 +631,9 @@ static void video_thread_loop(void *data)
             video_driver_build_info(&video_info);
 
             ret = thr->driver->frame(thr->driver_data,
-                  thr->frame.buffer, thr->frame.width, thr->frame.height,
-                  thr->frame.count,
-                  thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL,
+                  frame->dupe ? NULL : frame->buffer,
+                  frame->width, frame->height, frame->count,
+                  frame->pitch, *frame->msg ? frame->msg : NULL,
                   &video_info);
          }
 
@@ -628,7 +655,6 @@ static void video_thread_loop(void *data)
          thr->alive         = alive;
          thr->focus         = focus;
          thr->has_windowed  = has_windowed;
-         thr->frame.updated = false;
          thr->vp            = vp;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
@@ -697,6 +723,7 @@ static bool video_thread_frame(void *data, const void *frame_,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
    unsigned copy_stride;
+   struct thread_frame *frame          = NULL;
    const uint8_t *src                  = NULL;
    uint8_t *dst                        = NULL;
    thread_video_t *thr                 = (thread_video_t*)data;
@@ -716,8 +743,29 @@ static bool video_thread_frame(void *data, const void *frame_,
    copy_stride = width * (thr->info.rgb32
          ? sizeof(uint32_t) : sizeof(uint16_t));
 
-   src = (const uint8_t*)frame_;
-   dst = thr->frame.buffer;
+   /* The write buffer belongs to this thread, so it is
+    * filled in without holding any lock. */
+   frame       = &thr->frame.buffers[thr->frame.write];
+   src         = (const uint8_t*)frame_;
+   dst         = frame->buffer;
+
+   if (src)
+   {
+      unsigned h;
+      for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
+         memcpy(dst, src, copy_stride);
+   }
+
+   frame->dupe   = !src;
+   frame->width  = width;
+   frame->height = height;
+   frame->count  = frame_count;
+   frame->pitch  = copy_stride;
+
+   if (msg)
+      strlcpy(frame->msg, msg, sizeof(frame->msg));
+   else
+      *frame->msg = '\0';
 
    slock_lock(thr->lock);
 
@@ -742,27 +790,23 @@ static bool video_thread_frame(void *data, const void *frame_,
       }
    }
 
-   /* Drop frame if updated flag is still set, as thread is
-    * still working on last frame. */
-   if (!thr->frame.updated)
+   /* A dupe has nothing newer to show than a frame that is
+    * still waiting to be drawn. */
+   if (!(frame->dupe && thr->frame.updated))
    {
-      if (src)
-      {
-         unsigned h;
-         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
-      }
-
-      thr->frame.updated = true;
-      thr->frame.width  = width;
-      thr->frame.height = height;
-      thr->frame.count  = frame_count;
-      thr->frame.pitch  = copy_stride;
+      /* If the thread is still working on the last frame, the
+       * waiting one is dropped in favour of this newer one. */
+      unsigned ready;
 
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
+      if (thr->frame.updated)
+         thr->miss_count++;
       else
-         *thr->frame.msg = '\0';
+         thr->hit_count++;
+
+      ready              = thr->frame.ready;
+      thr->frame.ready   = thr->frame.write;
+      thr->frame.write   = ready;
+      thr->frame.updated = true;
 
       scond_signal(thr->cond_thread);
 
@@ -773,10 +817,7 @@ static bool video_thread_frame(void *data, const void *frame_,
             scond_wait(thr->cond_cmd, thr->lock);
       }
 #endif
-      thr->hit_count++;
    }
-   else
-      thr->miss_count++;
 
    slock_unlock(thr->lock);
 
@@ -795,6 +836,7 @@ static bool video_thread_init(thread_video_t *thr,
       const video_info_t info,
       input_driver_t **input, void **input_data)
 {
+   unsigned i;
    size_t max_size;
    thread_packet_t pkt = {CMD_INIT};
 
@@ -814,12 +856,21 @@ static bool video_thread_init(thread_video_t *thr,
    max_size                  = info.input_scale * RARCH_SCALE_BASE;
    max_size                 *= max_size;
    max_size                 *= info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
-   thr->frame.buffer         = (uint8_t*)malloc(max_size);
 
-   if (!thr->frame.buffer)
-      return false;
+   for (i = 0; i < ARRAY_SIZE(thr->frame.buffers); i++)
+   {
+      uint8_t *buffer = (uint8_t*)malloc(max_size);
 
-   memset(thr->frame.buffer, 0x80, max_size);
+      if (!buffer)
+         return false;
+
+      memset(buffer, 0x80, max_size);
+      thr->frame.buffers[i].buffer = buffer;
+   }
+
+   thr->frame.write          = 0;
+   thr->frame.ready          = 1;
+   thr->frame.read           = 2;
 
    thr->last_time            = cpu_features_get_time_usec();
    thr->thread               = sthread_create(video_thread_loop, thr);
@@ -916,6 +967,7 @@ static bool video_thread_read_viewport(void *data, uint8_t *buffer, bool is_idle
 
 static void video_thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
    thread_packet_t pkt = { CMD_FREE };
 
@@ -929,7 +981,8 @@ static void video_thread_free(void *data)
 #if defined(HAVE_MENU)
    free(thr->texture.frame);
 #endif
-   free(thr->frame.buffer);
+   for (i = 0; i < ARRAY_SIZE(thr->frame.buffers); i++)
+      free(thr->frame.buffers[i].buffer);
    slock_free(thr->frame.lock);
    slock_free(thr->lock);
    scond_free(thr->cond_cmd);
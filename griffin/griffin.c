@@ -747,6 +747,7 @@ INPUT (HID)
 FIFO BUFFER
 ============================================================ */
 #include "../libretro-common/queues/fifo_queue.c"
+#include "../libretro-common/queues/spsc_queue.c"
 
 /*============================================================
 AUDIO RESAMPLER
@@ -1963,6 +1963,8 @@ MSG_HASH(MENU_ENUM_LABEL_VIDEO_3DS_DISPLAY_MODE,
 #endif
 MSG_HASH(MENU_ENUM_LABEL_PLAYLIST_USE_OLD_FORMAT,
       "playlist_use_old_format")
+MSG_HASH(MENU_ENUM_LABEL_PLAYLIST_USE_JOURNAL,
+      "playlist_use_journal")
 MSG_HASH(MENU_ENUM_LABEL_MENU_SOUND_OK,
       "menu_sound_ok")
 MSG_HASH(MENU_ENUM_LABEL_MENU_SOUND_CANCEL,
@@ -1999,6 +2001,8 @@ MSG_HASH(MENU_ENUM_LABEL_VIDEO_SHADERS_ENABLE,
       "video_shader_enable")
 MSG_HASH(MENU_ENUM_LABEL_SCAN_WITHOUT_CORE_MATCH,
       "scan_without_core_match")
+MSG_HASH(MENU_ENUM_LABEL_SCAN_WORKER_THREADS,
+      "scan_worker_threads")
 MSG_HASH(MENU_ENUM_LABEL_MENU_XMB_ANIMATION_HORIZONTAL_HIGHLIGHT,
       "xmb_menu_animation_horizontal_highlight")
 MSG_HASH(MENU_ENUM_LABEL_MENU_XMB_ANIMATION_MOVE_UP_DOWN,
@@ -8875,6 +8875,14 @@ MSG_HASH(
     MENU_ENUM_LABEL_VALUE_PLAYLIST_USE_OLD_FORMAT,
     "Save playlists using old format"
     )
+MSG_HASH(
+    MENU_ENUM_LABEL_VALUE_PLAYLIST_USE_JOURNAL,
+    "Save playlist changes to a journal"
+    )
+MSG_HASH(
+    MENU_ENUM_SUBLABEL_PLAYLIST_USE_JOURNAL,
+    "Append playlist changes to a journal file next to the playlist instead of rewriting the whole playlist each time. The journal is merged back into the playlist once it grows large, and when the playlist is closed. Not used when saving playlists in the old format."
+    )
 MSG_HASH(
     MENU_ENUM_LABEL_VALUE_PLAYLIST_SHOW_INLINE_CORE_NAME,
     "Show associated cores in playlists"
@@ -9075,6 +9083,10 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_SCAN_WITHOUT_CORE_MATCH,
       "Scan without core match")
 MSG_HASH(MENU_ENUM_SUBLABEL_SCAN_WITHOUT_CORE_MATCH,
       "When disabled, content is only added to playlists if you have a core installed that supports its extension. By enabling this, it will add to playlist regardless. This way, you can install the core you need later on after scanning.")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_SCAN_WORKER_THREADS,
+      "Scan Hashing Threads")
+MSG_HASH(MENU_ENUM_SUBLABEL_SCAN_WORKER_THREADS,
+      "Number of threads used to read and checksum files while scanning content. 0 uses one thread per CPU core.")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_MENU_XMB_ANIMATION_HORIZONTAL_HIGHLIGHT,
       "Animation Horizontal Icon Highlight")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_MENU_XMB_ANIMATION_MOVE_UP_DOWN,
@@ -25,6 +25,8 @@
 
 #include <formats/rwav.h>
 #include <memalign.h>
+#include <retro_inline.h>
+#include <queues/spsc_queue.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -59,9 +61,22 @@
 #include <ibxm/ibxm.h>
 #endif
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #define AUDIO_MIXER_MAX_VOICES      8
 #define AUDIO_MIXER_TEMP_BUFFER 8192
 
+/* How much PCM streamed voices keep decoded ahead of the mixer */
+#define AUDIO_MIXER_DECODE_AHEAD_MS 200
+
 struct audio_mixer_sound
 {
    enum audio_mixer_type type;
@@ -121,6 +136,23 @@ struct audio_mixer_voice
    audio_mixer_sound_t *sound;
    audio_mixer_stop_cb_t stop_cb;
 
+   /* Everything but WAV is decoded ahead into this ring, as float
+    * PCM at the mixer rate, so mixing is only a gain and a sum.
+    * With threads a worker keeps it filled, otherwise the mixer
+    * tops it up itself. */
+   spsc_buffer_t *ring;
+   float   *decode_buffer;
+   /* Most bytes a single decode step can produce */
+   size_t   chunk_size;
+   unsigned underruns;
+   /* Owned by the decoder, changed under s_decode_lock */
+   bool     decoding;
+   bool     decode_done;
+   /* Times the decoder went back to the start, changed under
+    * s_decode_lock, and how many of those were reported to stop_cb */
+   unsigned loops;
+   unsigned loops_reported;
+
    union
    {
       struct
@@ -131,8 +163,6 @@ struct audio_mixer_voice
 #ifdef HAVE_STB_VORBIS
       struct
       {
-         unsigned    position;
-         unsigned    samples;
          unsigned    buf_samples;
          float*      buffer;
          float       ratio;
@@ -145,8 +175,6 @@ struct audio_mixer_voice
 #ifdef HAVE_DR_FLAC
       struct
       {
-         unsigned    position;
-         unsigned    samples;
          unsigned    buf_samples;
          float*      buffer;
          float       ratio;
@@ -159,8 +187,6 @@ struct audio_mixer_voice
 #ifdef HAVE_DR_MP3
       struct
       {
-         unsigned    position;
-         unsigned    samples;
          unsigned    buf_samples;
          float*      buffer;
          float       ratio;
@@ -173,8 +199,6 @@ struct audio_mixer_voice
 #ifdef HAVE_IBXM
       struct
       {
-         unsigned          position;
-         unsigned          samples;
          unsigned          buf_samples;
          int*              buffer;
          struct replay*    stream;
@@ -187,6 +211,13 @@ struct audio_mixer_voice
 static struct audio_mixer_voice s_voices[AUDIO_MIXER_MAX_VOICES] = {{0}};
 static unsigned s_rate = 0;
 
+#ifdef HAVE_THREADS
+static sthread_t *s_decode_thread = NULL;
+static slock_t   *s_decode_lock   = NULL;
+static scond_t   *s_decode_cond   = NULL;
+static bool       s_decode_quit   = false;
+#endif
+
 static bool wav2float(const rwav_t* wav, float** pcm, size_t samples_out)
 {
    size_t i;
@@ -314,8 +345,37 @@ void audio_mixer_done(void)
 {
    unsigned i;
 
+#ifdef HAVE_THREADS
+   if (s_decode_thread)
+   {
+      slock_lock(s_decode_lock);
+      s_decode_quit = true;
+      scond_signal(s_decode_cond);
+      slock_unlock(s_decode_lock);
+
+      sthread_join(s_decode_thread);
+      scond_free(s_decode_cond);
+      slock_free(s_decode_lock);
+
+      s_decode_thread = NULL;
+      s_decode_cond   = NULL;
+      s_decode_lock   = NULL;
+      s_decode_quit   = false;
+   }
+#endif
+
    for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++)
+   {
       s_voices[i].type = AUDIO_MIXER_TYPE_NONE;
+
+      spsc_free(s_voices[i].ring);
+      if (s_voices[i].decode_buffer)
+         memalign_free(s_voices[i].decode_buffer);
+
+      s_voices[i].ring          = NULL;
+      s_voices[i].decode_buffer = NULL;
+      s_voices[i].chunk_size    = 0;
+   }
 }
 
 audio_mixer_sound_t* audio_mixer_load_wav(void *buffer, int32_t size)
@@ -527,7 +587,8 @@ static bool audio_mixer_play_ogg(
          goto error;
    }
 
-   samples                         = (unsigned)(AUDIO_MIXER_TEMP_BUFFER * ratio);
+   /* Resamplers can return a few frames more than the ratio says */
+   samples                         = (unsigned)(AUDIO_MIXER_TEMP_BUFFER * ratio) + 16;
    ogg_buffer                      = (float*)memalign_alloc(16,
          ((samples + 15) & ~15) * sizeof(float));
 
@@ -551,9 +612,8 @@ static bool audio_mixer_play_ogg(
    voice->types.ogg.buffer         = (float*)ogg_buffer;
    voice->types.ogg.buf_samples    = samples;
    voice->types.ogg.ratio          = ratio;
+   voice->chunk_size               = samples * sizeof(float);
    voice->types.ogg.stream         = stb_vorbis;
-   voice->types.ogg.position       = 0;
-   voice->types.ogg.samples        = 0;
 
    return true;
 
@@ -627,8 +687,7 @@ static bool audio_mixer_play_mod(
    voice->types.mod.buffer         = (int*)mod_buffer;
    voice->types.mod.buf_samples    = buf_samples;
    voice->types.mod.stream         = replay;
-   voice->types.mod.position       = 0;
-   voice->types.mod.samples        = 0; /* samples; */
+   voice->chunk_size               = buf_samples * sizeof(float);
 
    return true;
 
@@ -668,7 +727,8 @@ static bool audio_mixer_play_flac(
          goto error;
    }
 
-   samples                         = (unsigned)(AUDIO_MIXER_TEMP_BUFFER * ratio);
+   /* Resamplers can return a few frames more than the ratio says */
+   samples                         = (unsigned)(AUDIO_MIXER_TEMP_BUFFER * ratio) + 16;
    flac_buffer                      = (float*)memalign_alloc(16,
          ((samples + 15) & ~15) * sizeof(float));
 
@@ -691,9 +751,8 @@ static bool audio_mixer_play_flac(
    voice->types.flac.buffer         = (float*)flac_buffer;
    voice->types.flac.buf_samples    = samples;
    voice->types.flac.ratio          = ratio;
+   voice->chunk_size               = samples * sizeof(float);
    voice->types.flac.stream         = dr_flac;
-   voice->types.flac.position       = 0;
-   voice->types.flac.samples        = 0;
 
    return true;
 
@@ -738,7 +797,8 @@ static bool audio_mixer_play_mp3(
          goto error;
    }
 
-   samples                         = (unsigned)(AUDIO_MIXER_TEMP_BUFFER * ratio);
+   /* Resamplers can return a few frames more than the ratio says */
+   samples                         = (unsigned)(AUDIO_MIXER_TEMP_BUFFER * ratio) + 16;
    mp3_buffer                      = (float*)memalign_alloc(16,
          ((samples + 15) & ~15) * sizeof(float));
 
@@ -760,8 +820,7 @@ static bool audio_mixer_play_mp3(
    voice->types.mp3.buffer         = (float*)mp3_buffer;
    voice->types.mp3.buf_samples    = samples;
    voice->types.mp3.ratio          = ratio;
-   voice->types.mp3.position       = 0;
-   voice->types.mp3.samples        = 0;
+   voice->chunk_size               = samples * sizeof(float);
 
    return true;
 
@@ -771,6 +830,330 @@ error:
 }
 #endif
 
+static INLINE bool audio_mixer_decode_threaded(void)
+{
+#ifdef HAVE_THREADS
+   return s_decode_thread != NULL;
+#else
+   return false;
+#endif
+}
+
+#if defined(HAVE_STB_VORBIS) || defined(HAVE_DR_FLAC) || \
+    defined(HAVE_DR_MP3)     || defined(HAVE_IBXM)
+/* Resamples what was just decoded if needed and queues it up */
+static void audio_mixer_voice_write(audio_mixer_voice_t* voice,
+      const float *pcm, unsigned samples, float *buffer, float ratio,
+      const retro_resampler_t *resampler, void *resampler_data)
+{
+   if (resampler)
+   {
+      struct resampler_data info;
+
+      info.data_in              = pcm;
+      info.data_out             = buffer;
+      info.input_frames         = samples / 2;
+      info.output_frames        = 0;
+      info.ratio                = ratio;
+
+      resampler->process(resampler_data, &info);
+
+      pcm                       = buffer;
+      samples                   = (unsigned)(info.output_frames * 2);
+   }
+
+   spsc_write(voice->ring, pcm, samples * sizeof(float));
+}
+#endif
+
+/* Decodes the next block of a streamed voice into decode_buffer
+ * (the replay buffer for MOD) and returns its size in samples,
+ * or 0 at the end of the sound. */
+static unsigned audio_mixer_voice_read(audio_mixer_voice_t* voice,
+      enum audio_mixer_type type)
+{
+   switch (type)
+   {
+      case AUDIO_MIXER_TYPE_OGG:
+#ifdef HAVE_STB_VORBIS
+         return stb_vorbis_get_samples_float_interleaved(
+               voice->types.ogg.stream, 2, voice->decode_buffer,
+               AUDIO_MIXER_TEMP_BUFFER) * 2;
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_MOD:
+#ifdef HAVE_IBXM
+         return replay_get_audio(
+               voice->types.mod.stream, voice->types.mod.buffer) * 2;
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_FLAC:
+#ifdef HAVE_DR_FLAC
+         return (unsigned)drflac_read_f32(voice->types.flac.stream,
+               AUDIO_MIXER_TEMP_BUFFER, voice->decode_buffer);
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_MP3:
+#ifdef HAVE_DR_MP3
+         return (unsigned)drmp3_read_f32(&voice->types.mp3.stream,
+               AUDIO_MIXER_TEMP_BUFFER / 2, voice->decode_buffer) * 2;
+#else
+         break;
+#endif
+      case AUDIO_MIXER_TYPE_WAV:
+      case AUDIO_MIXER_TYPE_NONE:
+         break;
+   }
+
+   return 0;
+}
+
+static void audio_mixer_voice_rewind(audio_mixer_voice_t* voice,
+      enum audio_mixer_type type)
+{
+   switch (type)
+   {
+      case AUDIO_MIXER_TYPE_OGG:
+#ifdef HAVE_STB_VORBIS
+         stb_vorbis_seek_start(voice->types.ogg.stream);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_MOD:
+#ifdef HAVE_IBXM
+         replay_seek(voice->types.mod.stream, 0);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_FLAC:
+#ifdef HAVE_DR_FLAC
+         drflac_seek_to_sample(voice->types.flac.stream, 0);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_MP3:
+#ifdef HAVE_DR_MP3
+         drmp3_seek_to_frame(&voice->types.mp3.stream, 0);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_WAV:
+      case AUDIO_MIXER_TYPE_NONE:
+         break;
+   }
+}
+
+/* Decodes one block of a streamed voice into its ring, which must
+ * have chunk_size bytes free. Sets looped if it went back to the
+ * start. Returns false once a sound that doesn't repeat has been
+ * decoded completely. */
+static bool audio_mixer_voice_decode(audio_mixer_voice_t* voice,
+      enum audio_mixer_type type, bool *looped)
+{
+   unsigned samples = audio_mixer_voice_read(voice, type);
+
+   *looped          = false;
+
+   if (samples == 0)
+   {
+      if (!voice->repeat)
+         return false;
+
+      audio_mixer_voice_rewind(voice, type);
+
+      /* Don't spin forever on an empty stream */
+      if ((samples = audio_mixer_voice_read(voice, type)) == 0)
+         return false;
+
+      *looped = true;
+   }
+
+   switch (type)
+   {
+      case AUDIO_MIXER_TYPE_OGG:
+#ifdef HAVE_STB_VORBIS
+         audio_mixer_voice_write(voice, voice->decode_buffer, samples,
+               voice->types.ogg.buffer, voice->types.ogg.ratio,
+               voice->types.ogg.resampler,
+               voice->types.ogg.resampler_data);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_MOD:
+#ifdef HAVE_IBXM
+         {
+            unsigned i;
+            const int *pcm = voice->types.mod.buffer;
+
+            while (samples)
+            {
+               unsigned count = samples < AUDIO_MIXER_TEMP_BUFFER
+                  ? samples : AUDIO_MIXER_TEMP_BUFFER;
+
+               for (i = 0; i < count; i++)
+               {
+                  float samplef      = (float)(*pcm++ + 32768) / 65535.0f;
+                  voice->decode_buffer[i] = samplef * 2.0f - 1.0f;
+               }
+
+               audio_mixer_voice_write(voice, voice->decode_buffer, count,
+                     NULL, 1.0f, NULL, NULL);
+               samples -= count;
+            }
+         }
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_FLAC:
+#ifdef HAVE_DR_FLAC
+         audio_mixer_voice_write(voice, voice->decode_buffer, samples,
+               voice->types.flac.buffer, voice->types.flac.ratio,
+               voice->types.flac.resampler,
+               voice->types.flac.resampler_data);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_MP3:
+#ifdef HAVE_DR_MP3
+         audio_mixer_voice_write(voice, voice->decode_buffer, samples,
+               voice->types.mp3.buffer, voice->types.mp3.ratio,
+               voice->types.mp3.resampler,
+               voice->types.mp3.resampler_data);
+#endif
+         break;
+      case AUDIO_MIXER_TYPE_WAV:
+      case AUDIO_MIXER_TYPE_NONE:
+         break;
+   }
+
+   return true;
+}
+
+#ifdef HAVE_THREADS
+/* Keeps the rings of all streamed voices topped up, starting with
+ * whichever has the least buffered. Only holds the lock while
+ * looking for work, never while decoding. */
+static void audio_mixer_decode_thread(void *data)
+{
+   slock_lock(s_decode_lock);
+
+   while (!s_decode_quit)
+   {
+      unsigned i;
+      bool decoded;
+      bool looped;
+      size_t most_free           = 0;
+      audio_mixer_voice_t *voice = NULL;
+
+      for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++)
+      {
+         size_t write_avail;
+         audio_mixer_voice_t *v = &s_voices[i];
+
+         if (     v->type == AUDIO_MIXER_TYPE_NONE
+               || v->type == AUDIO_MIXER_TYPE_WAV
+               || v->decode_done)
+            continue;
+
+         write_avail = spsc_write_avail(v->ring);
+
+         if (write_avail >= v->chunk_size && write_avail > most_free)
+         {
+            most_free = write_avail;
+            voice     = v;
+         }
+      }
+
+      if (!voice)
+      {
+         scond_wait(s_decode_cond, s_decode_lock);
+         continue;
+      }
+
+      voice->decoding    = true;
+      slock_unlock(s_decode_lock);
+
+      decoded            = audio_mixer_voice_decode(voice,
+            (enum audio_mixer_type)voice->type, &looped);
+
+      slock_lock(s_decode_lock);
+      voice->decoding    = false;
+      voice->decode_done = !decoded;
+      if (looped)
+         voice->loops++;
+      scond_broadcast(s_decode_cond);
+   }
+
+   slock_unlock(s_decode_lock);
+}
+
+static bool audio_mixer_decode_thread_start(void)
+{
+   s_decode_lock   = slock_new();
+   s_decode_cond   = scond_new();
+
+   if (s_decode_lock && s_decode_cond)
+      s_decode_thread = sthread_create(audio_mixer_decode_thread, NULL);
+
+   if (s_decode_thread)
+      return true;
+
+   /* The mixer will decode by itself */
+   if (s_decode_cond)
+      scond_free(s_decode_cond);
+   if (s_decode_lock)
+      slock_free(s_decode_lock);
+   s_decode_cond   = NULL;
+   s_decode_lock   = NULL;
+   return false;
+}
+#endif
+
+/* Sets up the ring of a streamed voice and decodes the first
+ * block, so it doesn't start out with an underrun. */
+static bool audio_mixer_voice_prepare(audio_mixer_voice_t* voice,
+      enum audio_mixer_type type)
+{
+   bool looped;
+   size_t size = ((size_t)s_rate * AUDIO_MIXER_DECODE_AHEAD_MS / 1000)
+      * 2 * sizeof(float) + voice->chunk_size;
+
+   /* Whole frames only */
+   size        = (size + 7) & ~(size_t)7;
+
+   if (voice->ring && voice->ring->size < size)
+   {
+      spsc_free(voice->ring);
+      voice->ring = NULL;
+   }
+
+   if (!voice->ring)
+   {
+      if (!(voice->ring = spsc_new(size)))
+         return false;
+   }
+   else
+      spsc_read_commit(voice->ring, spsc_read_avail(voice->ring));
+
+   if (!voice->decode_buffer)
+   {
+      voice->decode_buffer = (float*)memalign_alloc(16,
+            AUDIO_MIXER_TEMP_BUFFER * sizeof(float));
+
+      if (!voice->decode_buffer)
+         return false;
+   }
+
+   voice->underruns      = 0;
+   voice->loops_reported = 0;
+   voice->decoding       = false;
+   voice->decode_done    = !audio_mixer_voice_decode(voice, type, &looped);
+   voice->loops          = looped ? 1 : 0;
+
+#ifdef HAVE_THREADS
+   if (!s_decode_thread)
+      audio_mixer_decode_thread_start();
+#endif
+
+   return true;
+}
+
 audio_mixer_voice_t* audio_mixer_play(audio_mixer_sound_t* sound, bool repeat,
       float volume, audio_mixer_stop_cb_t stop_cb)
 {
@@ -818,16 +1201,28 @@ audio_mixer_voice_t* audio_mixer_play(audio_mixer_sound_t* sound, bool repeat,
       break;
    }
 
-   if (res)
-   {
-      voice->type     = sound->type;
-      voice->repeat   = repeat;
-      voice->volume   = volume;
-      voice->sound    = sound;
-      voice->stop_cb  = stop_cb;
-   }
-   else
-      voice = NULL;
+   if (!res)
+      return NULL;
+
+   voice->repeat   = repeat;
+   voice->volume   = volume;
+   voice->sound    = sound;
+   voice->stop_cb  = stop_cb;
+
+   /* Nobody looks at the voice until it has a type */
+   if (     sound->type != AUDIO_MIXER_TYPE_WAV
+         && !audio_mixer_voice_prepare(voice, sound->type))
+      return NULL;
+
+#ifdef HAVE_THREADS
+   slock_lock(s_decode_lock);
+   voice->type     = sound->type;
+   if (s_decode_thread)
+      scond_signal(s_decode_cond);
+   slock_unlock(s_decode_lock);
+#else
+   voice->type     = sound->type;
+#endif
 
    return voice;
 }
@@ -842,18 +1237,78 @@ void audio_mixer_stop(audio_mixer_voice_t* voice)
       stop_cb = voice->stop_cb;
       sound   = voice->sound;
 
+#ifdef HAVE_THREADS
+      slock_lock(s_decode_lock);
+      while (voice->decoding)
+         scond_wait(s_decode_cond, s_decode_lock);
+      voice->type = AUDIO_MIXER_TYPE_NONE;
+      slock_unlock(s_decode_lock);
+#else
       voice->type = AUDIO_MIXER_TYPE_NONE;
+#endif
 
       if (stop_cb)
          stop_cb(sound, AUDIO_MIXER_SOUND_STOPPED);
    }
 }
 
+/* buffer += pcm * volume */
+static void audio_mixer_add(float* buffer, const float* pcm,
+      size_t samples, float volume)
+{
+   size_t i = 0;
+
+#if defined(__SSE__)
+   __m128 vol = _mm_set1_ps(volume);
+
+   for (; i + 4 <= samples; i += 4)
+      _mm_storeu_ps(buffer + i, _mm_add_ps(_mm_loadu_ps(buffer + i),
+               _mm_mul_ps(_mm_loadu_ps(pcm + i), vol)));
+#elif defined(__ARM_NEON)
+   float32x4_t vol = vdupq_n_f32(volume);
+
+   for (; i + 4 <= samples; i += 4)
+      vst1q_f32(buffer + i, vmlaq_f32(vld1q_f32(buffer + i),
+               vld1q_f32(pcm + i), vol));
+#endif
+
+   for (; i < samples; i++)
+      buffer[i] += pcm[i] * volume;
+}
+
+static void audio_mixer_clamp(float* buffer, size_t samples)
+{
+   size_t i = 0;
+
+#if defined(__SSE__)
+   __m128 min = _mm_set1_ps(-1.0f);
+   __m128 max = _mm_set1_ps(1.0f);
+
+   for (; i + 4 <= samples; i += 4)
+      _mm_storeu_ps(buffer + i,
+            _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buffer + i), min), max));
+#elif defined(__ARM_NEON)
+   float32x4_t min = vdupq_n_f32(-1.0f);
+   float32x4_t max = vdupq_n_f32(1.0f);
+
+   for (; i + 4 <= samples; i += 4)
+      vst1q_f32(buffer + i,
+            vminq_f32(vmaxq_f32(vld1q_f32(buffer + i), min), max));
+#endif
+
+   for (; i < samples; i++)
+   {
+      if (buffer[i] < -1.0f)
+         buffer[i] = -1.0f;
+      else if (buffer[i] > 1.0f)
+         buffer[i] = 1.0f;
+   }
+}
+
 static void audio_mixer_mix_wav(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
       float volume)
 {
-   int i;
    unsigned buf_free                = (unsigned)(num_frames * 2);
    const audio_mixer_sound_t* sound = voice->sound;
    unsigned pcm_available           = sound->types.wav.frames
@@ -864,8 +1319,8 @@ static void audio_mixer_mix_wav(float* buffer, size_t num_frames,
 again:
    if (pcm_available < buf_free)
    {
-      for (i = pcm_available; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mixer_add(buffer, pcm, pcm_available, volume);
+      buffer += pcm_available;
 
       if (voice->repeat)
       {
@@ -886,317 +1341,98 @@ again:
    }
    else
    {
-      for (i = buf_free; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+      audio_mixer_add(buffer, pcm, buf_free, volume);
 
       voice->types.wav.position += buf_free;
    }
 }
 
-#ifdef HAVE_STB_VORBIS
-static void audio_mixer_mix_ogg(float* buffer, size_t num_frames,
-      audio_mixer_voice_t* voice,
-      float volume)
+/* The ring could not cover a whole mix, either because the sound
+ * is over or because the decoder fell behind. */
+static void audio_mixer_voice_drained(audio_mixer_voice_t* voice)
 {
-   int i;
-   struct resampler_data info = { 0 };
-   float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   unsigned temp_samples            = 0;
-   float* pcm                       = NULL;
-
-   if (voice->types.ogg.position == voice->types.ogg.samples)
-   {
-again:
-      temp_samples = stb_vorbis_get_samples_float_interleaved(
-            voice->types.ogg.stream, 2, temp_buffer,
-            AUDIO_MIXER_TEMP_BUFFER) * 2;
-
-      if (temp_samples == 0)
-      {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
+   bool finished;
 
-            stb_vorbis_seek_start(voice->types.ogg.stream);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
-      }
-
-      info.data_in              = temp_buffer;
-      info.data_out             = voice->types.ogg.buffer;
-      info.input_frames         = temp_samples / 2;
-      info.output_frames        = 0;
-      info.ratio                = voice->types.ogg.ratio;
-
-      if (voice->types.ogg.resampler)
-      {
-        voice->types.ogg.resampler->process(voice->types.ogg.resampler_data, &info);
-      }
-      else
-        memcpy(voice->types.ogg.buffer, temp_buffer, temp_samples * sizeof(float));
-      voice->types.ogg.position = 0;
-      voice->types.ogg.samples  = voice->types.ogg.buf_samples;
-   }
+#ifdef HAVE_THREADS
+   slock_lock(s_decode_lock);
+#endif
 
-   pcm = voice->types.ogg.buffer + voice->types.ogg.position;
+   finished = voice->decode_done && !spsc_read_avail(voice->ring);
 
-   if (voice->types.ogg.samples < buf_free)
-   {
-      for (i = voice->types.ogg.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
+   if (finished)
+      voice->type = AUDIO_MIXER_TYPE_NONE;
+   else if (!voice->decode_done)
+      voice->underruns++;
 
-      buf_free -= voice->types.ogg.samples;
-      goto again;
-   }
-   else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-         *buffer++ += *pcm++ * volume;
+#ifdef HAVE_THREADS
+   slock_unlock(s_decode_lock);
+#endif
 
-      voice->types.ogg.position += buf_free;
-      voice->types.ogg.samples  -= buf_free;
-   }
+   if (finished && voice->stop_cb)
+      voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
 }
-#endif
 
-#ifdef HAVE_IBXM
-static void audio_mixer_mix_mod(float* buffer, size_t num_frames,
+static void audio_mixer_mix_stream(float* buffer, size_t num_frames,
       audio_mixer_voice_t* voice,
       float volume)
 {
-   int i;
-   float samplef                    = 0.0f;
-   int samplei                      = 0;
-   unsigned temp_samples            = 0;
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   int* pcm                         = NULL;
+   spsc_region_t regions[2];
+   unsigned loops;
+   size_t size = num_frames * 2 * sizeof(float);
 
-   if (voice->types.mod.position == voice->types.mod.samples)
+   if (!audio_mixer_decode_threaded())
    {
-again:
-      temp_samples = replay_get_audio(
-            voice->types.mod.stream, voice->types.mod.buffer );
-
-      temp_samples *= 2; /* stereo */
+      bool looped;
 
-      if (temp_samples == 0)
+      while (     !voice->decode_done
+            && spsc_read_avail(voice->ring) < size
+            && spsc_write_avail(voice->ring) >= voice->chunk_size)
       {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
-
-            replay_seek( voice->types.mod.stream, 0);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
+         voice->decode_done = !audio_mixer_voice_decode(voice,
+               (enum audio_mixer_type)voice->type, &looped);
+         if (looped)
+            voice->loops++;
       }
-
-      voice->types.mod.position = 0;
-      voice->types.mod.samples  = temp_samples;
    }
-   pcm = voice->types.mod.buffer + voice->types.mod.position;
 
-   if (voice->types.mod.samples < buf_free)
-   {
-      for (i = voice->types.mod.samples; i != 0; i--)
-      {
-         samplei     = *pcm++ * volume;
-         samplef     = (float)((int)samplei + 32768) / 65535.0f;
-         samplef     = samplef * 2.0f - 1.0f;
-         *buffer++  += samplef;
-      }
+   size = spsc_read_regions(voice->ring, size, regions);
 
-      buf_free -= voice->types.mod.samples;
-      goto again;
-   }
-   else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-      {
-         samplei     = *pcm++ * volume;
-         samplef     = (float)((int)samplei + 32768) / 65535.0f;
-         samplef     = samplef * 2.0f - 1.0f;
-         *buffer++  += samplef;
-      }
-
-      voice->types.mod.position += buf_free;
-      voice->types.mod.samples  -= buf_free;
-   }
-}
-#endif
+   audio_mixer_add(buffer, (const float*)regions[0].data,
+         regions[0].size / sizeof(float), volume);
+   audio_mixer_add(buffer + regions[0].size / sizeof(float),
+         (const float*)regions[1].data,
+         regions[1].size / sizeof(float), volume);
 
-#ifdef HAVE_DR_FLAC
-static void audio_mixer_mix_flac(float* buffer, size_t num_frames,
-      audio_mixer_voice_t* voice,
-      float volume)
-{
-   int i;
-   struct resampler_data info = { 0 };
-   float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   unsigned temp_samples            = 0;
-   float* pcm                       = NULL;
+   spsc_read_commit(voice->ring, size);
 
-   if (voice->types.flac.position == voice->types.flac.samples)
+#ifdef HAVE_THREADS
+   if (s_decode_thread)
    {
-again:
-      temp_samples = (unsigned)drflac_read_f32( voice->types.flac.stream, AUDIO_MIXER_TEMP_BUFFER, temp_buffer);
-      if (temp_samples == 0)
-      {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
-
-            drflac_seek_to_sample(voice->types.flac.stream,0);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
-      }
-
-      info.data_in              = temp_buffer;
-      info.data_out             = voice->types.flac.buffer;
-      info.input_frames         = temp_samples / 2;
-      info.output_frames        = 0;
-      info.ratio                = voice->types.flac.ratio;
-
-      if (voice->types.flac.resampler)
-      {
-        voice->types.flac.resampler->process(voice->types.flac.resampler_data, &info);
-      }
-      else
-        memcpy(voice->types.flac.buffer, temp_buffer, temp_samples * sizeof(float));
-      voice->types.flac.position = 0;
-      voice->types.flac.samples  = voice->types.flac.buf_samples;
-   }
-
-   pcm = voice->types.flac.buffer + voice->types.flac.position;
-
-   if (voice->types.flac.samples < buf_free)
-   {
-      for (i = voice->types.flac.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
-
-      buf_free -= voice->types.flac.samples;
-      goto again;
+      /* Signalled under the lock, so the decoder either sees the
+       * space freed by the commit above or is already waiting */
+      slock_lock(s_decode_lock);
+      loops = voice->loops;
+      scond_signal(s_decode_cond);
+      slock_unlock(s_decode_lock);
    }
    else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-         *buffer++ += *pcm++ * volume;
-
-      voice->types.flac.position += buf_free;
-      voice->types.flac.samples  -= buf_free;
-   }
-}
 #endif
+      loops = voice->loops;
 
-#ifdef HAVE_DR_MP3
-static void audio_mixer_mix_mp3(float* buffer, size_t num_frames,
-      audio_mixer_voice_t* voice,
-      float volume)
-{
-   int i;
-   struct resampler_data info = { 0 };
-   float temp_buffer[AUDIO_MIXER_TEMP_BUFFER] = { 0 };
-   unsigned buf_free                = (unsigned)(num_frames * 2);
-   unsigned temp_samples            = 0;
-   float* pcm                       = NULL;
-
-   if (voice->types.mp3.position == voice->types.mp3.samples)
+   while (voice->loops_reported != loops)
    {
-again:
-      temp_samples = (unsigned)drmp3_read_f32(&voice->types.mp3.stream, AUDIO_MIXER_TEMP_BUFFER/2, temp_buffer) * 2;
-
-      if (temp_samples == 0)
-      {
-         if (voice->repeat)
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
-
-            drmp3_seek_to_frame(&voice->types.mp3.stream,0);
-            goto again;
-         }
-         else
-         {
-            if (voice->stop_cb)
-               voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_FINISHED);
-
-            voice->type = AUDIO_MIXER_TYPE_NONE;
-            return;
-         }
-      }
-
-      info.data_in              = temp_buffer;
-      info.data_out             = voice->types.mp3.buffer;
-      info.input_frames         = temp_samples / 2;
-      info.output_frames        = 0;
-      info.ratio                = voice->types.mp3.ratio;
-
-      if (voice->types.mp3.resampler)
-        voice->types.mp3.resampler->process(voice->types.mp3.resampler_data, &info);
-      else
-        memcpy(voice->types.mp3.buffer, temp_buffer, temp_samples * sizeof(float));
-      voice->types.mp3.position = 0;
-      voice->types.mp3.samples  = voice->types.mp3.buf_samples;
-   }
-
-   pcm = voice->types.mp3.buffer + voice->types.mp3.position;
-
-   if (voice->types.mp3.samples < buf_free)
-   {
-      for (i = voice->types.mp3.samples; i != 0; i--)
-         *buffer++ += *pcm++ * volume;
-
-      buf_free -= voice->types.mp3.samples;
-      goto again;
+      voice->loops_reported++;
+      if (voice->stop_cb)
+         voice->stop_cb(voice->sound, AUDIO_MIXER_SOUND_REPEATED);
    }
-   else
-   {
-      int i;
-      for (i = buf_free; i != 0; --i )
-         *buffer++ += *pcm++ * volume;
 
-      voice->types.mp3.position += buf_free;
-      voice->types.mp3.samples  -= buf_free;
-   }
+   if (size < num_frames * 2 * sizeof(float))
+      audio_mixer_voice_drained(voice);
 }
-#endif
 
 void audio_mixer_mix(float* buffer, size_t num_frames, float volume_override, bool override)
 {
    unsigned i;
-   size_t j                   = 0;
-   float* sample              = NULL;
    audio_mixer_voice_t* voice = s_voices;
 
    for (i = 0; i < AUDIO_MIXER_MAX_VOICES; i++, voice++)
@@ -1209,37 +1445,17 @@ void audio_mixer_mix(float* buffer, size_t num_frames, float volume_override, bo
             audio_mixer_mix_wav(buffer, num_frames, voice, volume);
             break;
          case AUDIO_MIXER_TYPE_OGG:
-#ifdef HAVE_STB_VORBIS
-            audio_mixer_mix_ogg(buffer, num_frames, voice, volume);
-#endif
-            break;
          case AUDIO_MIXER_TYPE_MOD:
-#ifdef HAVE_IBXM
-            audio_mixer_mix_mod(buffer, num_frames, voice, volume);
-#endif
-            break;
          case AUDIO_MIXER_TYPE_FLAC:
-#ifdef HAVE_DR_FLAC
-            audio_mixer_mix_flac(buffer, num_frames, voice, volume);
-#endif
-            break;
-            case AUDIO_MIXER_TYPE_MP3:
-#ifdef HAVE_DR_MP3
-            audio_mixer_mix_mp3(buffer, num_frames, voice, volume);
-#endif
+         case AUDIO_MIXER_TYPE_MP3:
+            audio_mixer_mix_stream(buffer, num_frames, voice, volume);
             break;
          case AUDIO_MIXER_TYPE_NONE:
             break;
       }
    }
 
-   for (j = 0, sample = buffer; j < num_frames; j++, sample++)
-   {
-      if (*sample < -1.0f)
-         *sample = -1.0f;
-      else if (*sample > 1.0f)
-         *sample = 1.0f;
-   }
+   audio_mixer_clamp(buffer, num_frames * 2);
 }
 
 float audio_mixer_voice_get_volume(audio_mixer_voice_t *voice)
@@ -1257,3 +1473,11 @@ void audio_mixer_voice_set_volume(audio_mixer_voice_t *voice, float val)
 
    voice->volume = val;
 }
+
+unsigned audio_mixer_voice_get_underruns(audio_mixer_voice_t *voice)
+{
+   if (!voice)
+      return 0;
+
+   return voice->underruns;
+}
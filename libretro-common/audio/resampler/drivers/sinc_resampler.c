@@ -32,16 +32,55 @@
 #include <memalign.h>
 
 #include <audio/audio_resampler.h>
-#include <filters.h>
 
-#ifdef __SSE__
+/* Every kernel is built whenever the compiler can emit it, and the
+ * best one the CPU supports is picked when the resampler is created. */
+#if defined(__x86_64__) || defined(__i386__) || defined(__i486__) || defined(__i686__) || defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86)
+#if defined(_MSC_VER) && _MSC_VER >= 1910
+#define SINC_SSE
+#define SINC_AVX2
+#define SINC_AVX512
+#define SINC_TARGET_SSE
+#define SINC_TARGET_AVX2
+#define SINC_TARGET_AVX512
+#elif defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 7)
+#define SINC_SSE
+#define SINC_AVX2
+#define SINC_AVX512
+#define SINC_TARGET_SSE    __attribute__((target("sse")))
+#define SINC_TARGET_AVX2   __attribute__((target("avx2,fma")))
+#define SINC_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SINC_SSE
+#define SINC_TARGET_SSE
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+#define SINC_AVX2
+#define SINC_TARGET_AVX2
+#endif
+#if defined(__AVX512F__)
+#define SINC_AVX512
+#define SINC_TARGET_AVX512
+#endif
+#endif
+#endif
+
+#ifdef SINC_SSE
 #include <xmmintrin.h>
 #endif
 
-#if defined(__AVX__)
+#if defined(SINC_AVX2) || defined(SINC_AVX512)
 #include <immintrin.h>
 #endif
 
+/* Only when the compiler really targets NEON, some builds
+ * define __ARM_NEON__ by hand. */
+#if (defined(__ARM_NEON) || defined(__aarch64__)) && !defined(DONT_WANT_ARM_OPTIMIZATIONS)
+#define SINC_NEON
+#include <arm_neon.h>
+#endif
+
 /* Rough SNR values for upsampling:
  * LOWEST: 40 dB
  * LOWER: 55 dB
@@ -59,15 +98,20 @@ enum sinc_window
    SINC_WINDOW_LANCZOS
 };
 
-/* For the little amount of taps we're using,
- * SSE1 is faster than AVX for some reason.
- * AVX code is kept here though as by increasing number
- * of sinc taps, the AVX code is clearly faster than SSE1.
- */
+/* Kaiser windowed tables interpolate between phases, so each
+ * phase stores the deltas to the next phase next to its taps.
+ * They are interleaved in blocks of SINC_BLOCK taps, one block of
+ * sinc values followed by the matching block of deltas, so every
+ * phase is read as a single forward stream.
+ * Lanczos tables have no deltas and are plain arrays of taps,
+ * padded to a multiple of 4. */
+#define SINC_BLOCK 16
+
+#define SINC_AVX512_MIN_TAPS 512
 
 typedef struct rarch_sinc_resampler
 {
-   unsigned enable_avx;
+   resampler_process_t process;
    unsigned phase_bits;
    unsigned subphase_bits;
    unsigned subphase_mask;
@@ -87,357 +131,363 @@ typedef struct rarch_sinc_resampler
    float *buffer_r;
 } rarch_sinc_resampler_t;
 
-#if defined(__ARM_NEON__) && !defined(DONT_WANT_ARM_OPTIMIZATIONS)
-#if TARGET_OS_IPHONE
-#else
-#define WANT_NEON
-#endif
-#endif
-
-#ifdef WANT_NEON
-/* Assumes that taps >= 8, and that taps is a multiple of 8. */
-void process_sinc_neon_asm(float *out, const float *left,
-      const float *right, const float *coeff, unsigned taps);
+/* Computes one output frame from the taps starting at buffer_l and
+ * buffer_r, and the table of the current phase. Kaiser kernels
+ * interpolate towards the next phase by delta. */
+typedef void (*sinc_kernel_t)(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta);
 
-static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
+static INLINE size_t resampler_sinc_push(rarch_sinc_resampler_t *resamp,
+      const float **input, size_t frames, unsigned phases)
 {
-   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
-
-   uint32_t ratio                 = phases / data->ratio;
-   const float *input             = data->data_in;
-   float *output                  = data->data_out;
-   size_t frames                  = data->input_frames;
-   size_t out_frames              = 0;
+   const float *in = *input;
 
-   while (frames)
+   while (frames && resamp->time >= phases)
    {
-      while (frames && resamp->time >= phases)
-      {
-         /* Push in reverse to make filter more obvious. */
-         if (!resamp->ptr)
-            resamp->ptr = resamp->taps;
-         resamp->ptr--;
+      /* Push in reverse to make filter more obvious. */
+      if (!resamp->ptr)
+         resamp->ptr = resamp->taps;
+      resamp->ptr--;
 
-         resamp->buffer_l[resamp->ptr + resamp->taps] =
-         resamp->buffer_l[resamp->ptr]                = *input++;
+      resamp->buffer_l[resamp->ptr + resamp->taps]    =
+         resamp->buffer_l[resamp->ptr]                = *in++;
 
-         resamp->buffer_r[resamp->ptr + resamp->taps] =
-         resamp->buffer_r[resamp->ptr]                = *input++;
-
-         resamp->time                                -= phases;
-         frames--;
-      }
+      resamp->buffer_r[resamp->ptr + resamp->taps]    =
+         resamp->buffer_r[resamp->ptr]                = *in++;
 
-      while (resamp->time < phases)
-      {
-         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
-         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
-         unsigned taps            = resamp->taps;
-         unsigned phase           = resamp->time >> resamp->subphase_bits;
-         const float *phase_table = resamp->phase_table + phase * taps;
-
-         process_sinc_neon_asm(output, buffer_l, buffer_r, phase_table, taps);
-
-         output += 2;
-         out_frames++;
-         resamp->time += ratio;
-      }
+      resamp->time                                   -= phases;
+      frames--;
    }
 
-   data->output_frames = out_frames;
+   *input = in;
+   return frames;
 }
-#endif
 
-#if defined(__AVX__)
-static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
+/* Shared by every instruction set; kaiser and lanczos are
+ * constants in each caller, so the kernels get inlined. */
+static INLINE void resampler_sinc_run(rarch_sinc_resampler_t *resamp,
+      struct resampler_data *data,
+      sinc_kernel_t kaiser, sinc_kernel_t lanczos)
 {
-   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
    unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
-
    uint32_t ratio                 = phases / data->ratio;
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
    size_t out_frames              = 0;
+   unsigned taps                  = resamp->taps;
 
    while (frames)
    {
-      while (frames && resamp->time >= phases)
-      {
-         /* Push in reverse to make filter more obvious. */
-         if (!resamp->ptr)
-            resamp->ptr = resamp->taps;
-         resamp->ptr--;
-
-         resamp->buffer_l[resamp->ptr + resamp->taps] =
-         resamp->buffer_l[resamp->ptr]                = *input++;
-
-         resamp->buffer_r[resamp->ptr + resamp->taps] =
-         resamp->buffer_r[resamp->ptr]                = *input++;
-
-         resamp->time                                -= phases;
-         frames--;
-      }
+      frames = resampler_sinc_push(resamp, &input, frames, phases);
 
       while (resamp->time < phases)
       {
-         unsigned i;
-         __m256 delta, sum_l, sum_r;
-         float *delta_table       = NULL;
-         float *phase_table       = NULL;
          const float *buffer_l    = resamp->buffer_l + resamp->ptr;
          const float *buffer_r    = resamp->buffer_r + resamp->ptr;
-         unsigned taps            = resamp->taps;
          unsigned phase           = resamp->time >> resamp->subphase_bits;
 
-         phase_table              = resamp->phase_table + phase * taps;
-
          if (resamp->window_type == SINC_WINDOW_KAISER)
-         {
-            phase_table              = resamp->phase_table + phase * taps * 2;
-            delta_table              = phase_table + taps;
-            delta                    = _mm256_set1_ps((float)
-                  (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
-         }
-
-         sum_l                    = _mm256_setzero_ps();
-         sum_r                    = _mm256_setzero_ps();
-
-         for (i = 0; i < taps; i += 8)
-         {
-            __m256 sinc;
-            __m256 buf_l  = _mm256_loadu_ps(buffer_l + i);
-            __m256 buf_r  = _mm256_loadu_ps(buffer_r + i);
-
-            if (resamp->window_type == SINC_WINDOW_KAISER)
-            {
-               __m256 deltas = _mm256_load_ps(delta_table + i);
-               sinc          = _mm256_add_ps(_mm256_load_ps((const float*)phase_table + i),
-                     _mm256_mul_ps(deltas, delta));
-            }
-            else
-            {
-               sinc          = _mm256_load_ps((const float*)phase_table + i);
-            }
-
-            sum_l         = _mm256_add_ps(sum_l, _mm256_mul_ps(buf_l, sinc));
-            sum_r         = _mm256_add_ps(sum_r, _mm256_mul_ps(buf_r, sinc));
-         }
+            kaiser(output, buffer_l, buffer_r,
+                  resamp->phase_table + phase * taps * 2, taps,
+                  (float)(resamp->time & resamp->subphase_mask)
+                  * resamp->subphase_mod);
+         else
+            lanczos(output, buffer_l, buffer_r,
+                  resamp->phase_table + phase * taps, taps, 0.0f);
 
-         /* hadd on AVX is weird, and acts on low-lanes
-          * and high-lanes separately. */
-         __m256 res_l = _mm256_hadd_ps(sum_l, sum_l);
-         __m256 res_r = _mm256_hadd_ps(sum_r, sum_r);
-         res_l        = _mm256_hadd_ps(res_l, res_l);
-         res_r        = _mm256_hadd_ps(res_r, res_r);
-         res_l        = _mm256_add_ps(_mm256_permute2f128_ps(res_l, res_l, 1), res_l);
-         res_r        = _mm256_add_ps(_mm256_permute2f128_ps(res_r, res_r, 1), res_r);
-
-         /* This is optimized to mov %xmmN, [mem].
-          * There doesn't seem to be any _mm256_store_ss intrinsic. */
-         _mm_store_ss(output + 0, _mm256_extractf128_ps(res_l, 0));
-         _mm_store_ss(output + 1, _mm256_extractf128_ps(res_r, 0));
-
-         output += 2;
+         output                  += 2;
          out_frames++;
-         resamp->time += ratio;
+         resamp->time            += ratio;
       }
    }
 
    data->output_frames = out_frames;
 }
-#endif
 
-#if defined(__SSE__)
-static void resampler_sinc_process_sse(void *re_, struct resampler_data *data)
+static INLINE void sinc_kernel_kaiser_c(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta)
 {
-   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   unsigned i, j;
+   float sum_l = 0.0f;
+   float sum_r = 0.0f;
 
-   uint32_t ratio                 = phases / data->ratio;
-   const float *input             = data->data_in;
-   float *output                  = data->data_out;
-   size_t frames                  = data->input_frames;
-   size_t out_frames              = 0;
-
-   while (frames)
+   for (i = 0; i < taps; i += SINC_BLOCK, phase_table += 2 * SINC_BLOCK)
    {
-      while (frames && resamp->time >= phases)
+      for (j = 0; j < SINC_BLOCK; j++)
       {
-         /* Push in reverse to make filter more obvious. */
-         if (!resamp->ptr)
-            resamp->ptr = resamp->taps;
-         resamp->ptr--;
-
-         resamp->buffer_l[resamp->ptr + resamp->taps] =
-         resamp->buffer_l[resamp->ptr]                = *input++;
+         float sinc_val = phase_table[j] + phase_table[SINC_BLOCK + j] * delta;
 
-         resamp->buffer_r[resamp->ptr + resamp->taps] =
-         resamp->buffer_r[resamp->ptr]                = *input++;
-
-         resamp->time                                -= phases;
-         frames--;
+         sum_l         += buffer_l[i + j] * sinc_val;
+         sum_r         += buffer_r[i + j] * sinc_val;
       }
+   }
 
-      while (resamp->time < phases)
-      {
-         unsigned i;
-         __m128 sum, sum_l, sum_r, delta;
-         float *phase_table       = NULL;
-         float *delta_table       = NULL;
-         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
-         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
-         unsigned taps            = resamp->taps;
-         unsigned phase           = resamp->time >> resamp->subphase_bits;
+   out[0] = sum_l;
+   out[1] = sum_r;
+}
 
-         if (resamp->window_type == SINC_WINDOW_KAISER)
-         {
-            phase_table              = resamp->phase_table + phase * taps * 2;
-            delta_table              = phase_table + taps;
-            delta                    = _mm_set1_ps((float)
-                  (resamp->time & resamp->subphase_mask) * resamp->subphase_mod);
-         }
-         else
-         {
-            phase_table              = resamp->phase_table + phase * taps;
-         }
+/* Lanczos filters only have a handful of taps. On x86 this beats
+ * the vector kernels, as reducing the sums and reloading the frame
+ * that was just pushed cost more than the multiplies themselves. */
+static INLINE void sinc_kernel_lanczos_c(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta)
+{
+   unsigned i;
+   float sum_l = 0.0f;
+   float sum_r = 0.0f;
 
-         sum_l                    = _mm_setzero_ps();
-         sum_r                    = _mm_setzero_ps();
+   for (i = 0; i < taps; i++)
+   {
+      sum_l += buffer_l[i] * phase_table[i];
+      sum_r += buffer_r[i] * phase_table[i];
+   }
 
-         for (i = 0; i < taps; i += 4)
-         {
-            __m128 deltas, _sinc;
-            __m128 buf_l = _mm_loadu_ps(buffer_l + i);
-            __m128 buf_r = _mm_loadu_ps(buffer_r + i);
-
-            if (resamp->window_type == SINC_WINDOW_KAISER)
-            {
-               deltas = _mm_load_ps(delta_table + i);
-               _sinc  = _mm_add_ps(_mm_load_ps((const float*)phase_table + i),
-                     _mm_mul_ps(deltas, delta));
-            }
-            else
-            {
-               _sinc  = _mm_load_ps((const float*)phase_table + i);
-            }
-            sum_l        = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
-            sum_r        = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
-         }
+   out[0] = sum_l;
+   out[1] = sum_r;
+}
+
+static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
+{
+   resampler_sinc_run((rarch_sinc_resampler_t*)re_, data,
+         sinc_kernel_kaiser_c, sinc_kernel_lanczos_c);
+}
 
-         /* Them annoying shuffles.
-          * sum_l = { l3, l2, l1, l0 }
-          * sum_r = { r3, r2, r1, r0 }
-          */
+#ifdef SINC_SSE
+/* Reduces the left and right sums and stores them as one frame. */
+SINC_TARGET_SSE
+static INLINE void sinc_store_sse(float *out, __m128 sum_l, __m128 sum_r)
+{
+   /* Them annoying shuffles.
+    * sum_l = { l3, l2, l1, l0 }
+    * sum_r = { r3, r2, r1, r0 }
+    */
+   __m128 sum = _mm_add_ps(_mm_shuffle_ps(sum_l, sum_r,
+            _MM_SHUFFLE(1, 0, 1, 0)),
+         _mm_shuffle_ps(sum_l, sum_r, _MM_SHUFFLE(3, 2, 3, 2)));
 
-         sum = _mm_add_ps(_mm_shuffle_ps(sum_l, sum_r,
-                  _MM_SHUFFLE(1, 0, 1, 0)),
-               _mm_shuffle_ps(sum_l, sum_r, _MM_SHUFFLE(3, 2, 3, 2)));
+   /* sum   = { r1, r0, l1, l0 } + { r3, r2, l3, l2 }
+    * sum   = { R1, R0, L1, L0 }
+    */
 
-         /* sum   = { r1, r0, l1, l0 } + { r3, r2, l3, l2 }
-          * sum   = { R1, R0, L1, L0 }
-          */
+   sum = _mm_add_ps(_mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 3, 1, 1)), sum);
 
-         sum = _mm_add_ps(_mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 3, 1, 1)), sum);
+   /* sum   = {R1, R1, L1, L1 } + { R1, R0, L1, L0 }
+    * sum   = { X,  R,  X,  L }
+    */
 
-         /* sum   = {R1, R1, L1, L1 } + { R1, R0, L1, L0 }
-          * sum   = { X,  R,  X,  L }
-          */
+   /* Store L */
+   _mm_store_ss(out + 0, sum);
 
-         /* Store L */
-         _mm_store_ss(output + 0, sum);
+   /* movehl { X, R, X, L } == { X, R, X, R } */
+   _mm_store_ss(out + 1, _mm_movehl_ps(sum, sum));
+}
 
-         /* movehl { X, R, X, L } == { X, R, X, R } */
-         _mm_store_ss(output + 1, _mm_movehl_ps(sum, sum));
+SINC_TARGET_SSE
+static INLINE void sinc_kernel_kaiser_sse(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta)
+{
+   unsigned i, j;
+   __m128 deltas = _mm_set1_ps(delta);
+   __m128 sum_l  = _mm_setzero_ps();
+   __m128 sum_r  = _mm_setzero_ps();
 
-         output += 2;
-         out_frames++;
-         resamp->time += ratio;
+   for (i = 0; i < taps; i += SINC_BLOCK, phase_table += 2 * SINC_BLOCK)
+   {
+      for (j = 0; j < SINC_BLOCK; j += 4)
+      {
+         __m128 sinc  = _mm_add_ps(_mm_load_ps(phase_table + j),
+               _mm_mul_ps(_mm_load_ps(phase_table + SINC_BLOCK + j), deltas));
+         sum_l        = _mm_add_ps(sum_l,
+               _mm_mul_ps(_mm_loadu_ps(buffer_l + i + j), sinc));
+         sum_r        = _mm_add_ps(sum_r,
+               _mm_mul_ps(_mm_loadu_ps(buffer_r + i + j), sinc));
       }
    }
 
-   data->output_frames = out_frames;
+   sinc_store_sse(out, sum_l, sum_r);
+}
+
+SINC_TARGET_SSE
+static void resampler_sinc_process_sse(void *re_, struct resampler_data *data)
+{
+   resampler_sinc_run((rarch_sinc_resampler_t*)re_, data,
+         sinc_kernel_kaiser_sse, sinc_kernel_lanczos_c);
 }
 #endif
 
-static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
+#ifdef SINC_AVX2
+/* Two accumulators per channel, so consecutive FMAs don't
+ * have to wait on each other. */
+SINC_TARGET_AVX2
+static INLINE void sinc_kernel_kaiser_avx2(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta)
 {
-   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   unsigned i;
+   __m256 deltas = _mm256_set1_ps(delta);
+   __m256 sum_l0 = _mm256_setzero_ps();
+   __m256 sum_l1 = _mm256_setzero_ps();
+   __m256 sum_r0 = _mm256_setzero_ps();
+   __m256 sum_r1 = _mm256_setzero_ps();
+
+   for (i = 0; i < taps; i += SINC_BLOCK, phase_table += 2 * SINC_BLOCK)
+   {
+      __m256 sinc0 = _mm256_fmadd_ps(_mm256_load_ps(phase_table + 16),
+            deltas, _mm256_load_ps(phase_table + 0));
+      __m256 sinc1 = _mm256_fmadd_ps(_mm256_load_ps(phase_table + 24),
+            deltas, _mm256_load_ps(phase_table + 8));
+
+      sum_l0       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i + 0),
+            sinc0, sum_l0);
+      sum_l1       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i + 8),
+            sinc1, sum_l1);
+      sum_r0       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i + 0),
+            sinc0, sum_r0);
+      sum_r1       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i + 8),
+            sinc1, sum_r1);
+   }
 
-   uint32_t ratio                 = phases / data->ratio;
-   const float *input             = data->data_in;
-   float *output                  = data->data_out;
-   size_t frames                  = data->input_frames;
-   size_t out_frames              = 0;
+   sum_l0 = _mm256_add_ps(sum_l0, sum_l1);
+   sum_r0 = _mm256_add_ps(sum_r0, sum_r1);
 
-   while (frames)
-   {
-      while (frames && resamp->time >= phases)
-      {
-         /* Push in reverse to make filter more obvious. */
-         if (!resamp->ptr)
-            resamp->ptr = resamp->taps;
-         resamp->ptr--;
+   sinc_store_sse(out,
+         _mm_add_ps(_mm256_castps256_ps128(sum_l0),
+            _mm256_extractf128_ps(sum_l0, 1)),
+         _mm_add_ps(_mm256_castps256_ps128(sum_r0),
+            _mm256_extractf128_ps(sum_r0, 1)));
+}
 
-         resamp->buffer_l[resamp->ptr + resamp->taps]    =
-            resamp->buffer_l[resamp->ptr]                = *input++;
+SINC_TARGET_AVX2
+static void resampler_sinc_process_avx2(void *re_, struct resampler_data *data)
+{
+   resampler_sinc_run((rarch_sinc_resampler_t*)re_, data,
+         sinc_kernel_kaiser_avx2, sinc_kernel_lanczos_c);
+}
+#endif
 
-         resamp->buffer_r[resamp->ptr + resamp->taps]    =
-            resamp->buffer_r[resamp->ptr]                = *input++;
+#ifdef SINC_AVX512
+/* One block of taps per iteration. */
+SINC_TARGET_AVX512
+static INLINE void sinc_kernel_kaiser_avx512(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta)
+{
+   unsigned i;
+   __m256 res_l, res_r;
+   __m512 deltas = _mm512_set1_ps(delta);
+   __m512 sum_l  = _mm512_setzero_ps();
+   __m512 sum_r  = _mm512_setzero_ps();
 
-         resamp->time                                   -= phases;
-         frames--;
-      }
+   for (i = 0; i < taps; i += SINC_BLOCK, phase_table += 2 * SINC_BLOCK)
+   {
+      __m512 sinc = _mm512_fmadd_ps(_mm512_load_ps(phase_table + SINC_BLOCK),
+            deltas, _mm512_load_ps(phase_table));
 
-      while (resamp->time < phases)
-      {
-         unsigned i;
-         float delta              = 0.0f;
-         float sum_l              = 0.0f;
-         float sum_r              = 0.0f;
-         float *phase_table       = NULL;
-         float *delta_table       = NULL;
-         const float *buffer_l    = resamp->buffer_l + resamp->ptr;
-         const float *buffer_r    = resamp->buffer_r + resamp->ptr;
-         unsigned taps            = resamp->taps;
-         unsigned phase           = resamp->time >> resamp->subphase_bits;
+      sum_l       = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_l + i), sinc, sum_l);
+      sum_r       = _mm512_fmadd_ps(_mm512_loadu_ps(buffer_r + i), sinc, sum_r);
+   }
 
-         if (resamp->window_type == SINC_WINDOW_KAISER)
-         {
-            phase_table           = resamp->phase_table + phase * taps * 2;
-            delta_table           = phase_table + taps;
-            delta                 = (float)
-               (resamp->time & resamp->subphase_mask) * resamp->subphase_mod;
-         }
-         else
-         {
-            phase_table           = resamp->phase_table + phase * taps;
-         }
+   res_l = _mm256_add_ps(_mm512_castps512_ps256(sum_l),
+         _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(sum_l), 1)));
+   res_r = _mm256_add_ps(_mm512_castps512_ps256(sum_r),
+         _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(sum_r), 1)));
 
-         for (i = 0; i < taps; i++)
-         {
-            float sinc_val        = phase_table[i];
+   sinc_store_sse(out,
+         _mm_add_ps(_mm256_castps256_ps128(res_l),
+            _mm256_extractf128_ps(res_l, 1)),
+         _mm_add_ps(_mm256_castps256_ps128(res_r),
+            _mm256_extractf128_ps(res_r, 1)));
+}
 
-            if (resamp->window_type == SINC_WINDOW_KAISER)
-               sinc_val           = sinc_val + delta_table[i] * delta;
+SINC_TARGET_AVX512
+static void resampler_sinc_process_avx512(void *re_, struct resampler_data *data)
+{
+   resampler_sinc_run((rarch_sinc_resampler_t*)re_, data,
+         sinc_kernel_kaiser_avx512, sinc_kernel_lanczos_c);
+}
+#endif
 
-            sum_l                += buffer_l[i] * sinc_val;
-            sum_r                += buffer_r[i] * sinc_val;
-         }
+#ifdef SINC_NEON
+#if defined(__aarch64__)
+#define SINC_NEON_MLA(acc, a, b) vfmaq_f32(acc, a, b)
+#else
+#define SINC_NEON_MLA(acc, a, b) vmlaq_f32(acc, a, b)
+#endif
 
-         output[0]                = sum_l;
-         output[1]                = sum_r;
+static INLINE void sinc_store_neon(float *out,
+      float32x4_t sum_l, float32x4_t sum_r)
+{
+#if defined(__aarch64__)
+   out[0] = vaddvq_f32(sum_l);
+   out[1] = vaddvq_f32(sum_r);
+#else
+   vst1_f32(out, vpadd_f32(
+            vadd_f32(vget_low_f32(sum_l), vget_high_f32(sum_l)),
+            vadd_f32(vget_low_f32(sum_r), vget_high_f32(sum_r))));
+#endif
+}
 
-         output                  += 2;
-         out_frames++;
-         resamp->time            += ratio;
+static INLINE void sinc_kernel_kaiser_neon(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta)
+{
+   unsigned i, j;
+   float32x4_t deltas = vdupq_n_f32(delta);
+   float32x4_t sum_l  = vdupq_n_f32(0.0f);
+   float32x4_t sum_r  = vdupq_n_f32(0.0f);
+
+   for (i = 0; i < taps; i += SINC_BLOCK, phase_table += 2 * SINC_BLOCK)
+   {
+      for (j = 0; j < SINC_BLOCK; j += 4)
+      {
+         float32x4_t sinc = SINC_NEON_MLA(vld1q_f32(phase_table + j),
+               vld1q_f32(phase_table + SINC_BLOCK + j), deltas);
+         sum_l            = SINC_NEON_MLA(sum_l,
+               vld1q_f32(buffer_l + i + j), sinc);
+         sum_r            = SINC_NEON_MLA(sum_r,
+               vld1q_f32(buffer_r + i + j), sinc);
       }
+   }
 
+   sinc_store_neon(out, sum_l, sum_r);
+}
+
+static INLINE void sinc_kernel_lanczos_neon(float *out,
+      const float *buffer_l, const float *buffer_r,
+      const float *phase_table, unsigned taps, float delta)
+{
+   unsigned i;
+   float32x4_t sum_l = vdupq_n_f32(0.0f);
+   float32x4_t sum_r = vdupq_n_f32(0.0f);
+
+   for (i = 0; i < taps; i += 4)
+   {
+      float32x4_t sinc = vld1q_f32(phase_table + i);
+      sum_l            = SINC_NEON_MLA(sum_l, vld1q_f32(buffer_l + i), sinc);
+      sum_r            = SINC_NEON_MLA(sum_r, vld1q_f32(buffer_r + i), sinc);
    }
 
-   data->output_frames = out_frames;
+   sinc_store_neon(out, sum_l, sum_r);
+}
+
+static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
+{
+   resampler_sinc_run((rarch_sinc_resampler_t*)re_, data,
+         sinc_kernel_kaiser_neon, sinc_kernel_lanczos_neon);
+}
+#endif
+
+/* The process function is picked per instance, since several
+ * resamplers of different quality can be alive at once. */
+static void resampler_sinc_process(void *re_, struct resampler_data *data)
+{
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   resamp->process(resamp, data);
 }
 
 static void resampler_sinc_free(void *data)
@@ -448,13 +498,23 @@ static void resampler_sinc_free(void *data)
    free(resamp);
 }
 
+/* Where a tap of a phase lives in the table, see SINC_BLOCK.
+ * With deltas, the delta of a tap is SINC_BLOCK further on. */
+static INLINE size_t sinc_table_index(int phase, int tap, int taps,
+      bool calculate_delta)
+{
+   if (!calculate_delta)
+      return phase * taps + tap;
+   return phase * 2 * taps + (tap / SINC_BLOCK) * 2 * SINC_BLOCK
+      + tap % SINC_BLOCK;
+}
+
 static void sinc_init_table_kaiser(rarch_sinc_resampler_t *resamp,
       double cutoff,
       float *phase_table, int phases, int taps, bool calculate_delta)
 {
    int i, j;
    double    window_mod = kaiser_window_function(0.0, resamp->kaiser_beta); /* Need to normalize w(0) to 1.0. */
-   int           stride = calculate_delta ? 2 : 1;
    double     sidelobes = taps / 2.0;
 
    for (i = 0; i < phases; i++)
@@ -469,7 +529,7 @@ static void sinc_init_table_kaiser(rarch_sinc_resampler_t *resamp,
          sinc_phase          = sidelobes * window_phase;
          val                 = cutoff * sinc(M_PI * sinc_phase * cutoff) *
             kaiser_window_function(window_phase, resamp->kaiser_beta) / window_mod;
-         phase_table[i * stride * taps + j] = val;
+         phase_table[sinc_table_index(i, j, taps, calculate_delta)] = val;
       }
    }
 
@@ -482,9 +542,10 @@ static void sinc_init_table_kaiser(rarch_sinc_resampler_t *resamp,
       {
          for (j = 0; j < taps; j++)
          {
-            float delta = phase_table[(p + 1) * stride * taps + j] -
-               phase_table[p * stride * taps + j];
-            phase_table[(p * stride + 1) * taps + j] = delta;
+            size_t index = sinc_table_index(p, j, taps, true);
+            float delta  = phase_table[sinc_table_index(p + 1, j, taps, true)] -
+               phase_table[index];
+            phase_table[index + SINC_BLOCK] = delta;
          }
       }
 
@@ -500,8 +561,8 @@ static void sinc_init_table_kaiser(rarch_sinc_resampler_t *resamp,
 
          val                 = cutoff * sinc(M_PI * sinc_phase * cutoff) *
             kaiser_window_function(window_phase, resamp->kaiser_beta) / window_mod;
-         delta = (val - phase_table[phase * stride * taps + j]);
-         phase_table[(phase * stride + 1) * taps + j] = delta;
+         delta = (val - phase_table[sinc_table_index(phase, j, taps, true)]);
+         phase_table[sinc_table_index(phase, j, taps, true) + SINC_BLOCK] = delta;
       }
    }
 }
@@ -511,7 +572,6 @@ static void sinc_init_table_lanczos(rarch_sinc_resampler_t *resamp, double cutof
 {
    int i, j;
    double    window_mod = lanzcos_window_function(0.0); /* Need to normalize w(0) to 1.0. */
-   int           stride = calculate_delta ? 2 : 1;
    double     sidelobes = taps / 2.0;
 
    for (i = 0; i < phases; i++)
@@ -526,7 +586,7 @@ static void sinc_init_table_lanczos(rarch_sinc_resampler_t *resamp, double cutof
          sinc_phase          = sidelobes * window_phase;
          val                 = cutoff * sinc(M_PI * sinc_phase * cutoff) *
             lanzcos_window_function(window_phase) / window_mod;
-         phase_table[i * stride * taps + j] = val;
+         phase_table[sinc_table_index(i, j, taps, calculate_delta)] = val;
       }
    }
 
@@ -539,9 +599,10 @@ static void sinc_init_table_lanczos(rarch_sinc_resampler_t *resamp, double cutof
       {
          for (j = 0; j < taps; j++)
          {
-            float delta = phase_table[(p + 1) * stride * taps + j] -
-               phase_table[p * stride * taps + j];
-            phase_table[(p * stride + 1) * taps + j] = delta;
+            size_t index = sinc_table_index(p, j, taps, true);
+            float delta  = phase_table[sinc_table_index(p + 1, j, taps, true)] -
+               phase_table[index];
+            phase_table[index + SINC_BLOCK] = delta;
          }
       }
 
@@ -557,12 +618,48 @@ static void sinc_init_table_lanczos(rarch_sinc_resampler_t *resamp, double cutof
 
          val                 = cutoff * sinc(M_PI * sinc_phase * cutoff) *
             lanzcos_window_function(window_phase) / window_mod;
-         delta = (val - phase_table[phase * stride * taps + j]);
-         phase_table[(phase * stride + 1) * taps + j] = delta;
+         delta = (val - phase_table[sinc_table_index(phase, j, taps, true)]);
+         phase_table[sinc_table_index(phase, j, taps, true) + SINC_BLOCK] = delta;
       }
    }
 }
 
+/* Picks the widest kernel family the CPU supports. 512-bit
+ * vectors only pull ahead of AVX2 on the long filters used when
+ * downsampling at the higher qualities, so shorter ones stay
+ * on AVX2. */
+static resampler_process_t resampler_sinc_select(
+      const rarch_sinc_resampler_t *re, resampler_simd_mask_t mask)
+{
+   (void)re;
+   (void)mask;
+
+#ifdef SINC_AVX512
+   if (     (re->taps >= SINC_AVX512_MIN_TAPS)
+         && (mask & RESAMPLER_SIMD_AVX512)
+         && (mask & RESAMPLER_SIMD_AVX2)
+         && (mask & RESAMPLER_SIMD_FMA))
+      return resampler_sinc_process_avx512;
+#endif
+#ifdef SINC_AVX2
+   if ((mask & RESAMPLER_SIMD_AVX2) && (mask & RESAMPLER_SIMD_FMA))
+      return resampler_sinc_process_avx2;
+#endif
+#ifdef SINC_SSE
+   if (mask & RESAMPLER_SIMD_SSE)
+      return resampler_sinc_process_sse;
+#endif
+#ifdef SINC_NEON
+   /* Always there on AArch64 */
+#if !defined(__aarch64__)
+   if (mask & RESAMPLER_SIMD_NEON)
+#endif
+      return resampler_sinc_process_neon;
+#endif
+
+   return resampler_sinc_process_c;
+}
+
 static void *resampler_sinc_new(const struct resampler_config *config,
       double bandwidth_mod, enum resampler_quality quality,
       resampler_simd_mask_t mask)
@@ -587,7 +684,6 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          re->phase_bits    = 12;
          re->subphase_bits = 10;
          re->window_type   = SINC_WINDOW_LANCZOS;
-         re->enable_avx    = 0;
          break;
       case RESAMPLER_QUALITY_LOWER:
          cutoff            = 0.98;
@@ -595,7 +691,6 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          re->phase_bits    = 12;
          re->subphase_bits = 10;
          re->window_type   = SINC_WINDOW_LANCZOS;
-         re->enable_avx    = 0;
          break;
       case RESAMPLER_QUALITY_HIGHER:
          cutoff            = 0.90;
@@ -604,7 +699,6 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          re->subphase_bits = 14;
          re->window_type   = SINC_WINDOW_KAISER;
          re->kaiser_beta   = 10.5;
-         re->enable_avx    = 1;
          break;
       case RESAMPLER_QUALITY_HIGHEST:
          cutoff            = 0.962;
@@ -613,7 +707,6 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          re->subphase_bits = 14;
          re->window_type   = SINC_WINDOW_KAISER;
          re->kaiser_beta   = 14.5;
-         re->enable_avx    = 1;
          break;
       case RESAMPLER_QUALITY_NORMAL:
       case RESAMPLER_QUALITY_DONTCARE:
@@ -623,7 +716,6 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          re->subphase_bits = 16;
          re->window_type   = SINC_WINDOW_KAISER;
          re->kaiser_beta   = 5.5;
-         re->enable_avx    = 0;
          break;
    }
 
@@ -640,18 +732,10 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    }
 
    /* Be SIMD-friendly. */
-#if defined(__AVX__)
-   if (re->enable_avx)
-      re->taps  = (re->taps + 7) & ~7;
+   if (re->window_type == SINC_WINDOW_KAISER)
+      re->taps     = (re->taps + SINC_BLOCK - 1) & ~(SINC_BLOCK - 1);
    else
-#endif
-   {
-#if defined(WANT_NEON)
-      re->taps     = (re->taps + 7) & ~7;
-#else
       re->taps     = (re->taps + 3) & ~3;
-#endif
-   }
 
    phase_elems     = ((1 << re->phase_bits) * re->taps);
    if (re->window_type == SINC_WINDOW_KAISER)
@@ -682,26 +766,7 @@ static void *resampler_sinc_new(const struct resampler_config *config,
          goto error;
    }
 
-   sinc_resampler.process = resampler_sinc_process_c;
-
-   if (mask & RESAMPLER_SIMD_AVX && re->enable_avx)
-   {
-#if defined(__AVX__)
-      sinc_resampler.process = resampler_sinc_process_avx;
-#endif
-   }
-   else if (mask & RESAMPLER_SIMD_SSE)
-   {
-#if defined(__SSE__)
-      sinc_resampler.process = resampler_sinc_process_sse;
-#endif
-   }
-   else if (mask & RESAMPLER_SIMD_NEON && re->window_type != SINC_WINDOW_KAISER)
-   {
-#if defined(WANT_NEON)
-      sinc_resampler.process = resampler_sinc_process_neon;
-#endif
-   }
+   re->process = resampler_sinc_select(re, mask);
 
    return re;
 
@@ -712,11 +777,10 @@ error:
 
 retro_resampler_t sinc_resampler = {
    resampler_sinc_new,
-   resampler_sinc_process_c,
+   resampler_sinc_process,
    resampler_sinc_free,
    RESAMPLER_API_VERSION,
    "sinc",
    "sinc"
 };
 
-#undef WANT_NEON
@@ -599,7 +599,7 @@ uint64_t cpu_features_get(void)
    const int avx_flags = (1 << 27) | (1 << 28);
 #endif
 
-   char buf[sizeof(" MMX MMXEXT SSE SSE2 SSE3 SSSE3 SS4 SSE4.2 AES AVX AVX2 NEON VMX VMX128 VFPU PS")];
+   char buf[sizeof(" MMX MMXEXT SSE SSE2 SSE3 SSSE3 SS4 SSE4.2 AES AVX AVX2 FMA AVX512 NEON VMX VMX128 VFPU PS")];
 
    memset(buf, 0, sizeof(buf));
 
@@ -737,13 +737,24 @@ uint64_t cpu_features_get(void)
     * AVX CPU support (guaranteed to have at least i686). */
    if (((flags[2] & avx_flags) == avx_flags)
          && ((xgetbv_x86(0) & 0x6) == 0x6))
+   {
       cpu |= RETRO_SIMD_AVX;
 
-   if (max_flag >= 7)
+      if (flags[2] & (1 << 12))
+         cpu |= CPU_FEATURES_FMA;
+   }
+
+   /* AVX2 and AVX-512 need the OS to save the YMM
+    * (and for AVX-512 the opmask and ZMM) state too. */
+   if ((cpu & RETRO_SIMD_AVX) && max_flag >= 7)
    {
       x86_cpuid(7, flags);
       if (flags[1] & (1 << 5))
          cpu |= RETRO_SIMD_AVX2;
+
+      if ((flags[1] & (1 << 16))
+            && ((xgetbv_x86(0) & 0xe6) == 0xe6))
+         cpu |= CPU_FEATURES_AVX512;
    }
 
    x86_cpuid(0x80000000, flags);
@@ -806,25 +817,27 @@ uint64_t cpu_features_get(void)
    cpu |= RETRO_SIMD_PS;
 #endif
 
-   if (cpu & RETRO_SIMD_MMX)    strlcat(buf, " MMX", sizeof(buf));
-   if (cpu & RETRO_SIMD_MMXEXT) strlcat(buf, " MMXEXT", sizeof(buf));
-   if (cpu & RETRO_SIMD_SSE)    strlcat(buf, " SSE", sizeof(buf));
-   if (cpu & RETRO_SIMD_SSE2)   strlcat(buf, " SSE2", sizeof(buf));
-   if (cpu & RETRO_SIMD_SSE3)   strlcat(buf, " SSE3", sizeof(buf));
-   if (cpu & RETRO_SIMD_SSSE3)  strlcat(buf, " SSSE3", sizeof(buf));
-   if (cpu & RETRO_SIMD_SSE4)   strlcat(buf, " SSE4", sizeof(buf));
-   if (cpu & RETRO_SIMD_SSE42)  strlcat(buf, " SSE4.2", sizeof(buf));
-   if (cpu & RETRO_SIMD_AES)    strlcat(buf, " AES", sizeof(buf));
-   if (cpu & RETRO_SIMD_AVX)    strlcat(buf, " AVX", sizeof(buf));
-   if (cpu & RETRO_SIMD_AVX2)   strlcat(buf, " AVX2", sizeof(buf));
-   if (cpu & RETRO_SIMD_NEON)   strlcat(buf, " NEON", sizeof(buf));
-   if (cpu & RETRO_SIMD_VFPV3)  strlcat(buf, " VFPv3", sizeof(buf));
-   if (cpu & RETRO_SIMD_VFPV4)  strlcat(buf, " VFPv4", sizeof(buf));
-   if (cpu & RETRO_SIMD_VMX)    strlcat(buf, " VMX", sizeof(buf));
-   if (cpu & RETRO_SIMD_VMX128) strlcat(buf, " VMX128", sizeof(buf));
-   if (cpu & RETRO_SIMD_VFPU)   strlcat(buf, " VFPU", sizeof(buf));
-   if (cpu & RETRO_SIMD_PS)     strlcat(buf, " PS", sizeof(buf));
-   if (cpu & RETRO_SIMD_ASIMD)  strlcat(buf, " ASIMD", sizeof(buf));
+   if (cpu & RETRO_SIMD_MMX)      strlcat(buf, " MMX", sizeof(buf));
+   if (cpu & RETRO_SIMD_MMXEXT)   strlcat(buf, " MMXEXT", sizeof(buf));
+   if (cpu & RETRO_SIMD_SSE)      strlcat(buf, " SSE", sizeof(buf));
+   if (cpu & RETRO_SIMD_SSE2)     strlcat(buf, " SSE2", sizeof(buf));
+   if (cpu & RETRO_SIMD_SSE3)     strlcat(buf, " SSE3", sizeof(buf));
+   if (cpu & RETRO_SIMD_SSSE3)    strlcat(buf, " SSSE3", sizeof(buf));
+   if (cpu & RETRO_SIMD_SSE4)     strlcat(buf, " SSE4", sizeof(buf));
+   if (cpu & RETRO_SIMD_SSE42)    strlcat(buf, " SSE4.2", sizeof(buf));
+   if (cpu & RETRO_SIMD_AES)      strlcat(buf, " AES", sizeof(buf));
+   if (cpu & RETRO_SIMD_AVX)      strlcat(buf, " AVX", sizeof(buf));
+   if (cpu & RETRO_SIMD_AVX2)     strlcat(buf, " AVX2", sizeof(buf));
+   if (cpu & CPU_FEATURES_FMA)    strlcat(buf, " FMA", sizeof(buf));
+   if (cpu & CPU_FEATURES_AVX512) strlcat(buf, " AVX512", sizeof(buf));
+   if (cpu & RETRO_SIMD_NEON)     strlcat(buf, " NEON", sizeof(buf));
+   if (cpu & RETRO_SIMD_VFPV3)    strlcat(buf, " VFPv3", sizeof(buf));
+   if (cpu & RETRO_SIMD_VFPV4)    strlcat(buf, " VFPv4", sizeof(buf));
+   if (cpu & RETRO_SIMD_VMX)      strlcat(buf, " VMX", sizeof(buf));
+   if (cpu & RETRO_SIMD_VMX128)   strlcat(buf, " VMX128", sizeof(buf));
+   if (cpu & RETRO_SIMD_VFPU)     strlcat(buf, " VFPU", sizeof(buf));
+   if (cpu & RETRO_SIMD_PS)       strlcat(buf, " PS", sizeof(buf));
+   if (cpu & RETRO_SIMD_ASIMD)    strlcat(buf, " ASIMD", sizeof(buf));
 
    return cpu;
 }
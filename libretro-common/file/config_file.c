@@ -51,6 +51,8 @@
 
 #define MAX_INCLUDE_DEPTH 16
 
+#define CONFIG_INDEX_MIN_SIZE 32
+
 struct config_entry_list
 {
    /* If we got this from an #include,
@@ -68,9 +70,164 @@ struct config_include_list
    struct config_include_list *next;
 };
 
+struct config_entry_slot
+{
+   uint32_t hash;
+   struct config_entry_list *entry;
+};
+
 static config_file_t *config_file_new_internal(
       const char *path, unsigned depth, config_file_cb_t *cb);
 
+static uint32_t config_index_hash(const char *key)
+{
+   uint32_t hash = 5381;
+
+   while (*key)
+      hash = (hash << 5) + hash + (uint8_t)*key++;
+
+   return hash;
+}
+
+/* Returns the slot holding key, or the empty slot it would go in.
+ * The index is never more than 3/4 full, so there always is one. */
+static struct config_entry_slot *config_index_slot(
+      const config_file_t *conf, const char *key, uint32_t hash)
+{
+   size_t mask = conf->index_size - 1;
+   size_t i    = hash & mask;
+
+   for (;;)
+   {
+      struct config_entry_slot *slot = &conf->index[i];
+
+      if (!slot->entry || (slot->hash == hash
+               && string_is_equal(slot->entry->key, key)))
+         return slot;
+
+      i = (i + 1) & mask;
+   }
+}
+
+static void config_index_free(config_file_t *conf)
+{
+   if (conf->index)
+      free(conf->index);
+
+   conf->index       = NULL;
+   conf->index_size  = 0;
+   conf->index_count = 0;
+}
+
+static bool config_index_resize(config_file_t *conf, size_t size)
+{
+   size_t i;
+   struct config_entry_slot *old   = conf->index;
+   size_t old_size                 = conf->index_size;
+   struct config_entry_slot *index = (struct config_entry_slot*)
+      calloc(size, sizeof(*index));
+
+   if (!index)
+      return false;
+
+   conf->index      = index;
+   conf->index_size = size;
+
+   for (i = 0; i < old_size; i++)
+      if (old[i].entry)
+         *config_index_slot(conf, old[i].entry->key, old[i].hash) = old[i];
+
+   free(old);
+   return true;
+}
+
+/* Adds entry to the index, unless an entry before it
+ * in the list already has the same key. */
+static void config_index_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   uint32_t hash;
+   struct config_entry_slot *slot = NULL;
+
+   if (!conf->index || !entry->key)
+      return;
+
+   if ((conf->index_count + 1) * 4 > conf->index_size * 3
+         && !config_index_resize(conf, conf->index_size * 2))
+   {
+      /* Gets rebuilt on the next lookup. */
+      config_index_free(conf);
+      return;
+   }
+
+   hash = config_index_hash(entry->key);
+   slot = config_index_slot(conf, entry->key, hash);
+
+   if (slot->entry)
+      return;
+
+   slot->hash  = hash;
+   slot->entry = entry;
+   conf->index_count++;
+}
+
+static void config_index_remove(config_file_t *conf, const char *key)
+{
+   size_t i, j, mask;
+   struct config_entry_slot *slot = NULL;
+
+   if (!conf->index)
+      return;
+
+   slot = config_index_slot(conf, key, config_index_hash(key));
+   if (!slot->entry)
+      return;
+
+   /* Shift the rest of the probe run back over the hole,
+    * except for slots already at or before their home. */
+   mask = conf->index_size - 1;
+   i    = slot - conf->index;
+
+   for (j = (i + 1) & mask; conf->index[j].entry; j = (j + 1) & mask)
+   {
+      size_t home = conf->index[j].hash & mask;
+
+      if (((j - home) & mask) >= ((j - i) & mask))
+      {
+         conf->index[i] = conf->index[j];
+         i              = j;
+      }
+   }
+
+   conf->index[i].entry = NULL;
+   conf->index_count--;
+}
+
+static bool config_index_build(config_file_t *conf)
+{
+   size_t count                    = 0;
+   size_t size                     = CONFIG_INDEX_MIN_SIZE;
+   struct config_entry_list *entry = NULL;
+
+   for (entry = conf->entries; entry; entry = entry->next)
+      count++;
+
+   while (count * 2 > size)
+      size *= 2;
+
+   conf->index = (struct config_entry_slot*)calloc(size, sizeof(*conf->index));
+   if (!conf->index)
+      return false;
+
+   conf->index_size  = size;
+   conf->index_count = 0;
+
+   for (entry = conf->entries; entry && conf->index; entry = entry->next)
+      config_index_add(conf, entry);
+
+   return conf->index != NULL;
+}
+
 static int config_sort_compare_func(struct config_entry_list *a,
       struct config_entry_list *b)
 {
@@ -227,6 +384,11 @@ static char *extract_value(char *line, bool is_value)
 static void add_child_list(config_file_t *parent, config_file_t *child)
 {
    struct config_entry_list *list = child->entries;
+
+   for (; list; list = list->next)
+      config_index_add(parent, list);
+
+   list = child->entries;
    if (parent->entries)
    {
       struct config_entry_list *head = parent->entries;
@@ -449,6 +611,7 @@ static config_file_t *config_file_new_internal(
             conf->entries    = list;
 
          conf->tail = list;
+         config_index_add(conf, list);
 
          if (cb != NULL && list->key != NULL && list->value != NULL)
             cb->config_file_new_entry_cb(list->key, list->value) ;
@@ -508,6 +671,8 @@ void config_file_free(config_file_t *conf)
          free(hold);
    }
 
+   config_index_free(conf);
+
    if (conf->path)
       free(conf->path);
    free(conf);
@@ -524,6 +689,12 @@ bool config_append_file(config_file_t *conf, const char *path)
       new_conf->tail->next = conf->entries;
       conf->entries        = new_conf->entries; /* Pilfer. */
       new_conf->entries    = NULL;
+
+      if (!conf->tail)
+         conf->tail        = new_conf->tail;
+
+      /* The new entries come first now, reindex on the next lookup. */
+      config_index_free(conf);
    }
 
    config_file_free(new_conf);
@@ -539,9 +710,6 @@ config_file_t *config_file_new_from_string(const char *from_string,
    if (!conf)
       return NULL;
 
-   if (!from_string)
-      return conf;
-
    conf->path                     = NULL;
    conf->entries                  = NULL;
    conf->tail                     = NULL;
@@ -549,6 +717,12 @@ config_file_t *config_file_new_from_string(const char *from_string,
    conf->includes                 = NULL;
    conf->include_depth            = 0;
    conf->guaranteed_no_duplicates = false ;
+   conf->index                    = NULL;
+   conf->index_size               = 0;
+   conf->index_count              = 0;
+
+   if (!from_string)
+      return conf;
 
    if (!string_is_empty(path))
       conf->path                  = strdup(path);
@@ -585,6 +759,7 @@ config_file_t *config_file_new_from_string(const char *from_string,
                conf->entries    = list;
 
             conf->tail          = list;
+            config_index_add(conf, list);
          }
       }
 
@@ -641,34 +816,37 @@ config_file_t *config_file_new_alloc(void)
    conf->includes                 = NULL;
    conf->include_depth            = 0;
    conf->guaranteed_no_duplicates = false ;
+   conf->index                    = NULL;
+   conf->index_size               = 0;
+   conf->index_count              = 0;
 
    return conf;
 }
 
 static struct config_entry_list *config_get_entry(
-      const config_file_t *conf,
-      const char *key, struct config_entry_list **prev)
+      config_file_t *conf, const char *key)
 {
-   struct config_entry_list *entry    = NULL;
-   struct config_entry_list *previous = prev ? *prev : NULL;
+   struct config_entry_list *entry = NULL;
+
+   if (!key)
+      return NULL;
 
+   if (conf->index || config_index_build(conf))
+      return config_index_slot(conf, key, config_index_hash(key))->entry;
+
+   /* Out of memory for the index, walk the list instead. */
    for (entry = conf->entries; entry; entry = entry->next)
    {
       if (string_is_equal(key, entry->key))
          return entry;
-
-      previous = entry;
    }
 
-   if (prev)
-      *prev = previous;
-
    return NULL;
 }
 
 bool config_get_double(config_file_t *conf, const char *key, double *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return false;
@@ -679,7 +857,7 @@ bool config_get_double(config_file_t *conf, const char *key, double *in)
 
 bool config_get_float(config_file_t *conf, const char *key, float *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return false;
@@ -691,7 +869,7 @@ bool config_get_float(config_file_t *conf, const char *key, float *in)
 
 bool config_get_int(config_file_t *conf, const char *key, int *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -710,7 +888,7 @@ bool config_get_int(config_file_t *conf, const char *key, int *in)
 
 bool config_get_size_t(config_file_t *conf, const char *key, size_t *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -729,7 +907,7 @@ bool config_get_size_t(config_file_t *conf, const char *key, size_t *in)
 #if defined(__STDC_VERSION__) && __STDC_VERSION__>=199901L
 bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -748,7 +926,7 @@ bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 
 bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -767,7 +945,7 @@ bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
    errno = 0;
 
    if (entry)
@@ -786,7 +964,7 @@ bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 
 bool config_get_char(config_file_t *conf, const char *key, char *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -802,7 +980,7 @@ bool config_get_char(config_file_t *conf, const char *key, char *in)
 
 bool config_get_string(config_file_t *conf, const char *key, char **str)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return false;
@@ -821,7 +999,7 @@ bool config_get_config_path(config_file_t *conf, char *s, size_t len)
 bool config_get_array(config_file_t *conf, const char *key,
       char *buf, size_t size)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
       return strlcpy(buf, entry->value, size) < size;
@@ -835,7 +1013,7 @@ bool config_get_path(config_file_t *conf, const char *key,
    if (config_get_array(conf, key, buf, size))
       return true;
 #else
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -848,7 +1026,7 @@ bool config_get_path(config_file_t *conf, const char *key,
 
 bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 {
-   const struct config_entry_list *entry = config_get_entry(conf, key, NULL);
+   const struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (entry)
    {
@@ -869,8 +1047,8 @@ bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 
 void config_set_string(config_file_t *conf, const char *key, const char *val)
 {
-   struct config_entry_list *last  = (conf->guaranteed_no_duplicates && conf->last) ? conf->last : conf->entries;
-   struct config_entry_list *entry = conf->guaranteed_no_duplicates?NULL:config_get_entry(conf, key, &last);
+   struct config_entry_list *last  = (conf->guaranteed_no_duplicates && conf->last) ? conf->last : conf->tail;
+   struct config_entry_list *entry = conf->guaranteed_no_duplicates?NULL:config_get_entry(conf, key);
 
    if (entry && !entry->readonly)
    {
@@ -898,20 +1076,32 @@ void config_set_string(config_file_t *conf, const char *key, const char *val)
       conf->entries = entry;
 
    conf->last       = entry;
+   conf->tail       = entry;
+   config_index_add(conf, entry);
 }
 
 void config_unset(config_file_t *conf, const char *key)
 {
-   struct config_entry_list *last  = conf->entries;
-   struct config_entry_list *entry = config_get_entry(conf, key, &last);
+   struct config_entry_list *next  = NULL;
+   struct config_entry_list *entry = config_get_entry(conf, key);
 
    if (!entry)
       return;
 
-   entry->key   = NULL;
-   entry->value = NULL;
+   /* A later entry with the same key shows through now. */
+   for (next = entry->next; next; next = next->next)
+      if (string_is_equal(next->key, entry->key))
+         break;
+
+   config_index_remove(conf, entry->key);
+
    free(entry->key);
    free(entry->value);
+   entry->key   = NULL;
+   entry->value = NULL;
+
+   if (next)
+      config_index_add(conf, next);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -1053,6 +1243,9 @@ void config_file_dump_orbis(config_file_t *conf, int fd)
    list = merge_sort_linked_list((struct config_entry_list*)conf->entries, config_sort_compare_func);
    conf->entries = list;
 
+   /* Sorting may change which duplicate comes first. */
+   config_index_free(conf);
+
    while (list)
    {
       if (!list->readonly && list->key)
@@ -1061,6 +1254,7 @@ void config_file_dump_orbis(config_file_t *conf, int fd)
          sprintf(newlist,"%s = %s\n", list->key, list->value);
          orbisWrite(fd, newlist, strlen(newlist));
       }
+      conf->tail = list;
       list = list->next;
    }
 }
@@ -1078,8 +1272,13 @@ void config_file_dump(config_file_t *conf, FILE *file, bool sort)
    }
 
    if (sort)
+   {
       list = merge_sort_linked_list((struct config_entry_list*)
             conf->entries, config_sort_compare_func);
+
+      /* Sorting may change which duplicate comes first. */
+      config_index_free(conf);
+   }
    else
       list = (struct config_entry_list*)conf->entries;
 
@@ -1089,22 +1288,14 @@ void config_file_dump(config_file_t *conf, FILE *file, bool sort)
    {
       if (!list->readonly && list->key)
          fprintf(file, "%s = \"%s\"\n", list->key, list->value);
+      conf->tail = list;
       list = list->next;
    }
 }
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (string_is_equal(entry, list->key))
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_get_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
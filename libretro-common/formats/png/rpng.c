@@ -30,6 +30,7 @@
 #endif
 
 #include <boolean.h>
+#include <features/features_cpu.h>
 #include <formats/image.h>
 #include <formats/rpng.h>
 #include <streams/trans_stream.h>
@@ -37,6 +38,39 @@
 
 #include "rpng_internal.h"
 
+#if _MSC_VER && _MSC_VER <= 1800
+#define RPNG_NO_SIMD
+#endif
+
+#if defined(__SSE2__) && !defined(RPNG_NO_SIMD)
+#define RPNG_SSE2
+#include <emmintrin.h>
+
+/* The SSSE3 converter is built whenever the compiler can emit it
+ * and used when the CPU has it, see rpng_set_simd(). */
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 7)
+#define RPNG_SSSE3
+#define RPNG_TARGET_SSSE3 __attribute__((target("ssse3")))
+#elif defined(__SSSE3__)
+#define RPNG_SSSE3
+#define RPNG_TARGET_SSSE3
+#endif
+#endif
+
+#ifdef RPNG_SSSE3
+#include <tmmintrin.h>
+#endif
+
+/* The NEON code leans on the lane order of little endian loads. */
+#if !defined(RPNG_NO_SIMD) && (defined(__ARM_NEON) || defined(__aarch64__)) && !defined(__ARM_BIG_ENDIAN) && !defined(DONT_WANT_ARM_OPTIMIZATIONS)
+#define RPNG_NEON
+#include <arm_neon.h>
+#endif
+
+/* Rows of non-interlaced images are inflated and unfiltered
+ * in batches of about this many bytes. */
+#define RPNG_BATCH_SIZE 0x10000
+
 enum png_ihdr_color_type
 {
    PNG_IHDR_COLOR_GRAY       = 0,
@@ -110,6 +144,7 @@ struct rpng_process
    unsigned pass_width;
    unsigned pass_height;
    unsigned pass_pos;
+   unsigned batch_rows;
    uint32_t *data;
    uint32_t *palette;
    void *stream;
@@ -131,6 +166,29 @@ struct rpng
    uint32_t palette[256];
 };
 
+static uint64_t rpng_simd      = 0;
+static bool rpng_simd_detected = false;
+
+/**
+ * rpng_set_simd:
+ * @simd         : RETRO_SIMD_* flags.
+ *
+ * Limits the decoder to the vector code @simd allows.
+ * Until this is called, it goes by what the CPU has.
+ **/
+void rpng_set_simd(uint64_t simd)
+{
+   rpng_simd          = simd;
+   rpng_simd_detected = true;
+}
+
+static uint64_t rpng_get_simd(void)
+{
+   if (!rpng_simd_detected)
+      rpng_set_simd(cpu_features_get());
+   return rpng_simd;
+}
+
 static INLINE uint32_t dword_be(const uint8_t *buf)
 {
    return (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3] << 0);
@@ -229,14 +287,416 @@ end:
    return ret;
 }
 
-static void png_reverse_filter_copy_line_rgb(uint32_t *data,
-      const uint8_t *decoded, unsigned width, unsigned bpp)
+#if defined(RPNG_SSE2) || defined(RPNG_NEON)
+/* Pixels of 3 or 4 bytes go through the low bytes
+ * of a word, first byte lowest. */
+static INLINE uint32_t png_pixel_load(const uint8_t *p, unsigned bpp)
+{
+   uint32_t v;
+
+   if (bpp == 4)
+   {
+      memcpy(&v, p, sizeof(v));
+      return v;
+   }
+
+   return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static INLINE void png_pixel_store(uint8_t *p, uint32_t v, unsigned bpp)
+{
+   if (bpp == 4)
+   {
+      memcpy(p, &v, sizeof(v));
+      return;
+   }
+
+   p[0] = (uint8_t)v;
+   p[1] = (uint8_t)(v >> 8);
+   p[2] = (uint8_t)(v >> 16);
+}
+#endif
+
+#ifdef RPNG_SSE2
+static void png_reverse_filter_up_sse2(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
 {
    unsigned i;
 
-   bpp /= 8;
+   for (i = 0; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(in + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
 
-   for (i = 0; i < width; i++)
+   for (; i < pitch; i++)
+      out[i] = prev[i] + in[i];
+}
+
+/* Sums up 4 pixels at a time across the register, then adds
+ * the last pixel of the step before to all of them. */
+static void png_reverse_filter_sub_sse2(uint8_t *out, const uint8_t *in,
+      unsigned bpp, unsigned pitch)
+{
+   unsigned i   = 0;
+   __m128i last = _mm_setzero_si128();
+
+   if (bpp == 4)
+   {
+      for (; i + 16 <= pitch; i += 16)
+      {
+         __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+         x         = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+         x         = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+         x         = _mm_add_epi8(x, last);
+         last      = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+         _mm_storeu_si128((__m128i*)(out + i), x);
+      }
+   }
+   else
+   {
+      const __m128i mask = _mm_cvtsi32_si128(0xffffff);
+
+      /* The top 4 bytes of every store get written
+       * again by the next step or the loop below. */
+      for (; i + 16 <= pitch; i += 12)
+      {
+         __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+         x         = _mm_add_epi8(x, _mm_slli_si128(x, 3));
+         x         = _mm_add_epi8(x, _mm_slli_si128(x, 6));
+         x         = _mm_add_epi8(x, last);
+         last      = _mm_and_si128(_mm_srli_si128(x, 9), mask);
+         last      = _mm_or_si128(last, _mm_slli_si128(last, 3));
+         last      = _mm_or_si128(last, _mm_slli_si128(last, 6));
+         _mm_storeu_si128((__m128i*)(out + i), x);
+      }
+   }
+
+   for (; i < bpp && i < pitch; i++)
+      out[i] = in[i];
+   for (; i < pitch; i++)
+      out[i] = out[i - bpp] + in[i];
+}
+
+/* Average and Paeth need the pixel before, so these
+ * go one pixel at a time, all channels at once. */
+static void png_reverse_filter_avg_sse2(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned bpp, unsigned pitch)
+{
+   unsigned i;
+   const __m128i one = _mm_set1_epi8(1);
+   __m128i a         = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b   = _mm_cvtsi32_si128((int)png_pixel_load(prev + i, bpp));
+      __m128i x   = _mm_cvtsi32_si128((int)png_pixel_load(in + i, bpp));
+      /* pavgb rounds up, take that back off */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
+
+      a           = _mm_add_epi8(x, avg);
+      png_pixel_store(out + i, (uint32_t)_mm_cvtsi128_si32(a), bpp);
+   }
+}
+
+static void png_reverse_filter_paeth_sse2(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned bpp, unsigned pitch)
+{
+   unsigned i;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i a          = zero;
+   __m128i c          = zero;
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b  = _mm_unpacklo_epi8(
+            _mm_cvtsi32_si128((int)png_pixel_load(prev + i, bpp)), zero);
+      __m128i x  = _mm_cvtsi32_si128((int)png_pixel_load(in + i, bpp));
+      /* p - a, p - b and p - c, where p = a + b - c */
+      __m128i pa = _mm_sub_epi16(b, c);
+      __m128i pb = _mm_sub_epi16(a, c);
+      __m128i pc = _mm_add_epi16(pa, pb);
+      __m128i not_a, not_b, pred;
+
+      pa    = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+      pb    = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+      pc    = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+      not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+      not_b = _mm_cmpgt_epi16(pb, pc);
+      pred  = _mm_or_si128(_mm_andnot_si128(not_b, b),
+            _mm_and_si128(not_b, c));
+      pred  = _mm_or_si128(_mm_andnot_si128(not_a, a),
+            _mm_and_si128(not_a, pred));
+
+      x     = _mm_add_epi8(x, _mm_packus_epi16(pred, pred));
+      png_pixel_store(out + i, (uint32_t)_mm_cvtsi128_si32(x), bpp);
+
+      a     = _mm_unpacklo_epi8(x, zero);
+      c     = b;
+   }
+}
+
+static unsigned png_reverse_filter_copy_line_rgba_sse2(uint32_t *data,
+      const uint8_t *decoded, unsigned width)
+{
+   unsigned i;
+   const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+   const __m128i ag_mask = _mm_slli_epi32(rb_mask, 8);
+
+   for (i = 0; i + 4 <= width; i += 4)
+   {
+      __m128i x  = _mm_loadu_si128((const __m128i*)(decoded + i * 4));
+      __m128i rb = _mm_and_si128(x, rb_mask);
+
+      /* Swap red and blue */
+      rb         = _mm_or_si128(_mm_slli_epi32(rb, 16),
+            _mm_srli_epi32(rb, 16));
+      _mm_storeu_si128((__m128i*)(data + i),
+            _mm_or_si128(_mm_and_si128(x, ag_mask), rb));
+   }
+
+   return i;
+}
+#endif
+
+#ifdef RPNG_SSSE3
+RPNG_TARGET_SSSE3
+static unsigned png_reverse_filter_copy_line_rgb_ssse3(uint32_t *data,
+      const uint8_t *decoded, unsigned width)
+{
+   unsigned i;
+   const __m128i shuffle = _mm_setr_epi8(
+         2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+   const __m128i alpha   = _mm_slli_epi32(_mm_set1_epi32(0xff), 24);
+
+   /* Every step reads 16 bytes for 4 pixels, stop while
+    * that still stays inside the row. */
+   for (i = 0; i + 6 <= width; i += 4)
+      _mm_storeu_si128((__m128i*)(data + i), _mm_or_si128(_mm_shuffle_epi8(
+                  _mm_loadu_si128((const __m128i*)(decoded + i * 3)),
+                  shuffle), alpha));
+
+   return i;
+}
+#endif
+
+#ifdef RPNG_NEON
+#define PNG_NEON_PIXEL(p, bpp) \
+   vreinterpret_u8_u32(vdup_n_u32(png_pixel_load(p, bpp)))
+#define PNG_NEON_WORD(v) vget_lane_u32(vreinterpret_u32_u8(v), 0)
+
+static void png_reverse_filter_up_neon(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
+{
+   unsigned i;
+
+   for (i = 0; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(in + i), vld1q_u8(prev + i)));
+
+   for (; i < pitch; i++)
+      out[i] = prev[i] + in[i];
+}
+
+static void png_reverse_filter_sub_neon(uint8_t *out, const uint8_t *in,
+      unsigned bpp, unsigned pitch)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = vadd_u8(a, PNG_NEON_PIXEL(in + i, bpp));
+      png_pixel_store(out + i, PNG_NEON_WORD(a), bpp);
+   }
+}
+
+static void png_reverse_filter_avg_neon(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned bpp, unsigned pitch)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = vadd_u8(PNG_NEON_PIXEL(in + i, bpp),
+            vhadd_u8(a, PNG_NEON_PIXEL(prev + i, bpp)));
+      png_pixel_store(out + i, PNG_NEON_WORD(a), bpp);
+   }
+}
+
+static void png_reverse_filter_paeth_neon(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned bpp, unsigned pitch)
+{
+   unsigned i;
+   uint16x8_t a = vdupq_n_u16(0);
+   uint16x8_t c = vdupq_n_u16(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      uint16x8_t b     = vmovl_u8(PNG_NEON_PIXEL(prev + i, bpp));
+      /* |p - a|, |p - b| and |p - c|, where p = a + b - c */
+      uint16x8_t pa    = vabdq_u16(b, c);
+      uint16x8_t pb    = vabdq_u16(a, c);
+      uint16x8_t pc    = vabdq_u16(vaddq_u16(a, b), vaddq_u16(c, c));
+      uint16x8_t use_a = vandq_u16(vcleq_u16(pa, pb), vcleq_u16(pa, pc));
+      uint16x8_t pred  = vbslq_u16(use_a, a,
+            vbslq_u16(vcleq_u16(pb, pc), b, c));
+      uint8x8_t x      = vadd_u8(PNG_NEON_PIXEL(in + i, bpp),
+            vmovn_u16(pred));
+
+      png_pixel_store(out + i, PNG_NEON_WORD(x), bpp);
+
+      a = vmovl_u8(x);
+      c = b;
+   }
+}
+
+static unsigned png_reverse_filter_copy_line_rgb_neon(uint32_t *data,
+      const uint8_t *decoded, unsigned width)
+{
+   unsigned i;
+
+   for (i = 0; i + 8 <= width; i += 8)
+   {
+      uint8x8x3_t rgb = vld3_u8(decoded + i * 3);
+      uint8x8x4_t argb;
+
+      argb.val[0] = rgb.val[2];
+      argb.val[1] = rgb.val[1];
+      argb.val[2] = rgb.val[0];
+      argb.val[3] = vdup_n_u8(0xff);
+      vst4_u8((uint8_t*)(data + i), argb);
+   }
+
+   return i;
+}
+
+static unsigned png_reverse_filter_copy_line_rgba_neon(uint32_t *data,
+      const uint8_t *decoded, unsigned width)
+{
+   unsigned i;
+
+   for (i = 0; i + 8 <= width; i += 8)
+   {
+      uint8x8x4_t px = vld4_u8(decoded + i * 4);
+      uint8x8_t r    = px.val[0];
+
+      px.val[0]      = px.val[2];
+      px.val[2]      = r;
+      vst4_u8((uint8_t*)(data + i), px);
+   }
+
+   return i;
+}
+#endif
+
+/* Unfilters a row with whatever vector unit is on, if it has code
+ * for this filter and pixel size. Returns false to leave the row
+ * to the C code. */
+static bool png_reverse_filter_line_simd(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned filter, unsigned bpp, unsigned pitch,
+      uint64_t simd)
+{
+   bool pixels = bpp == 3 || bpp == 4;
+
+#if defined(RPNG_SSE2)
+   if (simd & RETRO_SIMD_SSE2)
+   {
+      switch (filter)
+      {
+         case PNG_FILTER_UP:
+            png_reverse_filter_up_sse2(out, in, prev, pitch);
+            return true;
+         case PNG_FILTER_SUB:
+            if (!pixels)
+               break;
+            png_reverse_filter_sub_sse2(out, in, bpp, pitch);
+            return true;
+         case PNG_FILTER_AVERAGE:
+            if (!pixels)
+               break;
+            png_reverse_filter_avg_sse2(out, in, prev, bpp, pitch);
+            return true;
+         case PNG_FILTER_PAETH:
+            if (!pixels)
+               break;
+            png_reverse_filter_paeth_sse2(out, in, prev, bpp, pitch);
+            return true;
+      }
+   }
+#elif defined(RPNG_NEON)
+   if (simd & RETRO_SIMD_NEON)
+   {
+      switch (filter)
+      {
+         case PNG_FILTER_UP:
+            png_reverse_filter_up_neon(out, in, prev, pitch);
+            return true;
+         case PNG_FILTER_SUB:
+            if (!pixels)
+               break;
+            png_reverse_filter_sub_neon(out, in, bpp, pitch);
+            return true;
+         case PNG_FILTER_AVERAGE:
+            if (!pixels)
+               break;
+            png_reverse_filter_avg_neon(out, in, prev, bpp, pitch);
+            return true;
+         case PNG_FILTER_PAETH:
+            if (!pixels)
+               break;
+            png_reverse_filter_paeth_neon(out, in, prev, bpp, pitch);
+            return true;
+      }
+   }
+#else
+   (void)pixels;
+#endif
+
+   return false;
+}
+
+/* Row helpers for 8 bit RGB and RGBA. Each one converts as much
+ * of a row as it can and returns how many pixels it did. */
+static unsigned png_reverse_filter_copy_line_rgb_simd(uint32_t *data,
+      const uint8_t *decoded, unsigned width, uint64_t simd)
+{
+#if defined(RPNG_SSSE3)
+   if (simd & RETRO_SIMD_SSSE3)
+      return png_reverse_filter_copy_line_rgb_ssse3(data, decoded, width);
+#elif defined(RPNG_NEON)
+   if (simd & RETRO_SIMD_NEON)
+      return png_reverse_filter_copy_line_rgb_neon(data, decoded, width);
+#endif
+   return 0;
+}
+
+static unsigned png_reverse_filter_copy_line_rgba_simd(uint32_t *data,
+      const uint8_t *decoded, unsigned width, uint64_t simd)
+{
+#if defined(RPNG_SSE2)
+   if (simd & RETRO_SIMD_SSE2)
+      return png_reverse_filter_copy_line_rgba_sse2(data, decoded, width);
+#elif defined(RPNG_NEON)
+   if (simd & RETRO_SIMD_NEON)
+      return png_reverse_filter_copy_line_rgba_neon(data, decoded, width);
+#endif
+   return 0;
+}
+
+static void png_reverse_filter_copy_line_rgb(uint32_t *data,
+      const uint8_t *decoded, unsigned width, unsigned bpp, uint64_t simd)
+{
+   unsigned i = 0;
+
+   if (bpp == 8)
+      i = png_reverse_filter_copy_line_rgb_simd(data, decoded, width, simd);
+
+   bpp     /= 8;
+   decoded += i * 3 * bpp;
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b;
 
@@ -251,13 +711,17 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 }
 
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
-      const uint8_t *decoded, unsigned width, unsigned bpp)
+      const uint8_t *decoded, unsigned width, unsigned bpp, uint64_t simd)
 {
-   unsigned i;
+   unsigned i = 0;
 
-   bpp /= 8;
+   if (bpp == 8)
+      i = png_reverse_filter_copy_line_rgba_simd(data, decoded, width, simd);
 
-   for (i = 0; i < width; i++)
+   bpp     /= 8;
+   decoded += i * 4 * bpp;
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -559,7 +1023,8 @@ static int png_reverse_filter_init(const struct png_ihdr *ihdr,
 
    png_pass_geom(ihdr, ihdr->width, ihdr->height, &pngp->bpp, &pngp->pitch, &pass_size);
 
-   if (pngp->total_out < pass_size)
+   /* Row batches are only inflated as they are needed */
+   if (!pngp->batch_rows && pngp->total_out < pass_size)
       return -1;
 
    pngp->restore_buf_size      = 0;
@@ -584,44 +1049,51 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
       struct rpng_process *pngp, unsigned filter)
 {
    unsigned i;
+   uint8_t *scanline;
+   uint64_t simd = rpng_get_simd();
 
-   switch (filter)
+   if (!png_reverse_filter_line_simd(pngp->decoded_scanline,
+            pngp->inflate_buf, pngp->prev_scanline,
+            filter, pngp->bpp, pngp->pitch, simd))
    {
-      case PNG_FILTER_NONE:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
-         break;
-      case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
-         break;
-      case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
-         break;
-      case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
-         {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         break;
-      case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
-         break;
-
-      default:
-         return IMAGE_PROCESS_ERROR_END;
+      switch (filter)
+      {
+         case PNG_FILTER_NONE:
+            memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
+            break;
+         case PNG_FILTER_SUB:
+            for (i = 0; i < pngp->bpp; i++)
+               pngp->decoded_scanline[i] = pngp->inflate_buf[i];
+            for (i = pngp->bpp; i < pngp->pitch; i++)
+               pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+            break;
+         case PNG_FILTER_UP:
+            for (i = 0; i < pngp->pitch; i++)
+               pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+            break;
+         case PNG_FILTER_AVERAGE:
+            for (i = 0; i < pngp->bpp; i++)
+            {
+               uint8_t avg = pngp->prev_scanline[i] >> 1;
+               pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
+            }
+            for (i = pngp->bpp; i < pngp->pitch; i++)
+            {
+               uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
+               pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
+            }
+            break;
+         case PNG_FILTER_PAETH:
+            for (i = 0; i < pngp->bpp; i++)
+               pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
+            for (i = pngp->bpp; i < pngp->pitch; i++)
+               pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
+                     pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+            break;
+
+         default:
+            return IMAGE_PROCESS_ERROR_END;
+      }
    }
 
    switch (ihdr->color_type)
@@ -630,7 +1102,8 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
          png_reverse_filter_copy_line_bw(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
          break;
       case PNG_IHDR_COLOR_RGB:
-         png_reverse_filter_copy_line_rgb(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_rgb(data, pngp->decoded_scanline, ihdr->width,
+               ihdr->depth, simd);
          break;
       case PNG_IHDR_COLOR_PLT:
          png_reverse_filter_copy_line_plt(data, pngp->decoded_scanline, ihdr->width,
@@ -641,11 +1114,15 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
                ihdr->depth);
          break;
       case PNG_IHDR_COLOR_RGBA:
-         png_reverse_filter_copy_line_rgba(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_rgba(data, pngp->decoded_scanline, ihdr->width,
+               ihdr->depth, simd);
          break;
    }
 
-   memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
+   /* This row is the previous one for the next */
+   scanline               = pngp->prev_scanline;
+   pngp->prev_scanline    = pngp->decoded_scanline;
+   pngp->decoded_scanline = scanline;
 
    return IMAGE_PROCESS_NEXT;
 }
@@ -684,6 +1161,84 @@ end:
    return ret;
 }
 
+/* Inflates the next batch of rows to the start of the inflate
+ * buffer. Returns how many rows it got, or 0 if the image data
+ * is corrupt or ends too early. */
+static unsigned png_reverse_filter_inflate_batch(const struct png_ihdr *ihdr,
+      struct rpng_process *pngp)
+{
+   size_t size;
+   size_t total  = 0;
+   unsigned rows = ihdr->height - pngp->h;
+
+   if (rows > pngp->batch_rows)
+      rows = pngp->batch_rows;
+
+   size = (size_t)(pngp->pitch + 1) * rows;
+
+   pngp->inflate_buf     -= pngp->restore_buf_size;
+   pngp->restore_buf_size = 0;
+
+   pngp->stream_backend->set_out(pngp->stream,
+         pngp->inflate_buf, (uint32_t)size);
+
+   while (total < size)
+   {
+      uint32_t rd, wn;
+      enum trans_stream_error terror;
+      bool zstatus = pngp->stream_backend->trans(pngp->stream,
+            false, &rd, &wn, &terror);
+
+      if (!zstatus && terror != TRANS_STREAM_ERROR_BUFFER_FULL)
+         return 0;
+
+      pngp->avail_in  -= rd;
+      pngp->total_out += wn;
+      total           += wn;
+
+      /* End of the stream */
+      if (zstatus && terror == TRANS_STREAM_ERROR_NONE)
+         break;
+   }
+
+   if (total < size)
+      return 0;
+
+   return rows;
+}
+
+static int png_reverse_filter_batch_iterate(uint32_t **data, const struct png_ihdr *ihdr,
+      struct rpng_process *pngp)
+{
+   if (pngp->h < ihdr->height)
+   {
+      unsigned rows = png_reverse_filter_inflate_batch(ihdr, pngp);
+
+      if (!rows)
+      {
+         png_reverse_filter_deinit(pngp);
+
+         *data -= pngp->data_restore_buf_size;
+         pngp->data_restore_buf_size = 0;
+         return IMAGE_PROCESS_ERROR_END;
+      }
+
+      while (rows--)
+      {
+         int ret = png_reverse_filter_regular_iterate(data, ihdr, pngp);
+
+         if (ret != IMAGE_PROCESS_NEXT)
+            return ret;
+      }
+
+      if (pngp->h < ihdr->height)
+         return IMAGE_PROCESS_NEXT;
+   }
+
+   /* Wraps up once the last row is done */
+   return png_reverse_filter_regular_iterate(data, ihdr, pngp);
+}
+
 static int png_reverse_filter_adam7_iterate(uint32_t **data_,
       const struct png_ihdr *ihdr,
       struct rpng_process *pngp)
@@ -771,6 +1326,9 @@ static int png_reverse_filter_iterate(rpng_t *rpng, uint32_t **data)
    if (rpng->ihdr.interlace && rpng->process)
       return png_reverse_filter_adam7(data, &rpng->ihdr, rpng->process);
 
+   if (rpng->process->batch_rows)
+      return png_reverse_filter_batch_iterate(data, &rpng->ihdr, rpng->process);
+
    return png_reverse_filter_regular_iterate(data, &rpng->ihdr, rpng->process);
 }
 
@@ -783,7 +1341,8 @@ static int rpng_load_image_argb_process_inflate_init(rpng_t *rpng, uint32_t **da
    bool to_continue        = (process->avail_in > 0
          && process->avail_out > 0);
 
-   if (!to_continue)
+   /* Row batches get inflated as they are unfiltered */
+   if (!to_continue || process->batch_rows)
       goto end;
 
    zstatus = process->stream_backend->trans(process->stream, false, &rd, &wn, &terror);
@@ -799,8 +1358,11 @@ static int rpng_load_image_argb_process_inflate_init(rpng_t *rpng, uint32_t **da
       return 0;
 
 end:
-   process->stream_backend->stream_free(process->stream);
-   process->stream = NULL;
+   if (!process->batch_rows)
+   {
+      process->stream_backend->stream_free(process->stream);
+      process->stream = NULL;
+   }
 
 #ifdef GEKKO
    /* we often use these in textures, make sure they're 32-byte aligned */
@@ -869,6 +1431,7 @@ bool png_realloc_idat(const struct png_chunk *chunk, struct idat_buffer *buf)
 
 static struct rpng_process *rpng_process_init(rpng_t *rpng)
 {
+   unsigned pitch               = 0;
    uint8_t *inflate_buf         = NULL;
    struct rpng_process *process = (struct rpng_process*)calloc(1, sizeof(*process));
 
@@ -878,9 +1441,20 @@ static struct rpng_process *rpng_process_init(rpng_t *rpng)
    process->stream_backend = trans_stream_get_zlib_inflate_backend();
 
    png_pass_geom(&rpng->ihdr, rpng->ihdr.width,
-         rpng->ihdr.height, NULL, NULL, &process->inflate_buf_size);
+         rpng->ihdr.height, NULL, &pitch, &process->inflate_buf_size);
    if (rpng->ihdr.interlace == 1) /* To be sure. */
       process->inflate_buf_size *= 2;
+   else
+   {
+      /* Inflate a batch of rows at a time and unfilter them while
+       * they are still in the cache, instead of the whole image. */
+      process->batch_rows = RPNG_BATCH_SIZE / (pitch + 1);
+      if (process->batch_rows < 1)
+         process->batch_rows = 1;
+      if (process->batch_rows > rpng->ihdr.height)
+         process->batch_rows = rpng->ihdr.height;
+      process->inflate_buf_size = (size_t)(pitch + 1) * process->batch_rows;
+   }
 
    process->stream = process->stream_backend->stream_new();
 
@@ -976,7 +1550,6 @@ static bool png_parse_ihdr(uint8_t *buf,
 
 bool rpng_iterate_image(rpng_t *rpng)
 {
-   unsigned i;
    struct png_chunk chunk;
    uint8_t *buf           = (uint8_t*)rpng->buff_data;
 
@@ -991,13 +1564,6 @@ bool rpng_iterate_image(rpng_t *rpng)
    if (!read_chunk_header(buf, rpng->buff_end, &chunk))
       goto error;
 
-#if 0
-   for (i = 0; i < 4; i++)
-   {
-      fprintf(stderr, "chunktype: %c\n", chunk.type[i]);
-   }
-#endif
-
    switch (png_chunk_type(&chunk))
    {
       case PNG_CHUNK_NOOP:
@@ -1074,8 +1640,7 @@ bool rpng_iterate_image(rpng_t *rpng)
 
          buf += 8;
 
-         for (i = 0; i < chunk.size; i++)
-            rpng->idat_buf.data[i + rpng->idat_buf.size] = buf[i];
+         memcpy(rpng->idat_buf.data + rpng->idat_buf.size, buf, chunk.size);
 
          rpng->idat_buf.size += chunk.size;
 
@@ -1140,6 +1705,7 @@ error:
       if (rpng->process->stream)
          rpng->process->stream_backend->stream_free(rpng->process->stream);
       free(rpng->process);
+      rpng->process = NULL;
    }
    return IMAGE_PROCESS_ERROR;
 }
@@ -25,7 +25,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <boolean.h>
 #include <retro_inline.h>
+#include <features/features_cpu.h>
 
 #include <gfx/scaler/pixconv.h>
 
@@ -43,6 +45,376 @@
 #include <mmintrin.h>
 #endif
 
+/* The AVX2 converters are built whenever the compiler can emit them
+ * and used when the CPU has it, see conv_set_simd(). */
+#if !defined(SCALER_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(__i486__) || defined(__i686__) || defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86))
+#if defined(_MSC_VER) && _MSC_VER >= 1910
+#define CONV_AVX2
+#define CONV_TARGET_AVX2
+#elif defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 7)
+#define CONV_AVX2
+#define CONV_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define CONV_AVX2
+#define CONV_TARGET_AVX2
+#endif
+#endif
+
+#ifdef CONV_AVX2
+#include <immintrin.h>
+#endif
+
+/* The NEON converters lean on the lane order of little endian loads. */
+#if !defined(SCALER_NO_SIMD) && (defined(__ARM_NEON) || defined(__aarch64__)) && !defined(__ARM_BIG_ENDIAN) && !defined(DONT_WANT_ARM_OPTIMIZATIONS)
+#define CONV_NEON
+#include <arm_neon.h>
+#endif
+
+static uint64_t conv_simd      = 0;
+static bool conv_simd_detected = false;
+
+/**
+ * conv_set_simd:
+ * @simd         : RETRO_SIMD_* flags.
+ *
+ * Limits the converters to the vector code @simd allows.
+ * Until this is called, they go by what the CPU has.
+ **/
+void conv_set_simd(uint64_t simd)
+{
+   conv_simd          = simd;
+   conv_simd_detected = true;
+}
+
+/**
+ * conv_get_simd:
+ *
+ * Returns: the RETRO_SIMD_* flags the converters go by.
+ **/
+uint64_t conv_get_simd(void)
+{
+   if (!conv_simd_detected)
+      conv_set_simd(cpu_features_get());
+   return conv_simd;
+}
+
+/* Row helpers for the wider vector units. Each one converts as much
+ * of a row as it can and returns how many pixels it did, the callers
+ * finish the row with their own code. */
+#ifdef CONV_AVX2
+CONV_TARGET_AVX2
+static int conv_rgb565_0rgb1555_avx2(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i hi_mask = _mm256_set1_epi16(0x7fe0);
+   const __m256i lo_mask = _mm256_set1_epi16(0x1f);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i hi       = _mm256_and_si256(_mm256_srli_epi16(in, 1), hi_mask);
+      __m256i lo       = _mm256_and_si256(in, lo_mask);
+      _mm256_storeu_si256((__m256i*)(output + w), _mm256_or_si256(hi, lo));
+   }
+
+   return w;
+}
+
+CONV_TARGET_AVX2
+static int conv_0rgb1555_rgb565_avx2(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i hi_mask   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask = _mm256_set1_epi16(1 << 5);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i rg       = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask);
+      __m256i b        = _mm256_and_si256(in, lo_mask);
+      __m256i glow     = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask);
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
+   }
+
+   return w;
+}
+
+/* Same as the SSE2 code. The unpacks work within 128-bit lanes, so
+ * the halves get put back in order on the way out. */
+CONV_TARGET_AVX2
+static INLINE void conv_store_argb8888_avx2(uint32_t *output,
+      __m256i r, __m256i g, __m256i b)
+{
+   const __m256i a   = _mm256_set1_epi16(0x00ff);
+   __m256i res_lo_bg = _mm256_unpacklo_epi8(b, g);
+   __m256i res_hi_bg = _mm256_unpackhi_epi8(b, g);
+   __m256i res_lo_ra = _mm256_unpacklo_epi8(r, a);
+   __m256i res_hi_ra = _mm256_unpackhi_epi8(r, a);
+   __m256i res_lo    = _mm256_or_si256(res_lo_bg,
+         _mm256_slli_si256(res_lo_ra, 2));
+   __m256i res_hi    = _mm256_or_si256(res_hi_bg,
+         _mm256_slli_si256(res_hi_ra, 2));
+
+   _mm256_storeu_si256((__m256i*)(output + 0),
+         _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+   _mm256_storeu_si256((__m256i*)(output + 8),
+         _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+}
+
+CONV_TARGET_AVX2
+static int conv_0rgb1555_argb8888_avx2(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i pix_mask_r  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_gb = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul15_mid   = _mm256_set1_epi16(0x4200);
+   const __m256i mul15_hi    = _mm256_set1_epi16(0x0210);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i r = _mm256_and_si256(in, pix_mask_r);
+      __m256i g = _mm256_and_si256(in, pix_mask_gb);
+      __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_gb);
+
+      r = _mm256_mulhi_epi16(r, mul15_hi);
+      g = _mm256_mulhi_epi16(g, mul15_mid);
+      b = _mm256_mulhi_epi16(b, mul15_mid);
+
+      conv_store_argb8888_avx2(output + w, r, g, b);
+   }
+
+   return w;
+}
+
+CONV_TARGET_AVX2
+static int conv_rgb565_argb8888_avx2(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const __m256i pix_mask_r = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_g = _mm256_set1_epi16(0x3f <<  5);
+   const __m256i pix_mask_b = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul16_r    = _mm256_set1_epi16(0x0210);
+   const __m256i mul16_g    = _mm256_set1_epi16(0x2080);
+   const __m256i mul16_b    = _mm256_set1_epi16(0x4200);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i r = _mm256_and_si256(_mm256_srli_epi16(in, 1), pix_mask_r);
+      __m256i g = _mm256_and_si256(in, pix_mask_g);
+      __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_b);
+
+      r = _mm256_mulhi_epi16(r, mul16_r);
+      g = _mm256_mulhi_epi16(g, mul16_g);
+      b = _mm256_mulhi_epi16(b, mul16_b);
+
+      conv_store_argb8888_avx2(output + w, r, g, b);
+   }
+
+   return w;
+}
+
+CONV_TARGET_AVX2
+static INLINE __m256i conv_argb8888_0rgb1555_epi32_avx2(__m256i c)
+{
+   __m256i r = _mm256_and_si256(_mm256_srli_epi32(c, 9),
+         _mm256_set1_epi32(0x1f << 10));
+   __m256i g = _mm256_and_si256(_mm256_srli_epi32(c, 6),
+         _mm256_set1_epi32(0x1f <<  5));
+   __m256i b = _mm256_and_si256(_mm256_srli_epi32(c, 3),
+         _mm256_set1_epi32(0x1f));
+   return _mm256_or_si256(r, _mm256_or_si256(g, b));
+}
+
+CONV_TARGET_AVX2
+static int conv_argb8888_0rgb1555_avx2(uint16_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m256i lo = conv_argb8888_0rgb1555_epi32_avx2(
+            _mm256_loadu_si256((const __m256i*)(input + w + 0)));
+      __m256i hi = conv_argb8888_0rgb1555_epi32_avx2(
+            _mm256_loadu_si256((const __m256i*)(input + w + 8)));
+
+      /* The pack interleaves the lanes of both halves */
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xd8));
+   }
+
+   return w;
+}
+
+CONV_TARGET_AVX2
+static int conv_argb8888_abgr8888_avx2(uint32_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+   const __m256i shuffle = _mm256_setr_epi8(
+          2,  1,  0,  3,  6,  5,  4,  7, 10,  9,  8, 11, 14, 13, 12, 15,
+          2,  1,  0,  3,  6,  5,  4,  7, 10,  9,  8, 11, 14, 13, 12, 15);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_shuffle_epi8(in, shuffle));
+   }
+
+   return w;
+}
+#endif
+
+#ifdef CONV_NEON
+static int conv_rgb565_0rgb1555_neon(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const uint16x8_t hi_mask = vdupq_n_u16(0x7fe0);
+   const uint16x8_t lo_mask = vdupq_n_u16(0x1f);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint16x8_t in = vld1q_u16(input + w);
+      vst1q_u16(output + w, vorrq_u16(
+               vandq_u16(vshrq_n_u16(in, 1), hi_mask),
+               vandq_u16(in, lo_mask)));
+   }
+
+   return w;
+}
+
+static int conv_0rgb1555_rgb565_neon(uint16_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const uint16x8_t hi_mask   = vdupq_n_u16((0x1f << 11) | (0x1f << 6));
+   const uint16x8_t lo_mask   = vdupq_n_u16(0x1f);
+   const uint16x8_t glow_mask = vdupq_n_u16(1 << 5);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint16x8_t in   = vld1q_u16(input + w);
+      uint16x8_t rg   = vandq_u16(vshlq_n_u16(in, 1), hi_mask);
+      uint16x8_t b    = vandq_u16(in, lo_mask);
+      uint16x8_t glow = vandq_u16(vshrq_n_u16(in, 4), glow_mask);
+      vst1q_u16(output + w, vorrq_u16(rg, vorrq_u16(b, glow)));
+   }
+
+   return w;
+}
+
+/* Expands 5 and 6 bit channels the same way the C code does. */
+#define CONV_NEON_EXPAND5(c) vorr_u8(vshl_n_u8(c, 3), vshr_n_u8(c, 2))
+#define CONV_NEON_EXPAND6(c) vorr_u8(vshl_n_u8(c, 2), vshr_n_u8(c, 4))
+
+static int conv_0rgb1555_argb8888_neon(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+   const uint16x8_t mask = vdupq_n_u16(0x1f);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t px;
+      uint16x8_t in = vld1q_u16(input + w);
+      uint8x8_t r   = vmovn_u16(vandq_u16(vshrq_n_u16(in, 10), mask));
+      uint8x8_t g   = vmovn_u16(vandq_u16(vshrq_n_u16(in,  5), mask));
+      uint8x8_t b   = vmovn_u16(vandq_u16(in, mask));
+
+      px.val[0]     = CONV_NEON_EXPAND5(b);
+      px.val[1]     = CONV_NEON_EXPAND5(g);
+      px.val[2]     = CONV_NEON_EXPAND5(r);
+      px.val[3]     = vdup_n_u8(0xff);
+      vst4_u8((uint8_t*)(output + w), px);
+   }
+
+   return w;
+}
+
+static int conv_rgb565_argb8888_neon(uint32_t *output,
+      const uint16_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t px;
+      uint16x8_t in = vld1q_u16(input + w);
+      uint8x8_t r   = vshrn_n_u16(in, 11);
+      uint8x8_t g   = vmovn_u16(vandq_u16(vshrq_n_u16(in, 5),
+               vdupq_n_u16(0x3f)));
+      uint8x8_t b   = vmovn_u16(vandq_u16(in, vdupq_n_u16(0x1f)));
+
+      px.val[0]     = CONV_NEON_EXPAND5(b);
+      px.val[1]     = CONV_NEON_EXPAND6(g);
+      px.val[2]     = CONV_NEON_EXPAND5(r);
+      px.val[3]     = vdup_n_u8(0xff);
+      vst4_u8((uint8_t*)(output + w), px);
+   }
+
+   return w;
+}
+
+static int conv_argb8888_0rgb1555_neon(uint16_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t px = vld4_u8((const uint8_t*)(input + w));
+      uint16x8_t r   = vmovl_u8(vshr_n_u8(px.val[2], 3));
+      uint16x8_t g   = vmovl_u8(vshr_n_u8(px.val[1], 3));
+      uint16x8_t b   = vmovl_u8(vshr_n_u8(px.val[0], 3));
+
+      vst1q_u16(output + w, vorrq_u16(vshlq_n_u16(r, 10),
+               vorrq_u16(vshlq_n_u16(g, 5), b)));
+   }
+
+   return w;
+}
+
+static int conv_argb8888_abgr8888_neon(uint32_t *output,
+      const uint32_t *input, int width)
+{
+   int w;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t px = vld4_u8((const uint8_t*)(input + w));
+      uint8x8_t b    = px.val[0];
+
+      px.val[0]      = px.val[2];
+      px.val[2]      = b;
+      vst4_u8((uint8_t*)(output + w), px);
+   }
+
+   return w;
+}
+#endif
+
+/* Runs the row helper for whatever vector unit is on, if any */
+#if defined(CONV_AVX2)
+#define CONV_SIMD_ROW(name, simd, output, input, width) \
+   (((simd) & RETRO_SIMD_AVX2) ? name##_avx2(output, input, width) : 0)
+#elif defined(CONV_NEON)
+#define CONV_SIMD_ROW(name, simd, output, input, width) \
+   (((simd) & RETRO_SIMD_NEON) ? name##_neon(output, input, width) : 0)
+#else
+#define CONV_SIMD_ROW(name, simd, output, input, width) ((void)(simd), 0)
+#endif
+
 void conv_rgb565_0rgb1555(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -50,6 +422,7 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    int h;
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
+   uint64_t simd = conv_get_simd();
 
 #if defined(__SSE2__)
    int max_width           = width - 7;
@@ -60,12 +433,12 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
-      int w = 0;
+      int w = CONV_SIMD_ROW(conv_rgb565_0rgb1555, simd, output, input, width);
 #if defined(__SSE2__)
       for (; w < max_width; w += 8)
       {
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+         __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
          __m128i lo = _mm_and_si128(in, lo_mask);
          _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
       }
@@ -88,6 +461,7 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
    int h;
    const uint16_t *input   = (const uint16_t*)input_;
    uint16_t *output        = (uint16_t*)output_;
+   uint64_t simd           = conv_get_simd();
 
 #if defined(__SSE2__)
    int max_width           = width - 7;
@@ -101,7 +475,7 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
-      int w = 0;
+      int w = CONV_SIMD_ROW(conv_0rgb1555_rgb565, simd, output, input, width);
 #if defined(__SSE2__)
       for (; w < max_width; w += 8)
       {
@@ -132,6 +506,7 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    int h;
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
+   uint64_t simd         = conv_get_simd();
 
 #ifdef __SSE2__
    const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
@@ -146,7 +521,7 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      int w = 0;
+      int w = CONV_SIMD_ROW(conv_0rgb1555_argb8888, simd, output, input, width);
 #ifdef __SSE2__
       for (; w < max_width; w += 8)
       {
@@ -199,6 +574,7 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    int h;
    const uint16_t *input    = (const uint16_t*)input_;
    uint32_t *output         = (uint32_t*)output_;
+   uint64_t simd            = conv_get_simd();
 
 #if defined(__SSE2__)
    const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
@@ -225,7 +601,7 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      int w = 0;
+      int w = CONV_SIMD_ROW(conv_rgb565_argb8888, simd, output, input, width);
 #if defined(__SSE2__)
       for (; w < max_width; w += 8)
       {
@@ -747,14 +1123,45 @@ void conv_argb8888_0rgb1555(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
+   uint64_t simd         = conv_get_simd();
+
+#if defined(__SSE2__)
+   int max_width         = width - 7;
+   const __m128i r_mask  = _mm_set1_epi32(0x1f << 10);
+   const __m128i g_mask  = _mm_set1_epi32(0x1f <<  5);
+   const __m128i b_mask  = _mm_set1_epi32(0x1f);
+#endif
 
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = CONV_SIMD_ROW(conv_argb8888_0rgb1555, simd, output, input, width);
+#if defined(__SSE2__)
+      for (; w < max_width; w += 8)
+      {
+         __m128i res[2];
+         int i;
+
+         for (i = 0; i < 2; i++)
+         {
+            const __m128i in = _mm_loadu_si128(
+                  (const __m128i*)(input + w + i * 4));
+            __m128i r        = _mm_and_si128(_mm_srli_epi32(in, 9), r_mask);
+            __m128i g        = _mm_and_si128(_mm_srli_epi32(in, 6), g_mask);
+            __m128i b        = _mm_and_si128(_mm_srli_epi32(in, 3), b_mask);
+            res[i]           = _mm_or_si128(r, _mm_or_si128(g, b));
+         }
+
+         /* 15 bits fit the signed pack */
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_packs_epi32(res[0], res[1]));
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          uint16_t r   = (col >> 19) & 0x1f;
@@ -864,14 +1271,29 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
+   uint64_t simd         = conv_get_simd();
+#if defined(__SSE2__)
+   int max_width         = width - 3;
+   const __m128i a_mask  = _mm_set1_epi32(0xff000000);
+#endif
 
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = CONV_SIMD_ROW(conv_argb8888_abgr8888, simd, output, input, width);
+#if defined(__SSE2__)
+      for (; w < max_width; w += 4)
+      {
+         __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(
+                  conv_shuffle_rb_epi32(in), _mm_and_si128(in, a_mask)));
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          output[w]    = ((col << 16) & 0xff0000) |
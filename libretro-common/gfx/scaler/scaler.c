@@ -30,6 +30,230 @@
 #include <gfx/scaler/filter.h>
 #include <gfx/scaler/pixconv.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+/* Runs the input conversion and horizontal pass over input rows
+ * [y_start, y_end) of the frame. */
+static void scaler_ctx_scale_horiz(const struct scaler_ctx *ctx,
+      const void *input, int y_start, int y_end)
+{
+   struct scaler_ctx band  = *ctx;
+   const uint8_t *in       = (const uint8_t*)input;
+   int input_stride        = ctx->in_stride;
+
+   if (ctx->in_fmt != SCALER_FMT_ARGB8888)
+   {
+      ctx->in_pixconv(
+            (uint8_t*)ctx->input.frame + y_start * ctx->input.stride,
+            in + y_start * ctx->in_stride,
+            ctx->in_width, y_end - y_start,
+            ctx->input.stride, ctx->in_stride);
+
+      in                   = (const uint8_t*)ctx->input.frame;
+      input_stride         = ctx->input.stride;
+   }
+
+   band.scaled.frame       = ctx->scaled.frame
+      + y_start * (ctx->scaled.stride >> 3);
+   band.scaled.height      = y_end - y_start;
+
+   if (ctx->scaler_horiz)
+      ctx->scaler_horiz(&band, in + y_start * input_stride, input_stride);
+}
+
+/* Runs the vertical pass and output conversion over output rows
+ * [y_start, y_end) of the frame. */
+static void scaler_ctx_scale_vert(const struct scaler_ctx *ctx,
+      void *output, int y_start, int y_end)
+{
+   struct scaler_ctx band  = *ctx;
+   uint8_t *out            = (uint8_t*)output;
+   int output_stride       = ctx->out_stride;
+
+   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+   {
+      out                  = (uint8_t*)ctx->output.frame;
+      output_stride        = ctx->output.stride;
+   }
+
+   band.out_height         = y_end - y_start;
+   band.vert.filter        = ctx->vert.filter
+      + y_start * ctx->vert.filter_stride;
+   band.vert.filter_pos    = ctx->vert.filter_pos + y_start;
+
+   if (ctx->scaler_vert)
+      ctx->scaler_vert(&band, out + y_start * output_stride, output_stride);
+
+   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+      ctx->out_pixconv(
+            (uint8_t*)output + y_start * ctx->out_stride,
+            (const uint8_t*)ctx->output.frame + y_start * ctx->output.stride,
+            ctx->out_width, y_end - y_start,
+            ctx->out_stride, ctx->output.stride);
+}
+
+#ifdef HAVE_THREADS
+/* Splits the generic filter path into horizontal bands. The workers
+ * and the calling thread all take one band of the input for the
+ * horizontal pass, wait for each other, then one band of the output
+ * for the vertical pass, which reads rows from anywhere in the
+ * scaled frame. */
+struct scaler_thread
+{
+   struct scaler_thread_pool *pool;
+   sthread_t *thread;
+   unsigned band;
+};
+
+struct scaler_thread_pool
+{
+   struct scaler_thread *threads;
+   unsigned num_threads;
+   unsigned num_bands;
+
+   slock_t *lock;
+   scond_t *cond;
+   scond_t *done_cond;
+   unsigned generation;
+   unsigned busy;
+   bool die;
+
+   const struct scaler_ctx *ctx;
+   void *output;
+   const void *input;
+   bool vert;
+};
+
+static void scaler_thread_pool_band(struct scaler_thread_pool *pool,
+      unsigned band)
+{
+   const struct scaler_ctx *ctx = pool->ctx;
+
+   if (pool->vert)
+      scaler_ctx_scale_vert(ctx, pool->output,
+            ctx->out_height * band / pool->num_bands,
+            ctx->out_height * (band + 1) / pool->num_bands);
+   else
+      scaler_ctx_scale_horiz(ctx, pool->input,
+            ctx->in_height * band / pool->num_bands,
+            ctx->in_height * (band + 1) / pool->num_bands);
+}
+
+static void scaler_thread_loop(void *data)
+{
+   struct scaler_thread *thread    = (struct scaler_thread*)data;
+   struct scaler_thread_pool *pool = thread->pool;
+   unsigned generation             = 0;
+
+   for (;;)
+   {
+      slock_lock(pool->lock);
+      while (pool->generation == generation && !pool->die)
+         scond_wait(pool->cond, pool->lock);
+      if (pool->die)
+      {
+         slock_unlock(pool->lock);
+         break;
+      }
+      generation = pool->generation;
+      slock_unlock(pool->lock);
+
+      scaler_thread_pool_band(pool, thread->band);
+
+      slock_lock(pool->lock);
+      if (--pool->busy == 0)
+         scond_signal(pool->done_cond);
+      slock_unlock(pool->lock);
+   }
+}
+
+static void scaler_thread_pool_free(struct scaler_thread_pool *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   if (pool->threads)
+   {
+      slock_lock(pool->lock);
+      pool->die = true;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+
+      for (i = 0; i < pool->num_threads; i++)
+         if (pool->threads[i].thread)
+            sthread_join(pool->threads[i].thread);
+      free(pool->threads);
+   }
+
+   if (pool->lock)
+      slock_free(pool->lock);
+   if (pool->cond)
+      scond_free(pool->cond);
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+   free(pool);
+}
+
+static struct scaler_thread_pool *scaler_thread_pool_new(unsigned num_bands)
+{
+   struct scaler_thread_pool *pool = (struct scaler_thread_pool*)
+      calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->num_bands = num_bands;
+   pool->lock      = slock_new();
+   pool->cond      = scond_new();
+   pool->done_cond = scond_new();
+   pool->threads   = (struct scaler_thread*)calloc(num_bands - 1,
+         sizeof(*pool->threads));
+
+   if (!pool->lock || !pool->cond || !pool->done_cond || !pool->threads)
+      goto error;
+
+   /* The calling thread does the first band */
+   for (; pool->num_threads < num_bands - 1; pool->num_threads++)
+   {
+      struct scaler_thread *thread = &pool->threads[pool->num_threads];
+
+      thread->pool   = pool;
+      thread->band   = pool->num_threads + 1;
+      thread->thread = sthread_create(scaler_thread_loop, thread);
+      if (!thread->thread)
+         goto error;
+   }
+
+   return pool;
+
+error:
+   scaler_thread_pool_free(pool);
+   return NULL;
+}
+
+static void scaler_thread_pool_pass(struct scaler_thread_pool *pool,
+      bool vert)
+{
+   slock_lock(pool->lock);
+   pool->vert = vert;
+   pool->busy = pool->num_threads;
+   pool->generation++;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+
+   scaler_thread_pool_band(pool, 0);
+
+   slock_lock(pool->lock);
+   while (pool->busy)
+      scond_wait(pool->done_cond, pool->lock);
+   slock_unlock(pool->lock);
+}
+#endif
+
 static bool allocate_frames(struct scaler_ctx *ctx)
 {
    uint64_t *scaled_frame = NULL;
@@ -204,8 +428,7 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
    }
    else
    {
-      ctx->scaler_horiz = scaler_argb8888_horiz;
-      ctx->scaler_vert  = scaler_argb8888_vert;
+      scaler_argb8888_set_kernels(ctx, conv_get_simd());
 
       switch (ctx->in_fmt)
       {
@@ -261,6 +484,12 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 
       if (!scaler_gen_filter(ctx))
          return false;
+
+#ifdef HAVE_THREADS
+      /* Not worth it for the point special path */
+      if (ctx->threads > 1 && !ctx->scaler_special)
+         ctx->pool = scaler_thread_pool_new(ctx->threads);
+#endif
    }
 
    return true;
@@ -268,6 +497,9 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 {
+#ifdef HAVE_THREADS
+   scaler_thread_pool_free(ctx->pool);
+#endif
    if (ctx->horiz.filter)
       free(ctx->horiz.filter);
    if (ctx->horiz.filter_pos)
@@ -303,6 +535,8 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 
    ctx->output.frame        = NULL;
    ctx->output.stride       = 0;
+
+   ctx->pool                = NULL;
 }
 
 /**
@@ -316,44 +550,56 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 void scaler_ctx_scale(struct scaler_ctx *ctx,
       void *output, const void *input)
 {
-   const void *input_frame = input;
-   void *output_frame      = output;
-   int input_stride        = ctx->in_stride;
-   int output_stride       = ctx->out_stride;
-
-   if (ctx->in_fmt != SCALER_FMT_ARGB8888)
+   /* Take some special, and (hopefully) more optimized path. */
+   if (ctx->scaler_special)
    {
-      ctx->in_pixconv(ctx->input.frame, input,
-            ctx->in_width, ctx->in_height,
-            ctx->input.stride, ctx->in_stride);
+      const void *input_frame = input;
+      void *output_frame      = output;
+      int input_stride        = ctx->in_stride;
+      int output_stride       = ctx->out_stride;
 
-      input_frame       = ctx->input.frame;
-      input_stride      = ctx->input.stride;
-   }
+      if (ctx->in_fmt != SCALER_FMT_ARGB8888)
+      {
+         ctx->in_pixconv(ctx->input.frame, input,
+               ctx->in_width, ctx->in_height,
+               ctx->input.stride, ctx->in_stride);
 
-   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-   {
-      output_frame  = ctx->output.frame;
-      output_stride = ctx->output.stride;
-   }
+         input_frame       = ctx->input.frame;
+         input_stride      = ctx->input.stride;
+      }
+
+      if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+      {
+         output_frame  = ctx->output.frame;
+         output_stride = ctx->output.stride;
+      }
 
-   /* Take some special, and (hopefully) more optimized path. */
-   if (ctx->scaler_special)
       ctx->scaler_special(ctx, output_frame, input_frame,
             ctx->out_width, ctx->out_height,
             ctx->in_width, ctx->in_height,
             output_stride, input_stride);
-   else
+
+      if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+         ctx->out_pixconv(output, ctx->output.frame,
+               ctx->out_width, ctx->out_height,
+               ctx->out_stride, ctx->output.stride);
+      return;
+   }
+
+#ifdef HAVE_THREADS
+   if (ctx->pool)
    {
-      /* Take generic filter path. */
-      if (ctx->scaler_horiz)
-         ctx->scaler_horiz(ctx, input_frame, input_stride);
-      if (ctx->scaler_vert)
-         ctx->scaler_vert (ctx, output, output_stride);
+      ctx->pool->ctx    = ctx;
+      ctx->pool->input  = input;
+      ctx->pool->output = output;
+
+      scaler_thread_pool_pass(ctx->pool, false);
+      scaler_thread_pool_pass(ctx->pool, true);
+      return;
    }
+#endif
 
-   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-      ctx->out_pixconv(output, ctx->output.frame,
-            ctx->out_width, ctx->out_height,
-            ctx->out_stride, ctx->output.stride);
+   /* Take generic filter path. */
+   scaler_ctx_scale_horiz(ctx, input, 0, ctx->in_height);
+   scaler_ctx_scale_vert(ctx, output, 0, ctx->out_height);
 }
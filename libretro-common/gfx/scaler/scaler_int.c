@@ -20,9 +20,12 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <string.h>
+
 #include <gfx/scaler/scaler_int.h>
 
 #include <retro_inline.h>
+#include <libretro.h>
 
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
@@ -35,6 +38,35 @@
 #endif
 #endif
 
+/* The AVX2 kernels are built whenever the compiler can emit them and
+ * picked at runtime, see scaler_argb8888_set_kernels(). */
+#if !defined(SCALER_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(__i486__) || defined(__i686__) || defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86))
+#if defined(_MSC_VER) && _MSC_VER >= 1910
+#define SCALER_AVX2
+#define SCALER_TARGET_AVX2
+#elif defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 7)
+#define SCALER_AVX2
+#define SCALER_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define SCALER_AVX2
+#define SCALER_TARGET_AVX2
+#endif
+#endif
+
+#ifdef SCALER_AVX2
+#include <immintrin.h>
+#endif
+
+/* The NEON kernels lean on the lane order of little endian loads. */
+#if !defined(SCALER_NO_SIMD) && (defined(__ARM_NEON) || defined(__aarch64__)) && !defined(__ARM_BIG_ENDIAN) && !defined(DONT_WANT_ARM_OPTIMIZATIONS)
+#define SCALER_NEON
+#include <arm_neon.h>
+#endif
+
+/* Broadcasting the coefficient with a multiply would carry into the
+ * next lane for negative (sinc) taps. */
+#define SCALER_COEFF4(c) ((uint16_t)(c) * 0x0001000100010001ull)
+
 /* ARGB8888 scaler is split in two:
  *
  * First, horizontal scaler is applied.
@@ -59,7 +91,8 @@
  * into 8-bit values.
  *
  * The C version of scalers perform the exact same operations as the
- * SIMD code for testing purposes.
+ * SIMD code for testing purposes. The AVX2 and NEON kernels do too,
+ * they only handle more pixels at a time.
  */
 
 void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
@@ -86,7 +119,7 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
          for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2,
                input_base_y += (ctx->scaled.stride >> 2))
          {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(SCALER_COEFF4(filter_vert[y + 1]), SCALER_COEFF4(filter_vert[y + 0]));
             __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
 
             res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
@@ -94,7 +127,7 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 
          for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(0, SCALER_COEFF4(filter_vert[y]));
             __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
 
             res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
@@ -171,7 +204,7 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 #endif
          for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
          {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(SCALER_COEFF4(filter_horiz[x + 1]), SCALER_COEFF4(filter_horiz[x + 0]));
 
             __m128i col   = _mm_unpacklo_epi8(_mm_set_epi64x(0,
                      ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
@@ -182,7 +215,7 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
 
          for (; x < ctx->horiz.filter_len; x++)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
+            __m128i coeff = _mm_set_epi64x(0, SCALER_COEFF4(filter_horiz[x]));
             __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
 
             col           = _mm_slli_epi16(col, 7);
@@ -221,15 +254,260 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
             res_b         += (b * coeff) >> 16;
          }
 
+         /* Negative sums (sinc undershoot) must not sign extend
+          * into the other channels */
          output[w]         = (
-               (uint64_t)res_a  << 48)  |
-               ((uint64_t)res_r << 32)  |
-               ((uint64_t)res_g << 16)  |
-               ((uint64_t)res_b << 0);
+               (uint64_t)(uint16_t)res_a  << 48)  |
+               ((uint64_t)(uint16_t)res_r << 32)  |
+               ((uint64_t)(uint16_t)res_g << 16)  |
+               ((uint64_t)(uint16_t)res_b << 0);
+#endif
+      }
+   }
+}
+
+#ifdef SCALER_AVX2
+/* Two output pixels at a time, one in each 128-bit lane. */
+SCALER_TARGET_AVX2
+static void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx,
+      const void *input_, int stride)
+{
+   int h, w, x;
+   const uint32_t *input  = (const uint32_t*)input_;
+   uint64_t *output       = ctx->scaled.frame;
+   const __m256i coeff_idx = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+
+   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2,
+         output += ctx->scaled.stride >> 3)
+   {
+      for (w = 0; w < ctx->scaled.width; w += 2)
+      {
+         __m256i res         = _mm256_setzero_si256();
+         int w1              = (w + 1 < ctx->scaled.width) ? w + 1 : w;
+         const int16_t *f0   = ctx->horiz.filter + w  * ctx->horiz.filter_stride;
+         const int16_t *f1   = ctx->horiz.filter + w1 * ctx->horiz.filter_stride;
+         const uint32_t *in0 = input + ctx->horiz.filter_pos[w];
+         const uint32_t *in1 = input + ctx->horiz.filter_pos[w1];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            /* f0[x] f0[x+1] f1[x] f1[x+1], each taking up four channels */
+            __m128i c     = _mm_setr_epi16(f0[x], f0[x + 1],
+                  f1[x], f1[x + 1], 0, 0, 0, 0);
+            __m256i coeff = _mm256_permutevar8x32_epi32(
+                  _mm256_castsi128_si256(_mm_unpacklo_epi16(c, c)),
+                  coeff_idx);
+            __m256i col   = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(
+                     _mm_loadl_epi64((const __m128i*)(in0 + x)),
+                     _mm_loadl_epi64((const __m128i*)(in1 + x))));
+
+            col           = _mm256_slli_epi16(col, 7);
+            res           = _mm256_adds_epi16(
+                  _mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            __m128i c     = _mm_setr_epi16(f0[x], 0, f1[x], 0, 0, 0, 0, 0);
+            __m256i coeff = _mm256_permutevar8x32_epi32(
+                  _mm256_castsi128_si256(_mm_unpacklo_epi16(c, c)),
+                  coeff_idx);
+            __m256i col   = _mm256_cvtepu8_epi16(
+                  _mm_setr_epi32(in0[x], 0, in1[x], 0));
+
+            col           = _mm256_slli_epi16(col, 7);
+            res           = _mm256_adds_epi16(
+                  _mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         res = _mm256_adds_epi16(_mm256_srli_si256(res, 8), res);
+         res = _mm256_permute4x64_epi64(res, 0x08);
+
+         if (w1 != w)
+            _mm_storeu_si128((__m128i*)(output + w),
+                  _mm256_castsi256_si128(res));
+         else
+            _mm_storel_epi64((__m128i*)(output + w),
+                  _mm256_castsi256_si128(res));
+      }
+   }
+}
+
+/* Four output pixels at a time. The scaled frame is padded to eight
+ * pixels a row, so loading past the width stays inside it. */
+SCALER_TARGET_AVX2
+static void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx,
+      void *output_, int stride)
+{
+   int h, w, y;
+   const uint64_t *input      = ctx->scaled.frame;
+   uint32_t *output           = (uint32_t*)output_;
+   const int16_t *filter_vert = ctx->vert.filter;
+   int scaled_stride          = ctx->scaled.stride >> 3;
+
+   for (h = 0; h < ctx->out_height; h++,
+         filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = input + ctx->vert.filter_pos[h]
+         * scaled_stride;
+
+      for (w = 0; w < ctx->out_width; w += 4)
+      {
+         __m128i final;
+         __m256i res                  = _mm256_setzero_si256();
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++,
+               input_base_y += scaled_stride)
+         {
+            __m256i coeff = _mm256_set1_epi16(filter_vert[y]);
+            __m256i col   = _mm256_loadu_si256(
+                  (const __m256i*)input_base_y);
+
+            res           = _mm256_adds_epi16(
+                  _mm256_mulhi_epi16(col, coeff), res);
+         }
+
+         res   = _mm256_srai_epi16(res, (7 - 2 - 2));
+         res   = _mm256_packus_epi16(res, res);
+         final = _mm256_castsi256_si128(
+               _mm256_permute4x64_epi64(res, 0x08));
+
+         if (w + 4 <= ctx->out_width)
+            _mm_storeu_si128((__m128i*)(output + w), final);
+         else
+         {
+            uint32_t tmp[4];
+            _mm_storeu_si128((__m128i*)tmp, final);
+            memcpy(output + w, tmp,
+                  (ctx->out_width - w) * sizeof(uint32_t));
+         }
+      }
+   }
+}
 #endif
+
+#ifdef SCALER_NEON
+/* vqdmulh is (2 * a * b) >> 16. Widening the channels by 6 instead
+ * of 7 makes it the very same mulhi as above, the vertical pass
+ * halves it afterwards instead. */
+static void scaler_argb8888_horiz_neon(const struct scaler_ctx *ctx,
+      const void *input_, int stride)
+{
+   int h, w, x;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint64_t *output      = ctx->scaled.frame;
+
+   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2,
+         output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      for (w = 0; w < ctx->scaled.width; w++,
+            filter_horiz += ctx->horiz.filter_stride)
+      {
+         int16x4_t sum;
+         int16x8_t res                = vdupq_n_s16(0);
+         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         {
+            int16x8_t coeff = vcombine_s16(vdup_n_s16(filter_horiz[x]),
+                  vdup_n_s16(filter_horiz[x + 1]));
+            int16x8_t col   = vreinterpretq_s16_u16(vshll_n_u8(
+                     vld1_u8((const uint8_t*)(input_base_x + x)), 6));
+
+            res             = vqaddq_s16(vqdmulhq_s16(col, coeff), res);
+         }
+
+         for (; x < ctx->horiz.filter_len; x++)
+         {
+            int16x8_t coeff = vcombine_s16(vdup_n_s16(filter_horiz[x]),
+                  vdup_n_s16(0));
+            int16x8_t col   = vreinterpretq_s16_u16(vshll_n_u8(
+                     vreinterpret_u8_u32(vdup_n_u32(input_base_x[x])), 6));
+
+            res             = vqaddq_s16(vqdmulhq_s16(col, coeff), res);
+         }
+
+         sum = vqadd_s16(vget_low_s16(res), vget_high_s16(res));
+         vst1_s16((int16_t*)(output + w), sum);
+      }
+   }
+}
+
+/* Two output pixels at a time, see scaler_argb8888_vert_avx2(). */
+static void scaler_argb8888_vert_neon(const struct scaler_ctx *ctx,
+      void *output_, int stride)
+{
+   int h, w, y;
+   const uint64_t *input      = ctx->scaled.frame;
+   uint32_t *output           = (uint32_t*)output_;
+   const int16_t *filter_vert = ctx->vert.filter;
+   int scaled_stride          = ctx->scaled.stride >> 3;
+
+   for (h = 0; h < ctx->out_height; h++,
+         filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   {
+      const uint64_t *input_base = input + ctx->vert.filter_pos[h]
+         * scaled_stride;
+
+      for (w = 0; w < ctx->out_width; w += 2)
+      {
+         uint8x8_t final;
+         int16x8_t res                = vdupq_n_s16(0);
+         const uint64_t *input_base_y = input_base + w;
+
+         for (y = 0; y < ctx->vert.filter_len; y++,
+               input_base_y += scaled_stride)
+         {
+            int16x8_t col = vld1q_s16((const int16_t*)input_base_y);
+
+            res           = vqaddq_s16(vshrq_n_s16(
+                     vqdmulhq_n_s16(col, filter_vert[y]), 1), res);
+         }
+
+         final = vqmovun_s16(vshrq_n_s16(res, (7 - 2 - 2)));
+
+         if (w + 2 <= ctx->out_width)
+            vst1_u8((uint8_t*)(output + w), final);
+         else
+            vst1_lane_u32(output + w, vreinterpret_u32_u8(final), 0);
       }
    }
 }
+#endif
+
+/**
+ * scaler_argb8888_set_kernels:
+ * @ctx          : pointer to scaler context object.
+ * @simd         : RETRO_SIMD_* flags of the CPU.
+ *
+ * Points the horizontal and vertical passes of @ctx at the
+ * fastest kernels @simd allows.
+ **/
+void scaler_argb8888_set_kernels(struct scaler_ctx *ctx, uint64_t simd)
+{
+   (void)simd;
+
+   ctx->scaler_horiz = scaler_argb8888_horiz;
+   ctx->scaler_vert  = scaler_argb8888_vert;
+
+#ifdef SCALER_AVX2
+   if (simd & RETRO_SIMD_AVX2)
+   {
+      ctx->scaler_horiz = scaler_argb8888_horiz_avx2;
+      ctx->scaler_vert  = scaler_argb8888_vert_avx2;
+   }
+#endif
+#ifdef SCALER_NEON
+   if (simd & RETRO_SIMD_NEON)
+   {
+      ctx->scaler_horiz = scaler_argb8888_horiz_neon;
+      ctx->scaler_vert  = scaler_argb8888_vert_neon;
+   }
+#endif
+}
 
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output_, const void *input_,
@@ -77,6 +77,10 @@ float audio_mixer_voice_get_volume(audio_mixer_voice_t *voice);
 
 void audio_mixer_voice_set_volume(audio_mixer_voice_t *voice, float val);
 
+/* Number of times a streamed voice ran out of decoded audio
+ * since it started playing. */
+unsigned audio_mixer_voice_get_underruns(audio_mixer_voice_t *voice);
+
 void audio_mixer_mix(float* buffer, size_t num_frames, float volume_override, bool override);
 
 RETRO_END_DECLS
@@ -46,6 +46,8 @@ RETRO_BEGIN_DECLS
 #define RESAMPLER_SIMD_AVX2     (1 << 12)
 #define RESAMPLER_SIMD_VFPU     (1 << 13)
 #define RESAMPLER_SIMD_PS       (1 << 14)
+#define RESAMPLER_SIMD_FMA      (1U << 30)
+#define RESAMPLER_SIMD_AVX512   (1U << 31)
 
 enum resampler_quality
 {
@@ -31,6 +31,13 @@
 
 RETRO_BEGIN_DECLS
 
+/* Features cpu_features_get() reports on top of the RETRO_SIMD_*
+ * ones. These are not part of the libretro API, so they are kept
+ * at the top of the low 32 bits, clear of where RETRO_SIMD_* grows.
+ * Frontends should mask them out of what they hand to cores. */
+#define CPU_FEATURES_FMA      (1U << 30)
+#define CPU_FEATURES_AVX512   (1U << 31)
+
 /**
  * cpu_features_get_perf_counter:
  *
@@ -61,6 +61,12 @@ struct config_file
    bool guaranteed_no_duplicates;
 
    struct config_include_list *includes;
+
+   /* Open addressing index from each key to its first
+    * entry in list order. Built on the first lookup. */
+   struct config_entry_slot *index;
+   size_t index_size;
+   size_t index_count;
 };
 
 typedef struct config_file config_file_t;
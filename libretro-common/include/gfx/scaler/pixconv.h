@@ -23,12 +23,30 @@
 #ifndef __LIBRETRO_SDK_SCALER_PIXCONV_H__
 #define __LIBRETRO_SDK_SCALER_PIXCONV_H__
 
+#include <stdint.h>
+
 #include <clamping.h>
 
 #include <retro_common_api.h>
 
 RETRO_BEGIN_DECLS
 
+/**
+ * conv_set_simd:
+ * @simd         : RETRO_SIMD_* flags.
+ *
+ * Limits the converters to the vector code @simd allows.
+ * Until this is called, they go by what the CPU has.
+ **/
+void conv_set_simd(uint64_t simd);
+
+/**
+ * conv_get_simd:
+ *
+ * Returns: the RETRO_SIMD_* flags the converters go by.
+ **/
+uint64_t conv_get_simd(void);
+
 void conv_0rgb1555_argb8888(void *output, const void *input,
       int width, int height,
       int out_stride, int in_stride);
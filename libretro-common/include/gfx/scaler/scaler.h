@@ -59,6 +59,8 @@ struct scaler_filter
    int *filter_pos;
 };
 
+struct scaler_thread_pool;
+
 struct scaler_ctx
 {
    int in_width;
@@ -106,6 +108,11 @@ struct scaler_ctx
       uint32_t *frame;
       int stride;
    } output;
+
+   /* Threads scaler_ctx_scale() may split a frame across, set before
+    * scaler_ctx_gen_filter(). 0 or 1 scales on the calling thread. */
+   unsigned threads;
+   struct scaler_thread_pool *pool;
 };
 
 bool scaler_ctx_gen_filter(struct scaler_ctx *ctx);
@@ -35,6 +35,16 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx,
 void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
       const void *input, int stride);
 
+/**
+ * scaler_argb8888_set_kernels:
+ * @ctx          : pointer to scaler context object.
+ * @simd         : RETRO_SIMD_* flags of the CPU.
+ *
+ * Points the horizontal and vertical passes of @ctx at the
+ * fastest kernels @simd allows.
+ **/
+void scaler_argb8888_set_kernels(struct scaler_ctx *ctx, uint64_t simd);
+
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output, const void *input,
       int out_width, int out_height,
@@ -0,0 +1,106 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (spsc_queue.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __LIBRETRO_SDK_SPSC_BUFFER_H
+#define __LIBRETRO_SDK_SPSC_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* A byte ring buffer like fifo_buffer_t, except that one producer
+ * thread and one consumer thread can use it at the same time
+ * without a lock.
+ *
+ * The write functions may only be called by the producer and the
+ * read functions only by the consumer. Each side owns its position
+ * on a cache line of its own, along with the last position it saw
+ * of the other side. */
+
+#define SPSC_CACHE_LINE 64
+
+struct spsc_buffer
+{
+   uint8_t *buffer;
+   size_t size;
+   uint8_t pad0[SPSC_CACHE_LINE - sizeof(uint8_t*) - sizeof(size_t)];
+
+   /* Producer */
+   volatile size_t end;
+   size_t first_cached;
+   uint8_t pad1[SPSC_CACHE_LINE - 2 * sizeof(size_t)];
+
+   /* Consumer */
+   volatile size_t first;
+   size_t end_cached;
+   uint8_t pad2[SPSC_CACHE_LINE - 2 * sizeof(size_t)];
+};
+
+typedef struct spsc_buffer spsc_buffer_t;
+
+/* Part of the buffer that can be written to or read from in
+ * place. A request that wraps around the end of the buffer
+ * is split over two of these. */
+typedef struct spsc_region
+{
+   uint8_t *data;
+   size_t size;
+} spsc_region_t;
+
+spsc_buffer_t *spsc_new(size_t size);
+
+void spsc_free(spsc_buffer_t *buffer);
+
+/* Producer */
+
+size_t spsc_write_avail(spsc_buffer_t *buffer);
+
+void spsc_write(spsc_buffer_t *buffer, const void *in_buf, size_t size);
+
+/* Fills in the two regions where up to size bytes can be written
+ * and returns how many bytes they hold in total. Nothing becomes
+ * visible to the consumer until spsc_write_commit(). */
+size_t spsc_write_regions(spsc_buffer_t *buffer, size_t size,
+      spsc_region_t *regions);
+
+void spsc_write_commit(spsc_buffer_t *buffer, size_t size);
+
+/* Consumer */
+
+size_t spsc_read_avail(spsc_buffer_t *buffer);
+
+void spsc_read(spsc_buffer_t *buffer, void *out_buf, size_t size);
+
+/* Fills in the two regions holding up to size bytes that can be
+ * read in place and returns how many bytes they hold in total.
+ * The space is handed back to the producer by spsc_read_commit(). */
+size_t spsc_read_regions(spsc_buffer_t *buffer, size_t size,
+      spsc_region_t *regions);
+
+void spsc_read_commit(spsc_buffer_t *buffer, size_t size);
+
+RETRO_END_DECLS
+
+#endif
@@ -29,6 +29,7 @@
 
 #include <retro_common.h>
 #include <retro_common_api.h>
+#include <libretro.h>
 
 RETRO_BEGIN_DECLS
 
@@ -42,6 +43,19 @@ enum task_type
    TASK_TYPE_BLOCKING
 };
 
+enum task_priority
+{
+   TASK_PRIORITY_NORMAL = 0,
+   /* Latency sensitive work the user is waiting on,
+    * e.g. menu thumbnails and save states. */
+   TASK_PRIORITY_HIGH,
+   /* Long running bulk work such as database scans,
+    * only run when nothing more urgent is queued. */
+   TASK_PRIORITY_LOW,
+
+   TASK_PRIORITY_COUNT
+};
+
 typedef struct retro_task retro_task_t;
 typedef void (*retro_task_callback_t)(retro_task_t *task,
       void *task_data,
@@ -65,6 +79,27 @@ typedef struct
    char *source_file;
 } decompress_task_data_t;
 
+/* Timestamps are in microseconds as returned by
+ * cpu_features_get_time_usec(), 0 if not reached yet */
+typedef struct retro_task_metrics
+{
+   /* accepted by task_queue_push() */
+   retro_time_t enqueue_time;
+   /* first call to the handler */
+   retro_time_t start_time;
+   /* handler marked the task as finished */
+   retro_time_t finish_time;
+   /* picked up by task_queue_check() to run the callback */
+   retro_time_t gather_time;
+   /* time spent inside the handler, over all calls */
+   retro_time_t handler_time;
+   /* number of times the handler was called */
+   unsigned iterations;
+} retro_task_metrics_t;
+
+typedef void (*retro_task_metrics_log_t)(retro_task_t *task,
+      const retro_task_metrics_t *metrics);
+
 struct retro_task
 {
    retro_task_handler_t  handler;
@@ -123,6 +158,17 @@ struct retro_task
    task progress display */
    bool alternative_look;
 
+   /* which tasks the threaded task queue runs first */
+   enum task_priority priority;
+
+   /* set if the handler may run at the same time as other
+    * handlers. The threaded task queue runs the handlers of
+    * tasks without it one at a time. */
+   bool thread_safe;
+
+   /* filled in by the task queue, see task_get_metrics() */
+   retro_task_metrics_t metrics;
+
    /* don't touch this. */
    retro_task_t *next;
 };
@@ -186,6 +232,16 @@ char* task_get_title(retro_task_t *task);
 
 void* task_get_data(retro_task_t *task);
 
+/* Copies the timing data of a task. Safe to call while the
+ * task is running; once it has finished, gather_time is set
+ * before its callback runs. */
+void task_get_metrics(retro_task_t *task, retro_task_metrics_t *metrics);
+
+/* Sets a function that is passed the metrics of every task
+ * as it is gathered, right before its callback runs.
+ * NULL disables it. */
+void task_queue_set_metrics_log(retro_task_metrics_log_t log);
+
 void task_queue_set_threaded(void);
 
 void task_queue_unset_threaded(void);
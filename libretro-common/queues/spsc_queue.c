@@ -0,0 +1,224 @@
+/* Copyright  (C) 2010-2018 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (spsc_queue.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+#include <memalign.h>
+#include <queues/spsc_queue.h>
+
+#if defined(_MSC_VER)
+#ifdef _XBOX
+#include <xtl.h>
+#else
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#endif
+
+/* A position is published with release semantics after the data
+ * it covers has been copied, and loaded by the other side with
+ * acquire semantics before touching that data. */
+#if defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define SPSC_LOAD(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define SPSC_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#elif defined(__GNUC__)
+#define SPSC_BARRIER()       __sync_synchronize()
+#elif defined(_MSC_VER)
+#define SPSC_BARRIER()       MemoryBarrier()
+#else
+/* Single core targets, volatile is enough */
+#define SPSC_BARRIER()
+#endif
+
+#ifndef SPSC_LOAD
+static INLINE size_t spsc_load(volatile size_t *ptr)
+{
+   size_t val = *ptr;
+   SPSC_BARRIER();
+   return val;
+}
+
+static INLINE void spsc_store(volatile size_t *ptr, size_t val)
+{
+   SPSC_BARRIER();
+   *ptr = val;
+}
+
+#define SPSC_LOAD(ptr)       spsc_load(ptr)
+#define SPSC_STORE(ptr, val) spsc_store(ptr, val)
+#endif
+
+/* Positions count up to twice the size of the buffer, so a full
+ * buffer can be told apart from an empty one without leaving a
+ * byte unused. Regions then stay aligned to whatever unit the
+ * size and every write are a multiple of. */
+static INLINE size_t spsc_used(const spsc_buffer_t *buffer,
+      size_t first, size_t end)
+{
+   return (end + ((end < first) ? 2 * buffer->size : 0)) - first;
+}
+
+/* Splits size bytes starting at pos into the part up to the end
+ * of the buffer and the part that wraps around to the start. */
+static INLINE void spsc_split(spsc_buffer_t *buffer, size_t pos,
+      size_t size, spsc_region_t *regions)
+{
+   size_t first_size = size;
+
+   if (pos >= buffer->size)
+      pos            -= buffer->size;
+
+   if (pos + size > buffer->size)
+      first_size      = buffer->size - pos;
+
+   regions[0].data    = buffer->buffer + pos;
+   regions[0].size    = first_size;
+   regions[1].data    = buffer->buffer;
+   regions[1].size    = size - first_size;
+}
+
+static INLINE size_t spsc_advance(spsc_buffer_t *buffer,
+      size_t pos, size_t size)
+{
+   pos += size;
+   if (pos >= 2 * buffer->size)
+      pos -= 2 * buffer->size;
+   return pos;
+}
+
+spsc_buffer_t *spsc_new(size_t size)
+{
+   uint8_t    *data   = NULL;
+   spsc_buffer_t *buf = (spsc_buffer_t*)
+      memalign_alloc(SPSC_CACHE_LINE, sizeof(*buf));
+
+   if (!buf)
+      return NULL;
+
+   memset(buf, 0, sizeof(*buf));
+
+   data = (uint8_t*)calloc(1, size);
+
+   if (!data)
+   {
+      memalign_free(buf);
+      return NULL;
+   }
+
+   buf->buffer = data;
+   buf->size   = size;
+
+   return buf;
+}
+
+void spsc_free(spsc_buffer_t *buffer)
+{
+   if (!buffer)
+      return;
+
+   free(buffer->buffer);
+   memalign_free(buffer);
+}
+
+size_t spsc_write_avail(spsc_buffer_t *buffer)
+{
+   buffer->first_cached = SPSC_LOAD(&buffer->first);
+
+   return buffer->size -
+      spsc_used(buffer, buffer->first_cached, buffer->end);
+}
+
+size_t spsc_write_regions(spsc_buffer_t *buffer, size_t size,
+      spsc_region_t *regions)
+{
+   size_t avail = buffer->size -
+      spsc_used(buffer, buffer->first_cached, buffer->end);
+
+   /* Only look at the consumer's cache line when we have to */
+   if (avail < size)
+      avail = spsc_write_avail(buffer);
+   if (size > avail)
+      size = avail;
+
+   spsc_split(buffer, buffer->end, size, regions);
+   return size;
+}
+
+void spsc_write_commit(spsc_buffer_t *buffer, size_t size)
+{
+   SPSC_STORE(&buffer->end, spsc_advance(buffer, buffer->end, size));
+}
+
+void spsc_write(spsc_buffer_t *buffer, const void *in_buf, size_t size)
+{
+   spsc_region_t regions[2];
+
+   spsc_split(buffer, buffer->end, size, regions);
+
+   memcpy(regions[0].data, in_buf, regions[0].size);
+   memcpy(regions[1].data, (const uint8_t*)in_buf + regions[0].size,
+         regions[1].size);
+
+   spsc_write_commit(buffer, size);
+}
+
+size_t spsc_read_avail(spsc_buffer_t *buffer)
+{
+   buffer->end_cached = SPSC_LOAD(&buffer->end);
+
+   return spsc_used(buffer, buffer->first, buffer->end_cached);
+}
+
+size_t spsc_read_regions(spsc_buffer_t *buffer, size_t size,
+      spsc_region_t *regions)
+{
+   size_t avail = spsc_used(buffer, buffer->first, buffer->end_cached);
+
+   if (avail < size)
+      avail = spsc_read_avail(buffer);
+   if (size > avail)
+      size = avail;
+
+   spsc_split(buffer, buffer->first, size, regions);
+   return size;
+}
+
+void spsc_read_commit(spsc_buffer_t *buffer, size_t size)
+{
+   SPSC_STORE(&buffer->first, spsc_advance(buffer, buffer->first, size));
+}
+
+void spsc_read(spsc_buffer_t *buffer, void *out_buf, size_t size)
+{
+   spsc_region_t regions[2];
+
+   spsc_split(buffer, buffer->first, size, regions);
+
+   memcpy(out_buf, regions[0].data, regions[0].size);
+   memcpy((uint8_t*)out_buf + regions[0].size, regions[1].data,
+         regions[1].size);
+
+   spsc_read_commit(buffer, size);
+}
@@ -23,8 +23,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include <queues/task_queue.h>
+#include <features/features_cpu.h>
 
 #ifdef HAVE_THREADS
 #include <rthreads/rthreads.h>
@@ -64,6 +66,8 @@ static bool task_threaded_enable            = false;
 
 static uint32_t task_count                  = 0;
 
+static retro_task_metrics_log_t task_metrics_log = NULL;
+
 static void task_queue_msg_push(retro_task_t *task,
       unsigned prio, unsigned duration,
       bool flush, const char *fmt, ...)
@@ -132,11 +136,35 @@ static retro_task_t *task_queue_get(task_queue_t *queue)
    return task;
 }
 
+/* Runs one step of @task and accounts for it.
+ * Returns the time the step ended. */
+static retro_time_t task_queue_run_handler(retro_task_t *task)
+{
+   retro_time_t start = cpu_features_get_time_usec();
+   retro_time_t end;
+
+   task->handler(task);
+
+   end = cpu_features_get_time_usec();
+
+   if (!task->metrics.start_time)
+      task->metrics.start_time = start;
+   task->metrics.handler_time += end - start;
+   task->metrics.iterations++;
+
+   return end;
+}
+
 static void retro_task_internal_gather(void)
 {
    retro_task_t *task = NULL;
    while ((task = task_queue_get(&tasks_finished)) != NULL)
    {
+      task->metrics.gather_time = cpu_features_get_time_usec();
+
+      if (task_metrics_log)
+         task_metrics_log(task, &task->metrics);
+
       task_queue_push_progress(task);
 
       if (task->callback)
@@ -180,13 +208,18 @@ static void retro_task_regular_gather(void)
 
    for (task = queue; task; task = next)
    {
+      retro_time_t end;
+
       next = task->next;
-      task->handler(task);
+      end  = task_queue_run_handler(task);
 
       task_queue_push_progress(task);
 
       if (task->finished)
+      {
+         task->metrics.finish_time = end;
          task_queue_put(&tasks_finished, task);
+      }
       else
          retro_task_regular_push_running(task);
    }
@@ -287,13 +320,43 @@ static struct retro_task_impl impl_regular = {
 };
 
 #ifdef HAVE_THREADS
+#define TASK_QUEUE_MAX_WORKERS 8
+
+/* Ring of tasks ready to run, one per priority class */
+typedef struct
+{
+   retro_task_t **tasks;
+   size_t front;
+   size_t count;
+   size_t capacity;
+} task_deque_t;
+
+typedef struct
+{
+   slock_t *lock;
+   sthread_t *thread;
+   task_deque_t deques[TASK_PRIORITY_COUNT];
+} task_worker_t;
+
+/* Priority classes in the order workers look at them */
+static const enum task_priority task_priority_order[TASK_PRIORITY_COUNT] = {
+   TASK_PRIORITY_HIGH,
+   TASK_PRIORITY_NORMAL,
+   TASK_PRIORITY_LOW
+};
+
 static slock_t *running_lock    = NULL;
 static slock_t *finished_lock   = NULL;
 static slock_t *property_lock   = NULL;
 static slock_t *queue_lock      = NULL;
 static scond_t *worker_cond     = NULL;
-static sthread_t *worker_thread = NULL;
 static bool worker_continue     = true; /* use running_lock when touching it */
+static unsigned worker_ready    = 0;    /* use running_lock when touching it */
+static unsigned worker_next     = 0;    /* use running_lock when touching it */
+static unsigned serial_ready    = 0;    /* use running_lock when touching it */
+static bool serial_running      = false; /* use running_lock when touching it */
+static unsigned worker_count    = 0;
+static task_worker_t task_workers[TASK_QUEUE_MAX_WORKERS];
 
 static void task_queue_remove(task_queue_t *queue, retro_task_t *task)
 {
@@ -333,14 +396,158 @@ static void task_queue_remove(task_queue_t *queue, retro_task_t *task)
    }
 }
 
+static bool task_deque_push_back(task_deque_t *deque, retro_task_t *task)
+{
+   if (deque->count == deque->capacity)
+   {
+      size_t i;
+      size_t capacity      = deque->capacity ? deque->capacity * 2 : 16;
+      retro_task_t **tasks = (retro_task_t**)
+         malloc(capacity * sizeof(*tasks));
+
+      if (!tasks)
+         return false;
+
+      for (i = 0; i < deque->count; i++)
+         tasks[i] = deque->tasks[(deque->front + i) % deque->capacity];
+
+      free(deque->tasks);
+      deque->tasks    = tasks;
+      deque->front    = 0;
+      deque->capacity = capacity;
+   }
+
+   deque->tasks[(deque->front + deque->count) % deque->capacity] = task;
+   deque->count++;
+   return true;
+}
+
+/* Removes the oldest task of @deque, or the newest if @newest is
+ * set, skipping tasks that are not thread safe unless @serial_ok. */
+static retro_task_t *task_deque_take(task_deque_t *deque,
+      bool newest, bool serial_ok)
+{
+   size_t i;
+
+   for (i = 0; i < deque->count; i++)
+   {
+      size_t n           = newest ? deque->count - 1 - i : i;
+      retro_task_t *task = deque->tasks[
+         (deque->front + n) % deque->capacity];
+
+      if (!serial_ok && !task->thread_safe)
+         continue;
+
+      if (n == 0)
+         deque->front = (deque->front + 1) % deque->capacity;
+      else
+      {
+         /* Close the gap behind it */
+         for (; n + 1 < deque->count; n++)
+            deque->tasks[(deque->front + n) % deque->capacity] =
+               deque->tasks[(deque->front + n + 1) % deque->capacity];
+      }
+
+      deque->count--;
+      return task;
+   }
+
+   return NULL;
+}
+
+static enum task_priority task_get_priority(retro_task_t *task)
+{
+   if (task->priority >= TASK_PRIORITY_COUNT)
+      return TASK_PRIORITY_NORMAL;
+   return task->priority;
+}
+
+/* Queues a task that is ready to run on @worker and
+ * wakes up a worker to run it. */
+static void retro_task_threaded_ready(task_worker_t *worker,
+      retro_task_t *task)
+{
+   bool queued;
+
+   slock_lock(worker->lock);
+   queued = task_deque_push_back(
+         &worker->deques[task_get_priority(task)], task);
+   slock_unlock(worker->lock);
+
+   if (!queued)
+      return;
+
+   slock_lock(running_lock);
+   worker_ready++;
+   if (!task->thread_safe)
+      serial_ready++;
+   scond_signal(worker_cond);
+   slock_unlock(running_lock);
+}
+
+/* Takes the next task for @self, or returns NULL if there is
+ * nothing it may run. Call with running_lock held.
+ *
+ * Higher priority classes come first, and a class is stolen from
+ * other workers before looking at the next one down. Each worker
+ * runs its own tasks in the order they were queued so that tasks
+ * which take several steps share it fairly, while thieves take the
+ * most recently queued one.
+ *
+ * Tasks that are not marked thread safe run one at a time, like
+ * they did on the single worker, so they are skipped while one of
+ * them is running. Tasks are queued before they are counted as
+ * ready and only taken here, so whenever the counts say there is
+ * something to run, the scan finds it. */
+static retro_task_t *retro_task_threaded_take(unsigned self)
+{
+   unsigned i, j;
+   bool serial_ok = !serial_running;
+
+   if (!worker_ready || (!serial_ok && worker_ready == serial_ready))
+      return NULL;
+
+   for (i = 0; i < TASK_PRIORITY_COUNT; i++)
+   {
+      enum task_priority prio = task_priority_order[i];
+      retro_task_t *task      = NULL;
+
+      for (j = 0; j < worker_count && !task; j++)
+      {
+         task_worker_t *worker = &task_workers[(self + j) % worker_count];
+
+         slock_lock(worker->lock);
+         task = task_deque_take(&worker->deques[prio], j != 0, serial_ok);
+         slock_unlock(worker->lock);
+      }
+
+      if (task)
+      {
+         worker_ready--;
+         if (!task->thread_safe)
+         {
+            serial_ready--;
+            serial_running = true;
+         }
+         return task;
+      }
+   }
+
+   return NULL;
+}
+
 static void retro_task_threaded_push_running(retro_task_t *task)
 {
+   task_worker_t *worker = NULL;
+
    slock_lock(running_lock);
    slock_lock(queue_lock);
    task_queue_put(&tasks_running, task);
-   scond_signal(worker_cond);
    slock_unlock(queue_lock);
+   worker = &task_workers[worker_next++ % worker_count];
    slock_unlock(running_lock);
+
+   retro_task_threaded_ready(worker, task);
 }
 
 static void retro_task_threaded_cancel(void *task)
@@ -437,47 +644,59 @@ static void retro_task_threaded_retrieve(task_retriever_data_t *data)
 
 static void threaded_worker(void *userdata)
 {
-   (void)userdata;
+   unsigned self = (unsigned)((task_worker_t*)userdata - task_workers);
 
    for (;;)
    {
+      retro_time_t start, end;
       retro_task_t *task  = NULL;
       bool finished = false;
 
-      if (!worker_continue)
-         break; /* should we keep running until all tasks finished? */
-
       slock_lock(running_lock);
-
-      /* Get first task to run */
-      task = tasks_running.front;
-      if (task == NULL)
-      {
+      while (worker_continue && !(task = retro_task_threaded_take(self)))
          scond_wait(worker_cond, running_lock);
-         slock_unlock(running_lock);
-         continue;
-      }
-
       slock_unlock(running_lock);
 
+      if (!task)
+         break; /* should we keep running until all tasks finished? */
+
+      start = cpu_features_get_time_usec();
       task->handler(task);
+      end   = cpu_features_get_time_usec();
 
       slock_lock(property_lock);
       finished = task->finished;
       slock_unlock(property_lock);
 
+      /* Metrics go with running_lock like task_get_data(), as
+       * property_lock is held while callbacks run. */
       slock_lock(running_lock);
-      task_queue_remove(&tasks_running, task);
+      if (!task->metrics.start_time)
+         task->metrics.start_time = start;
+      task->metrics.handler_time += end - start;
+      task->metrics.iterations++;
+      if (!task->thread_safe)
+      {
+         serial_running = false;
+         if (serial_ready)
+            scond_broadcast(worker_cond);
+      }
+      if (finished)
+      {
+         task->metrics.finish_time = end;
+         task_queue_remove(&tasks_running, task);
+      }
       slock_unlock(running_lock);
 
       /* Update queue */
       if (!finished)
       {
-         /* Re-add task to running queue */
-         retro_task_threaded_push_running(task);
+         /* Queue the next step on this worker again */
+         retro_task_threaded_ready(&task_workers[self], task);
       }
       else
       {
+
          /* Add task to finished queue */
          slock_lock(finished_lock);
          task_queue_put(&tasks_finished, task);
@@ -488,27 +707,78 @@ static void threaded_worker(void *userdata)
 
 static void retro_task_threaded_init(void)
 {
+   unsigned i;
+   retro_task_t *task = NULL;
+
    running_lock  = slock_new();
    finished_lock = slock_new();
    property_lock = slock_new();
    queue_lock    = slock_new();
    worker_cond   = scond_new();
 
+   /* At least two workers so that a long running task
+    * cannot hold up everything else. */
+   worker_count  = cpu_features_get_core_amount();
+   if (worker_count < 2)
+      worker_count = 2;
+   if (worker_count > TASK_QUEUE_MAX_WORKERS)
+      worker_count = TASK_QUEUE_MAX_WORKERS;
+
+   for (i = 0; i < worker_count; i++)
+   {
+      memset(&task_workers[i], 0, sizeof(task_workers[i]));
+      task_workers[i].lock = slock_new();
+   }
+
    slock_lock(running_lock);
    worker_continue = true;
+   worker_ready    = 0;
+   worker_next     = 0;
+   serial_ready    = 0;
+   serial_running  = false;
+
+   /* Pick up tasks left over by the previous implementation */
+   for (task = tasks_running.front; task; task = task->next)
+   {
+      task_worker_t *worker = &task_workers[worker_next++ % worker_count];
+
+      if (task_deque_push_back(
+               &worker->deques[task_get_priority(task)], task))
+      {
+         worker_ready++;
+         if (!task->thread_safe)
+            serial_ready++;
+      }
+   }
    slock_unlock(running_lock);
 
-   worker_thread = sthread_create(threaded_worker, NULL);
+   for (i = 0; i < worker_count; i++)
+      task_workers[i].thread = sthread_create(threaded_worker,
+            &task_workers[i]);
 }
 
 static void retro_task_threaded_deinit(void)
 {
+   unsigned i, j;
+
    slock_lock(running_lock);
    worker_continue = false;
-   scond_signal(worker_cond);
+   scond_broadcast(worker_cond);
    slock_unlock(running_lock);
 
-   sthread_join(worker_thread);
+   for (i = 0; i < worker_count; i++)
+   {
+      if (task_workers[i].thread)
+         sthread_join(task_workers[i].thread);
+
+      /* Tasks stay in tasks_running and are picked up again
+       * by whichever implementation comes next */
+      for (j = 0; j < TASK_PRIORITY_COUNT; j++)
+         free(task_workers[i].deques[j].tasks);
+
+      slock_free(task_workers[i].lock);
+      memset(&task_workers[i], 0, sizeof(task_workers[i]));
+   }
 
    scond_free(worker_cond);
    slock_free(running_lock);
@@ -516,7 +786,9 @@ static void retro_task_threaded_deinit(void)
    slock_free(property_lock);
    slock_free(queue_lock);
 
-   worker_thread = NULL;
+   worker_count  = 0;
+   worker_ready  = 0;
+   serial_ready  = 0;
    worker_cond   = NULL;
    running_lock  = NULL;
    finished_lock = NULL;
@@ -637,6 +909,8 @@ bool task_queue_push(retro_task_t *task)
          return false;
    }
 
+   task->metrics.enqueue_time = cpu_features_get_time_usec();
+
    /* The lack of NULL checks in the following functions
     * is proposital to ensure correct control flow by the users. */
    impl_current->push_running(task);
@@ -748,6 +1022,18 @@ void task_free_title(retro_task_t *task)
    SLOCK_UNLOCK(property_lock);
 }
 
+void task_get_metrics(retro_task_t *task, retro_task_metrics_t *metrics)
+{
+   SLOCK_LOCK(running_lock);
+   *metrics = task->metrics;
+   SLOCK_UNLOCK(running_lock);
+}
+
+void task_queue_set_metrics_log(retro_task_metrics_log_t log)
+{
+   task_metrics_log = log;
+}
+
 void* task_get_data(retro_task_t *task)
 {
    void *data = NULL;
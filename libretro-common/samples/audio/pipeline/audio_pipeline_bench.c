@@ -0,0 +1,351 @@
+/* Pushes batches of core audio through the stages of the frontend's
+ * audio output, converting, resampling, mixing and converting back
+ * into a driver ring buffer. This runs once with a full pass over the
+ * batch per stage, the way audio_driver_flush() used to work, and once
+ * block by block, both with and without writing straight into the
+ * ring. Reports the cost per second of audio.
+ *
+ * Usage: audio_pipeline_bench [input rate] [batch frames] [seconds] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <audio/audio_mixer.h>
+#include <audio/audio_resampler.h>
+#include <audio/conversion/float_to_s16.h>
+#include <audio/conversion/s16_to_float.h>
+#include <features/features_cpu.h>
+#include <queues/spsc_queue.h>
+
+#define BENCH_OUT_RATE      48000
+/* Same as AUDIO_FLUSH_BLOCK_FRAMES in retroarch.c */
+#define BENCH_BLOCK_FRAMES  256
+#define BENCH_MAX_RATIO     4
+
+enum bench_mode
+{
+   BENCH_MULTI_PASS = 0,
+   BENCH_FUSED,
+   BENCH_FUSED_DIRECT,
+   BENCH_MODES
+};
+
+static const char *bench_modes[] = {
+   "multi-pass", "fused", "fused+direct"
+};
+
+static const char *bench_qualities[] = {
+   NULL, "lowest", "lower", "normal", "higher", "highest"
+};
+
+typedef struct
+{
+   void *resampler;
+   spsc_buffer_t *ring;
+   float *in;
+   float *out;
+   int16_t *conv;
+   double ratio;
+
+   /* Everything the driver played, for comparing the modes */
+   int16_t *capture;
+   size_t captured;
+   size_t capture_max;
+} bench_state_t;
+
+/* Plays back whatever is in the ring, like the audio hardware would */
+static void bench_drain(bench_state_t *state)
+{
+   spsc_region_t regions[2];
+   size_t size = spsc_read_regions(state->ring,
+         spsc_read_avail(state->ring), regions);
+   unsigned i;
+
+   for (i = 0; i < 2 && state->capture; i++)
+   {
+      size_t samples = regions[i].size / sizeof(int16_t);
+
+      if (samples > state->capture_max - state->captured)
+         samples = state->capture_max - state->captured;
+
+      memcpy(state->capture + state->captured, regions[i].data,
+            samples * sizeof(int16_t));
+      state->captured += samples;
+   }
+
+   spsc_read_commit(state->ring, size);
+}
+
+static size_t bench_resample_mix(bench_state_t *state, const float *in,
+      size_t frames, float *out)
+{
+   struct resampler_data data;
+
+   data.data_in       = in;
+   data.data_out      = out;
+   data.input_frames  = frames;
+   data.output_frames = 0;
+   data.ratio         = state->ratio;
+
+   sinc_resampler.process(state->resampler, &data);
+   audio_mixer_mix(out, data.output_frames, 1.0f, false);
+
+   return data.output_frames;
+}
+
+static void bench_flush(bench_state_t *state, enum bench_mode mode,
+      const int16_t *data, size_t frames)
+{
+   size_t i;
+   size_t staged = 0;
+
+   if (mode == BENCH_MULTI_PASS)
+   {
+      convert_s16_to_float(state->in, data, frames * 2, 1.0f);
+      staged = bench_resample_mix(state, state->in, frames, state->out);
+      convert_float_to_s16(state->conv, state->out, staged * 2);
+      spsc_write(state->ring, state->conv, staged * 2 * sizeof(int16_t));
+      return;
+   }
+
+   for (i = 0; i < frames; i += BENCH_BLOCK_FRAMES)
+   {
+      size_t count = frames - i < BENCH_BLOCK_FRAMES
+         ? frames - i : BENCH_BLOCK_FRAMES;
+      const float *out = state->out;
+
+      convert_s16_to_float(state->in, data + i * 2, count * 2, 1.0f);
+      count = bench_resample_mix(state, state->in, count, state->out);
+
+      if (mode == BENCH_FUSED)
+      {
+         convert_float_to_s16(state->conv + staged * 2, out, count * 2);
+         staged += count;
+         continue;
+      }
+
+      while (count)
+      {
+         spsc_region_t regions[2];
+         size_t n;
+
+         /* Like the drivers, only hand out the part up to the
+          * end of the ring and come back for the rest. */
+         spsc_write_regions(state->ring,
+               count * 2 * sizeof(int16_t), regions);
+         n = regions[0].size / (2 * sizeof(int16_t));
+         convert_float_to_s16((int16_t*)regions[0].data, out, n * 2);
+         spsc_write_commit(state->ring, n * 2 * sizeof(int16_t));
+
+         out   += n * 2;
+         count -= n;
+      }
+   }
+
+   if (staged)
+      spsc_write(state->ring, state->conv, staged * 2 * sizeof(int16_t));
+}
+
+/* Returns microseconds spent in the pipeline. */
+static retro_time_t bench_run(bench_state_t *state, enum bench_mode mode,
+      enum resampler_quality quality, audio_mixer_sound_t *sound,
+      const int16_t *in, size_t in_frames, size_t batch_frames)
+{
+   size_t i;
+   retro_time_t total       = 0;
+   audio_mixer_voice_t *voice = audio_mixer_play(sound, true, 0.5f, NULL);
+
+   state->resampler = sinc_resampler.init(NULL, state->ratio, quality,
+         cpu_features_get());
+   state->captured  = 0;
+
+   for (i = 0; i < in_frames; i += batch_frames)
+   {
+      size_t frames      = in_frames - i < batch_frames
+         ? in_frames - i : batch_frames;
+      retro_time_t start = cpu_features_get_time_usec();
+
+      bench_flush(state, mode, in + i * 2, frames);
+      total += cpu_features_get_time_usec() - start;
+
+      bench_drain(state);
+   }
+
+   sinc_resampler.free(state->resampler);
+   audio_mixer_stop(voice);
+   return total;
+}
+
+/* One second of a quiet tone as a 16-bit stereo WAV file,
+ * for the mixer to play on top. */
+static void *bench_wav_new(size_t *size)
+{
+   unsigned i;
+   uint32_t data_size = BENCH_OUT_RATE * 2 * sizeof(int16_t);
+   uint8_t *wav       = (uint8_t*)calloc(1, 44 + data_size);
+   int16_t *samples   = (int16_t*)(wav + 44);
+
+   if (!wav)
+      return NULL;
+
+   memcpy(wav +  0, "RIFF", 4);
+   memcpy(wav +  8, "WAVEfmt ", 8);
+   memcpy(wav + 36, "data", 4);
+
+#define BENCH_LE32(p, v) \
+   do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); \
+      (p)[2] = (uint8_t)((v) >> 16); (p)[3] = (uint8_t)((v) >> 24); } while (0)
+   BENCH_LE32(wav +  4, 36 + data_size);
+   BENCH_LE32(wav + 16, 16);
+   wav[20] = 1;  /* PCM */
+   wav[22] = 2;  /* stereo */
+   BENCH_LE32(wav + 24, BENCH_OUT_RATE);
+   BENCH_LE32(wav + 28, BENCH_OUT_RATE * 4);
+   wav[32] = 4;  /* bytes per frame */
+   wav[34] = 16; /* bits per sample */
+   BENCH_LE32(wav + 40, data_size);
+#undef BENCH_LE32
+
+   for (i = 0; i < BENCH_OUT_RATE; i++)
+   {
+      int16_t s          = (int16_t)(4000.0 *
+            sin(2.0 * M_PI * 440.0 * i / BENCH_OUT_RATE));
+      samples[i * 2 + 0] = s;
+      samples[i * 2 + 1] = s;
+   }
+
+   *size = 44 + data_size;
+   return wav;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned m, q;
+   size_t i, in_frames, out_max, wav_size;
+   bench_state_t state;
+   int16_t *in;
+   int16_t *ref;
+   void *wav;
+   audio_mixer_sound_t *sound;
+   unsigned in_rate     = 44100;
+   size_t batch_frames  = 1024;
+   unsigned seconds     = 10;
+
+   if (argc > 1)
+      in_rate      = (unsigned)strtoul(argv[1], NULL, 10);
+   if (argc > 2)
+      batch_frames = (size_t)strtoul(argv[2], NULL, 10);
+   if (argc > 3)
+      seconds      = (unsigned)strtoul(argv[3], NULL, 10);
+
+   if (!in_rate || !batch_frames || !seconds
+         || BENCH_OUT_RATE > in_rate * BENCH_MAX_RATIO)
+   {
+      fprintf(stderr,
+            "Usage: %s [input rate] [batch frames] [seconds]\n", argv[0]);
+      return 1;
+   }
+
+   convert_s16_to_float_init_simd();
+   convert_float_to_s16_init_simd();
+   audio_mixer_init(BENCH_OUT_RATE);
+
+   memset(&state, 0, sizeof(state));
+
+   state.ratio       = (double)BENCH_OUT_RATE / in_rate;
+   in_frames         = (size_t)in_rate * seconds;
+   out_max           = (batch_frames + 1) * BENCH_MAX_RATIO;
+   state.in          = (float*)malloc(batch_frames * 2 * sizeof(float));
+   state.out         = (float*)malloc(out_max * 2 * sizeof(float));
+   state.conv        = (int16_t*)malloc(out_max * 2 * sizeof(int16_t));
+   state.ring        = spsc_new(out_max * 2 * sizeof(int16_t));
+   state.capture_max = (size_t)BENCH_OUT_RATE * 2;
+   state.capture     = (int16_t*)malloc(state.capture_max * sizeof(int16_t));
+   ref               = (int16_t*)malloc(state.capture_max * sizeof(int16_t));
+   in                = (int16_t*)malloc(in_frames * 2 * sizeof(int16_t));
+   wav               = bench_wav_new(&wav_size);
+   sound             = wav ? audio_mixer_load_wav(wav, (int32_t)wav_size)
+      : NULL;
+
+   if (!state.in || !state.out || !state.conv || !state.ring
+         || !state.capture || !ref || !in || !sound)
+      return 1;
+
+   /* A sweep on the left, noise on the right */
+   srand(1);
+   for (i = 0; i < in_frames; i++)
+   {
+      double t      = (double)i / in_rate;
+      in[i * 2 + 0] = (int16_t)(16000.0 * sin(2.0 * M_PI * 20.0 * t
+               * (1.0 + t * 1000.0 / seconds)));
+      in[i * 2 + 1] = (int16_t)(rand() % 32768 - 16384);
+   }
+
+   printf("%u Hz -> %u Hz, %u frame batches, %u seconds\n\n",
+         in_rate, BENCH_OUT_RATE, (unsigned)batch_frames, seconds);
+   /* The error is in 16-bit steps against the multi-pass output. The
+    * scalar tail of convert_float_to_s16() truncates where the SIMD
+    * body rounds, so different block edges can differ by one step. */
+   printf("%-8s %-13s %14s %10s\n",
+         "quality", "pipeline", "usec/s audio", "max error");
+
+   for (q = RESAMPLER_QUALITY_LOWEST; q <= RESAMPLER_QUALITY_HIGHEST; q++)
+   {
+      size_t ref_size = 0;
+
+      for (m = 0; m < BENCH_MODES; m++)
+      {
+         retro_time_t total;
+         int error = 0;
+
+         /* The first second once more while keeping what was
+          * played, then the whole run without. */
+         bench_run(&state, (enum bench_mode)m, (enum resampler_quality)q,
+               sound, in, in_rate < in_frames ? in_rate : in_frames,
+               batch_frames);
+
+         if (!m)
+         {
+            memcpy(ref, state.capture, state.captured * sizeof(int16_t));
+            ref_size = state.captured;
+         }
+         if (state.captured != ref_size)
+            error = 0x10000;
+         else
+         {
+            for (i = 0; i < ref_size; i++)
+            {
+               int diff = abs(ref[i] - state.capture[i]);
+               if (diff > error)
+                  error = diff;
+            }
+         }
+
+         {
+            int16_t *capture = state.capture;
+            state.capture    = NULL;
+            total            = bench_run(&state, (enum bench_mode)m,
+                  (enum resampler_quality)q, sound, in, in_frames,
+                  batch_frames);
+            state.capture    = capture;
+         }
+
+         printf("%-8s %-13s %14.1f %10d\n", bench_qualities[q],
+               bench_modes[m], (double)total / seconds, error);
+      }
+   }
+
+   audio_mixer_destroy(sound);
+   audio_mixer_done();
+   spsc_free(state.ring);
+   free(wav);
+   free(in);
+   free(ref);
+   free(state.capture);
+   free(state.in);
+   free(state.out);
+   free(state.conv);
+   return 0;
+}
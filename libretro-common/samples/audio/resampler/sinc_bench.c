@@ -0,0 +1,171 @@
+/* Runs the sinc resampler at every quality level with every kernel
+ * family this CPU supports and reports the time per output frame,
+ * along with how far each kernel strays from the plain C one.
+ *
+ * Usage: sinc_bench [input rate] [output rate] [seconds] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <audio/audio_resampler.h>
+#include <features/features_cpu.h>
+
+#define BENCH_CHUNK_FRAMES 1024
+
+typedef struct
+{
+   const char *name;
+   resampler_simd_mask_t mask;
+} bench_isa_t;
+
+/* Kernel families by the SIMD mask that selects them. On AArch64
+ * NEON is always there, so the C row runs NEON as well. */
+static const bench_isa_t bench_isas[] = {
+   { "C",       0 },
+   { "SSE",     RESAMPLER_SIMD_SSE },
+   { "AVX2",    RESAMPLER_SIMD_SSE | RESAMPLER_SIMD_AVX2 | RESAMPLER_SIMD_FMA },
+   { "AVX-512", RESAMPLER_SIMD_SSE | RESAMPLER_SIMD_AVX2 | RESAMPLER_SIMD_FMA
+      | RESAMPLER_SIMD_AVX512 },
+   { "NEON",    RESAMPLER_SIMD_NEON },
+};
+
+static const char *bench_qualities[] = {
+   NULL, "lowest", "lower", "normal", "higher", "highest"
+};
+
+/* Returns the number of output frames, or 0 on failure. */
+static size_t bench_run(enum resampler_quality quality,
+      resampler_simd_mask_t mask, double ratio,
+      const float *in, size_t in_frames, float *out, double *ns_per_frame)
+{
+   size_t i;
+   retro_time_t start;
+   size_t out_frames = 0;
+   void *re          = sinc_resampler.init(NULL, ratio, quality, mask);
+
+   if (!re)
+      return 0;
+
+   start = cpu_features_get_time_usec();
+
+   for (i = 0; i < in_frames; i += BENCH_CHUNK_FRAMES)
+   {
+      struct resampler_data data;
+
+      data.data_in       = in + i * 2;
+      data.data_out      = out + out_frames * 2;
+      data.input_frames  = in_frames - i < BENCH_CHUNK_FRAMES
+         ? in_frames - i : BENCH_CHUNK_FRAMES;
+      data.output_frames = 0;
+      data.ratio         = ratio;
+
+      sinc_resampler.process(re, &data);
+      out_frames        += data.output_frames;
+   }
+
+   *ns_per_frame = (cpu_features_get_time_usec() - start) * 1000.0
+      / out_frames;
+
+   sinc_resampler.free(re);
+   return out_frames;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, q;
+   size_t in_frames, out_max;
+   float *in, *out, *ref;
+   uint64_t cpu      = cpu_features_get();
+   unsigned in_rate  = 44100;
+   unsigned out_rate = 48000;
+   unsigned seconds  = 10;
+   double ratio;
+
+   if (argc > 1)
+      in_rate  = (unsigned)strtoul(argv[1], NULL, 10);
+   if (argc > 2)
+      out_rate = (unsigned)strtoul(argv[2], NULL, 10);
+   if (argc > 3)
+      seconds  = (unsigned)strtoul(argv[3], NULL, 10);
+
+   if (!in_rate || !out_rate || !seconds)
+   {
+      fprintf(stderr, "Usage: %s [input rate] [output rate] [seconds]\n",
+            argv[0]);
+      return 1;
+   }
+
+   ratio     = (double)out_rate / in_rate;
+   in_frames = (size_t)in_rate * seconds;
+   out_max   = (size_t)(in_frames * ratio) + 2 * BENCH_CHUNK_FRAMES;
+   in        = (float*)malloc(in_frames * 2 * sizeof(float));
+   out       = (float*)malloc(out_max * 2 * sizeof(float));
+   ref       = (float*)malloc(out_max * 2 * sizeof(float));
+
+   if (!in || !out || !ref)
+      return 1;
+
+   /* A sweep on the left, noise on the right */
+   srand(1);
+   for (i = 0; i < in_frames; i++)
+   {
+      double t      = (double)i / in_rate;
+      in[i * 2 + 0] = (float)(0.5 * sin(2.0 * M_PI * 20.0 * t
+               * (1.0 + t * 1000.0 / seconds)));
+      in[i * 2 + 1] = (float)rand() / RAND_MAX - 0.5f;
+   }
+
+   printf("%u Hz -> %u Hz, %u seconds\n\n", in_rate, out_rate, seconds);
+   printf("%-8s %-8s %10s %10s %12s\n",
+         "quality", "isa", "ns/frame", "x realtime", "max error");
+
+   for (q = RESAMPLER_QUALITY_LOWEST; q <= RESAMPLER_QUALITY_HIGHEST; q++)
+   {
+      size_t ref_frames = 0;
+
+      for (i = 0; i < sizeof(bench_isas) / sizeof(bench_isas[0]); i++)
+      {
+         size_t j, out_frames;
+         double ns;
+         float error = 0.0f;
+
+         if ((bench_isas[i].mask & cpu) != bench_isas[i].mask)
+            continue;
+
+         out_frames = bench_run((enum resampler_quality)q,
+               bench_isas[i].mask, ratio, in, in_frames,
+               i ? out : ref, &ns);
+
+         if (!out_frames)
+         {
+            printf("%-8s %-8s failed\n", bench_qualities[q],
+                  bench_isas[i].name);
+            continue;
+         }
+
+         if (!i)
+            ref_frames = out_frames;
+         else if (out_frames != ref_frames)
+            error = INFINITY;
+         else
+         {
+            for (j = 0; j < out_frames * 2; j++)
+            {
+               float diff = fabsf(out[j] - ref[j]);
+               if (diff > error)
+                  error = diff;
+            }
+         }
+
+         printf("%-8s %-8s %10.1f %10.0f %12g\n", bench_qualities[q],
+               bench_isas[i].name, ns, 1e9 / (ns * out_rate), error);
+      }
+   }
+
+   free(in);
+   free(out);
+   free(ref);
+   return 0;
+}
@@ -0,0 +1,219 @@
+/* Writes out a config shaped like a full retroarch.cfg, a few hundred
+ * general settings and the input binds of every player, then loads
+ * it the way the frontend does: parse the file and look up every key
+ * once, then set every key once before saving. Lookups are timed both
+ * through the config_get_* calls and by walking the entry list, which
+ * is what every one of those calls used to do. Reports the time per
+ * load and how many lookups per second each way manages.
+ *
+ * Usage: config_file_bench [players] [loads] [config path] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <file/config_file.h>
+#include <features/features_cpu.h>
+#include <string/stdstring.h>
+
+static const char *bench_sections[] = {
+   "video", "audio", "input", "menu", "netplay", "rewind", "savestate",
+   "cheevos", "playlist", "content", "core", "network", "ui", "log",
+};
+
+static const char *bench_settings[] = {
+   "driver", "enable", "device", "scale", "latency", "volume", "mute",
+   "threaded", "directory", "path", "timeout", "max_swapchain_images",
+   "font_size", "color_red", "color_green", "color_blue", "opacity",
+   "show", "auto_index", "sort_alphabetical", "history_size", "filter",
+};
+
+static const char *bench_binds[] = {
+   "b", "y", "select", "start", "up", "down", "left", "right",
+   "a", "x", "l", "r", "l2", "r2", "l3", "r3",
+   "l_x_plus", "l_x_minus", "l_y_plus", "l_y_minus",
+   "r_x_plus", "r_x_minus", "r_y_plus", "r_y_minus",
+   "turbo", "gun_trigger", "gun_reload",
+};
+
+static const char *bench_bind_kinds[] = { "", "_btn", "_axis", "_mbtn" };
+
+#define BENCH_ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+static char **bench_make_keys(unsigned players, size_t *count)
+{
+   unsigned p;
+   size_t i, j, k, n = 0;
+   size_t max        = BENCH_ARRAY_SIZE(bench_sections)
+      * BENCH_ARRAY_SIZE(bench_settings) + players
+      * BENCH_ARRAY_SIZE(bench_binds) * BENCH_ARRAY_SIZE(bench_bind_kinds);
+   char **keys       = (char**)calloc(max, sizeof(*keys));
+
+   if (!keys)
+      return NULL;
+
+   for (i = 0; i < BENCH_ARRAY_SIZE(bench_sections); i++)
+   {
+      for (j = 0; j < BENCH_ARRAY_SIZE(bench_settings); j++)
+      {
+         char key[128];
+         snprintf(key, sizeof(key), "%s_%s",
+               bench_sections[i], bench_settings[j]);
+         keys[n++] = strdup(key);
+      }
+   }
+
+   for (p = 1; p <= players; p++)
+   {
+      for (j = 0; j < BENCH_ARRAY_SIZE(bench_binds); j++)
+      {
+         for (k = 0; k < BENCH_ARRAY_SIZE(bench_bind_kinds); k++)
+         {
+            char key[128];
+            snprintf(key, sizeof(key), "input_player%u_%s%s",
+                  p, bench_binds[j], bench_bind_kinds[k]);
+            keys[n++] = strdup(key);
+         }
+      }
+   }
+
+   *count = n;
+   return keys;
+}
+
+static bool bench_write(const char *path, char **keys, size_t count)
+{
+   size_t i;
+   FILE *file = fopen(path, "wb");
+
+   if (!file)
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      if (i % 3 == 0)
+         fprintf(file, "%s = \"%u\"\n", keys[i], (unsigned)i);
+      else if (i % 3 == 1)
+         fprintf(file, "%s = \"%s\"\n", keys[i], i & 4 ? "true" : "false");
+      else
+         fprintf(file, "%s = \"~/.config/retroarch/%s\"\n", keys[i], keys[i]);
+   }
+
+   fclose(file);
+   return true;
+}
+
+/* What config_get_entry() did before it had an index. */
+static bool bench_walk(config_file_t *conf, const char *key,
+      char *s, size_t len)
+{
+   struct config_file_entry entry;
+
+   if (!config_get_entry_list_head(conf, &entry))
+      return false;
+
+   do
+   {
+      if (string_is_equal(key, entry.key))
+      {
+         strlcpy(s, entry.value, len);
+         return true;
+      }
+   } while (config_get_entry_list_next(&entry));
+
+   return false;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned l;
+   size_t i, count = 0;
+   retro_time_t parse = 0, get = 0, walk = 0, set = 0;
+   unsigned players   = 16;
+   unsigned loads     = 20;
+   const char *path   = "config_file_bench.cfg";
+   char **keys        = NULL;
+   size_t found       = 0;
+
+   if (argc > 1)
+      players = (unsigned)strtoul(argv[1], NULL, 10);
+   if (argc > 2)
+      loads   = (unsigned)strtoul(argv[2], NULL, 10);
+   if (argc > 3)
+      path    = argv[3];
+
+   if (!loads)
+   {
+      fprintf(stderr, "Usage: %s [players] [loads] [config path]\n",
+            argv[0]);
+      return 1;
+   }
+
+   keys = bench_make_keys(players, &count);
+   if (!keys || !bench_write(path, keys, count))
+   {
+      fprintf(stderr, "Could not write %s\n", path);
+      return 1;
+   }
+
+   for (l = 0; l < loads; l++)
+   {
+      char value[256];
+      retro_time_t start  = cpu_features_get_time_usec();
+      config_file_t *conf = config_file_new(path);
+
+      if (!conf)
+      {
+         fprintf(stderr, "Could not read %s\n", path);
+         return 1;
+      }
+
+      parse += cpu_features_get_time_usec() - start;
+
+      start  = cpu_features_get_time_usec();
+      for (i = 0; i < count; i++)
+         found += config_get_array(conf, keys[i], value, sizeof(value));
+      get   += cpu_features_get_time_usec() - start;
+
+      start  = cpu_features_get_time_usec();
+      for (i = 0; i < count; i++)
+         found += bench_walk(conf, keys[i], value, sizeof(value));
+      walk  += cpu_features_get_time_usec() - start;
+
+      start  = cpu_features_get_time_usec();
+      for (i = 0; i < count; i++)
+         config_set_string(conf, keys[i], keys[count - i - 1]);
+      set   += cpu_features_get_time_usec() - start;
+
+      config_file_free(conf);
+   }
+
+   remove(path);
+
+   if (found != 2 * count * loads)
+   {
+      fprintf(stderr, "Lookups found %u of %u keys\n",
+            (unsigned)found, (unsigned)(2 * count * loads));
+      return 1;
+   }
+
+   printf("%u keys, %u loads\n\n", (unsigned)count, loads);
+   printf("%-22s %12s %14s\n", "stage", "usec/load", "lookups/sec");
+   printf("%-22s %12.1f %14s\n", "parse",
+         (double)parse / loads, "-");
+   printf("%-22s %12.1f %14.0f\n", "config_get_array",
+         (double)get / loads, (double)count * loads * 1000000.0 / (get ? get : 1));
+   printf("%-22s %12.1f %14.0f\n", "list walk",
+         (double)walk / loads, (double)count * loads * 1000000.0 / (walk ? walk : 1));
+   printf("%-22s %12.1f %14.0f\n", "config_set_string",
+         (double)set / loads, (double)count * loads * 1000000.0 / (set ? set : 1));
+   printf("\nparse + get: %.1f usec, parse + list walk: %.1f usec, %.2fx\n",
+         (double)(parse + get) / loads, (double)(parse + walk) / loads,
+         (double)(parse + walk) / (parse + get ? parse + get : 1));
+
+   for (i = 0; i < count; i++)
+      free(keys[i]);
+   free(keys);
+   return 0;
+}
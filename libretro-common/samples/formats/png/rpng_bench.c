@@ -0,0 +1,281 @@
+/* Decodes a corpus of PNG thumbnails from memory the way the frontend
+ * does, first with the plain C reverse filters and pixel converters,
+ * then with the best vector code the CPU supports. Without any files
+ * given it writes a corpus of boxart sized RGB and RGBA images with
+ * rpng's own encoder first, which picks a filter for every row. Reports
+ * the megabytes of decoded ARGB output per second and whether both runs
+ * decode the same pixels.
+ *
+ * Usage: rpng_bench [loads] [png files...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <formats/image.h>
+#include <formats/rpng.h>
+
+/* Synthetic corpus, when no files are given */
+#define BENCH_IMAGES 16
+#define BENCH_WIDTH  512
+#define BENCH_HEIGHT 384
+
+struct bench_file
+{
+   const char *path;
+   uint8_t *buf;
+   size_t len;
+   uint32_t *ref;
+   unsigned width;
+   unsigned height;
+};
+
+static uint8_t *bench_read(const char *path, size_t *len)
+{
+   long size;
+   uint8_t *buf = NULL;
+   FILE *file   = fopen(path, "rb");
+
+   if (!file)
+      return NULL;
+
+   fseek(file, 0, SEEK_END);
+   size = ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   if (size > 0)
+      buf = (uint8_t*)malloc(size);
+
+   if (buf && fread(buf, 1, size, file) != (size_t)size)
+   {
+      free(buf);
+      buf = NULL;
+   }
+
+   fclose(file);
+   *len = (size_t)size;
+   return buf;
+}
+
+/* Soft gradients with noise and a few hard edges, about what
+ * scanned boxart looks like to the row filters. */
+static bool bench_write(const char *path, unsigned n)
+{
+   unsigned x, y;
+   bool ret;
+   bool rgba       = n & 1;
+   unsigned pitch  = BENCH_WIDTH * (rgba ? 4 : 3);
+   uint8_t *pixels = (uint8_t*)malloc(pitch * BENCH_HEIGHT);
+
+   if (!pixels)
+      return false;
+
+   srand(n + 1);
+   for (y = 0; y < BENCH_HEIGHT; y++)
+   {
+      for (x = 0; x < BENCH_WIDTH; x++)
+      {
+         uint8_t *px = pixels + y * pitch + x * (rgba ? 4 : 3);
+         unsigned r  = (x * 255 / BENCH_WIDTH + n * 16) & 0xff;
+         unsigned g  = (y * 255 / BENCH_HEIGHT) ^ (((x / 64 + y / 48) & 1) * 0x80);
+         unsigned b  = ((x + y) / 4 + (rand() & 7)) & 0xff;
+
+         if (rgba)
+            *(uint32_t*)px = ((0xf0u + (rand() & 0x0f)) << 24)
+               | (r << 16) | (g << 8) | b;
+         else
+         {
+            px[0] = b;
+            px[1] = g;
+            px[2] = r;
+         }
+      }
+   }
+
+   if (rgba)
+      ret = rpng_save_image_argb(path, (const uint32_t*)pixels,
+            BENCH_WIDTH, BENCH_HEIGHT, pitch);
+   else
+      ret = rpng_save_image_bgr24(path, pixels,
+            BENCH_WIDTH, BENCH_HEIGHT, pitch);
+
+   free(pixels);
+   return ret;
+}
+
+static uint32_t *bench_decode(const struct bench_file *file,
+      unsigned *width, unsigned *height)
+{
+   int ret;
+   uint32_t *data = NULL;
+   rpng_t *rpng   = rpng_alloc();
+
+   if (!rpng)
+      return NULL;
+
+   if (!rpng_set_buf_ptr(rpng, file->buf, file->len)
+         || !rpng_start(rpng))
+      goto error;
+
+   while (rpng_iterate_image(rpng));
+
+   if (!rpng_is_valid(rpng))
+      goto error;
+
+   do
+   {
+      ret = rpng_process_image(rpng, (void**)&data,
+            file->len, width, height);
+   } while (ret == IMAGE_PROCESS_NEXT);
+
+   if (ret == IMAGE_PROCESS_ERROR || ret == IMAGE_PROCESS_ERROR_END)
+      goto error;
+
+   rpng_free(rpng);
+   return data;
+
+error:
+   rpng_free(rpng);
+   free(data);
+   return NULL;
+}
+
+/* Returns microseconds per pass over the corpus. Keeps the pixels
+ * of the first load as the reference if there is none yet, otherwise
+ * checks against it. */
+static double bench_run(struct bench_file *files, unsigned count,
+      uint64_t simd, unsigned loads, bool *same)
+{
+   unsigned l, i;
+   retro_time_t total = 0;
+
+   rpng_set_simd(simd);
+
+   for (l = 0; l < loads; l++)
+   {
+      for (i = 0; i < count; i++)
+      {
+         unsigned width     = 0;
+         unsigned height    = 0;
+         retro_time_t start = cpu_features_get_time_usec();
+         uint32_t *data     = bench_decode(&files[i], &width, &height);
+
+         total += cpu_features_get_time_usec() - start;
+
+         if (!data)
+         {
+            *same = false;
+            continue;
+         }
+
+         if (!files[i].ref)
+         {
+            files[i].ref    = data;
+            files[i].width  = width;
+            files[i].height = height;
+            continue;
+         }
+
+         if (width != files[i].width || height != files[i].height
+               || memcmp(data, files[i].ref,
+                  (size_t)width * height * sizeof(uint32_t)))
+            *same = false;
+
+         free(data);
+      }
+   }
+
+   return (double)total / loads;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   double base, usec, mb;
+   struct bench_file *files;
+   char paths[BENCH_IMAGES][32];
+   unsigned loads     = 20;
+   unsigned count     = 0;
+   bool synthetic     = argc <= 2;
+   bool same          = true;
+   size_t in_size     = 0;
+   size_t out_size    = 0;
+   uint64_t simd      = cpu_features_get();
+
+   if (argc > 1)
+      loads = (unsigned)strtoul(argv[1], NULL, 10);
+
+   if (!loads)
+   {
+      fprintf(stderr, "Usage: %s [loads] [png files...]\n", argv[0]);
+      return 1;
+   }
+
+   count = synthetic ? BENCH_IMAGES : (unsigned)(argc - 2);
+   files = (struct bench_file*)calloc(count, sizeof(*files));
+   if (!files)
+      return 1;
+
+   for (i = 0; i < count; i++)
+   {
+      if (synthetic)
+      {
+         snprintf(paths[i], sizeof(paths[i]), "rpng_bench_%u.png", i);
+         if (!bench_write(paths[i], i))
+         {
+            fprintf(stderr, "Could not write %s\n", paths[i]);
+            return 1;
+         }
+         files[i].path = paths[i];
+      }
+      else
+         files[i].path = argv[i + 2];
+
+      files[i].buf = bench_read(files[i].path, &files[i].len);
+
+      if (synthetic)
+         remove(paths[i]);
+
+      if (!files[i].buf)
+      {
+         fprintf(stderr, "Could not read %s\n", files[i].path);
+         return 1;
+      }
+
+      in_size += files[i].len;
+   }
+
+   base = bench_run(files, count, 0, loads, &same);
+
+   for (i = 0; i < count; i++)
+   {
+      if (!files[i].ref)
+      {
+         fprintf(stderr, "Could not decode %s\n", files[i].path);
+         return 1;
+      }
+      out_size += (size_t)files[i].width * files[i].height * sizeof(uint32_t);
+   }
+
+   usec = bench_run(files, count, simd, loads, &same);
+   mb   = (double)out_size / (1024.0 * 1024.0);
+
+   printf("%u files, %.1f MB of PNG, %.1f MB decoded, %u loads\n\n",
+         count, (double)in_size / (1024.0 * 1024.0), mb, loads);
+   printf("%-8s %12s %10s %8s %7s\n",
+         "kernels", "usec/pass", "MB/s", "speedup", "output");
+   printf("%-8s %12.1f %10.1f %7.2fx %7s\n",
+         "base", base, mb * 1000000.0 / base, 1.0, "-");
+   printf("%-8s %12.1f %10.1f %7.2fx %7s\n",
+         "best", usec, mb * 1000000.0 / usec, base / usec,
+         same ? "same" : "DIFFERS");
+
+   for (i = 0; i < count; i++)
+   {
+      free(files[i].buf);
+      free(files[i].ref);
+   }
+   free(files);
+   return same ? 0 : 1;
+}
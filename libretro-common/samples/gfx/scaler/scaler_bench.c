@@ -0,0 +1,318 @@
+/* Scales a synthetic frame with every scaler type between the pixel
+ * formats the frontend uses, first with the baseline kernels (plain
+ * C, or SSE2 where the build has it), then with the best ones the CPU
+ * supports, on one thread and on more. Then runs the same-size format
+ * converters both ways. Reports the time per frame and the largest
+ * difference of any output byte from the baseline.
+ *
+ * Usage: scaler_bench [in width] [in height] [out width] [out height] [frames] [max threads] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <gfx/scaler/scaler.h>
+#include <gfx/scaler/pixconv.h>
+
+static const struct
+{
+   const char *name;
+   enum scaler_type type;
+} bench_types[] = {
+   { "point",    SCALER_TYPE_POINT    },
+   { "bilinear", SCALER_TYPE_BILINEAR },
+   { "sinc",     SCALER_TYPE_SINC     },
+};
+
+static const struct
+{
+   const char *name;
+   enum scaler_pix_fmt in_fmt;
+   enum scaler_pix_fmt out_fmt;
+} bench_formats[] = {
+   { "ARGB8888 -> ARGB8888", SCALER_FMT_ARGB8888, SCALER_FMT_ARGB8888 },
+   { "RGB565 -> ARGB8888",   SCALER_FMT_RGB565,   SCALER_FMT_ARGB8888 },
+   { "0RGB1555 -> ARGB8888", SCALER_FMT_0RGB1555, SCALER_FMT_ARGB8888 },
+   { "ARGB8888 -> 0RGB1555", SCALER_FMT_ARGB8888, SCALER_FMT_0RGB1555 },
+   { "ARGB8888 -> ABGR8888", SCALER_FMT_ARGB8888, SCALER_FMT_ABGR8888 },
+};
+
+static const struct
+{
+   const char *name;
+   void (*conv)(void*, const void*, int, int, int, int);
+   enum scaler_pix_fmt in_fmt;
+   enum scaler_pix_fmt out_fmt;
+} bench_convs[] = {
+   { "conv_rgb565_argb8888",   conv_rgb565_argb8888,
+      SCALER_FMT_RGB565,   SCALER_FMT_ARGB8888 },
+   { "conv_0rgb1555_argb8888", conv_0rgb1555_argb8888,
+      SCALER_FMT_0RGB1555, SCALER_FMT_ARGB8888 },
+   { "conv_argb8888_0rgb1555", conv_argb8888_0rgb1555,
+      SCALER_FMT_ARGB8888, SCALER_FMT_0RGB1555 },
+   { "conv_argb8888_abgr8888", conv_argb8888_abgr8888,
+      SCALER_FMT_ARGB8888, SCALER_FMT_ABGR8888 },
+   { "conv_rgb565_0rgb1555",   conv_rgb565_0rgb1555,
+      SCALER_FMT_RGB565,   SCALER_FMT_0RGB1555 },
+   { "conv_0rgb1555_rgb565",   conv_0rgb1555_rgb565,
+      SCALER_FMT_0RGB1555, SCALER_FMT_RGB565   },
+};
+
+static unsigned bench_bpp(enum scaler_pix_fmt fmt)
+{
+   switch (fmt)
+   {
+      case SCALER_FMT_RGB565:
+      case SCALER_FMT_0RGB1555:
+         return 2;
+      default:
+         break;
+   }
+   return 4;
+}
+
+/* Smooth gradients with some noise and hard edges on top, so the
+ * sinc filter rings and overshoots. */
+static void bench_fill(uint8_t *frame, size_t pitch,
+      enum scaler_pix_fmt fmt, unsigned width, unsigned height)
+{
+   unsigned x, y;
+
+   srand(1);
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         unsigned r = (x * 255 / width) ^ (((x / 16 + y / 16) & 1) * 0xc0);
+         unsigned g = y * 255 / height;
+         unsigned b = rand() & 0xff;
+         unsigned a = 0xff - (rand() & 0x0f);
+
+         switch (fmt)
+         {
+            case SCALER_FMT_RGB565:
+               ((uint16_t*)(frame + y * pitch))[x] = (uint16_t)(
+                     ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+               break;
+            case SCALER_FMT_0RGB1555:
+               ((uint16_t*)(frame + y * pitch))[x] = (uint16_t)(
+                     ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3));
+               break;
+            default:
+               ((uint32_t*)(frame + y * pitch))[x] =
+                  (a << 24) | (r << 16) | (g << 8) | b;
+               break;
+         }
+      }
+   }
+}
+
+static int bench_diff(const uint8_t *a, const uint8_t *b, size_t pitch,
+      unsigned row_bytes, unsigned height)
+{
+   unsigned x, y;
+   int diff = 0;
+
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < row_bytes; x++)
+      {
+         int d = abs(a[y * pitch + x] - b[y * pitch + x]);
+         if (d > diff)
+            diff = d;
+      }
+   }
+
+   return diff;
+}
+
+/* Returns microseconds per frame, or a negative value on failure. */
+static double bench_scale(enum scaler_type type, unsigned f,
+      uint64_t simd, unsigned threads,
+      const uint8_t *in, size_t in_pitch, unsigned in_width,
+      unsigned in_height, uint8_t *out, size_t out_pitch,
+      unsigned out_width, unsigned out_height, unsigned frames)
+{
+   unsigned i;
+   retro_time_t start, total;
+   struct scaler_ctx ctx;
+
+   memset(&ctx, 0, sizeof(ctx));
+
+   ctx.in_width    = in_width;
+   ctx.in_height   = in_height;
+   ctx.in_stride   = (int)in_pitch;
+   ctx.in_fmt      = bench_formats[f].in_fmt;
+   ctx.out_width   = out_width;
+   ctx.out_height  = out_height;
+   ctx.out_stride  = (int)out_pitch;
+   ctx.out_fmt     = bench_formats[f].out_fmt;
+   ctx.scaler_type = type;
+   ctx.threads     = threads;
+
+   conv_set_simd(simd);
+
+   if (!scaler_ctx_gen_filter(&ctx))
+   {
+      scaler_ctx_gen_reset(&ctx);
+      return -1.0;
+   }
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < frames; i++)
+      scaler_ctx_scale(&ctx, out, in);
+   total = cpu_features_get_time_usec() - start;
+
+   scaler_ctx_gen_reset(&ctx);
+
+   return (double)total / frames;
+}
+
+static double bench_conv(unsigned c, uint64_t simd,
+      const uint8_t *in, size_t in_pitch, uint8_t *out, size_t out_pitch,
+      unsigned width, unsigned height, unsigned frames)
+{
+   unsigned i;
+   retro_time_t start, total;
+
+   conv_set_simd(simd);
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < frames; i++)
+      bench_convs[c].conv(out, in, width, height,
+            (int)out_pitch, (int)in_pitch);
+   total = cpu_features_get_time_usec() - start;
+
+   return (double)total / frames;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned t, f, c, threads;
+   size_t in_pitch, out_pitch, out_size;
+   uint8_t *in, *out, *ref;
+   unsigned in_width   = 320;
+   unsigned in_height  = 240;
+   unsigned out_width  = 1280;
+   unsigned out_height = 960;
+   unsigned frames     = 100;
+   unsigned cores      = cpu_features_get_core_amount();
+   uint64_t simd       = cpu_features_get();
+
+   if (argc > 1)
+      in_width   = (unsigned)strtoul(argv[1], NULL, 10);
+   if (argc > 2)
+      in_height  = (unsigned)strtoul(argv[2], NULL, 10);
+   if (argc > 3)
+      out_width  = (unsigned)strtoul(argv[3], NULL, 10);
+   if (argc > 4)
+      out_height = (unsigned)strtoul(argv[4], NULL, 10);
+   if (argc > 5)
+      frames     = (unsigned)strtoul(argv[5], NULL, 10);
+   if (argc > 6)
+      cores      = (unsigned)strtoul(argv[6], NULL, 10);
+
+   /* Same size frames only get converted, not scaled */
+   if (!in_width || !in_height || !out_width || !out_height
+         || !frames || !cores
+         || (in_width == out_width && in_height == out_height))
+   {
+      fprintf(stderr, "Usage: %s [in width] [in height] [out width] "
+            "[out height] [frames] [max threads]\n", argv[0]);
+      return 1;
+   }
+
+   /* Odd pitches, so no row starts aligned */
+   in_pitch  = in_width  * 4 + 4;
+   out_pitch = (out_width > in_width ? out_width : in_width) * 4 + 4;
+   out_size  = out_pitch * (out_height > in_height
+         ? out_height : in_height);
+   in        = (uint8_t*)malloc(in_pitch * in_height);
+   out       = (uint8_t*)malloc(out_size);
+   ref       = (uint8_t*)malloc(out_size);
+
+   if (!in || !out || !ref)
+      return 1;
+
+   printf("%ux%u -> %ux%u, %u frames, up to %u threads\n\n",
+         in_width, in_height, out_width, out_height, frames, cores);
+   printf("%-8s %-22s %-7s %7s %12s %8s %8s\n", "scaler", "format",
+         "kernels", "threads", "usec/frame", "speedup", "max diff");
+
+   for (t = 0; t < sizeof(bench_types) / sizeof(bench_types[0]); t++)
+   {
+      for (f = 0; f < sizeof(bench_formats) / sizeof(bench_formats[0]); f++)
+      {
+         double base;
+         unsigned row_bytes = out_width * bench_bpp(bench_formats[f].out_fmt);
+
+         bench_fill(in, in_pitch, bench_formats[f].in_fmt,
+               in_width, in_height);
+
+         memset(ref, 0, out_size);
+         base = bench_scale(bench_types[t].type, f, 0, 1,
+               in, in_pitch, in_width, in_height,
+               ref, out_pitch, out_width, out_height, frames);
+
+         if (base < 0.0)
+         {
+            printf("%-8s %-22s not supported\n",
+                  bench_types[t].name, bench_formats[f].name);
+            continue;
+         }
+
+         printf("%-8s %-22s %-7s %7u %12.1f %7.2fx %8d\n",
+               bench_types[t].name, bench_formats[f].name,
+               "base", 1, base, 1.0, 0);
+
+         for (threads = 1;; threads = threads * 2 < cores
+               ? threads * 2 : cores)
+         {
+            double usec;
+
+            memset(out, 0, out_size);
+            usec = bench_scale(bench_types[t].type, f, simd, threads,
+                  in, in_pitch, in_width, in_height,
+                  out, out_pitch, out_width, out_height, frames);
+
+            printf("%-8s %-22s %-7s %7u %12.1f %7.2fx %8d\n",
+                  bench_types[t].name, bench_formats[f].name,
+                  "best", threads, usec, base / usec,
+                  bench_diff(ref, out, out_pitch, row_bytes, out_height));
+
+            if (threads >= cores)
+               break;
+         }
+      }
+   }
+
+   printf("\n%-24s %-7s %12s %8s %8s\n", "converter",
+         "kernels", "usec/frame", "speedup", "max diff");
+
+   for (c = 0; c < sizeof(bench_convs) / sizeof(bench_convs[0]); c++)
+   {
+      double base, usec;
+      unsigned row_bytes = in_width * bench_bpp(bench_convs[c].out_fmt);
+
+      bench_fill(in, in_pitch, bench_convs[c].in_fmt, in_width, in_height);
+
+      memset(ref, 0, out_size);
+      memset(out, 0, out_size);
+      base = bench_conv(c, 0, in, in_pitch, ref, out_pitch,
+            in_width, in_height, frames);
+      usec = bench_conv(c, simd, in, in_pitch, out, out_pitch,
+            in_width, in_height, frames);
+
+      printf("%-24s %-7s %12.1f %7.2fx %8d\n", bench_convs[c].name,
+            "base", base, 1.0, 0);
+      printf("%-24s %-7s %12.1f %7.2fx %8d\n", bench_convs[c].name,
+            "best", usec, base / usec,
+            bench_diff(ref, out, out_pitch, row_bytes, in_height));
+   }
+
+   free(in);
+   free(out);
+   free(ref);
+   return 0;
+}
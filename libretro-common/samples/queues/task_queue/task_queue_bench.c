@@ -0,0 +1,215 @@
+/* Pushes a batch of synthetic tasks through the task queue and
+ * reports throughput and latencies, first in regular and then
+ * in threaded mode.
+ *
+ * Usage: task_queue_bench [number of tasks] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <queues/task_queue.h>
+#include <features/features_cpu.h>
+#include <retro_timers.h>
+
+#define BENCH_DEFAULT_TASKS 2000
+/* How often the main loop gathers, like a 1000 Hz frontend */
+#define BENCH_GATHER_USEC   1000
+
+typedef struct
+{
+   /* busy work per step, in microseconds */
+   unsigned cpu_usec;
+   /* time per step spent waiting, like a task doing I/O */
+   unsigned io_usec;
+   unsigned steps;
+} bench_task_state_t;
+
+typedef struct
+{
+   retro_time_t *latency;
+   retro_time_t *wait;
+   retro_time_t *latency_high;
+   size_t count;
+   size_t count_high;
+} bench_results_t;
+
+static bench_results_t bench_results;
+
+static void bench_spin(unsigned usec)
+{
+   retro_time_t end = cpu_features_get_time_usec() + usec;
+   while (cpu_features_get_time_usec() < end);
+}
+
+static void bench_task_handler(retro_task_t *task)
+{
+   bench_task_state_t *state = (bench_task_state_t*)task->state;
+
+   bench_spin(state->cpu_usec);
+   if (state->io_usec)
+      retro_sleep(state->io_usec / 1000);
+
+   if (--state->steps == 0)
+      task_set_finished(task, true);
+}
+
+static void bench_task_callback(retro_task_t *task,
+      void *task_data, void *user_data, const char *error)
+{
+   retro_task_metrics_t metrics;
+
+   task_get_metrics(task, &metrics);
+
+   bench_results.wait[bench_results.count]      =
+      metrics.start_time  - metrics.enqueue_time;
+   bench_results.latency[bench_results.count++] =
+      metrics.gather_time - metrics.enqueue_time;
+
+   if (task->priority == TASK_PRIORITY_HIGH)
+      bench_results.latency_high[bench_results.count_high++] =
+         metrics.gather_time - metrics.enqueue_time;
+
+   free(task->state);
+}
+
+/* Mostly short tasks, some that take a few steps and
+ * a handful of long bulk ones, with a bit of I/O. */
+static void bench_push(unsigned i)
+{
+   retro_task_t *task        = task_init();
+   bench_task_state_t *state = (bench_task_state_t*)
+      calloc(1, sizeof(*state));
+   unsigned kind             = (i * 2654435761u) % 100;
+
+   if (kind < 70)
+   {
+      state->cpu_usec = 50;
+      state->steps    = 1;
+   }
+   else if (kind < 85)
+   {
+      state->cpu_usec = 100;
+      state->io_usec  = 1000;
+      state->steps    = 3;
+      task->priority  = TASK_PRIORITY_HIGH;
+   }
+   else if (kind < 97)
+   {
+      state->cpu_usec = 200;
+      state->steps    = 5;
+   }
+   else
+   {
+      state->cpu_usec = 500;
+      state->steps    = 40;
+      task->priority  = TASK_PRIORITY_LOW;
+   }
+
+   task->state    = state;
+   task->handler  = bench_task_handler;
+   task->callback = bench_task_callback;
+   task->mute     = true;
+
+   task_queue_push(task);
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+   retro_time_t x = *(const retro_time_t*)a;
+   retro_time_t y = *(const retro_time_t*)b;
+   return (x > y) - (x < y);
+}
+
+static double bench_percentile(retro_time_t *values, size_t count,
+      unsigned percent)
+{
+   if (!count)
+      return 0.0;
+   qsort(values, count, sizeof(*values), bench_cmp);
+   return values[(count - 1) * percent / 100] / 1000.0;
+}
+
+static void bench_run(bool threaded, unsigned num_tasks)
+{
+   unsigned i;
+   retro_time_t start, total;
+
+   memset(bench_results.latency,      0, num_tasks * sizeof(retro_time_t));
+   memset(bench_results.wait,         0, num_tasks * sizeof(retro_time_t));
+   memset(bench_results.latency_high, 0, num_tasks * sizeof(retro_time_t));
+   bench_results.count      = 0;
+   bench_results.count_high = 0;
+
+   task_queue_init(threaded, NULL);
+
+   start = cpu_features_get_time_usec();
+
+   for (i = 0; i < num_tasks; i++)
+      bench_push(i);
+
+   while (bench_results.count < num_tasks)
+   {
+      retro_time_t frame = cpu_features_get_time_usec();
+
+      task_queue_check();
+
+      frame = cpu_features_get_time_usec() - frame;
+      if (frame < BENCH_GATHER_USEC)
+         retro_sleep((unsigned)(BENCH_GATHER_USEC - frame) / 1000);
+   }
+
+   total = cpu_features_get_time_usec() - start;
+
+   task_queue_deinit();
+
+   printf("%-8s: %u tasks in %.1f ms, %.0f tasks/s\n",
+         threaded ? "threaded" : "regular",
+         num_tasks, total / 1000.0, num_tasks * 1000000.0 / total);
+   printf("          latency p50 %.2f ms, p99 %.2f ms\n",
+         bench_percentile(bench_results.latency, bench_results.count, 50),
+         bench_percentile(bench_results.latency, bench_results.count, 99));
+   printf("          queued  p50 %.2f ms, p99 %.2f ms\n",
+         bench_percentile(bench_results.wait, bench_results.count, 50),
+         bench_percentile(bench_results.wait, bench_results.count, 99));
+   printf("          high priority latency p50 %.2f ms, p99 %.2f ms\n",
+         bench_percentile(bench_results.latency_high,
+            bench_results.count_high, 50),
+         bench_percentile(bench_results.latency_high,
+            bench_results.count_high, 99));
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned num_tasks = BENCH_DEFAULT_TASKS;
+
+   if (argc > 1)
+      num_tasks = (unsigned)strtoul(argv[1], NULL, 10);
+
+   if (!num_tasks)
+   {
+      fprintf(stderr, "Usage: %s [number of tasks]\n", argv[0]);
+      return 1;
+   }
+
+   bench_results.latency      = (retro_time_t*)malloc(
+         num_tasks * sizeof(retro_time_t));
+   bench_results.wait         = (retro_time_t*)malloc(
+         num_tasks * sizeof(retro_time_t));
+   bench_results.latency_high = (retro_time_t*)malloc(
+         num_tasks * sizeof(retro_time_t));
+
+   if (!bench_results.latency || !bench_results.wait
+         || !bench_results.latency_high)
+      return 1;
+
+   bench_run(false, num_tasks);
+#ifdef HAVE_THREADS
+   bench_run(true, num_tasks);
+#endif
+
+   free(bench_results.latency);
+   free(bench_results.wait);
+   free(bench_results.latency_high);
+   return 0;
+}
@@ -840,7 +840,9 @@ int retro_vfs_file_remove_impl(const char *path)
 int retro_vfs_file_rename_impl(const char *old_path, const char *new_path)
 {
 #if defined(_WIN32) && !defined(_XBOX)
-   /* Win32 (no Xbox) */
+   /* Win32 (no Xbox)
+    * Unlike rename(), MoveFileEx() can replace an existing
+    * file, and does so in one step */
    int ret                 = -1;
 #if defined(_WIN32_WINNT) && _WIN32_WINNT < 0x0500
    char *old_path_local    = NULL;
@@ -860,8 +862,16 @@ int retro_vfs_file_rename_impl(const char *old_path, const char *new_path)
 
       if (new_path_local)
       {
-         if (rename(old_path_local, new_path_local) == 0)
+         if (MoveFileExA(old_path_local, new_path_local,
+                  MOVEFILE_REPLACE_EXISTING))
             ret = 0;
+         /* Windows 9x has no MoveFileEx(), replace by hand */
+         else if (GetLastError() == ERROR_CALL_NOT_IMPLEMENTED)
+         {
+            remove(new_path_local);
+            if (rename(old_path_local, new_path_local) == 0)
+               ret = 0;
+         }
          free(new_path_local);
       }
 
@@ -876,7 +886,8 @@ int retro_vfs_file_rename_impl(const char *old_path, const char *new_path)
 
       if (new_path_wide)
       {
-         if (_wrename(old_path_wide, new_path_wide) == 0)
+         if (MoveFileExW(old_path_wide, new_path_wide,
+                  MOVEFILE_REPLACE_EXISTING))
             ret = 0;
          free(new_path_wide);
       }
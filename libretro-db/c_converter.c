@@ -743,6 +743,33 @@ static int dat_converter_value_provider(
    return 0;
 }
 
+/* Lets the frontend look up crc, serial and names without a full scan */
+static bool dat_converter_create_indexes(const char *rdb_path)
+{
+   int rv;
+   libretrodb_t *db = libretrodb_new();
+
+   if (!db)
+      return false;
+
+   if ((rv = libretrodb_open(rdb_path, db)) == 0)
+   {
+      rv = libretrodb_create_indexes(db);
+      libretrodb_close(db);
+   }
+
+   libretrodb_free(db);
+
+   if (rv != 0)
+   {
+      printf("Could not create indexes in '%s': %s\n",
+            rdb_path, strerror(-rv));
+      return false;
+   }
+
+   return true;
+}
+
 int main(int argc, char** argv)
 {
    const char* rdb_path;
@@ -832,6 +859,9 @@ int main(int argc, char** argv)
 
    filestream_close(rdb_file);
 
+   if (!dat_converter_create_indexes(rdb_path))
+      dat_converter_exit(1);
+
    dat_converter_list_free(dat_parser_list);
 
    while (dat_count--)
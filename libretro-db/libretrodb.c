@@ -32,24 +32,46 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
 #include <streams/file_stream.h>
 #include <retro_endianness.h>
 #include <string/stdstring.h>
 #include <compat/strl.h>
 
+#ifdef RARCH_INTERNAL
+#include "../verbosity.h"
+#endif
+
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
 #include "rmsgpack.h"
-#include "bintree.h"
 #include "query.h"
-#include "libretrodb.h"
 
 #define MAGIC_NUMBER "RARCHDB"
 
-struct node_iter_ctx
+/* Secondary indexes are appended after the metadata. Each one is an
+ * index header followed by (key, record offset) pairs of two big endian
+ * uint64_t, sorted by key. The key is a 64-bit hash of the field value,
+ * so several records may share a key and matches still go through the
+ * query filter. */
+#define LIBRETRODB_MAX_INDEXES    8
+#define LIBRETRODB_INDEX_KEY_SIZE sizeof(uint64_t)
+
+struct libretrodb_index
 {
-	libretrodb_t *db;
-	libretrodb_index_t *idx;
+	char name[50];
+	char field[50];
+	uint64_t key_size;
+	uint64_t next;
+	uint64_t offset;
 };
 
 struct libretrodb
@@ -59,13 +81,12 @@ struct libretrodb
 	uint64_t count;
 	uint64_t first_index_offset;
    char *path;
-};
-
-struct libretrodb_index
-{
-	char name[50];
-	uint64_t key_size;
-	uint64_t next;
+   unsigned index_count;
+   libretrodb_index_t indexes[LIBRETRODB_MAX_INDEXES];
+   /* Read-only mapping of the whole file, records are decoded
+    * in place and only copied out when a query matches. */
+   const uint8_t *map;
+   uint64_t map_size;
 };
 
 typedef struct libretrodb_metadata
@@ -86,6 +107,13 @@ struct libretrodb_cursor
 	int eof;
 	libretrodb_query_t *query;
 	libretrodb_t *db;
+   uint64_t *offsets;
+   size_t offsets_count;
+   size_t offsets_pos;
+   int indexed;
+   uint64_t map_offset;
+   struct rmsgpack_dom_view view;
+   struct rmsgpack_dom_value item;
 };
 
 static struct rmsgpack_dom_value sentinal;
@@ -173,8 +201,7 @@ int libretrodb_create(RFILE *fd, libretrodb_value_provider value_provider,
    if ((rv = rmsgpack_dom_write(fd, &sentinal)) < 0)
       goto clean;
 
-   header.metadata_offset = swap_if_little64(filestream_seek(
-            fd, 0, RETRO_VFS_SEEK_POSITION_CURRENT));
+   header.metadata_offset = swap_if_little64(filestream_tell(fd));
    md.count = item_count;
    libretrodb_write_metadata(fd, &md);
    filestream_seek(fd, root, RETRO_VFS_SEEK_POSITION_START);
@@ -184,34 +211,174 @@ clean:
    return rv;
 }
 
+static struct rmsgpack_dom_value *libretrodb_map_value(
+      const struct rmsgpack_dom_value *map, const char *name)
+{
+   struct rmsgpack_dom_value key;
+
+   key.type            = RDT_STRING;
+   key.val.string.len  = (uint32_t)strlen(name);
+   key.val.string.buff = (char*)name;
+
+   return rmsgpack_dom_value_map_value(map, &key);
+}
+
+static void libretrodb_map_string(const struct rmsgpack_dom_value *map,
+      const char *name, char *s, size_t len)
+{
+   struct rmsgpack_dom_value *value = libretrodb_map_value(map, name);
+
+   s[0] = '\0';
+
+   if (value && value->type == RDT_STRING)
+      strlcpy(s, value->val.string.buff, len);
+}
+
+static uint64_t libretrodb_map_uint(const struct rmsgpack_dom_value *map,
+      const char *name)
+{
+   struct rmsgpack_dom_value *value = libretrodb_map_value(map, name);
+
+   if (value && (value->type == RDT_UINT || value->type == RDT_INT))
+      return value->val.uint_;
+
+   return 0;
+}
+
 static int libretrodb_read_index_header(RFILE *fd, libretrodb_index_t *idx)
 {
-   uint64_t name_len = 50;
-   return rmsgpack_dom_read_into(fd,
-         "name", idx->name, &name_len,
-         "key_size", &idx->key_size,
-         "next", &idx->next, NULL);
+   struct rmsgpack_dom_value map;
+   int rv = rmsgpack_dom_read(fd, &map);
+
+   if (rv < 0)
+      return rv;
+
+   if (map.type != RDT_MAP)
+   {
+      rmsgpack_dom_value_free(&map);
+      return -EINVAL;
+   }
+
+   /* Headers written before indexes were hashed have no field */
+   libretrodb_map_string(&map, "name",  idx->name,  sizeof(idx->name));
+   libretrodb_map_string(&map, "field", idx->field, sizeof(idx->field));
+   idx->key_size = libretrodb_map_uint(&map, "key_size");
+   idx->next     = libretrodb_map_uint(&map, "next");
+
+   rmsgpack_dom_value_free(&map);
+   return 0;
 }
 
 static void libretrodb_write_index_header(RFILE *fd, libretrodb_index_t *idx)
 {
-   rmsgpack_write_map_header(fd, 3);
+   rmsgpack_write_map_header(fd, 4);
    rmsgpack_write_string(fd, "name", STRLEN_CONST("name"));
    rmsgpack_write_string(fd, idx->name, (uint32_t)strlen(idx->name));
+   rmsgpack_write_string(fd, "field", STRLEN_CONST("field"));
+   rmsgpack_write_string(fd, idx->field, (uint32_t)strlen(idx->field));
    rmsgpack_write_string(fd, "key_size", (uint32_t)STRLEN_CONST("key_size"));
    rmsgpack_write_uint(fd, idx->key_size);
    rmsgpack_write_string(fd, "next", STRLEN_CONST("next"));
    rmsgpack_write_uint(fd, idx->next);
 }
 
+/* Reads the index headers following the metadata so that queries
+ * can be planned without touching the file again. */
+static void libretrodb_load_indexes(libretrodb_t *db)
+{
+   int64_t eof    = filestream_get_size(db->fd);
+   int64_t offset = (int64_t)db->first_index_offset;
+
+   db->index_count = 0;
+
+   filestream_seek(db->fd, offset, RETRO_VFS_SEEK_POSITION_START);
+
+   while (offset < eof && db->index_count < LIBRETRODB_MAX_INDEXES)
+   {
+      libretrodb_index_t *idx = &db->indexes[db->index_count];
+
+      if (libretrodb_read_index_header(db->fd, idx) < 0)
+         break;
+
+      idx->offset = filestream_tell(db->fd);
+      offset      = (int64_t)(idx->offset + idx->next);
+
+      if (offset > eof)
+         break;
+
+      db->index_count++;
+
+      filestream_seek(db->fd, offset, RETRO_VFS_SEEK_POSITION_START);
+   }
+}
+
+/* Indexes written before keys were hashed are still listed, but
+ * never used for lookups or query planning. */
+static void libretrodb_warn_old_indexes(libretrodb_t *db)
+{
+   unsigned i;
+
+   for (i = 0; i < db->index_count; i++)
+   {
+      if (db->indexes[i].key_size == LIBRETRODB_INDEX_KEY_SIZE)
+         continue;
+#ifdef RARCH_INTERNAL
+      RARCH_WARN("[libretrodb] Ignoring old format index \"%s\" in \"%s\", "
+            "rebuild the database to index it again.\n",
+            db->indexes[i].name, db->path);
+#else
+      fprintf(stderr, "Ignoring old format index '%s' in '%s', "
+            "rebuild the database to index it again.\n",
+            db->indexes[i].name, db->path);
+#endif
+   }
+}
+
+static void libretrodb_map(libretrodb_t *db)
+{
+#ifdef HAVE_MMAP
+   struct stat st;
+   int fd = open(db->path, O_RDONLY);
+
+   if (fd < 0)
+      return;
+
+   if (fstat(fd, &st) == 0 && st.st_size > 0)
+   {
+      void *map = mmap(NULL, (size_t)st.st_size, PROT_READ,
+            MAP_PRIVATE, fd, 0);
+
+      if (map != MAP_FAILED)
+      {
+         db->map      = (const uint8_t*)map;
+         db->map_size = (uint64_t)st.st_size;
+      }
+   }
+
+   close(fd);
+#endif
+}
+
+static void libretrodb_unmap(libretrodb_t *db)
+{
+#ifdef HAVE_MMAP
+   if (db->map)
+      munmap((void*)db->map, (size_t)db->map_size);
+#endif
+   db->map      = NULL;
+   db->map_size = 0;
+}
+
 void libretrodb_close(libretrodb_t *db)
 {
+   libretrodb_unmap(db);
    if (db->fd)
       filestream_close(db->fd);
    if (!string_is_empty(db->path))
       free(db->path);
-   db->path = NULL;
-   db->fd   = NULL;
+   db->path        = NULL;
+   db->fd          = NULL;
+   db->index_count = 0;
 }
 
 int libretrodb_open(const char *path, libretrodb_t *db)
@@ -238,7 +405,8 @@ int libretrodb_open(const char *path, libretrodb_t *db)
       goto error;
    }
 
-   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+   if (memcmp(header.magic_number, MAGIC_NUMBER,
+            sizeof(header.magic_number)) != 0)
    {
       rv = -EINVAL;
       goto error;
@@ -257,6 +425,10 @@ int libretrodb_open(const char *path, libretrodb_t *db)
    db->count              = md.count;
    db->first_index_offset = filestream_tell(fd);
    db->fd                 = fd;
+
+   libretrodb_load_indexes(db);
+   libretrodb_warn_old_indexes(db);
+   libretrodb_map(db);
    return 0;
 
 error:
@@ -265,93 +437,282 @@ error:
    return rv;
 }
 
-static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
-      libretrodb_index_t *idx)
+static libretrodb_index_t *libretrodb_find_index(libretrodb_t *db,
+      const char *index_name)
 {
-   ssize_t eof    = filestream_get_size(db->fd);
-   ssize_t offset = filestream_seek(db->fd,
-         (ssize_t)db->first_index_offset,
-         RETRO_VFS_SEEK_POSITION_START);
+   unsigned i;
 
-   /* TODO: this should use filestream_eof instead */
-   while (offset < eof)
+   for (i = 0; i < db->index_count; i++)
+      if (string_is_equal(db->indexes[i].name, index_name))
+         return &db->indexes[i];
+
+   return NULL;
+}
+
+static libretrodb_index_t *libretrodb_find_field_index(libretrodb_t *db,
+      const char *field_name)
+{
+   unsigned i;
+
+   for (i = 0; i < db->index_count; i++)
    {
-      libretrodb_read_index_header(db->fd, idx);
+      libretrodb_index_t *idx = &db->indexes[i];
 
-      if (strncmp(index_name, idx->name, strlen(idx->name)) == 0)
-         return 0;
+      if (     idx->key_size == LIBRETRODB_INDEX_KEY_SIZE
+            && string_is_equal(idx->field, field_name))
+         return idx;
+   }
+
+   return NULL;
+}
+
+/**
+ * libretrodb_has_index:
+ * @db                  : Handle to database.
+ * @field_name          : Name of the field.
+ *
+ * Returns: true if @db carries an index on @field_name.
+ **/
+bool libretrodb_has_index(libretrodb_t *db, const char *field_name)
+{
+   if (!db || !field_name)
+      return false;
+   return libretrodb_find_field_index(db, field_name) != NULL;
+}
+
+/* FNV-1a over the value type and its bytes. Only strings and binaries
+ * are indexed, which covers name, rom_name, serial and crc. */
+static bool libretrodb_index_key(const struct rmsgpack_dom_value *value,
+      uint64_t *key)
+{
+   uint32_t i;
+   uint32_t len;
+   const uint8_t *buff;
+   uint64_t hash = UINT64_C(0xcbf29ce484222325);
+
+   switch (value->type)
+   {
+      case RDT_STRING:
+         buff = (const uint8_t*)value->val.string.buff;
+         len  = value->val.string.len;
+         break;
+      case RDT_BINARY:
+         buff = (const uint8_t*)value->val.binary.buff;
+         len  = value->val.binary.len;
+         break;
+      default:
+         return false;
+   }
+
+   hash ^= (uint8_t)value->type;
+   hash *= UINT64_C(0x100000001b3);
+
+   for (i = 0; i < len; i++)
+   {
+      hash ^= buff[i];
+      hash *= UINT64_C(0x100000001b3);
+   }
+
+   *key = hash;
+   return true;
+}
+
+static int libretrodb_index_entry_cmp(const void *a, const void *b)
+{
+   const uint64_t *x = (const uint64_t*)a;
+   const uint64_t *y = (const uint64_t*)b;
+
+   if (x[0] != y[0])
+      return (x[0] < y[0]) ? -1 : 1;
+   if (x[1] != y[1])
+      return (x[1] < y[1]) ? -1 : 1;
+   return 0;
+}
+
+static int libretrodb_offset_cmp(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
+
+   if (x != y)
+      return (x < y) ? -1 : 1;
+   return 0;
+}
 
-      filestream_seek(db->fd, (ssize_t)idx->next,
-            RETRO_VFS_SEEK_POSITION_CURRENT);
-      offset = filestream_tell(db->fd);
+static int libretrodb_read_index_entry(libretrodb_t *db, RFILE *fd,
+      const libretrodb_index_t *idx, uint64_t i, uint64_t *entry)
+{
+   uint64_t offset = idx->offset + i * 2 * sizeof(uint64_t);
+
+   if (db->map)
+   {
+      if (offset + 2 * sizeof(uint64_t) > db->map_size)
+         return -EINVAL;
+      memcpy(entry, db->map + offset, 2 * sizeof(uint64_t));
    }
+   else
+   {
+      filestream_seek(fd, (int64_t)offset, RETRO_VFS_SEEK_POSITION_START);
 
-   return -1;
+      if (filestream_read(fd, entry, 2 * sizeof(uint64_t))
+            != 2 * sizeof(uint64_t))
+         return -EINVAL;
+   }
+
+   entry[0] = swap_if_little64(entry[0]);
+   entry[1] = swap_if_little64(entry[1]);
+   return 0;
 }
 
-static int binsearch(const void *buff, const void *item,
-      uint64_t count, uint8_t field_size, uint64_t *offset)
+/* Binary searches @idx for @key and appends the offsets of all
+ * records sharing it to @offsets. */
+static int libretrodb_index_probe(libretrodb_t *db, RFILE *fd,
+      const libretrodb_index_t *idx, uint64_t key,
+      uint64_t **offsets, size_t *count, size_t *capacity)
 {
-   int mid            = (int)(count / 2);
-   int item_size      = field_size + sizeof(uint64_t);
-   uint64_t *current  = (uint64_t *)buff + (mid * item_size);
-   int rv             = memcmp(current, item, field_size);
+   uint64_t entry[2];
+   uint64_t lo    = 0;
+   uint64_t total = idx->next / (2 * sizeof(uint64_t));
+   uint64_t hi    = total;
 
-   if (rv == 0)
+   while (lo < hi)
    {
-      *offset = *(uint64_t *)(current + field_size);
-      return 0;
+      uint64_t mid = lo + (hi - lo) / 2;
+
+      if (libretrodb_read_index_entry(db, fd, idx, mid, entry) < 0)
+         return -EINVAL;
+
+      if (entry[0] < key)
+         lo = mid + 1;
+      else
+         hi = mid;
    }
 
-   if (count == 0)
-      return -1;
+   for (; lo < total; lo++)
+   {
+      if (libretrodb_read_index_entry(db, fd, idx, lo, entry) < 0)
+         return -EINVAL;
+
+      if (entry[0] != key)
+         break;
+
+      if (*count == *capacity)
+      {
+         size_t new_capacity = *capacity ? *capacity * 2 : 16;
+         uint64_t *tmp       = (uint64_t*)realloc(*offsets,
+               new_capacity * sizeof(uint64_t));
+
+         if (!tmp)
+            return -ENOMEM;
 
-   if (rv > 0)
-      return binsearch(buff, item, mid, field_size, offset);
+         *offsets  = tmp;
+         *capacity = new_capacity;
+      }
+
+      (*offsets)[(*count)++] = entry[1];
+   }
 
-   return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+   return 0;
 }
 
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
-      const void *key, struct rmsgpack_dom_value *out)
+      const struct rmsgpack_dom_value *key, struct rmsgpack_dom_value *out)
 {
-   libretrodb_index_t idx;
    int rv;
-   void *buff;
-   uint64_t offset;
-   ssize_t bufflen, nread = 0;
-
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
+   size_t i;
+   uint64_t hash;
+   struct rmsgpack_dom_value *value = NULL;
+   uint64_t *offsets                = NULL;
+   size_t count                     = 0;
+   size_t capacity                  = 0;
+   libretrodb_index_t *idx          = libretrodb_find_index(db, index_name);
+
+   if (!idx || idx->key_size != LIBRETRODB_INDEX_KEY_SIZE)
       return -1;
 
-   bufflen = idx.next;
-   buff = malloc(bufflen);
+   if (!libretrodb_index_key(key, &hash))
+      return -EINVAL;
+
+   if ((rv = libretrodb_index_probe(db, db->fd, idx, hash,
+               &offsets, &count, &capacity)) < 0)
+      goto end;
 
-   if (!buff)
-      return -ENOMEM;
+   if (count > 1)
+      qsort(offsets, count, sizeof(uint64_t), libretrodb_offset_cmp);
 
-   while (nread < bufflen)
+   /* Skip over records that only share the hash */
+   rv = -1;
+   for (i = 0; i < count; i++)
    {
-      void *buff_ = (uint64_t *)buff + nread;
-      rv = (int)filestream_read(db->fd, buff_, bufflen - nread);
+      filestream_seek(db->fd, (int64_t)offsets[i],
+            RETRO_VFS_SEEK_POSITION_START);
+
+      if ((rv = rmsgpack_dom_read(db->fd, out)) < 0)
+         break;
 
-      if (rv <= 0)
+      value = libretrodb_map_value(out, idx->field);
+      if (value && rmsgpack_dom_value_cmp(value, key) == 0)
       {
-         free(buff);
-         return -errno;
+         rv = 0;
+         break;
       }
-      nread += rv;
+
+      rmsgpack_dom_value_free(out);
+      rv = -1;
    }
 
-   rv = binsearch(buff, key, db->count, (ssize_t)idx.key_size, &offset);
-   free(buff);
+end:
+   free(offsets);
+   return rv;
+}
 
-   if (rv == 0)
-      filestream_seek(db->fd, (ssize_t)offset,
-            RETRO_VFS_SEEK_POSITION_START);
+/* Resolves the candidate records of an indexed query up front.
+ * On failure the cursor falls back to a sequential scan. */
+static void libretrodb_cursor_plan(libretrodb_cursor_t *cursor,
+      libretrodb_query_t *q)
+{
+   unsigned i, count;
+   size_t j, capacity                         = 0;
+   libretrodb_index_t *idx                    = NULL;
+   const struct rmsgpack_dom_value **values   = NULL;
+   const char *field                          =
+      libretrodb_query_index(q, &values, &count);
+
+   if (!field || !(idx = libretrodb_find_field_index(cursor->db, field)))
+      return;
+
+   for (i = 0; i < count; i++)
+   {
+      uint64_t key;
+
+      if (!libretrodb_index_key(values[i], &key))
+         goto error;
+
+      if (libretrodb_index_probe(cursor->db, cursor->fd, idx, key,
+               &cursor->offsets, &cursor->offsets_count, &capacity) < 0)
+         goto error;
+   }
+
+   /* Visit candidates in database order, once each */
+   if (cursor->offsets_count > 1)
+   {
+      qsort(cursor->offsets, cursor->offsets_count,
+            sizeof(uint64_t), libretrodb_offset_cmp);
+
+      for (i = 0, j = 1; j < cursor->offsets_count; j++)
+         if (cursor->offsets[j] != cursor->offsets[i])
+            cursor->offsets[++i] = cursor->offsets[j];
 
-   return rmsgpack_dom_read(db->fd, out);
+      cursor->offsets_count = i + 1;
+   }
+
+   cursor->indexed = 1;
+   return;
+
+error:
+   free(cursor->offsets);
+   cursor->offsets       = NULL;
+   cursor->offsets_count = 0;
 }
 
 /**
@@ -364,13 +725,69 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
-   cursor->eof = 0;
+   cursor->eof         = 0;
+   cursor->offsets_pos = 0;
+   cursor->map_offset  = cursor->db->root + sizeof(libretrodb_header_t);
+
+   if (!cursor->fd)
+      return 0;
+
    return (int)filestream_seek(cursor->fd,
          (ssize_t)(cursor->db->root + sizeof(libretrodb_header_t)),
          RETRO_VFS_SEEK_POSITION_START);
 }
 
-int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
+static uint64_t libretrodb_cursor_tell(libretrodb_cursor_t *cursor)
+{
+   if (cursor->db->map)
+      return cursor->map_offset;
+   return filestream_tell(cursor->fd);
+}
+
+/* Decodes the next record in place from the mapping */
+static int libretrodb_cursor_next_mapped(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out)
+{
+   const uint8_t *map = cursor->db->map;
+   const uint8_t *end = map + cursor->db->map_size;
+
+   for (;;)
+   {
+      int rv;
+      const uint8_t *p = NULL;
+
+      if (cursor->indexed)
+      {
+         if (cursor->offsets_pos >= cursor->offsets_count)
+            break;
+         p = map + cursor->offsets[cursor->offsets_pos++];
+      }
+      else
+         p = map + cursor->map_offset;
+
+      if (p >= end)
+         return -EINVAL;
+
+      if ((rv = rmsgpack_dom_view_read(&cursor->view, &p, end, out)) < 0)
+         return rv;
+
+      if (!cursor->indexed)
+      {
+         cursor->map_offset = (uint64_t)(p - map);
+         if (out->type == RDT_NULL)
+            break;
+      }
+
+      if (!cursor->query || libretrodb_query_filter(cursor->query, out))
+         return 0;
+   }
+
+   cursor->eof = 1;
+   return EOF;
+}
+
+/* Reads the next record into the cursor, which keeps ownership */
+static int libretrodb_cursor_next(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out)
 {
    int rv;
@@ -378,29 +795,84 @@ int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
    if (cursor->eof)
       return EOF;
 
-retry:
-   rv = rmsgpack_dom_read(cursor->fd, out);
-   if (rv < 0)
-      return rv;
+   if (cursor->db->map)
+      return libretrodb_cursor_next_mapped(cursor, out);
 
-   if (out->type == RDT_NULL)
-   {
-      cursor->eof = 1;
-      return EOF;
-   }
+   rmsgpack_dom_value_free(&cursor->item);
+   cursor->item.type = RDT_NULL;
 
-   if (cursor->query)
+   for (;;)
    {
-      if (!libretrodb_query_filter(cursor->query, out))
+      if (cursor->indexed)
       {
-         rmsgpack_dom_value_free(out);
-         goto retry;
+         if (cursor->offsets_pos >= cursor->offsets_count)
+            break;
+         filestream_seek(cursor->fd,
+               (int64_t)cursor->offsets[cursor->offsets_pos++],
+               RETRO_VFS_SEEK_POSITION_START);
+      }
+
+      if ((rv = rmsgpack_dom_read(cursor->fd, &cursor->item)) < 0)
+      {
+         cursor->item.type = RDT_NULL;
+         return rv;
       }
+
+      if (!cursor->indexed && cursor->item.type == RDT_NULL)
+         break;
+
+      /* The index only narrows the search down, keys may collide */
+      if (!cursor->query
+            || libretrodb_query_filter(cursor->query, &cursor->item))
+      {
+         *out = cursor->item;
+         return 0;
+      }
+
+      rmsgpack_dom_value_free(&cursor->item);
+      cursor->item.type = RDT_NULL;
    }
 
+   cursor->eof = 1;
+   return EOF;
+}
+
+int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out)
+{
+   struct rmsgpack_dom_value item;
+   int rv = libretrodb_cursor_next(cursor, &item);
+
+   if (rv != 0)
+      return rv;
+
+   if (cursor->db->map)
+      return rmsgpack_dom_value_copy(out, &item);
+
+   /* Hand the record over to the caller */
+   *out              = cursor->item;
+   cursor->item.type = RDT_NULL;
    return 0;
 }
 
+/**
+ * libretrodb_cursor_read_view:
+ * @cursor              : Handle to database cursor.
+ * @out                 : Next record matching the query.
+ *
+ * Like libretrodb_cursor_read_item(), but @out stays owned by the
+ * cursor and is only valid until the next read. Strings and
+ * binaries may point straight into the database file and are not
+ * NUL terminated, so their length has to be used.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_cursor_read_view(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out)
+{
+   return libretrodb_cursor_next(cursor, out);
+}
+
 /**
  * libretrodb_cursor_close:
  * @cursor              : Handle to database cursor.
@@ -418,11 +890,22 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (cursor->query)
       libretrodb_query_free(cursor->query);
 
-   cursor->is_valid = 0;
-   cursor->eof      = 1;
-   cursor->fd       = NULL;
-   cursor->db       = NULL;
-   cursor->query    = NULL;
+   if (cursor->offsets)
+      free(cursor->offsets);
+
+   rmsgpack_dom_view_free(&cursor->view);
+   rmsgpack_dom_value_free(&cursor->item);
+
+   cursor->is_valid      = 0;
+   cursor->eof           = 1;
+   cursor->fd            = NULL;
+   cursor->db            = NULL;
+   cursor->query         = NULL;
+   cursor->offsets       = NULL;
+   cursor->offsets_count = 0;
+   cursor->offsets_pos   = 0;
+   cursor->indexed       = 0;
+   cursor->item.type     = RDT_NULL;
 }
 
 /**
@@ -431,7 +914,9 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
  * @cursor              : Handle to database cursor.
  * @q                   : Query to execute.
  *
- * Opens cursor to database based on query @q.
+ * Opens cursor to database based on query @q. If the query was
+ * compiled against an index of @db, only the records the index
+ * points at are read.
  *
  * Returns: 0 if successful, otherwise negative.
  **/
@@ -442,150 +927,184 @@ int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
    if (!db || string_is_empty(db->path))
       return -errno;
 
-   fd = filestream_open(db->path,
-         RETRO_VFS_FILE_ACCESS_READ,
-         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   /* Mapped databases are read straight from memory */
+   if (!db->map)
+   {
+      fd = filestream_open(db->path,
+            RETRO_VFS_FILE_ACCESS_READ,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
-   if (!fd)
-      return -errno;
+      if (!fd)
+         return -errno;
+   }
 
-   cursor->fd       = fd;
-   cursor->db       = db;
-   cursor->is_valid = 1;
-   libretrodb_cursor_reset(cursor);
-   cursor->query    = q;
+   cursor->fd            = fd;
+   cursor->db            = db;
+   cursor->is_valid      = 1;
+   cursor->offsets       = NULL;
+   cursor->offsets_count = 0;
+   cursor->indexed       = 0;
+   cursor->item.type     = RDT_NULL;
+   cursor->query         = q;
+
+   memset(&cursor->view, 0, sizeof(cursor->view));
 
    if (q)
+   {
       libretrodb_query_inc_ref(q);
+      libretrodb_cursor_plan(cursor, q);
+   }
 
-   return 0;
-}
-
-static int node_iter(void *value, void *ctx)
-{
-   struct node_iter_ctx *nictx = (struct node_iter_ctx*)ctx;
-
-   if (filestream_write(nictx->db->fd, value,
-            (ssize_t)(nictx->idx->key_size + sizeof(uint64_t))) > 0)
-      return 0;
-
-   return -1;
-}
-
-static uint64_t libretrodb_tell(libretrodb_t *db)
-{
-   return filestream_tell(db->fd);
-}
+   libretrodb_cursor_reset(cursor);
 
-static int node_compare(const void *a, const void *b, void *ctx)
-{
-   return memcmp(a, b, *(uint8_t *)ctx);
+   return 0;
 }
 
+/**
+ * libretrodb_create_index:
+ * @db                  : Handle to database.
+ * @name                : Name of the new index.
+ * @field_name          : Field to index.
+ *
+ * Appends a sorted index over the string or binary values of
+ * @field_name to the database file. Records without the field
+ * are left out.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
 int libretrodb_create_index(libretrodb_t *db,
       const char *name, const char *field_name)
 {
-   struct node_iter_ctx nictx;
-   struct rmsgpack_dom_value key;
+   size_t i;
    libretrodb_index_t idx;
    struct rmsgpack_dom_value item;
    libretrodb_cursor_t cur          = {0};
-   struct rmsgpack_dom_value *field = NULL;
-   void *buff                       = NULL;
-   uint64_t *buff_u64               = NULL;
-   uint8_t field_size               = 0;
-   uint64_t item_loc                = libretrodb_tell(db);
-   bintree_t *tree                  = bintree_new(node_compare, &field_size);
+   RFILE *fd                        = NULL;
+   uint64_t *entries                = NULL;
+   size_t count                     = 0;
+   size_t capacity                  = 0;
+   int rv                           = 0;
 
-   item.type                        = RDT_NULL;
+   if (libretrodb_find_index(db, name))
+      return -EEXIST;
 
-   if (!tree || (libretrodb_cursor_open(db, &cur, NULL) != 0))
-      goto clean;
+   if (db->index_count >= LIBRETRODB_MAX_INDEXES)
+      return -ENOSPC;
 
-   key.type            = RDT_STRING;
-   key.val.string.len  = (uint32_t)strlen(field_name);
-   key.val.string.buff = (char *) field_name;   /* We know we aren't going to change it */
+   if ((rv = libretrodb_cursor_open(db, &cur, NULL)) != 0)
+      return rv;
+
+   item.type = RDT_NULL;
 
-   while (libretrodb_cursor_read_item(&cur, &item) == 0)
+   for (;;)
    {
-      if (item.type != RDT_MAP)
-      {
-         printf("Only map keys are supported\n");
-         goto clean;
-      }
+      uint64_t key;
+      struct rmsgpack_dom_value *field = NULL;
+      uint64_t item_loc                = libretrodb_cursor_tell(&cur);
 
-      field = rmsgpack_dom_value_map_value(&item, &key);
+      if (libretrodb_cursor_read_item(&cur, &item) != 0)
+         break;
 
-      if (!field)
-      {
-         printf("field not found in item\n");
-         goto clean;
-      }
+      field = libretrodb_map_value(&item, field_name);
 
-      if (field->type != RDT_BINARY)
+      if (field && libretrodb_index_key(field, &key))
       {
-         printf("field is not binary\n");
-         goto clean;
+         if (count == capacity)
+         {
+            size_t new_capacity = capacity ? capacity * 2 : 256;
+            uint64_t *tmp       = (uint64_t*)realloc(entries,
+                  new_capacity * 2 * sizeof(uint64_t));
+
+            if (!tmp)
+            {
+               rv = -ENOMEM;
+               goto clean;
+            }
+
+            entries  = tmp;
+            capacity = new_capacity;
+         }
+
+         entries[count * 2]     = key;
+         entries[count * 2 + 1] = item_loc;
+         count++;
       }
 
-      if (field->val.binary.len == 0)
-      {
-         printf("field is empty\n");
-         goto clean;
-      }
+      rmsgpack_dom_value_free(&item);
+      item.type = RDT_NULL;
+   }
 
-      if (field_size == 0)
-         field_size = field->val.binary.len;
-      else if (field->val.binary.len != field_size)
-      {
-         printf("field is not of correct size\n");
-         goto clean;
-      }
+   if (count)
+      qsort(entries, count, 2 * sizeof(uint64_t),
+            libretrodb_index_entry_cmp);
 
-      buff = malloc(field_size + sizeof(uint64_t));
-      if (!buff)
-         goto clean;
+   /* The mapping does not cover what is about to be appended */
+   libretrodb_unmap(db);
 
-      memcpy(buff, field->val.binary.buff, field_size);
+   fd = filestream_open(db->path,
+         RETRO_VFS_FILE_ACCESS_READ_WRITE
+         | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
-      buff_u64 = (uint64_t *)buff + field_size;
+   if (!fd)
+   {
+      rv = -errno;
+      goto clean;
+   }
 
-      memcpy(buff_u64, &item_loc, sizeof(uint64_t));
+   filestream_seek(fd, 0, RETRO_VFS_SEEK_POSITION_END);
 
-      if (bintree_insert(tree, buff) != 0)
-      {
-         printf("Value is not unique: ");
-         rmsgpack_dom_value_print(field);
-         printf("\n");
-         goto clean;
-      }
-      buff     = NULL;
-      rmsgpack_dom_value_free(&item);
-      item_loc = libretrodb_tell(db);
-   }
+   strlcpy(idx.name,  name,       sizeof(idx.name));
+   strlcpy(idx.field, field_name, sizeof(idx.field));
+   idx.key_size = LIBRETRODB_INDEX_KEY_SIZE;
+   idx.next     = count * 2 * sizeof(uint64_t);
+   libretrodb_write_index_header(fd, &idx);
 
-   filestream_seek(db->fd, 0, RETRO_VFS_SEEK_POSITION_END);
+   for (i = 0; i < count * 2; i++)
+      entries[i] = swap_if_little64(entries[i]);
 
-   strncpy(idx.name, name, 50);
+   if (count && filestream_write(fd, entries, (int64_t)idx.next)
+         != (int64_t)idx.next)
+      rv = -EIO;
 
-   idx.name[49] = '\0';
-   idx.key_size = field_size;
-   idx.next     = db->count * (field_size + sizeof(uint64_t));
-   libretrodb_write_index_header(db->fd, &idx);
+   filestream_close(fd);
 
-   nictx.db  = db;
-   nictx.idx = &idx;
-   bintree_iterate(tree, node_iter, &nictx);
+   libretrodb_load_indexes(db);
+   libretrodb_map(db);
 
 clean:
    rmsgpack_dom_value_free(&item);
-   if (buff)
-      free(buff);
    if (cur.is_valid)
       libretrodb_cursor_close(&cur);
-   if (tree)
-      bintree_free(tree);
-   free(tree);
+   free(entries);
+   return rv;
+}
+
+/**
+ * libretrodb_create_indexes:
+ * @db                  : Handle to database.
+ *
+ * Creates the indexes on the fields the database scanner and the
+ * menus look up (crc, serial, name and rom_name), leaving out the
+ * ones @db already has.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_create_indexes(libretrodb_t *db)
+{
+   static const char *fields[] = {"crc", "serial", "name", "rom_name"};
+   unsigned i;
+   int rv;
+
+   for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+   {
+      if (libretrodb_has_index(db, fields[i]))
+         continue;
+
+      if ((rv = libretrodb_create_index(db, fields[i], fields[i])) != 0)
+         return rv;
+   }
+
    return 0;
 }
 
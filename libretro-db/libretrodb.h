@@ -31,6 +31,7 @@
 #endif
 
 #include <retro_common_api.h>
+#include <boolean.h>
 
 #include "query.h"
 #include "rmsgpack_dom.h"
@@ -54,8 +55,12 @@ int libretrodb_open(const char *path, libretrodb_t *db);
 int libretrodb_create_index(libretrodb_t *db, const char *name,
       const char *field_name);
 
+bool libretrodb_has_index(libretrodb_t *db, const char *field_name);
+
+int libretrodb_create_indexes(libretrodb_t *db);
+
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
-        const void *key, struct rmsgpack_dom_value *out);
+        const struct rmsgpack_dom_value *key, struct rmsgpack_dom_value *out);
 
 libretrodb_t *libretrodb_new(void);
 
@@ -105,6 +110,9 @@ void libretrodb_query_free(void *q);
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out);
 
+int libretrodb_cursor_read_view(libretrodb_cursor_t *cursor,
+      struct rmsgpack_dom_value *out);
+
 RETRO_END_DECLS
 
 #endif
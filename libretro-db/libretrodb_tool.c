@@ -33,7 +33,7 @@ int main(int argc, char ** argv)
    int rv;
    libretrodb_t *db;
    libretrodb_cursor_t *cur;
-   libretrodb_query_t *q;
+   libretrodb_query_t *q = NULL;
    struct rmsgpack_dom_value item;
    const char *command, *path, *query_exp, *error;
 
@@ -43,6 +43,7 @@ int main(int argc, char ** argv)
       printf("Available Commands:\n");
       printf("\tlist\n");
       printf("\tcreate-index <index name> <field name>\n");
+      printf("\tcreate-indexes\n");
       printf("\tfind <query expression>\n");
       printf("\tget-names <query expression>\n");
       return 1;
@@ -156,6 +157,20 @@ int main(int argc, char ** argv)
          rmsgpack_dom_value_free(&item);
       }
    }
+   else if (memcmp(command, "create-indexes", 14) == 0)
+   {
+      if (argc != 3)
+      {
+         printf("Usage: %s <db file> create-indexes\n", argv[0]);
+         goto error;
+      }
+
+      if ((rv = libretrodb_create_indexes(db)) != 0)
+      {
+         printf("Could not create indexes: %s\n", strerror(-rv));
+         goto error;
+      }
+   }
    else if (memcmp(command, "create-index", 12) == 0)
    {
       const char * index_name, * field_name;
@@ -169,7 +184,12 @@ int main(int argc, char ** argv)
       index_name = argv[3];
       field_name = argv[4];
 
-      libretrodb_create_index(db, index_name, field_name);
+      if ((rv = libretrodb_create_index(db, index_name, field_name)) != 0)
+      {
+         printf("Could not create index '%s': %s\n",
+               index_name, strerror(-rv));
+         goto error;
+      }
    }
    else
    {
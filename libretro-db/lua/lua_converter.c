@@ -112,5 +112,20 @@ int main(int argc, char ** argv)
 clean:
    lua_close(L);
    filestream_close(dst);
+
+   if (rv == 0)
+   {
+      libretrodb_t *db = libretrodb_new();
+
+      if (db && (rv = libretrodb_open(db_file, db)) == 0)
+      {
+         if ((rv = libretrodb_create_indexes(db)) != 0)
+            printf("Could not create indexes in '%s': %s\n",
+                  db_file, strerror(-rv));
+         libretrodb_close(db);
+      }
+      libretrodb_free(db);
+   }
+
    return rv;
 }
@@ -83,6 +83,10 @@ struct query
 {
    unsigned ref_count;
    struct invocation root;
+   /* Set by the planner when a field of the root table is indexed */
+   const char *index_field;
+   unsigned index_count;
+   const struct rmsgpack_dom_value *index_values[QUERY_MAX_ARGS];
 };
 
 struct registered_func
@@ -256,8 +260,10 @@ static struct rmsgpack_dom_value query_func_glob(
       struct rmsgpack_dom_value input,
       unsigned argc, const struct argument * argv)
 {
+   char buff[256];
    struct rmsgpack_dom_value res;
    unsigned i = 0;
+   char *str  = buff;
 
    res.type      = RDT_BOOL;
    res.val.bool_ = 0;
@@ -270,11 +276,24 @@ static struct rmsgpack_dom_value query_func_glob(
       return res;
    if (input.type != RDT_STRING)
       return res;
+
+   /* Records read in place are not NUL terminated */
+   if (input.val.string.len >= sizeof(buff))
+   {
+      if (!(str = (char*)malloc(input.val.string.len + 1)))
+         return res;
+   }
+   memcpy(str, input.val.string.buff, input.val.string.len);
+   str[input.val.string.len] = '\0';
+
    res.val.bool_ = rl_fnmatch(
          argv[0].a.value.val.string.buff,
-         input.val.string.buff,
+         str,
          0
          ) == 0;
+
+   if (str != buff)
+      free(str);
    return res;
 }
 
@@ -918,6 +937,63 @@ void libretrodb_query_free(void *q)
    free(real_q);
 }
 
+static bool query_value_is_indexable(const struct argument *arg)
+{
+   return arg->type == AT_VALUE
+      && (     arg->a.value.type == RDT_STRING
+            || arg->a.value.type == RDT_BINARY);
+}
+
+/* Picks a field of a top-level table that @db has an index on and
+ * that the query only ever compares for equality, either with a
+ * single value or through 'or' of values. Everything else is left
+ * to a full scan. */
+static void query_plan(libretrodb_t *db, struct query *q)
+{
+   unsigned i, j;
+
+   if (q->root.func != query_func_all_map)
+      return;
+
+   for (i = 0; i + 1 < q->root.argc; i += 2)
+   {
+      const struct argument *key = &q->root.argv[i];
+      const struct argument *arg = &q->root.argv[i + 1];
+
+      if (     key->type != AT_VALUE
+            || key->a.value.type != RDT_STRING
+            || !libretrodb_has_index(db, key->a.value.val.string.buff))
+         continue;
+
+      if (query_value_is_indexable(arg))
+      {
+         q->index_values[0] = &arg->a.value;
+         q->index_count     = 1;
+      }
+      else if (arg->type == AT_FUNCTION
+            && arg->a.invocation.func == query_func_operator_or
+            && arg->a.invocation.argc > 0)
+      {
+         for (j = 0; j < arg->a.invocation.argc; j++)
+         {
+            if (!query_value_is_indexable(&arg->a.invocation.argv[j]))
+               break;
+            q->index_values[j] = &arg->a.invocation.argv[j].a.value;
+         }
+
+         if (j < arg->a.invocation.argc)
+            continue;
+
+         q->index_count = j;
+      }
+      else
+         continue;
+
+      q->index_field = key->a.value.val.string.buff;
+      return;
+   }
+}
+
 void *libretrodb_query_compile(libretrodb_t *db,
       const char *query, size_t buff_len, const char **error_string)
 {
@@ -954,6 +1030,9 @@ void *libretrodb_query_compile(libretrodb_t *db,
       goto error;
    }
 
+   if (db)
+      query_plan(db, q);
+
    return q;
 
 error:
@@ -969,6 +1048,16 @@ void libretrodb_query_inc_ref(libretrodb_query_t *q)
       rq->ref_count += 1;
 }
 
+const char *libretrodb_query_index(libretrodb_query_t *q,
+      const struct rmsgpack_dom_value ***values, unsigned *count)
+{
+   struct query *rq = (struct query*)q;
+
+   *values = rq->index_values;
+   *count  = rq->index_count;
+   return rq->index_field;
+}
+
 int libretrodb_query_filter(libretrodb_query_t *q,
       struct rmsgpack_dom_value *v)
 {
@@ -38,6 +38,18 @@ void libretrodb_query_dec_ref(libretrodb_query_t *q);
 
 int libretrodb_query_filter(libretrodb_query_t *q, struct rmsgpack_dom_value *v);
 
+/**
+ * libretrodb_query_index:
+ * @q                   : Compiled query.
+ * @values              : Values the indexed field has to match.
+ * @count               : Number of entries in @values.
+ *
+ * Returns: name of the indexed field the query was planned on,
+ * or NULL if the whole database has to be scanned.
+ **/
+const char *libretrodb_query_index(libretrodb_query_t *q,
+      const struct rmsgpack_dom_value ***values, unsigned *count);
+
 RETRO_END_DECLS
 
 #endif
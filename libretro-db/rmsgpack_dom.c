@@ -503,3 +503,358 @@ clean:
    rmsgpack_dom_value_free(&map);
    return 0;
 }
+
+static uint64_t dom_view_read_be(const uint8_t *p, unsigned size)
+{
+   uint64_t value = 0;
+
+   while (size--)
+      value = (value << 8) | *p++;
+
+   return value;
+}
+
+/* Hands out @len slots from @view. When they run out, @used is left
+ * past @size and the caller fails with -ENOBUFS, so that
+ * rmsgpack_dom_view_read() can grow the storage and start over.
+ * Slots are never moved while a value is being decoded. */
+static void *dom_view_reserve(void *items, uint32_t *used,
+      uint32_t size, uint32_t len, size_t item_size)
+{
+   void *ret;
+
+   if (len > size - *used)
+   {
+      *used = size + 1;
+      return NULL;
+   }
+
+   ret    = (uint8_t*)items + (size_t)*used * item_size;
+   *used += len;
+   return ret;
+}
+
+static int dom_view_decode(struct rmsgpack_dom_view *view,
+      const uint8_t **buff, const uint8_t *end,
+      struct rmsgpack_dom_value *out, unsigned depth)
+{
+   int rv;
+   uint32_t i;
+   uint64_t len      = 0;
+   unsigned size     = 0;
+   const uint8_t *p  = *buff;
+   uint8_t type;
+
+   if (p >= end || depth >= MAX_DEPTH)
+      return -EINVAL;
+
+   type = *p++;
+
+   if (type < 0x80)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = type;
+      goto done;
+   }
+   else if (type >= 0xe0)
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = (int8_t)type;
+      goto done;
+   }
+   else if (type < 0x90)
+   {
+      len = type & 0x0f;
+      goto map;
+   }
+   else if (type < 0xa0)
+   {
+      len = type & 0x0f;
+      goto array;
+   }
+   else if (type < 0xc0)
+   {
+      len       = type & 0x1f;
+      out->type = RDT_STRING;
+      goto buffer;
+   }
+
+   switch (type)
+   {
+      case 0xc0: /* nil */
+         out->type = RDT_NULL;
+         goto done;
+      case 0xc2: /* false */
+      case 0xc3: /* true */
+         out->type      = RDT_BOOL;
+         out->val.bool_ = type & 1;
+         goto done;
+      case 0xc4: /* bin 8/16/32 */
+      case 0xc5:
+      case 0xc6:
+         size      = 1 << (type - 0xc4);
+         out->type = RDT_BINARY;
+         break;
+      case 0xd9: /* str 8/16/32 */
+      case 0xda:
+      case 0xdb:
+         size      = 1 << (type - 0xd9);
+         out->type = RDT_STRING;
+         break;
+      case 0xcc: /* uint 8/16/32/64 */
+      case 0xcd:
+      case 0xce:
+      case 0xcf:
+         size = 1 << (type - 0xcc);
+         if ((size_t)(end - p) < size)
+            return -EINVAL;
+         out->type      = RDT_UINT;
+         out->val.uint_ = dom_view_read_be(p, size);
+         p             += size;
+         goto done;
+      case 0xd0: /* int 8/16/32/64 */
+      case 0xd1:
+      case 0xd2:
+      case 0xd3:
+         size = 1 << (type - 0xd0);
+         if ((size_t)(end - p) < size)
+            return -EINVAL;
+         out->type = RDT_INT;
+         len       = dom_view_read_be(p, size);
+         p        += size;
+         switch (size)
+         {
+            case 1:
+               out->val.int_ = (int8_t)len;
+               break;
+            case 2:
+               out->val.int_ = (int16_t)len;
+               break;
+            case 4:
+               out->val.int_ = (int32_t)len;
+               break;
+            default:
+               out->val.int_ = (int64_t)len;
+               break;
+         }
+         goto done;
+      case 0xdc: /* array 16/32 */
+      case 0xdd:
+      case 0xde: /* map 16/32 */
+      case 0xdf:
+         size = 2 << (type & 1);
+         if ((size_t)(end - p) < size)
+            return -EINVAL;
+         len  = dom_view_read_be(p, size);
+         p   += size;
+         if (type >= 0xde)
+            goto map;
+         goto array;
+      default:
+         return -EINVAL;
+   }
+
+   /* Length prefixed string or binary */
+   if ((size_t)(end - p) < size)
+      return -EINVAL;
+   len  = dom_view_read_be(p, size);
+   p   += size;
+
+buffer:
+   if ((uint64_t)(end - p) < len)
+      return -EINVAL;
+   /* Both members of the union share their layout */
+   out->val.string.len  = (uint32_t)len;
+   out->val.string.buff = (char*)p;
+   p                   += len;
+   goto done;
+
+map:
+   /* Every pair takes up at least two bytes */
+   if (len > (uint64_t)(end - p) / 2)
+      return -EINVAL;
+   out->type          = RDT_MAP;
+   out->val.map.len   = (uint32_t)len;
+   out->val.map.items = (struct rmsgpack_dom_pair*)dom_view_reserve(
+         view->pairs, &view->pairs_used, view->pairs_size,
+         (uint32_t)len, sizeof(*view->pairs));
+   if (!out->val.map.items && len)
+      return -ENOBUFS;
+   for (i = 0; i < len; i++)
+   {
+      if ((rv = dom_view_decode(view, &p, end,
+                  &out->val.map.items[i].key, depth + 1)) < 0)
+         return rv;
+      if ((rv = dom_view_decode(view, &p, end,
+                  &out->val.map.items[i].value, depth + 1)) < 0)
+         return rv;
+   }
+   goto done;
+
+array:
+   if (len > (uint64_t)(end - p))
+      return -EINVAL;
+   out->type            = RDT_ARRAY;
+   out->val.array.len   = (uint32_t)len;
+   out->val.array.items = (struct rmsgpack_dom_value*)dom_view_reserve(
+         view->values, &view->values_used, view->values_size,
+         (uint32_t)len, sizeof(*view->values));
+   if (!out->val.array.items && len)
+      return -ENOBUFS;
+   for (i = 0; i < len; i++)
+      if ((rv = dom_view_decode(view, &p, end,
+                  &out->val.array.items[i], depth + 1)) < 0)
+         return rv;
+
+done:
+   *buff = p;
+   return 0;
+}
+
+/**
+ * rmsgpack_dom_view_read:
+ * @view                : Scratch storage for maps and arrays.
+ * @buff                : Start of the encoded value, moved past it.
+ * @end                 : End of the readable memory.
+ * @out                 : Decoded value.
+ *
+ * Decodes a value in place. Strings and binaries point into @buff
+ * and are not NUL terminated, maps and arrays live in @view until
+ * the next read. @out must not be passed to rmsgpack_dom_value_free(),
+ * use rmsgpack_dom_value_copy() to keep it around.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_dom_view_read(struct rmsgpack_dom_view *view,
+      const uint8_t **buff, const uint8_t *end,
+      struct rmsgpack_dom_value *out)
+{
+   for (;;)
+   {
+      const uint8_t *p = *buff;
+      int rv;
+
+      view->pairs_used  = 0;
+      view->values_used = 0;
+
+      if ((rv = dom_view_decode(view, &p, end, out, 0)) != -ENOBUFS)
+      {
+         if (rv == 0)
+            *buff = p;
+         return rv;
+      }
+
+      if (view->pairs_used > view->pairs_size)
+      {
+         uint32_t size = view->pairs_size ? view->pairs_size * 2 : 64;
+         struct rmsgpack_dom_pair *pairs = (struct rmsgpack_dom_pair*)
+            realloc(view->pairs, size * sizeof(*pairs));
+
+         if (!pairs)
+            return -ENOMEM;
+
+         view->pairs      = pairs;
+         view->pairs_size = size;
+      }
+      else
+      {
+         uint32_t size = view->values_size ? view->values_size * 2 : 64;
+         struct rmsgpack_dom_value *values = (struct rmsgpack_dom_value*)
+            realloc(view->values, size * sizeof(*values));
+
+         if (!values)
+            return -ENOMEM;
+
+         view->values      = values;
+         view->values_size = size;
+      }
+   }
+}
+
+void rmsgpack_dom_view_free(struct rmsgpack_dom_view *view)
+{
+   free(view->pairs);
+   free(view->values);
+   view->pairs       = NULL;
+   view->values      = NULL;
+   view->pairs_size  = 0;
+   view->values_size = 0;
+   view->pairs_used  = 0;
+   view->values_used = 0;
+}
+
+/**
+ * rmsgpack_dom_value_copy:
+ * @dst                 : Deep copy of @src.
+ * @src                 : Value to copy, usually a view.
+ *
+ * Strings and binaries of the copy are NUL terminated, like the
+ * ones returned by rmsgpack_dom_read().
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_dom_value_copy(struct rmsgpack_dom_value *dst,
+      const struct rmsgpack_dom_value *src)
+{
+   uint32_t i;
+
+   *dst = *src;
+
+   switch (src->type)
+   {
+      case RDT_STRING:
+      case RDT_BINARY:
+         if (!(dst->val.string.buff = (char*)malloc(src->val.string.len + 1)))
+            goto error;
+         memcpy(dst->val.string.buff, src->val.string.buff,
+               src->val.string.len);
+         dst->val.string.buff[src->val.string.len] = '\0';
+         break;
+      case RDT_MAP:
+         if (!(dst->val.map.items = (struct rmsgpack_dom_pair*)calloc(
+                     src->val.map.len, sizeof(*dst->val.map.items))))
+         {
+            if (src->val.map.len)
+               goto error;
+            break;
+         }
+         for (i = 0; i < src->val.map.len; i++)
+         {
+            if (     rmsgpack_dom_value_copy(&dst->val.map.items[i].key,
+                        &src->val.map.items[i].key) < 0
+                  || rmsgpack_dom_value_copy(&dst->val.map.items[i].value,
+                        &src->val.map.items[i].value) < 0)
+            {
+               rmsgpack_dom_value_free(dst);
+               goto error;
+            }
+         }
+         break;
+      case RDT_ARRAY:
+         if (!(dst->val.array.items = (struct rmsgpack_dom_value*)calloc(
+                     src->val.array.len, sizeof(*dst->val.array.items))))
+         {
+            if (src->val.array.len)
+               goto error;
+            break;
+         }
+         for (i = 0; i < src->val.array.len; i++)
+         {
+            if (rmsgpack_dom_value_copy(&dst->val.array.items[i],
+                     &src->val.array.items[i]) < 0)
+            {
+               rmsgpack_dom_value_free(dst);
+               goto error;
+            }
+         }
+         break;
+      default:
+         break;
+   }
+
+   return 0;
+
+error:
+   dst->type = RDT_NULL;
+   return -ENOMEM;
+}
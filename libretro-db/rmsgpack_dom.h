@@ -79,6 +79,17 @@ struct rmsgpack_dom_pair
 	struct rmsgpack_dom_value value;
 };
 
+/* Storage reused by every rmsgpack_dom_view_read() */
+struct rmsgpack_dom_view
+{
+   struct rmsgpack_dom_pair *pairs;
+   struct rmsgpack_dom_value *values;
+   uint32_t pairs_size;
+   uint32_t pairs_used;
+   uint32_t values_size;
+   uint32_t values_used;
+};
+
 void rmsgpack_dom_value_print(struct rmsgpack_dom_value *obj);
 void rmsgpack_dom_value_free(struct rmsgpack_dom_value *v);
 
@@ -95,6 +106,15 @@ int rmsgpack_dom_write(RFILE *fd, const struct rmsgpack_dom_value *obj);
 
 int rmsgpack_dom_read_into(RFILE *fd, ...);
 
+int rmsgpack_dom_view_read(struct rmsgpack_dom_view *view,
+      const uint8_t **buff, const uint8_t *end,
+      struct rmsgpack_dom_value *out);
+
+void rmsgpack_dom_view_free(struct rmsgpack_dom_view *view);
+
+int rmsgpack_dom_value_copy(struct rmsgpack_dom_value *dst,
+      const struct rmsgpack_dom_value *src);
+
 RETRO_END_DECLS
 
 #endif
@@ -26,6 +26,11 @@
 #include <retro_inline.h>
 #include <compat/strl.h>
 #include <compat/intrinsics.h>
+#include <streams/trans_stream.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "state_manager.h"
 #include "../msg_hash.h"
@@ -62,6 +67,13 @@
 #include <emmintrin.h>
 #endif
 
+/* Every Nth pushed state is additionally stored as a standalone
+ * keyframe, which survives after the delta ring has forgotten it. */
+#define STATE_MANAGER_KEYFRAME_INTERVAL 120
+
+/* 1/Nth of the rewind buffer is reserved for keyframes. */
+#define STATE_MANAGER_KEYFRAME_SHARE    4
+
 /* There's no equivalent in libc, you'd think so ...
  * std::mismatch exists, but it's not optimized at all. */
 static size_t find_change(const uint16_t *a, const uint16_t *b)
@@ -159,6 +171,17 @@ static size_t find_same(const uint16_t *a, const uint16_t *b)
    return a - a_org;
 }
 
+struct state_manager_keyframe
+{
+   uint8_t *data;
+   size_t size;
+   /* Where the delta ring's head was right after this frame was pushed;
+    * walking backwards from here yields the frames before it. */
+   size_t ring_pos;
+   unsigned frame;
+   bool deflated;
+};
+
 struct state_manager
 {
    uint8_t *data;
@@ -168,8 +191,47 @@ struct state_manager
    /* If head comes close to this, discard a frame. */
    uint8_t *tail;
 
+   /* Newest state. */
    uint8_t *thisblock;
+   /* The core serializes into this one. */
    uint8_t *nextblock;
+   /* State before thisblock, while its delta is being compressed. */
+   uint8_t *prevblock;
+   /* All zeroes, keyframes are stored as a patch against it. */
+   uint8_t *zeroblock;
+   /* Uncompressed keyframe patch. */
+   uint8_t *scratch;
+   /* Deflated keyframe patch. */
+   uint8_t *scratch_deflated;
+
+   /* Sparse, heavily compressed history, oldest first.
+    * When it grows past keyframes_capacity, the older half
+    * is thinned out, so old history gets sparser with age. */
+   struct state_manager_keyframe *keyframes;
+   size_t keyframes_count;
+   size_t keyframes_size;
+   size_t keyframes_bytes;
+   size_t keyframes_capacity;
+
+   const struct trans_stream_backend *deflate_backend;
+   void *deflate_stream;
+   void *inflate_stream;
+
+#ifdef HAVE_THREADS
+   /* Compresses prevblock -> thisblock in the background. */
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool busy;
+   bool quit;
+#endif
+   bool job_delta;
+   bool job_keyframe;
+
+   /* Frame numbers of the states in thisblock and prevblock. */
+   unsigned frame;
+   unsigned prevframe;
+   unsigned pushes;
 
    /* This one is rounded up from reset::blocksize. */
    size_t blocksize;
@@ -190,6 +252,7 @@ struct state_manager
 /* Format per frame (pseudocode): */
 #if 0
 size nextstart;
+size frame; /* frame number of the state this patch yields */
 repeat {
    uint16 numchanged; /* everything is counted in units of uint16 */
    if (numchanged)
@@ -212,6 +275,8 @@ struct state_manager_rewind_state
    /* Rewind support. */
    state_manager_t *state;
    size_t size;
+   /* Frames run since rewind was initialized, minus the ones rewound. */
+   unsigned frame;
 };
 
 static struct state_manager_rewind_state rewind_state;
@@ -408,33 +473,361 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+static void state_manager_keyframes_truncate(state_manager_t *state,
+      unsigned frame)
+{
+   while (state->keyframes_count &&
+         state->keyframes[state->keyframes_count - 1].frame > frame)
+   {
+      struct state_manager_keyframe *keyframe =
+         &state->keyframes[--state->keyframes_count];
+      state->keyframes_bytes -= keyframe->size;
+      free(keyframe->data);
+      keyframe->data          = NULL;
+   }
+}
+
+/* Makes room for new keyframes by discarding every other keyframe
+ * in the older half. Repeating this as history grows leaves old
+ * history progressively sparser, while recent keyframes stay dense. */
+static void state_manager_keyframes_thin(state_manager_t *state)
+{
+   while (state->keyframes_bytes > state->keyframes_capacity
+         && state->keyframes_count)
+   {
+      size_t i, j;
+      size_t half = state->keyframes_count / 2;
+
+      if (half < 2)
+      {
+         /* Too few left to thin, drop the oldest one. */
+         state->keyframes_bytes -= state->keyframes[0].size;
+         free(state->keyframes[0].data);
+         memmove(state->keyframes, state->keyframes + 1,
+               (state->keyframes_count - 1) * sizeof(*state->keyframes));
+         state->keyframes_count--;
+         continue;
+      }
+
+      for (i = 0, j = 0; i < state->keyframes_count; i++)
+      {
+         if (i < half && (i & 1))
+         {
+            state->keyframes_bytes -= state->keyframes[i].size;
+            free(state->keyframes[i].data);
+            continue;
+         }
+         state->keyframes[j++] = state->keyframes[i];
+      }
+      state->keyframes_count = j;
+   }
+}
+
+static void *state_manager_trans_new(
+      const struct trans_stream_backend *backend)
+{
+   void *stream = backend->stream_new();
+
+   /* The default of 9 is needlessly slow for this;
+    * the inflate backend ignores it. */
+   if (stream && backend->define)
+      backend->define(stream, "level", 6);
+
+   return stream;
+}
+
+static void state_manager_trans_reset(
+      const struct trans_stream_backend *backend, void **stream)
+{
+   backend->stream_free(*stream);
+   *stream = state_manager_trans_new(backend);
+}
+
+/* Stores thisblock as a keyframe: a patch against an all-zero
+ * block (savestates are mostly zeroes), deflated if possible. */
+static void state_manager_push_keyframe(state_manager_t *state)
+{
+   struct state_manager_keyframe *keyframe = NULL;
+   const uint8_t *src = state->scratch;
+   bool deflated      = false;
+   size_t len         = state_manager_raw_compress(state->thisblock,
+         state->zeroblock, state->blocksize, state->scratch);
+
+   if (state->deflate_stream)
+   {
+      uint32_t rd, wn;
+      enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+      const struct trans_stream_backend *backend = state->deflate_backend;
+
+      backend->set_in(state->deflate_stream, state->scratch, (uint32_t)len);
+      backend->set_out(state->deflate_stream,
+            state->scratch_deflated, (uint32_t)len);
+
+      if (     backend->trans(state->deflate_stream, true, &rd, &wn, &err)
+            && err == TRANS_STREAM_ERROR_NONE)
+      {
+         src      = state->scratch_deflated;
+         len      = wn;
+         deflated = true;
+      }
+      else /* Didn't shrink, the stream was left mid-way. */
+         state_manager_trans_reset(backend, &state->deflate_stream);
+   }
+
+   if (state->keyframes_count == state->keyframes_size)
+   {
+      size_t new_size = state->keyframes_size ?
+         state->keyframes_size * 2 : 16;
+      struct state_manager_keyframe *keyframes =
+         (struct state_manager_keyframe*)realloc(state->keyframes,
+               new_size * sizeof(*keyframes));
+
+      if (!keyframes)
+         return;
+
+      state->keyframes      = keyframes;
+      state->keyframes_size = new_size;
+   }
+
+   keyframe                = &state->keyframes[state->keyframes_count];
+   keyframe->data          = (uint8_t*)malloc(len);
+
+   if (!keyframe->data)
+      return;
+
+   memcpy(keyframe->data, src, len);
+   keyframe->size          = len;
+   keyframe->ring_pos      = state->head - state->data;
+   keyframe->frame         = state->frame;
+   keyframe->deflated      = deflated;
+
+   state->keyframes_count++;
+   state->keyframes_bytes += len;
+
+   state_manager_keyframes_thin(state);
+}
+
+static bool state_manager_keyframe_decode(state_manager_t *state,
+      const struct state_manager_keyframe *keyframe, uint8_t *out)
+{
+   const uint8_t *patch = keyframe->data;
+
+   if (keyframe->deflated)
+   {
+      uint32_t rd, wn;
+      enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+      const struct trans_stream_backend *backend =
+         state->deflate_backend->reverse;
+
+      if (!state->inflate_stream)
+         return false;
+
+      backend->set_in(state->inflate_stream,
+            keyframe->data, (uint32_t)keyframe->size);
+      backend->set_out(state->inflate_stream,
+            state->scratch, (uint32_t)state->maxcompsize);
+
+      if (    !backend->trans(state->inflate_stream, true, &rd, &wn, &err)
+            || err != TRANS_STREAM_ERROR_NONE)
+      {
+         state_manager_trans_reset(backend, &state->inflate_stream);
+         return false;
+      }
+
+      patch = state->scratch;
+   }
+
+   memset(out, 0, state->blocksize);
+   state_manager_raw_decompress(patch, state->maxcompsize,
+         out, state->blocksize);
+   return true;
+}
+
+/* Writes the patch turning thisblock into prevblock to the delta ring. */
+static void state_manager_push_delta(state_manager_t *state)
+{
+   const uint8_t *oldb, *newb;
+   uint8_t *compressed;
+   size_t headpos, tailpos, remaining;
+
+recheckcapacity:;
+
+   headpos = state->head - state->data;
+   tailpos = state->tail - state->data;
+   remaining = (tailpos + state->capacity -
+         sizeof(size_t) - headpos - 1) % state->capacity + 1;
+
+   if (remaining <= state->maxcompsize)
+   {
+      state->tail = state->data + read_size_t(state->tail);
+      state->entries--;
+      goto recheckcapacity;
+   }
+
+   oldb        = state->prevblock;
+   newb        = state->thisblock;
+   compressed  = state->head + sizeof(size_t);
+
+   write_size_t(compressed, state->prevframe);
+   compressed += sizeof(size_t);
+
+   compressed += state_manager_raw_compress(oldb, newb,
+         state->blocksize, compressed);
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+      {
+         state->tail = state->data + read_size_t(state->tail);
+         state->entries--;
+      }
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head = compressed;
+}
+
+static void state_manager_process(state_manager_t *state)
+{
+   if (state->job_delta)
+      state_manager_push_delta(state);
+   if (state->job_keyframe)
+      state_manager_push_keyframe(state);
+}
+
+#ifdef HAVE_THREADS
+static void state_manager_thread(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   slock_lock(state->lock);
+
+   for (;;)
+   {
+      while (!state->busy && !state->quit)
+         scond_wait(state->cond, state->lock);
+
+      if (state->quit)
+         break;
+
+      slock_unlock(state->lock);
+      state_manager_process(state);
+      slock_lock(state->lock);
+
+      state->busy = false;
+      scond_signal(state->cond);
+   }
+
+   slock_unlock(state->lock);
+}
+#endif
+
+/* Blocks until the worker is done with prevblock, thisblock,
+ * the delta ring and the keyframes. */
+static void state_manager_wait(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   if (!state->thread)
+      return;
+
+   slock_lock(state->lock);
+   while (state->busy)
+      scond_wait(state->cond, state->lock);
+   slock_unlock(state->lock);
+#endif
+}
+
+static void state_manager_submit(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   if (state->thread)
+   {
+      slock_lock(state->lock);
+      state->busy = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+      return;
+   }
+#endif
+
+   state_manager_process(state);
+}
+
 static void state_manager_free(state_manager_t *state)
 {
+   size_t i;
+
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   if (state->thread)
+   {
+      slock_lock(state->lock);
+      while (state->busy)
+         scond_wait(state->cond, state->lock);
+      state->quit = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+
+      sthread_join(state->thread);
+   }
+   if (state->lock)
+      slock_free(state->lock);
+   if (state->cond)
+      scond_free(state->cond);
+   state->thread     = NULL;
+   state->lock       = NULL;
+   state->cond       = NULL;
+#endif
+
+   for (i = 0; i < state->keyframes_count; i++)
+      free(state->keyframes[i].data);
+   if (state->keyframes)
+      free(state->keyframes);
+
+   if (state->deflate_stream)
+      state->deflate_backend->stream_free(state->deflate_stream);
+   if (state->inflate_stream)
+      state->deflate_backend->reverse->stream_free(state->inflate_stream);
+
    if (state->data)
       free(state->data);
    if (state->thisblock)
       free(state->thisblock);
    if (state->nextblock)
       free(state->nextblock);
+   if (state->prevblock)
+      free(state->prevblock);
+   if (state->zeroblock)
+      free(state->zeroblock);
+   if (state->scratch)
+      free(state->scratch);
+   if (state->scratch_deflated)
+      free(state->scratch_deflated);
 #if STRICT_BUF_SIZE
    if (state->debugblock)
       free(state->debugblock);
    state->debugblock = NULL;
 #endif
-   state->data       = NULL;
-   state->thisblock  = NULL;
-   state->nextblock  = NULL;
+   state->keyframes        = NULL;
+   state->keyframes_count  = 0;
+   state->deflate_stream   = NULL;
+   state->inflate_stream   = NULL;
+   state->data             = NULL;
+   state->thisblock        = NULL;
+   state->nextblock        = NULL;
+   state->prevblock        = NULL;
+   state->zeroblock        = NULL;
+   state->scratch          = NULL;
+   state->scratch_deflated = NULL;
 }
 
 static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
 {
-   size_t max_comp_size, block_size;
-   uint8_t *next_block    = NULL;
-   uint8_t *this_block    = NULL;
-   uint8_t *state_data    = NULL;
+   size_t max_comp_size, block_size, keyframes_capacity;
    state_manager_t *state = (state_manager_t*)calloc(1, sizeof(*state));
 
    if (!state)
@@ -442,25 +835,52 @@ static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
 
    block_size         = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
 
-   /* the compressed data is surrounded by pointers to the other side */
-   max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
-   state_data         = (uint8_t*)malloc(buffer_size);
+   /* the compressed data is surrounded by pointers to the other side,
+    * and prefixed with the frame number */
+   max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 3;
+
+   /* Only set aside room for keyframes if the delta ring
+    * can still hold a reasonable amount of frames. */
+   keyframes_capacity = buffer_size / STATE_MANAGER_KEYFRAME_SHARE;
+   if (buffer_size - keyframes_capacity < max_comp_size * 8)
+      keyframes_capacity = 0;
+   buffer_size       -= keyframes_capacity;
 
-   if (!state_data)
+   state->data        = (uint8_t*)malloc(buffer_size);
+
+   if (!state->data)
       goto error;
 
-   this_block         = (uint8_t*)state_manager_raw_alloc(state_size, 0);
-   next_block         = (uint8_t*)state_manager_raw_alloc(state_size, 1);
+   state->thisblock   = (uint8_t*)state_manager_raw_alloc(state_size, 0);
+   state->nextblock   = (uint8_t*)state_manager_raw_alloc(state_size, 1);
+   state->prevblock   = (uint8_t*)state_manager_raw_alloc(state_size, 2);
 
-   if (!this_block || !next_block)
+   if (!state->thisblock || !state->nextblock || !state->prevblock)
       goto error;
 
-   state->blocksize   = block_size;
-   state->maxcompsize = max_comp_size;
-   state->data        = state_data;
-   state->thisblock   = this_block;
-   state->nextblock   = next_block;
-   state->capacity    = buffer_size;
+   if (keyframes_capacity)
+   {
+      state->zeroblock        = (uint8_t*)state_manager_raw_alloc(state_size, 3);
+      state->scratch          = (uint8_t*)malloc(max_comp_size);
+      state->scratch_deflated = (uint8_t*)malloc(max_comp_size);
+
+      if (!state->zeroblock || !state->scratch || !state->scratch_deflated)
+         goto error;
+
+      state->deflate_backend  = trans_stream_get_zlib_deflate_backend();
+      if (state->deflate_backend)
+      {
+         state->deflate_stream = state_manager_trans_new(
+               state->deflate_backend);
+         state->inflate_stream = state_manager_trans_new(
+               state->deflate_backend->reverse);
+      }
+   }
+
+   state->blocksize          = block_size;
+   state->maxcompsize        = max_comp_size;
+   state->capacity           = buffer_size;
+   state->keyframes_capacity = keyframes_capacity;
 
    state->head        = state->data + sizeof(size_t);
    state->tail        = state->data + sizeof(size_t);
@@ -470,23 +890,55 @@ static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
    state->debugblock  = (uint8_t*)malloc(state_size);
 #endif
 
+#ifdef HAVE_THREADS
+   /* If any of this fails, compression runs synchronously instead. */
+   state->lock        = slock_new();
+   state->cond        = scond_new();
+   if (state->lock && state->cond)
+      state->thread   = sthread_create(state_manager_thread, state);
+#endif
+
    return state;
 
 error:
-   if (state_data)
-      free(state_data);
    state_manager_free(state);
    free(state);
 
    return NULL;
 }
 
+static bool state_manager_pop_keyframe(state_manager_t *state)
+{
+   struct state_manager_keyframe *keyframe = NULL;
+
+   /* Anything at or after the current frame is of no use anymore. */
+   if (state->frame == 0)
+      state_manager_keyframes_truncate(state, 0);
+   else
+      state_manager_keyframes_truncate(state, state->frame - 1);
+
+   if (!state->keyframes_count || state->frame == 0)
+      return false;
+
+   keyframe = &state->keyframes[state->keyframes_count - 1];
+
+   if (!state_manager_keyframe_decode(state, keyframe, state->thisblock))
+      return false;
+
+   /* The ring is empty, frames pushed from here on follow it */
+   keyframe->ring_pos = state->head - state->data;
+   state->frame       = keyframe->frame;
+   return true;
+}
+
 static bool state_manager_pop(state_manager_t *state, const void **data)
 {
    size_t start;
    uint8_t *out                 = NULL;
    const uint8_t *compressed    = NULL;
 
+   state_manager_wait(state);
+
    *data = NULL;
 
    if (state->thisblock_valid)
@@ -499,7 +951,7 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
 
    *data = state->thisblock;
    if (state->head == state->tail)
-      return false;
+      return state_manager_pop_keyframe(state);
 
    start = read_size_t(state->head - sizeof(size_t));
    state->head = state->data + start;
@@ -507,10 +959,136 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
    compressed = state->data + start + sizeof(size_t);
    out = state->thisblock;
 
+   state->frame = (unsigned)read_size_t(compressed);
+   compressed  += sizeof(size_t);
+
    state_manager_raw_decompress(compressed,
          state->maxcompsize, out, state->blocksize);
 
    state->entries--;
+   state_manager_keyframes_truncate(state, state->frame);
+   return true;
+}
+
+/* Frame number of the oldest state still in the delta ring. */
+static unsigned state_manager_ring_oldest(state_manager_t *state)
+{
+   if (state->head == state->tail)
+      return state->frame;
+   return (unsigned)read_size_t(state->tail + sizeof(size_t));
+}
+
+/* Loads a keyframe into thisblock, leaving it untouched on failure. */
+static bool state_manager_load_keyframe(state_manager_t *state,
+      const struct state_manager_keyframe *keyframe)
+{
+   uint8_t *swap = NULL;
+
+   if (!state_manager_keyframe_decode(state, keyframe, state->nextblock))
+      return false;
+
+   swap             = state->thisblock;
+   state->thisblock = state->nextblock;
+   state->nextblock = swap;
+   return true;
+}
+
+/*
+ * Makes the newest state at or before 'frame' the current one,
+ * discarding everything after it.
+ *
+ * If the target is still covered by the delta ring, this decodes the
+ * closest keyframe after it (or thisblock) and walks the ring back from
+ * there, so the cost is bounded by the keyframe interval rather than by
+ * the distance travelled. Anything older is served by keyframes alone.
+ */
+static bool state_manager_jump(state_manager_t *state, unsigned frame)
+{
+   size_t i;
+   size_t pos;
+   size_t headpos;
+   unsigned cur;
+   struct state_manager_keyframe *keyframe = NULL;
+
+   state_manager_wait(state);
+
+   if (frame > state->frame)
+      return false;
+
+   if (frame >= state_manager_ring_oldest(state))
+   {
+      cur     = state->frame;
+      pos     = state->head - state->data;
+      headpos = pos;
+
+      for (i = state->keyframes_count; i-- > 0; )
+      {
+         if (state->keyframes[i].frame < frame)
+            break;
+         if (state->keyframes[i].frame < cur)
+            keyframe = &state->keyframes[i];
+      }
+
+      if (keyframe)
+      {
+         if (!state_manager_load_keyframe(state, keyframe))
+            return false;
+         cur = keyframe->frame;
+         pos = keyframe->ring_pos;
+      }
+
+      while (cur > frame)
+      {
+         const uint8_t *compressed;
+         size_t start = read_size_t(state->data + pos - sizeof(size_t));
+
+         compressed   = state->data + start + sizeof(size_t);
+         cur          = (unsigned)read_size_t(compressed);
+
+         state_manager_raw_decompress(compressed + sizeof(size_t),
+               state->maxcompsize, state->thisblock, state->blocksize);
+
+         pos          = start;
+      }
+
+      state->head = state->data + pos;
+
+      /* The deltas between the new and the old head are gone,
+       * thisblock counts again if a pop had consumed it. */
+      while (pos != headpos)
+      {
+         pos = read_size_t(state->data + pos);
+         state->entries--;
+      }
+      if (!state->thisblock_valid)
+         state->entries++;
+   }
+   else
+   {
+      for (i = state->keyframes_count; i-- > 0; )
+      {
+         if (state->keyframes[i].frame <= frame)
+         {
+            keyframe = &state->keyframes[i];
+            break;
+         }
+      }
+
+      if (!keyframe || !state_manager_load_keyframe(state, keyframe))
+         return false;
+
+      cur                = keyframe->frame;
+      /* The whole ring is newer than this. Its position in the
+       * discarded ring is stale, frames pushed from here on
+       * follow it instead. */
+      state->head        = state->tail;
+      state->entries     = 1;
+      keyframe->ring_pos = state->head - state->data;
+   }
+
+   state->frame           = cur;
+   state->thisblock_valid = true;
+   state_manager_keyframes_truncate(state, cur);
    return true;
 }
 
@@ -536,7 +1114,7 @@ static void state_manager_push_where(state_manager_t *state, void **data)
 #endif
 }
 
-static void state_manager_push_do(state_manager_t *state)
+static void state_manager_push_do(state_manager_t *state, unsigned frame)
 {
    uint8_t *swap = NULL;
 
@@ -544,54 +1122,35 @@ static void state_manager_push_do(state_manager_t *state)
    memcpy(state->nextblock, state->debugblock, state->debugsize);
 #endif
 
+   /* The previous delta must be done before its blocks are recycled. */
+   state_manager_wait(state);
+
    if (state->thisblock_valid)
    {
-      const uint8_t *oldb, *newb;
-      uint8_t *compressed;
-      size_t headpos, tailpos, remaining;
       if (state->capacity < sizeof(size_t) + state->maxcompsize)
          return;
-
-recheckcapacity:;
-
-      headpos = state->head - state->data;
-      tailpos = state->tail - state->data;
-      remaining = (tailpos + state->capacity -
-            sizeof(size_t) - headpos - 1) % state->capacity + 1;
-
-      if (remaining <= state->maxcompsize)
-      {
-         state->tail = state->data + read_size_t(state->tail);
-         state->entries--;
-         goto recheckcapacity;
-      }
-
-      oldb        = state->thisblock;
-      newb        = state->nextblock;
-      compressed  = state->head + sizeof(size_t);
-
-      compressed += state_manager_raw_compress(oldb, newb,
-            state->blocksize, compressed);
-
-      if (compressed - state->data + state->maxcompsize > state->capacity)
-      {
-         compressed = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
-      }
-      write_size_t(compressed, state->head-state->data);
-      compressed += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head = compressed;
+      state->job_delta = true;
    }
    else
+   {
+      state->job_delta       = false;
       state->thisblock_valid = true;
+   }
 
-   swap             = state->thisblock;
+   state->prevframe    = state->frame;
+   state->frame        = frame;
+   state->job_keyframe = state->keyframes_capacity &&
+      (state->pushes++ % STATE_MANAGER_KEYFRAME_INTERVAL) == 0;
+
+   swap             = state->prevblock;
+   state->prevblock = state->thisblock;
    state->thisblock = state->nextblock;
    state->nextblock = swap;
 
    state->entries++;
+
+   if (state->job_delta || state->job_keyframe)
+      state_manager_submit(state);
 }
 
 #if 0
@@ -655,7 +1214,8 @@ void state_manager_event_init(unsigned rewind_buffer_size)
 
    core_serialize(&serial_info);
 
-   state_manager_push_do(rewind_state.state);
+   rewind_state.frame = 0;
+   state_manager_push_do(rewind_state.state, rewind_state.frame);
 }
 
 bool state_manager_frame_is_reversed(void)
@@ -672,6 +1232,71 @@ void state_manager_event_deinit(void)
    }
    rewind_state.state = NULL;
    rewind_state.size  = 0;
+   rewind_state.frame = 0;
+}
+
+/**
+ * state_manager_frame_range:
+ * @oldest               : oldest frame that can be sought to
+ * @newest               : newest frame that can be sought to
+ *
+ * Frame numbers count frames run since rewind was initialized,
+ * minus the ones that have been rewound since.
+ *
+ * Returns: false if rewind is not initialized.
+ **/
+bool state_manager_frame_range(unsigned *oldest, unsigned *newest)
+{
+   state_manager_t *state = rewind_state.state;
+
+   if (!state)
+      return false;
+
+   state_manager_wait(state);
+
+   *oldest = state_manager_ring_oldest(state);
+   if (state->keyframes_count && state->keyframes[0].frame < *oldest)
+      *oldest = state->keyframes[0].frame;
+   *newest = state->frame;
+
+   return true;
+}
+
+/**
+ * state_manager_seek:
+ * @frame                : frame to go back to
+ *
+ * Loads the newest rewind state at or before @frame into the core,
+ * discarding all history after it.
+ *
+ * Returns: true if such a state was found and loaded.
+ **/
+bool state_manager_seek(unsigned frame)
+{
+   retro_ctx_serialize_info_t serial_info;
+
+   if (!rewind_state.state)
+      return false;
+
+   if (!state_manager_jump(rewind_state.state, frame))
+      return false;
+
+#ifdef HAVE_NETWORKING
+   netplay_driver_ctl(RARCH_NETPLAY_CTL_DESYNC_PUSH, NULL);
+#endif
+
+   serial_info.data_const = rewind_state.state->thisblock;
+   serial_info.size       = rewind_state.size;
+
+   core_unserialize(&serial_info);
+
+#ifdef HAVE_NETWORKING
+   netplay_driver_ctl(RARCH_NETPLAY_CTL_DESYNC_POP, NULL);
+#endif
+
+   rewind_state.frame     = rewind_state.state->frame;
+
+   return true;
 }
 
 /**
@@ -736,6 +1361,8 @@ bool state_manager_check_rewind(bool pressed,
 
          core_unserialize(&serial_info);
 
+         rewind_state.frame     = rewind_state.state->frame;
+
          bsv_movie_frame_rewind();
       }
       else
@@ -772,6 +1399,8 @@ bool state_manager_check_rewind(bool pressed,
       cnt = (cnt + 1) % (rewind_granularity ?
             rewind_granularity : 1); /* Avoid possible SIGFPE. */
 
+      rewind_state.frame++;
+
       if ((cnt == 0) || rarch_ctl(RARCH_CTL_BSV_MOVIE_IS_INITED, NULL))
       {
          retro_ctx_serialize_info_t serial_info;
@@ -784,7 +1413,7 @@ bool state_manager_check_rewind(bool pressed,
 
          core_serialize(&serial_info);
 
-         state_manager_push_do(rewind_state.state);
+         state_manager_push_do(rewind_state.state, rewind_state.frame);
       }
    }
 
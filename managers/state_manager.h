@@ -34,6 +34,10 @@ void state_manager_event_deinit(void);
 
 void state_manager_event_init(unsigned rewind_buffer_size);
 
+bool state_manager_frame_range(unsigned *oldest, unsigned *newest);
+
+bool state_manager_seek(unsigned frame);
+
 /**
  * check_rewind:
  * @pressed              : was rewind key pressed or held?
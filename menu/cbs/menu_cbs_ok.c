@@ -3701,6 +3701,13 @@ static void cb_decompressed(retro_task_t *task,
          case CB_UPDATE_ASSETS:
             generic_action_ok_command(CMD_EVENT_REINIT);
             break;
+#ifdef HAVE_LIBRETRODB
+         case CB_UPDATE_DATABASES:
+            /* The downloaded databases come without indexes */
+            task_push_database_index(
+                  config_get_ptr()->paths.path_content_database);
+            break;
+#endif
       }
    }
 
@@ -8098,6 +8098,23 @@ static bool setting_append_list(
                   general_read_handler,
                   SD_FLAG_NONE);
 
+#ifdef HAVE_THREADS
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.scan_worker_threads,
+                  MENU_ENUM_LABEL_SCAN_WORKER_THREADS,
+                  MENU_ENUM_LABEL_VALUE_SCAN_WORKER_THREADS,
+                  DEFAULT_SCAN_WORKER_THREADS,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 0, 32, 1, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+#endif
+
             END_SUB_GROUP(list, list_info, parent_group);
             END_GROUP(list, list_info, parent_group);
          }
@@ -14247,6 +14264,22 @@ static bool setting_append_list(
                SD_FLAG_NONE
                );
 
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->bools.playlist_use_journal,
+               MENU_ENUM_LABEL_PLAYLIST_USE_JOURNAL,
+               MENU_ENUM_LABEL_VALUE_PLAYLIST_USE_JOURNAL,
+               playlist_use_journal,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_NONE
+               );
+
          CONFIG_BOOL(
                list, list_info,
                &settings->bools.playlist_show_sublabels,
@@ -452,6 +452,7 @@ enum msg_hash_enums
    MENU_LABEL(MENU_XMB_ANIMATION_MOVE_UP_DOWN),
    MENU_LABEL(MENU_XMB_ANIMATION_OPENING_MAIN_MENU),
    MENU_LABEL(SCAN_WITHOUT_CORE_MATCH),
+   MENU_LABEL(SCAN_WORKER_THREADS),
    MENU_LABEL(STREAMING_TITLE),
    MENU_LABEL(STREAMING_MODE),
    MENU_LABEL(VIDEO_RECORD_QUALITY),
@@ -2526,6 +2527,7 @@ enum msg_hash_enums
    MENU_ENUM_LABEL_VALUE_HOLD_START,
    MENU_ENUM_LABEL_VALUE_DOWN_SELECT,
    MENU_LABEL(PLAYLIST_USE_OLD_FORMAT),
+   MENU_LABEL(PLAYLIST_USE_JOURNAL),
    MENU_LABEL(MENU_SOUNDS),
    MENU_LABEL(MENU_SOUND_OK),
    MENU_LABEL(MENU_SOUND_CANCEL),
@@ -2585,6 +2587,7 @@ enum msg_hash_enums
 
 #define CB_CORE_UPDATER_DOWNLOAD                                               0x7412da7dU
 #define CB_UPDATE_ASSETS                                                       0xbf85795eU
+#define CB_UPDATE_DATABASES                                                    0x931eb8d3U
 
 /* Deferred */
 
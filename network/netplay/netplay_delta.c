@@ -16,13 +16,30 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include <boolean.h>
+#include <retro_inline.h>
+#include <retro_endianness.h>
 #include <encodings/crc32.h>
 
 #include "netplay_private.h"
 
+/* Unchanged runs shorter than a record header are cheaper to carry along
+ * as changed bytes than to skip */
+#define NETPLAY_DELTA_MIN_SKIP (2*sizeof(uint32_t))
+
+/* Block hashes are XXH64, which runs four independent lanes over the data
+ * and so goes several times as fast as CRC-32 */
+#define HASH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME64_3 0x165667B19E3779F9ULL
+#define HASH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define HASH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define HASH_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
 static void clear_input(netplay_input_state_t istate)
 {
    while (istate)
@@ -58,6 +75,7 @@ bool netplay_delta_frame_ready(netplay_t *netplay, struct delta_frame *delta,
    delta->used  = true;
    delta->frame = frame;
    delta->crc   = 0;
+   delta->have_block_hash = false;
 
    for (i = 0; i < MAX_INPUT_DEVICES; i++)
    {
@@ -83,6 +101,359 @@ uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta)
    return encoding_crc32(0L, (const unsigned char*)delta->state, netplay->state_size);
 }
 
+/* The hash has to be the same on every platform, so the data is always
+ * read little-endian */
+static INLINE uint64_t hash_read64(const uint8_t *data)
+{
+   uint64_t val;
+   memcpy(&val, data, sizeof(val));
+   return swap_if_big64(val);
+}
+
+static INLINE uint32_t hash_read32(const uint8_t *data)
+{
+   uint32_t val;
+   memcpy(&val, data, sizeof(val));
+   return swap_if_big32(val);
+}
+
+static INLINE uint64_t hash_round(uint64_t acc, uint64_t input)
+{
+   acc += input * HASH_PRIME64_2;
+   acc  = HASH_ROTL64(acc, 31);
+   return acc * HASH_PRIME64_1;
+}
+
+static INLINE uint64_t hash_merge(uint64_t acc, uint64_t val)
+{
+   acc ^= hash_round(0, val);
+   return acc * HASH_PRIME64_1 + HASH_PRIME64_4;
+}
+
+static uint64_t hash_block(const uint8_t *data, size_t len)
+{
+   uint64_t h;
+   const uint8_t *end = data + len;
+
+   if (len >= 32)
+   {
+      const uint8_t *limit = end - 32;
+      uint64_t v1          = HASH_PRIME64_1 + HASH_PRIME64_2;
+      uint64_t v2          = HASH_PRIME64_2;
+      uint64_t v3          = 0;
+      uint64_t v4          = 0 - HASH_PRIME64_1;
+
+      do
+      {
+         v1    = hash_round(v1, hash_read64(data));
+         v2    = hash_round(v2, hash_read64(data + 8));
+         v3    = hash_round(v3, hash_read64(data + 16));
+         v4    = hash_round(v4, hash_read64(data + 24));
+         data += 32;
+      } while (data <= limit);
+
+      h = HASH_ROTL64(v1, 1)  + HASH_ROTL64(v2, 7) +
+          HASH_ROTL64(v3, 12) + HASH_ROTL64(v4, 18);
+      h = hash_merge(h, v1);
+      h = hash_merge(h, v2);
+      h = hash_merge(h, v3);
+      h = hash_merge(h, v4);
+   }
+   else
+      h = HASH_PRIME64_5;
+
+   h += len;
+
+   for (; data + 8 <= end; data += 8)
+   {
+      h ^= hash_round(0, hash_read64(data));
+      h  = HASH_ROTL64(h, 27) * HASH_PRIME64_1 + HASH_PRIME64_4;
+   }
+
+   if (data + 4 <= end)
+   {
+      h    ^= (uint64_t)hash_read32(data) * HASH_PRIME64_1;
+      h     = HASH_ROTL64(h, 23) * HASH_PRIME64_2 + HASH_PRIME64_3;
+      data += 4;
+   }
+
+   for (; data < end; data++)
+   {
+      h ^= *data * HASH_PRIME64_5;
+      h  = HASH_ROTL64(h, 11) * HASH_PRIME64_1;
+   }
+
+   h ^= h >> 33;
+   h *= HASH_PRIME64_2;
+   h ^= h >> 29;
+   h *= HASH_PRIME64_3;
+   h ^= h >> 32;
+
+   return h;
+}
+
+/* Blocks are a multiple of the hash's 32 byte stripes, the last one takes
+ * whatever is left */
+static size_t hash_block_size(netplay_t *netplay)
+{
+   return ((netplay->state_size + NETPLAY_HASH_BLOCKS - 1)
+         / NETPLAY_HASH_BLOCKS + 31) & ~(size_t)31;
+}
+
+/**
+ * netplay_delta_frame_hash
+ *
+ * Get the hash of each block of the serialization of this frame.
+ */
+void netplay_delta_frame_hash(netplay_t *netplay, struct delta_frame *delta,
+      uint32_t *hash)
+{
+   unsigned i;
+   size_t block_size   = hash_block_size(netplay);
+   size_t pos          = 0;
+   const uint8_t *data = (const uint8_t*)delta->state;
+
+   for (i = 0; i < NETPLAY_HASH_BLOCKS; i++)
+   {
+      size_t len = 0;
+      uint64_t h;
+
+      if (pos < netplay->state_size)
+      {
+         len = netplay->state_size - pos;
+         if (len > block_size)
+            len = block_size;
+      }
+
+      h       = hash_block(data + pos, len);
+      hash[i] = (uint32_t)(h ^ (h >> 32));
+      pos    += len;
+   }
+}
+
+/**
+ * netplay_delta_frame_hash_check
+ *
+ * Check the serialization of this frame against the block hashes we were
+ * sent.
+ */
+bool netplay_delta_frame_hash_check(netplay_t *netplay,
+      struct delta_frame *delta)
+{
+   unsigned i;
+   uint32_t hash[NETPLAY_HASH_BLOCKS];
+   size_t block_size = hash_block_size(netplay);
+   bool match        = true;
+
+   netplay_delta_frame_hash(netplay, delta, hash);
+
+   for (i = 0; i < NETPLAY_HASH_BLOCKS; i++)
+   {
+      size_t first, last;
+
+      if (hash[i] == delta->block_hash[i])
+         continue;
+
+      first = i * block_size;
+      last  = first + block_size;
+      if (last > netplay->state_size)
+         last = netplay->state_size;
+
+      RARCH_WARN("[netplay] Frame %u differs in block %u of the state "
+            "(bytes %u to %u).\n", delta->frame, i,
+            (unsigned)first, (unsigned)last - 1);
+      match = false;
+   }
+
+   return match;
+}
+
+/**
+ * netplay_delta_frame_find
+ *
+ * Find the delta frame holding the given frame, if it's still buffered.
+ */
+struct delta_frame *netplay_delta_frame_find(netplay_t *netplay,
+      uint32_t frame)
+{
+   size_t i;
+
+   for (i = 0; i < netplay->buffer_size; i++)
+   {
+      struct delta_frame *delta = &netplay->buffer[i];
+      if (delta->used && delta->frame == frame)
+         return delta;
+   }
+
+   return NULL;
+}
+
+/**
+ * netplay_delta_frame_agreed
+ *
+ * Note that the state at the given frame is shared with a peer.
+ */
+void netplay_delta_frame_agreed(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t frame)
+{
+   size_t i;
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *conn = &netplay->connections[i];
+
+      if (connection && conn != connection)
+         continue;
+      if (!conn->active || !conn->delta_supported)
+         continue;
+      /* Keep the newest base, a late CRC shouldn't move it back */
+      if (conn->have_delta_base && frame < conn->delta_base_frame)
+         continue;
+
+      conn->have_delta_base  = true;
+      conn->delta_base_frame = frame;
+   }
+}
+
+/* Length of the run starting at pos in which base and state are equal
+ * (or differ, if equal is false), compared a word at a time where
+ * possible. */
+static size_t delta_run(const uint8_t *base, const uint8_t *state,
+      size_t pos, size_t size, bool equal)
+{
+   size_t end = pos;
+
+   if (equal)
+   {
+      while (end + sizeof(uint32_t) <= size)
+      {
+         uint32_t a, b;
+         memcpy(&a, base  + end, sizeof(a));
+         memcpy(&b, state + end, sizeof(b));
+         if (a != b)
+            break;
+         end += sizeof(uint32_t);
+      }
+   }
+
+   while (end < size && (base[end] == state[end]) == equal)
+      end++;
+
+   return end - pos;
+}
+
+/**
+ * netplay_delta_state_encode
+ *
+ * Encode the XOR of state against base. The encoding is a list of records,
+ * each a 32-bit count of unchanged bytes to skip and a 32-bit count of
+ * changed bytes, followed by those bytes XORed with base. Unchanged bytes
+ * at the end aren't recorded.
+ */
+bool netplay_delta_state_encode(netplay_t *netplay, const void *base,
+      const void *state, uint8_t *out, size_t out_size, size_t *out_len)
+{
+   const uint8_t *bbuf = (const uint8_t*)base;
+   const uint8_t *sbuf = (const uint8_t*)state;
+   size_t size         = netplay->state_size;
+   size_t pos          = 0;
+   size_t wr           = 0;
+
+   while (pos < size)
+   {
+      uint32_t run[2];
+      size_t i;
+      size_t start = pos + delta_run(bbuf, sbuf, pos, size, true);
+      size_t end   = start;
+
+      if (start >= size)
+         break;
+
+      /* Take in the changed bytes along with any short gaps between them */
+      for (;;)
+      {
+         size_t gap;
+
+         end += delta_run(bbuf, sbuf, end, size, false);
+         gap  = delta_run(bbuf, sbuf, end, size, true);
+
+         if (end + gap >= size || gap >= NETPLAY_DELTA_MIN_SKIP)
+            break;
+         end += gap;
+      }
+
+      if (wr + sizeof(run) + (end - start) > out_size)
+         return false;
+
+      run[0] = htonl((uint32_t)(start - pos));
+      run[1] = htonl((uint32_t)(end - start));
+      memcpy(out + wr, run, sizeof(run));
+      wr    += sizeof(run);
+
+      for (i = start; i < end; i++)
+         out[wr++] = bbuf[i] ^ sbuf[i];
+
+      pos = end;
+   }
+
+   *out_len = wr;
+   return true;
+}
+
+/**
+ * netplay_delta_state_apply
+ *
+ * Rebuild state from the base state and an encoding made by
+ * netplay_delta_state_encode.
+ */
+bool netplay_delta_state_apply(netplay_t *netplay, const uint8_t *in,
+      size_t in_size, const void *base, void *state)
+{
+   unsigned pass;
+   uint8_t *sbuf = (uint8_t*)state;
+   size_t size   = netplay->state_size;
+
+   /* Check every record on the first pass, only write on the second */
+   for (pass = 0; pass < 2; pass++)
+   {
+      size_t rd  = 0;
+      size_t pos = 0;
+
+      if (pass && base != state)
+         memcpy(state, base, size);
+
+      while (rd < in_size)
+      {
+         uint32_t run[2];
+         size_t skip, len;
+
+         if (in_size - rd < sizeof(run))
+            return false;
+         memcpy(run, in + rd, sizeof(run));
+         rd  += sizeof(run);
+         skip = ntohl(run[0]);
+         len  = ntohl(run[1]);
+
+         if (skip > size - pos || len > size - pos - skip ||
+               len > in_size - rd)
+            return false;
+         pos += skip;
+
+         if (pass)
+         {
+            size_t i;
+            for (i = 0; i < len; i++)
+               sbuf[pos + i] ^= in[rd + i];
+         }
+
+         pos += len;
+         rd  += len;
+      }
+   }
+
+   return true;
+}
+
 /*
  * Free an input state list
  */
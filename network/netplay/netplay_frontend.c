@@ -1178,43 +1178,102 @@ static void netplay_force_future(netplay_t *netplay)
 }
 
 /**
- * netplay_send_savestate
+ * netplay_send_savestate_delta
  * @netplay              : pointer to netplay object
+ * @connection           : peer to send the savestate to
  * @serial_info          : the savestate being loaded
- * @cx                   : compression type
  * @z                    : compression backend to use
  *
- * Send a loaded savestate to those connected peers using the given compression
- * scheme.
+ * Send a loaded savestate to a peer as a delta against the last state we
+ * believe we share with it, if that's still buffered and the delta is
+ * smaller than the state.
+ *
+ * Returns: True if the savestate has been dealt with, false if it has to be
+ * sent whole.
  */
-void netplay_send_savestate(netplay_t *netplay,
-   retro_ctx_serialize_info_t *serial_info, uint32_t cx,
+static bool netplay_send_savestate_delta(netplay_t *netplay,
+   struct netplay_connection *connection,
+   retro_ctx_serialize_info_t *serial_info,
    struct compression_transcoder *z)
 {
-   uint32_t header[4];
+   uint32_t header[6];
    uint32_t rd, wn;
-   size_t i;
+   size_t dsize;
+   struct delta_frame *base;
+   retro_time_t start = cpu_features_get_time_usec();
+
+   if (!connection->delta_supported || !connection->have_delta_base ||
+       !netplay->dbuffer || serial_info->size != netplay->state_size ||
+       connection->delta_base_frame >= netplay->run_frame_count)
+      return false;
+
+   base = netplay_delta_frame_find(netplay, connection->delta_base_frame);
+   if (!base)
+      return false;
+
+   if (!netplay_delta_state_encode(netplay, base->state,
+         serial_info->data_const, netplay->dbuffer, netplay->state_size,
+         &dsize))
+      return false;
 
    /* Compress it */
    z->compression_backend->set_in(z->compression_stream,
-      (const uint8_t*)serial_info->data_const, (uint32_t)serial_info->size);
+      netplay->dbuffer, (uint32_t)dsize);
    z->compression_backend->set_out(z->compression_stream,
       netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
    if (!z->compression_backend->trans(z->compression_stream, true, &rd,
          &wn, NULL))
+      return false;
+
+   header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE_DELTA);
+   header[1] = htonl(wn + 4*sizeof(uint32_t));
+   header[2] = htonl(netplay->run_frame_count);
+   header[3] = htonl(serial_info->size);
+   header[4] = htonl(base->frame);
+   header[5] = htonl(netplay_delta_frame_crc(netplay, base));
+
+   if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
+         sizeof(header)) ||
+       !netplay_send(&connection->send_packet_buffer, connection->fd,
+         netplay->zbuffer, wn))
    {
-      /* Catastrophe! */
-      for (i = 0; i < netplay->connections_size; i++)
-         netplay_hangup(netplay, &netplay->connections[i]);
-      return;
+      netplay_hangup(netplay, connection);
+      return true;
    }
 
-   /* Send it to relevant peers */
+   RARCH_LOG("[netplay] Sent savestate delta for frame %u against frame %u: "
+         "%u bytes instead of %u, in %u usec.\n",
+         netplay->run_frame_count, base->frame, (unsigned)(wn + sizeof(header)),
+         (unsigned)serial_info->size,
+         (unsigned)(cpu_features_get_time_usec() - start));
+
+   return true;
+}
+
+/**
+ * netplay_send_savestate
+ * @netplay              : pointer to netplay object
+ * @serial_info          : the savestate being loaded
+ * @cx                   : compression type
+ * @z                    : compression backend to use
+ *
+ * Send a loaded savestate to those connected peers using the given compression
+ * scheme, as a delta to those that share an earlier state with us.
+ */
+void netplay_send_savestate(netplay_t *netplay,
+   retro_ctx_serialize_info_t *serial_info, uint32_t cx,
+   struct compression_transcoder *z)
+{
+   uint32_t header[4];
+   uint32_t rd, wn;
+   size_t i;
+   bool compressed = false;
+
    header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE);
-   header[1] = htonl(wn + 2*sizeof(uint32_t));
    header[2] = htonl(netplay->run_frame_count);
    header[3] = htonl(serial_info->size);
 
+   /* Send it to relevant peers */
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
@@ -1222,11 +1281,53 @@ void netplay_send_savestate(netplay_t *netplay,
           connection->mode < NETPLAY_CONNECTION_CONNECTED ||
           connection->compression_supported != cx) continue;
 
-      if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
-            sizeof(header)) ||
-          !netplay_send(&connection->send_packet_buffer, connection->fd,
-            netplay->zbuffer, wn))
-         netplay_hangup(netplay, connection);
+      if (netplay_send_savestate_delta(netplay, connection, serial_info, z))
+      {
+         /* The delta went through zbuffer */
+         compressed = false;
+      }
+      else
+      {
+         retro_time_t start = cpu_features_get_time_usec();
+
+         /* Compress it */
+         if (!compressed)
+         {
+            z->compression_backend->set_in(z->compression_stream,
+               (const uint8_t*)serial_info->data_const,
+               (uint32_t)serial_info->size);
+            z->compression_backend->set_out(z->compression_stream,
+               netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
+            if (!z->compression_backend->trans(z->compression_stream, true,
+                  &rd, &wn, NULL))
+            {
+               /* Catastrophe! */
+               for (i = 0; i < netplay->connections_size; i++)
+                  netplay_hangup(netplay, &netplay->connections[i]);
+               return;
+            }
+            header[1] = htonl(wn + 2*sizeof(uint32_t));
+            compressed = true;
+         }
+
+         if (!netplay_send(&connection->send_packet_buffer, connection->fd,
+               header, sizeof(header)) ||
+             !netplay_send(&connection->send_packet_buffer, connection->fd,
+               netplay->zbuffer, wn))
+         {
+            netplay_hangup(netplay, connection);
+            continue;
+         }
+
+         RARCH_LOG("[netplay] Sent savestate for frame %u: %u bytes, in %u usec.\n",
+               netplay->run_frame_count, (unsigned)(wn + sizeof(header)),
+               (unsigned)(cpu_features_get_time_usec() - start));
+      }
+
+      /* Once it's loaded, the peer has this frame's state too */
+      if (connection->active)
+         netplay_delta_frame_agreed(netplay, connection,
+               netplay->run_frame_count);
    }
 }
 
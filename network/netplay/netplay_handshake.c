@@ -206,7 +206,8 @@ bool netplay_handshake_init_send(netplay_t *netplay,
 
    header[0] = htonl(netplay_magic);
    header[1] = htonl(netplay_platform_magic());
-   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED);
+   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED | NETPLAY_COMPRESSION_DELTA
+         | NETPLAY_COMPRESSION_BLOCK_HASH);
    header[3] = 0;
    header[4] = htonl(NETPLAY_PROTOCOL_VERSION);
    header[5] = htonl(netplay_impl_magic());
@@ -371,6 +372,13 @@ bool netplay_handshake_init(netplay_t *netplay,
 
    /* Check what compression is supported */
    compression  = ntohl(header[2]);
+
+   /* Older peers don't know about savestate deltas or block hashes and
+    * leave the bits clear, so they keep getting CRCs */
+   connection->delta_supported      = !!(compression & NETPLAY_COMPRESSION_DELTA);
+   connection->have_delta_base      = false;
+   connection->block_hash_supported = !!(compression & NETPLAY_COMPRESSION_BLOCK_HASH);
+
    compression &= NETPLAY_COMPRESSION_SUPPORTED;
 
    if (compression & NETPLAY_COMPRESSION_ZLIB)
@@ -304,6 +304,9 @@ bool netplay_init_serialization(netplay_t *netplay)
       return false;
    }
 
+   /* Without a delta buffer we can still send whole states */
+   netplay->dbuffer = (uint8_t *) calloc(netplay->state_size, 1);
+
    return true;
 }
 
@@ -560,6 +563,9 @@ void netplay_free(netplay_t *netplay)
    if (netplay->zbuffer)
       free(netplay->zbuffer);
 
+   if (netplay->dbuffer)
+      free(netplay->dbuffer);
+
    if (netplay->compress_nil.compression_stream)
    {
       netplay->compress_nil.compression_backend->stream_free(netplay->compress_nil.compression_stream);
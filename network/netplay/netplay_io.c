@@ -440,21 +440,57 @@ static bool netplay_cmd_nak(netplay_t *netplay,
 /**
  * netplay_cmd_crc
  *
- * Send a CRC command to all active clients.
+ * Send a CRC command, or the block hashes to those that support them, to all
+ * active clients.
  */
 bool netplay_cmd_crc(netplay_t *netplay, struct delta_frame *delta)
 {
    uint32_t payload[2];
+   uint32_t hash_payload[1 + NETPLAY_HASH_BLOCKS];
    bool success = true;
    size_t i;
-   payload[0] = htonl(delta->frame);
-   payload[1] = htonl(delta->crc);
+
+   /* Only pay for the kinds of hash somebody will check */
+   delta->crc             = 0;
+   delta->have_block_hash = false;
+
    for (i = 0; i < netplay->connections_size; i++)
    {
-      if (netplay->connections[i].active &&
-            netplay->connections[i].mode >= NETPLAY_CONNECTION_CONNECTED)
-         success = netplay_send_raw_cmd(netplay, &netplay->connections[i],
+      struct netplay_connection *connection = &netplay->connections[i];
+
+      if (!connection->active ||
+            connection->mode < NETPLAY_CONNECTION_CONNECTED)
+         continue;
+
+      if (connection->block_hash_supported)
+      {
+         if (!delta->have_block_hash)
+         {
+            unsigned j;
+            netplay_delta_frame_hash(netplay, delta, delta->block_hash);
+            delta->have_block_hash = true;
+
+            hash_payload[0] = htonl(delta->frame);
+            for (j = 0; j < NETPLAY_HASH_BLOCKS; j++)
+               hash_payload[1 + j] = htonl(delta->block_hash[j]);
+         }
+
+         success = netplay_send_raw_cmd(netplay, connection,
+            NETPLAY_CMD_BLOCK_HASH, hash_payload, sizeof(hash_payload))
+            && success;
+      }
+      else
+      {
+         if (!delta->crc)
+         {
+            delta->crc = netplay_delta_frame_crc(netplay, delta);
+            payload[0] = htonl(delta->frame);
+            payload[1] = htonl(delta->crc);
+         }
+
+         success = netplay_send_raw_cmd(netplay, connection,
             NETPLAY_CMD_CRC, payload, sizeof(payload)) && success;
+      }
    }
    return success;
 }
@@ -905,6 +941,39 @@ static void handle_play_spectate(netplay_t *netplay, uint32_t client_num,
    }
 }
 
+/**
+ * netplay_load_savestate_delta
+ *
+ * Rebuild a state sent as a delta from the compressed delta in zbuffer and
+ * our copy of the base state, if we have it and it has the CRC the sender
+ * expects.
+ *
+ * Returns: True if the state was loaded into delta, false if nothing was
+ * touched.
+ */
+static bool netplay_load_savestate_delta(netplay_t *netplay,
+      struct compression_transcoder *ctrans, struct delta_frame *delta,
+      size_t zsize, uint32_t base_frame, uint32_t base_crc)
+{
+   uint32_t rd, wn;
+   struct delta_frame *base = netplay_delta_frame_find(netplay, base_frame);
+
+   if (!base || !netplay->dbuffer ||
+         netplay_delta_frame_crc(netplay, base) != base_crc)
+      return false;
+
+   ctrans->decompression_backend->set_in(ctrans->decompression_stream,
+      netplay->zbuffer, (uint32_t)zsize);
+   ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+      netplay->dbuffer, (uint32_t)netplay->state_size);
+   if (!ctrans->decompression_backend->trans(ctrans->decompression_stream,
+         true, &rd, &wn, NULL))
+      return false;
+
+   return netplay_delta_state_apply(netplay, netplay->dbuffer, wn,
+         base->state, delta->state);
+}
+
 #undef RECV
 #define RECV(buf, sz) \
 recvd = netplay_recv(&connection->recv_packet_buffer, connection->fd, (buf), \
@@ -1553,6 +1622,8 @@ static bool netplay_get_cmd(netplay_t *netplay,
                   /* Problem! */
                   netplay_cmd_request_savestate(netplay);
                }
+               else
+                  netplay_delta_frame_agreed(netplay, connection, buffer[0]);
             }
             else
             {
@@ -1563,13 +1634,57 @@ static bool netplay_get_cmd(netplay_t *netplay,
             break;
          }
 
+      case NETPLAY_CMD_BLOCK_HASH:
+         {
+            unsigned i;
+            uint32_t buffer[1 + NETPLAY_HASH_BLOCKS];
+            struct delta_frame *delta = NULL;
+
+            if (cmd_size != sizeof(buffer))
+            {
+               RARCH_ERR("NETPLAY_CMD_BLOCK_HASH received unexpected payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(buffer, sizeof(buffer))
+            {
+               RARCH_ERR("NETPLAY_CMD_BLOCK_HASH failed to receive payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            buffer[0] = ntohl(buffer[0]);
+
+            /* Oh well, we got rid of it! */
+            if (!(delta = netplay_delta_frame_find(netplay, buffer[0])))
+               break;
+
+            for (i = 0; i < NETPLAY_HASH_BLOCKS; i++)
+               delta->block_hash[i] = ntohl(buffer[1 + i]);
+            delta->have_block_hash = true;
+
+            /* If we've already replayed up to this frame we can check it
+             * directly, otherwise we'll check it when we catch up */
+            if (buffer[0] <= netplay->other_frame_count)
+            {
+               if (netplay_delta_frame_hash_check(netplay, delta))
+                  netplay_delta_frame_agreed(netplay, connection, buffer[0]);
+               else
+                  netplay_cmd_request_savestate(netplay);
+            }
+
+            break;
+         }
+
       case NETPLAY_CMD_REQUEST_SAVESTATE:
          /* Delay until next frame so we don't send the savestate after the
-          * input */
+          * input. Whatever went wrong, the peer can't be trusted to share any
+          * of our states, so send it whole. */
          netplay->force_send_savestate = true;
+         connection->have_delta_base   = false;
          break;
 
       case NETPLAY_CMD_LOAD_SAVESTATE:
+      case NETPLAY_CMD_LOAD_SAVESTATE_DELTA:
       case NETPLAY_CMD_RESET:
          {
             uint32_t frame;
@@ -1577,7 +1692,10 @@ static bool netplay_get_cmd(netplay_t *netplay,
             uint32_t rd, wn;
             uint32_t client;
             uint32_t load_frame_count;
+            uint32_t base[2];
             size_t load_ptr;
+            size_t header_size = 2*sizeof(uint32_t);
+            retro_time_t load_time = cpu_features_get_time_usec();
             struct compression_transcoder *ctrans = NULL;
             uint32_t                   client_num = (uint32_t)
              (connection - netplay->connections + 1);
@@ -1626,9 +1744,12 @@ static bool netplay_get_cmd(netplay_t *netplay,
              * gets loaded. This is just to avoid having reloading implemented in
              * too many places. */
 
-            /* Check the payload size */
-            if ((cmd == NETPLAY_CMD_LOAD_SAVESTATE &&
-                 (cmd_size < 2*sizeof(uint32_t) || cmd_size > netplay->zbuffer_size + 2*sizeof(uint32_t))) ||
+            /* Check the payload size. A delta also carries the frame and CRC
+             * of the state it's against. */
+            if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               header_size += sizeof(base);
+            if ((cmd != NETPLAY_CMD_RESET &&
+                 (cmd_size < header_size || cmd_size > netplay->zbuffer_size + header_size)) ||
                 (cmd == NETPLAY_CMD_RESET && cmd_size != sizeof(uint32_t)))
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE received an unexpected payload size.\n");
@@ -1666,7 +1787,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
             }
 
             /* Now we switch based on whether we're loading a state or resetting */
-            if (cmd == NETPLAY_CMD_LOAD_SAVESTATE)
+            if (cmd != NETPLAY_CMD_RESET)
             {
                RECV(&isize, sizeof(isize))
                {
@@ -1681,7 +1802,18 @@ static bool netplay_get_cmd(netplay_t *netplay,
                   return netplay_cmd_nak(netplay, connection);
                }
 
-               RECV(netplay->zbuffer, cmd_size - 2*sizeof(uint32_t))
+               if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               {
+                  RECV(base, sizeof(base))
+                  {
+                     RARCH_ERR("CMD_LOAD_SAVESTATE_DELTA failed to receive the base frame.\n");
+                     return netplay_cmd_nak(netplay, connection);
+                  }
+                  base[0] = ntohl(base[0]);
+                  base[1] = ntohl(base[1]);
+               }
+
+               RECV(netplay->zbuffer, cmd_size - header_size)
                {
                   RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive savestate.\n");
                   return netplay_cmd_nak(netplay, connection);
@@ -1696,13 +1828,40 @@ static bool netplay_get_cmd(netplay_t *netplay,
                   default:
                      ctrans = &netplay->compress_nil;
                }
-               ctrans->decompression_backend->set_in(ctrans->decompression_stream,
-                  netplay->zbuffer, cmd_size - 2*sizeof(uint32_t));
-               ctrans->decompression_backend->set_out(ctrans->decompression_stream,
-                  (uint8_t*)netplay->buffer[load_ptr].state,
-                  (unsigned)netplay->state_size);
-               ctrans->decompression_backend->trans(ctrans->decompression_stream,
-                  true, &rd, &wn, NULL);
+
+               if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               {
+                  if (!netplay_load_savestate_delta(netplay, ctrans,
+                        &netplay->buffer[load_ptr], cmd_size - header_size,
+                        base[0], base[1]))
+                  {
+                     /* We don't have the state it's against, so carry on
+                      * until the whole state arrives */
+                     RARCH_WARN("[netplay] Can't apply savestate delta against frame %u, requesting the full state.\n",
+                           base[0]);
+                     netplay_cmd_request_savestate(netplay);
+                     break;
+                  }
+               }
+               else
+               {
+                  ctrans->decompression_backend->set_in(ctrans->decompression_stream,
+                     netplay->zbuffer, cmd_size - 2*sizeof(uint32_t));
+                  ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+                     (uint8_t*)netplay->buffer[load_ptr].state,
+                     (unsigned)netplay->state_size);
+                  ctrans->decompression_backend->trans(ctrans->decompression_stream,
+                     true, &rd, &wn, NULL);
+               }
+
+               /* Both sides now have this frame's state */
+               netplay_delta_frame_agreed(netplay, connection, load_frame_count);
+
+               RARCH_LOG("[netplay] Loaded %s for frame %u: %u bytes in %u usec.\n",
+                     cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA
+                     ? "savestate delta" : "savestate",
+                     load_frame_count, (unsigned)cmd_size,
+                     (unsigned)(cpu_features_get_time_usec() - load_time));
 
                /* Force a rewind to the relevant frame */
                netplay->force_rewind = true;
@@ -60,6 +60,10 @@ typedef uint32_t client_bitmap_t;
 #define PREV_PTR(x) ((x) == 0 ? netplay->buffer_size - 1 : (x) - 1)
 #define NEXT_PTR(x) ((x + 1) % netplay->buffer_size)
 
+/* States are hashed in this many blocks, so a mismatch can be narrowed down
+ * to the part of the state it's in */
+#define NETPLAY_HASH_BLOCKS 16
+
 /* Quirks mandated by how particular cores save states. This is distilled from
  * the larger set of quirks that the quirks environment can communicate. */
 #define NETPLAY_QUIRK_NO_SAVESTATES (1<<0)
@@ -89,6 +93,12 @@ typedef uint32_t client_bitmap_t;
 
 /* Compression protocols supported */
 #define NETPLAY_COMPRESSION_ZLIB (1<<0)
+/* Savestates may be sent as deltas against a frame both sides share,
+ * see NETPLAY_CMD_LOAD_SAVESTATE_DELTA */
+#define NETPLAY_COMPRESSION_DELTA (1<<1)
+/* Frames are checked with block hashes rather than a CRC-32 of the whole
+ * state, see NETPLAY_CMD_BLOCK_HASH */
+#define NETPLAY_COMPRESSION_BLOCK_HASH (1<<2)
 #if HAVE_ZLIB
 #define NETPLAY_COMPRESSION_SUPPORTED NETPLAY_COMPRESSION_ZLIB
 #else
@@ -166,6 +176,13 @@ enum netplay_cmd
    /* Sends over cheats enabled on client (unsupported) */
    NETPLAY_CMD_CHEATS         = 0x0047,
 
+   /* Send a savestate for the client to load as the XOR/RLE delta against
+    * the state of an earlier frame, identified by its frame and CRC */
+   NETPLAY_CMD_LOAD_SAVESTATE_DELTA = 0x0048,
+
+   /* Send the block hashes of a frame's state, replaces CRC */
+   NETPLAY_CMD_BLOCK_HASH     = 0x0049,
+
    /* Misc. commands */
 
    /* Sends multiple config requests over,
@@ -298,6 +315,11 @@ struct delta_frame
    /* The CRC-32 of the serialized state if we've calculated it, else 0 */
    uint32_t crc;
 
+   /* The hash of each block of the serialized state, and whether we have
+    * them (the server's own, or the server's to check against as client) */
+   uint32_t block_hash[NETPLAY_HASH_BLOCKS];
+   bool have_block_hash;
+
    /* The resolved input, i.e., what's actually going to the core. One input
     * per device. */
    netplay_input_state_t resolved_input[MAX_INPUT_DEVICES];
@@ -359,6 +381,18 @@ struct netplay_connection
    /* What compression does this peer support? */
    uint32_t compression_supported;
 
+   /* Does this peer accept savestate deltas? */
+   bool delta_supported;
+
+   /* Does this peer check frames with block hashes? */
+   bool block_hash_supported;
+
+   /* The latest frame whose state we believe this peer shares with us, to
+    * send savestate deltas against. The peer checks the CRC before using
+    * it, so this only has to be a good guess. */
+   bool have_delta_base;
+   uint32_t delta_base_frame;
+
    /* Is this player paused? */
    bool paused;
 
@@ -459,6 +493,10 @@ struct netplay
    uint8_t *zbuffer;
    size_t zbuffer_size;
 
+   /* A buffer for the XOR/RLE encoding of savestate deltas, state_size
+    * bytes long */
+   uint8_t *dbuffer;
+
    /* The size of our packet buffers */
    size_t packet_buffer_size;
 
@@ -661,6 +699,69 @@ bool netplay_delta_frame_ready(netplay_t *netplay, struct delta_frame *delta,
  */
 uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta);
 
+/**
+ * netplay_delta_frame_hash
+ *
+ * Get the hash of each block of the serialization of this frame.
+ */
+void netplay_delta_frame_hash(netplay_t *netplay, struct delta_frame *delta,
+      uint32_t *hash);
+
+/**
+ * netplay_delta_frame_hash_check
+ *
+ * Check the serialization of this frame against the block hashes we were
+ * sent, and report the parts of the state that differ.
+ *
+ * Returns: True if every block matches.
+ */
+bool netplay_delta_frame_hash_check(netplay_t *netplay,
+      struct delta_frame *delta);
+
+/**
+ * netplay_delta_frame_find
+ *
+ * Find the delta frame holding the given frame, if it's still buffered.
+ *
+ * Returns: The delta frame, or NULL if it's gone.
+ */
+struct delta_frame *netplay_delta_frame_find(netplay_t *netplay,
+      uint32_t frame);
+
+/**
+ * netplay_delta_frame_agreed
+ *
+ * Note that the state at the given frame is believed to be shared with the
+ * peer at the other end of the connection, or with every peer if connection
+ * is NULL, so that savestates can be sent as deltas against it.
+ */
+void netplay_delta_frame_agreed(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t frame);
+
+/**
+ * netplay_delta_state_encode
+ *
+ * Encode the XOR of state against base as runs of unchanged bytes and
+ * runs of changed bytes, and store its size in out_len. Equal states encode
+ * to nothing.
+ *
+ * Returns: True if the encoding fits in out_size bytes.
+ */
+bool netplay_delta_state_encode(netplay_t *netplay, const void *base,
+      const void *state, uint8_t *out, size_t out_size, size_t *out_len);
+
+/**
+ * netplay_delta_state_apply
+ *
+ * Rebuild state from the base state and an encoding made by
+ * netplay_delta_state_encode. base and state may be the same buffer. Nothing
+ * is changed if the encoding is malformed.
+ *
+ * Returns: True if the delta was applied.
+ */
+bool netplay_delta_state_apply(netplay_t *netplay, const uint8_t *in,
+      size_t in_size, const void *base, void *state);
+
 /**
  * netplay_delta_frame_free
  *
@@ -851,7 +952,8 @@ void netplay_send_raw_cmd_all(netplay_t *netplay,
 /**
  * netplay_cmd_crc
  *
- * Send a CRC command to all active clients.
+ * Send a CRC command, or the block hashes to those that support them, to all
+ * active clients.
  */
 bool netplay_cmd_crc(netplay_t *netplay, struct delta_frame *delta);
 
@@ -514,15 +514,24 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
       if (netplay->check_frames &&
           delta->frame % abs(netplay->check_frames) == 0)
       {
-         delta->crc = netplay_delta_frame_crc(netplay, delta);
          netplay_cmd_crc(netplay, delta);
+
+         /* Clients only speak up when their CRC doesn't match, so until
+          * they request a savestate, assume this frame is shared */
+         netplay_delta_frame_agreed(netplay, NULL, delta->frame);
       }
    }
-   else if (delta->crc && netplay->crcs_valid)
+   else if ((delta->crc || delta->have_block_hash) && netplay->crcs_valid)
    {
-      /* We have a remote CRC, so check it */
-      uint32_t local_crc = netplay_delta_frame_crc(netplay, delta);
-      if (local_crc != delta->crc)
+      /* We have a remote hash, so check it */
+      bool match;
+
+      if (delta->have_block_hash)
+         match = netplay_delta_frame_hash_check(netplay, delta);
+      else
+         match = netplay_delta_frame_crc(netplay, delta) == delta->crc;
+
+      if (!match)
       {
          /* If the very first check frame is wrong,
           * they probably just don't work */
@@ -540,8 +549,12 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
                netplay_cmd_request_savestate(netplay);
          }
       }
-      else if (!netplay->crc_validity_checked)
-         netplay->crc_validity_checked = true;
+      else
+      {
+         if (!netplay->crc_validity_checked)
+            netplay->crc_validity_checked = true;
+         netplay_delta_frame_agreed(netplay, NULL, delta->frame);
+      }
    }
 }
 
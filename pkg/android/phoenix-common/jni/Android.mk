@@ -42,7 +42,6 @@ ifeq ($(HAVE_NEON),1)
 	DEFINES += -D__ARM_NEON__ -DHAVE_NEON
    LOCAL_SRC_FILES += $(LIBRETRO_COMM_DIR)/audio/conversion/s16_to_float_neon.S.neon \
 							 $(LIBRETRO_COMM_DIR)/audio/conversion/float_to_s16_neon.S.neon \
-							 $(LIBRETRO_COMM_DIR)/audio/resampler/drivers/sinc_resampler_neon.S.neon \
 							 $(RARCH_DIR)/audio/drivers_resampler/cc_resampler_neon.S.neon
 endif
 DEFINES += -DANDROID_ARM_V7
@@ -30,6 +30,8 @@
 #include <file/file_path.h>
 #include <lists/string_list.h>
 #include <formats/jsonsax_full.h>
+#include <rhash.h>
+#include <encodings/crc32.h>
 
 #include "playlist.h"
 #include "verbosity.h"
@@ -40,6 +42,40 @@
 #define PLAYLIST_ENTRIES 6
 #endif
 
+#define PLAYLIST_JOURNAL_EXTENSION ".journal"
+#define PLAYLIST_TMP_EXTENSION     ".tmp"
+#define PLAYLIST_JOURNAL_HEADER    "playlist_journal\t1"
+#define PLAYLIST_JOURNAL_SLACK     64
+
+enum playlist_index_kind
+{
+   PLAYLIST_INDEX_PATH = 0,
+   PLAYLIST_INDEX_ARCHIVE
+};
+
+struct playlist_index_node
+{
+   char *key;
+   size_t idx;
+   uint32_t hash;
+   enum playlist_index_kind kind;
+   struct playlist_index_node *next;
+};
+
+struct playlist_journal
+{
+   char *buf;           /* Records not yet appended */
+   size_t len;
+   size_t cap;
+   size_t pending;      /* Records in buf */
+   size_t records;      /* Records in the journal file */
+   uint32_t base_crc;   /* CRC32 of the playlist file */
+   bool base_valid;
+   bool enabled;
+   bool appended;       /* Journal file written through this handle */
+   bool rewrite;        /* Next write has to rewrite the playlist file */
+};
+
 struct content_playlist
 {
    bool modified;
@@ -54,6 +90,14 @@ struct content_playlist
    char *default_core_path;
    char *default_core_name;
    struct playlist_entry *entries;
+
+   /* Entry lookup by path, see playlist_index_find() */
+   struct playlist_index_node **index;
+   size_t index_buckets;
+   size_t index_count;
+
+   /* Change journal, see playlist_journal_add() */
+   struct playlist_journal journal;
 };
 
 typedef struct
@@ -77,6 +121,8 @@ typedef struct
    bool in_items;
    bool in_subsystem_roms;
    bool capacity_exceeded;
+   bool write_failed;
+   uint32_t crc;
 } JSONContext;
 
 static playlist_t *playlist_cached = NULL;
@@ -217,6 +263,546 @@ static bool playlist_core_path_equal(const char *real_core_path, const char *ent
    return false;
 }
 
+/* Entries are looked up through a hash index of their
+ * 'real' paths, so that pushing content or checking
+ * whether it exists does not have to resolve the path
+ * of every entry in the playlist. Archive entries
+ * ([archive_path][delimiter][rom_file]) are also indexed
+ * by [archive_path], for fuzzy archive matching.
+ * The index is built on first use, and every function
+ * that adds, removes, moves or renames entries keeps it
+ * in step (or drops it, to be rebuilt later) */
+static void playlist_index_free(playlist_t *playlist)
+{
+   size_t i;
+
+   if (!playlist->index)
+      return;
+
+   for (i = 0; i < playlist->index_buckets; i++)
+   {
+      struct playlist_index_node *node = playlist->index[i];
+
+      while (node)
+      {
+         struct playlist_index_node *next = node->next;
+         free(node->key);
+         free(node);
+         node = next;
+      }
+   }
+
+   free(playlist->index);
+   playlist->index         = NULL;
+   playlist->index_buckets = 0;
+   playlist->index_count   = 0;
+}
+
+static void playlist_index_add_key(playlist_t *playlist,
+      const char *key, size_t idx, enum playlist_index_kind kind)
+{
+   uint32_t hash                    = djb2_calculate(key);
+   struct playlist_index_node *node = NULL;
+
+   /* Keep chains short */
+   if (playlist->index_count >= playlist->index_buckets)
+   {
+      size_t i;
+      size_t buckets                     = playlist->index_buckets * 2;
+      struct playlist_index_node **index = (struct playlist_index_node**)
+         calloc(buckets, sizeof(*index));
+
+      if (index)
+      {
+         for (i = 0; i < playlist->index_buckets; i++)
+         {
+            struct playlist_index_node *old = playlist->index[i];
+
+            while (old)
+            {
+               struct playlist_index_node *next = old->next;
+               old->next = index[old->hash & (buckets - 1)];
+               index[old->hash & (buckets - 1)] = old;
+               old       = next;
+            }
+         }
+
+         free(playlist->index);
+         playlist->index         = index;
+         playlist->index_buckets = buckets;
+      }
+   }
+
+   node = (struct playlist_index_node*)malloc(sizeof(*node));
+   if (!node)
+      return;
+
+   node->key  = strdup(key);
+   node->hash = hash;
+   node->idx  = idx;
+   node->kind = kind;
+
+   if (!node->key)
+   {
+      free(node);
+      return;
+   }
+
+   node->next = playlist->index[hash & (playlist->index_buckets - 1)];
+   playlist->index[hash & (playlist->index_buckets - 1)] = node;
+   playlist->index_count++;
+}
+
+/**
+ * playlist_index_add:
+ * @playlist            : Playlist handle.
+ * @idx                 : Index of playlist entry.
+ *
+ * Adds the keys of the entry at @idx to the index.
+ **/
+static void playlist_index_add(playlist_t *playlist, size_t idx)
+{
+   const char *delim = NULL;
+   const char *path  = playlist->entries[idx].path;
+   char key[PATH_MAX_LENGTH];
+
+   key[0] = '\0';
+
+   if (!playlist->index)
+      return;
+
+   /* Entries without a path only match
+    * content pushed without a path */
+   if (string_is_empty(path))
+   {
+      playlist_index_add_key(playlist, "", idx, PLAYLIST_INDEX_PATH);
+      return;
+   }
+
+   /* Same 'real' path as playlist_path_equal() compares */
+   strlcpy(key, path, sizeof(key));
+   path_resolve_realpath(key, sizeof(key), true);
+
+   if (string_is_empty(key))
+      return;
+
+#ifdef _WIN32
+   /* Handle case-insensitive operating systems*/
+   string_to_lower(key);
+#endif
+
+   playlist_index_add_key(playlist, key, idx, PLAYLIST_INDEX_PATH);
+
+   if (path_is_compressed_file(key))
+      return;
+
+   delim = path_get_archive_delim(key);
+   if (delim)
+   {
+      key[delim - key] = '\0';
+      playlist_index_add_key(playlist, key, idx, PLAYLIST_INDEX_ARCHIVE);
+   }
+}
+
+static bool playlist_index_init(playlist_t *playlist)
+{
+   size_t i;
+
+   if (playlist->index)
+      return true;
+
+   playlist->index_buckets = 64;
+   while (playlist->index_buckets < playlist->size * 2)
+      playlist->index_buckets *= 2;
+
+   playlist->index_count   = 0;
+   playlist->index         = (struct playlist_index_node**)
+      calloc(playlist->index_buckets, sizeof(*playlist->index));
+
+   if (!playlist->index)
+   {
+      playlist->index_buckets = 0;
+      return false;
+   }
+
+   for (i = 0; i < playlist->size; i++)
+      playlist_index_add(playlist, i);
+
+   return true;
+}
+
+/**
+ * playlist_index_drop:
+ * @playlist            : Playlist handle.
+ * @idx                 : Index of playlist entry.
+ * @close_gap           : Whether the entries after @idx move down by one.
+ *
+ * Removes the keys of the entry at @idx from the index.
+ **/
+static void playlist_index_drop(playlist_t *playlist,
+      size_t idx, bool close_gap)
+{
+   size_t i;
+
+   if (!playlist->index)
+      return;
+
+   for (i = 0; i < playlist->index_buckets; i++)
+   {
+      struct playlist_index_node **link = &playlist->index[i];
+
+      while (*link)
+      {
+         struct playlist_index_node *node = *link;
+
+         if (node->idx == idx)
+         {
+            *link = node->next;
+            free(node->key);
+            free(node);
+            playlist->index_count--;
+            continue;
+         }
+
+         if (close_gap && node->idx > idx)
+            node->idx--;
+
+         link = &node->next;
+      }
+   }
+}
+
+/**
+ * playlist_index_bump:
+ * @playlist            : Playlist handle.
+ * @idx                 : Index of playlist entry.
+ *
+ * Follows the entry at @idx moving to the top of the
+ * playlist, and the entries above it moving down by one.
+ * An @idx of playlist->size makes room for a new top entry.
+ **/
+static void playlist_index_bump(playlist_t *playlist, size_t idx)
+{
+   size_t i;
+
+   if (!playlist->index)
+      return;
+
+   for (i = 0; i < playlist->index_buckets; i++)
+   {
+      struct playlist_index_node *node = playlist->index[i];
+
+      for (; node; node = node->next)
+      {
+         if (node->idx == idx)
+            node->idx = 0;
+         else if (node->idx < idx)
+            node->idx++;
+      }
+   }
+}
+
+static void playlist_index_match(playlist_t *playlist,
+      const char *key, enum playlist_index_kind kind, bool compressed,
+      size_t **matches, size_t *count, size_t *cap)
+{
+   uint32_t hash                    = djb2_calculate(key);
+   struct playlist_index_node *node =
+      playlist->index[hash & (playlist->index_buckets - 1)];
+
+   for (; node; node = node->next)
+   {
+      if (node->hash != hash || node->kind != kind)
+         continue;
+      if (!string_is_equal(node->key, key))
+         continue;
+      if (compressed && !path_is_compressed_file(node->key))
+         continue;
+
+      if (*count == *cap)
+      {
+         size_t new_cap   = *cap ? *cap * 2 : 8;
+         size_t *new_data = (size_t*)
+            realloc(*matches, new_cap * sizeof(size_t));
+
+         if (!new_data)
+            return;
+
+         *matches = new_data;
+         *cap     = new_cap;
+      }
+
+      (*matches)[(*count)++] = node->idx;
+   }
+}
+
+static int playlist_index_cmp(const void *a, const void *b)
+{
+   size_t idx_a = *(const size_t*)a;
+   size_t idx_b = *(const size_t*)b;
+
+   return (idx_a > idx_b) - (idx_a < idx_b);
+}
+
+/**
+ * playlist_index_find:
+ * @playlist            : Playlist handle.
+ * @real_path           : 'Real' search path, generated by path_resolve_realpath()
+ * @matches             : Set to the indices of the matching entries, in
+ *                        playlist order. To be freed by the caller.
+ *
+ * Finds every entry for which playlist_path_equal() would
+ * return 'true', or which has no path if @real_path is empty.
+ *
+ * Returns: number of matching entries.
+ **/
+static size_t playlist_index_find(playlist_t *playlist,
+      const char *real_path, size_t **matches)
+{
+   size_t count = 0;
+   size_t cap   = 0;
+   char key[PATH_MAX_LENGTH];
+#ifdef RARCH_INTERNAL
+   settings_t *settings = config_get_ptr();
+#endif
+
+   *matches = NULL;
+
+   if (!playlist_index_init(playlist))
+   {
+      size_t i;
+
+      /* No index, fall back to comparing every entry */
+      for (i = 0; i < playlist->size; i++)
+      {
+         const char *entry_path = playlist->entries[i].path;
+
+         if (!(string_is_empty(real_path) && string_is_empty(entry_path))
+               && !playlist_path_equal(real_path, entry_path))
+            continue;
+
+         if (count == cap)
+         {
+            size_t new_cap   = cap ? cap * 2 : 8;
+            size_t *new_data = (size_t*)
+               realloc(*matches, new_cap * sizeof(size_t));
+
+            if (!new_data)
+               break;
+
+            *matches = new_data;
+            cap      = new_cap;
+         }
+
+         (*matches)[count++] = i;
+      }
+
+      return count;
+   }
+
+   strlcpy(key, real_path ? real_path : "", sizeof(key));
+#ifdef _WIN32
+   /* Handle case-insensitive operating systems*/
+   string_to_lower(key);
+#endif
+
+   playlist_index_match(playlist, key, PLAYLIST_INDEX_PATH, false,
+         matches, &count, &cap);
+
+#ifdef RARCH_INTERNAL
+   /* Fuzzy matching may be disabled */
+   if (settings && settings->bools.playlist_fuzzy_archive_match)
+#endif
+   {
+      /* Search path is just [archive_path], entry path
+       * is [archive_path][delimiter][rom_file]... */
+      if (path_is_compressed_file(key))
+         playlist_index_match(playlist, key, PLAYLIST_INDEX_ARCHIVE, false,
+               matches, &count, &cap);
+      /* ...or vice versa */
+      else
+      {
+         const char *delim = path_get_archive_delim(key);
+
+         if (delim)
+         {
+            key[delim - key] = '\0';
+            playlist_index_match(playlist, key, PLAYLIST_INDEX_PATH, true,
+                  matches, &count, &cap);
+         }
+      }
+   }
+
+   /* Chains hold the most recently indexed entries first */
+   if (count > 1)
+      qsort(*matches, count, sizeof(size_t), playlist_index_cmp);
+
+   return count;
+}
+
+/* Instead of rewriting the whole playlist file on every
+ * playlist_write_file(), changes may be appended to a
+ * journal next to it ([conf_path].journal). Every change
+ * is one line: a record type and an entry index, followed
+ * by the entry itself where needed, all tab separated:
+ *   P 0 [entry]    - entry pushed to the top
+ *   B [idx]        - entry at [idx] bumped to the top
+ *   U [idx] [entry]- entry at [idx] replaced
+ *   D [idx]        - entry at [idx] deleted
+ *   C 0            - playlist cleared
+ * The first line holds the CRC32 of the playlist file that
+ * the journal applies to, so a journal left behind by an
+ * interrupted merge is ignored. Changes that the journal
+ * cannot express (sorting, metadata) make the next write
+ * rewrite the playlist file, which merges the journal. */
+static size_t playlist_journal_limit(playlist_t *playlist)
+{
+   /* Beyond this, rewriting the playlist is
+    * cheaper than replaying the journal on load */
+   return playlist->size / 2 + PLAYLIST_JOURNAL_SLACK;
+}
+
+static void playlist_journal_rewrite(playlist_t *playlist)
+{
+   struct playlist_journal *journal = &playlist->journal;
+
+   free(journal->buf);
+   journal->buf     = NULL;
+   journal->len     = 0;
+   journal->cap     = 0;
+   journal->pending = 0;
+   journal->rewrite = true;
+}
+
+static bool playlist_journal_reserve(playlist_t *playlist, size_t len)
+{
+   struct playlist_journal *journal = &playlist->journal;
+
+   if (journal->rewrite)
+      return false;
+
+   if (journal->len + len > journal->cap)
+   {
+      size_t cap = journal->cap ? journal->cap : 4096;
+      char  *buf = NULL;
+
+      while (cap < journal->len + len)
+         cap *= 2;
+
+      buf = (char*)realloc(journal->buf, cap);
+
+      if (!buf)
+      {
+         playlist_journal_rewrite(playlist);
+         return false;
+      }
+
+      journal->buf = buf;
+      journal->cap = cap;
+   }
+
+   return true;
+}
+
+static void playlist_journal_put(playlist_t *playlist, const char *str)
+{
+   struct playlist_journal *journal = &playlist->journal;
+   const char *s                    = str ? str : "";
+
+   if (!playlist_journal_reserve(playlist, 1 + 2 * strlen(s)))
+      return;
+
+   journal->buf[journal->len++] = '\t';
+
+   for (; *s; s++)
+   {
+      switch (*s)
+      {
+         case '\\':
+            journal->buf[journal->len++] = '\\';
+            journal->buf[journal->len++] = '\\';
+            break;
+         case '\t':
+            journal->buf[journal->len++] = '\\';
+            journal->buf[journal->len++] = 't';
+            break;
+         case '\n':
+            journal->buf[journal->len++] = '\\';
+            journal->buf[journal->len++] = 'n';
+            break;
+         case '\r':
+            journal->buf[journal->len++] = '\\';
+            journal->buf[journal->len++] = 'r';
+            break;
+         default:
+            journal->buf[journal->len++] = *s;
+            break;
+      }
+   }
+}
+
+/**
+ * playlist_journal_add:
+ * @playlist            : Playlist handle.
+ * @type                : Record type.
+ * @idx                 : Index of playlist entry.
+ * @entry               : Entry to record, or NULL.
+ *
+ * Queues a journal record, to be appended to the
+ * journal by the next playlist_write_file().
+ **/
+static void playlist_journal_add(playlist_t *playlist,
+      char type, size_t idx, const struct playlist_entry *entry)
+{
+   char num[32];
+   struct playlist_journal *journal = &playlist->journal;
+
+   if (!journal->enabled || journal->rewrite)
+      return;
+
+   if (journal->records + journal->pending >= playlist_journal_limit(playlist))
+   {
+      playlist_journal_rewrite(playlist);
+      return;
+   }
+
+   if (!playlist_journal_reserve(playlist, 1))
+      return;
+
+   journal->buf[journal->len++] = type;
+
+   snprintf(num, sizeof(num), "%u", (unsigned)idx);
+   playlist_journal_put(playlist, num);
+
+   if (entry)
+   {
+      size_t i;
+      const struct string_list *roms = entry->subsystem_roms;
+
+      playlist_journal_put(playlist, entry->path);
+      playlist_journal_put(playlist, entry->label);
+      playlist_journal_put(playlist, entry->core_path);
+      playlist_journal_put(playlist, entry->core_name);
+      playlist_journal_put(playlist, entry->db_name);
+      playlist_journal_put(playlist, entry->crc32);
+      playlist_journal_put(playlist, entry->subsystem_ident);
+      playlist_journal_put(playlist, entry->subsystem_name);
+
+      snprintf(num, sizeof(num), "%u", roms ? (unsigned)roms->size : 0);
+      playlist_journal_put(playlist, num);
+
+      if (roms)
+         for (i = 0; i < roms->size; i++)
+            playlist_journal_put(playlist, roms->elems[i].data);
+   }
+
+   if (!playlist_journal_reserve(playlist, 1))
+      return;
+
+   journal->buf[journal->len++] = '\n';
+   journal->pending++;
+}
+
 uint32_t playlist_get_size(playlist_t *playlist)
 {
    if (!playlist)
@@ -331,6 +917,9 @@ void playlist_delete_index(playlist_t *playlist,
    memmove(playlist->entries + idx, playlist->entries + idx + 1,
          (playlist->size - idx) * sizeof(struct playlist_entry));
 
+   playlist_index_drop(playlist, idx, true);
+   playlist_journal_add(playlist, 'D', idx, NULL);
+
    playlist->modified = true;
 }
 
@@ -338,7 +927,7 @@ void playlist_get_index_by_path(playlist_t *playlist,
       const char *search_path,
       const struct playlist_entry **entry)
 {
-   size_t i;
+   size_t *matches = NULL;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -350,22 +939,21 @@ void playlist_get_index_by_path(playlist_t *playlist,
    strlcpy(real_search_path, search_path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (!playlist_path_equal(real_search_path, playlist->entries[i].path))
-         continue;
+   if (string_is_empty(real_search_path))
+      return;
 
-      *entry = &playlist->entries[i];
+   if (playlist_index_find(playlist, real_search_path, &matches) > 0)
+      *entry = &playlist->entries[matches[0]];
 
-      break;
-   }
+   free(matches);
 }
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
       const char *crc32)
 {
-   size_t i;
+   size_t count;
+   size_t *matches = NULL;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -377,11 +965,13 @@ bool playlist_entry_exists(playlist_t *playlist,
    strlcpy(real_search_path, path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
-   for (i = 0; i < playlist->size; i++)
-      if (playlist_path_equal(real_search_path, playlist->entries[i].path))
-         return true;
+   if (string_is_empty(real_search_path))
+      return false;
 
-   return false;
+   count = playlist_index_find(playlist, real_search_path, &matches);
+   free(matches);
+
+   return count > 0;
 }
 
 void playlist_update(playlist_t *playlist, size_t idx,
@@ -400,6 +990,9 @@ void playlist_update(playlist_t *playlist, size_t idx,
          free(entry->path);
       entry->path        = strdup(update_entry->path);
       playlist->modified = true;
+
+      playlist_index_drop(playlist, idx, false);
+      playlist_index_add(playlist, idx);
    }
 
    if (update_entry->label && (update_entry->label != entry->label))
@@ -442,6 +1035,9 @@ void playlist_update(playlist_t *playlist, size_t idx,
       entry->crc32       = strdup(update_entry->crc32);
       playlist->modified = true;
    }
+
+   if (playlist->modified && idx < playlist->size)
+      playlist_journal_add(playlist, 'U', idx, entry);
 }
 
 void playlist_update_runtime(playlist_t *playlist, size_t idx,
@@ -462,6 +1058,9 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
       entry->path        = NULL;
       entry->path        = strdup(update_entry->path);
       playlist->modified = playlist->modified || register_update;
+
+      playlist_index_drop(playlist, idx, false);
+      playlist_index_add(playlist, idx);
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
@@ -532,12 +1131,16 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
       entry->last_played_second = update_entry->last_played_second;
       playlist->modified = playlist->modified || register_update;
    }
+
+   if (register_update && playlist->modified && idx < playlist->size)
+      playlist_journal_add(playlist, 'U', idx, entry);
 }
 
 bool playlist_push_runtime(playlist_t *playlist,
       const struct playlist_entry *entry)
 {
-   size_t i;
+   size_t i, n, count;
+   size_t *matches = NULL;
    char real_path[PATH_MAX_LENGTH];
    char real_core_path[PATH_MAX_LENGTH];
 
@@ -571,22 +1174,21 @@ bool playlist_push_runtime(playlist_t *playlist,
       return false;
    }
 
-   for (i = 0; i < playlist->size; i++)
+   count = playlist_index_find(playlist, real_path, &matches);
+
+   for (n = 0; n < count; n++)
    {
       struct playlist_entry tmp;
-      const char *entry_path = playlist->entries[i].path;
-      bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path);
+
+      i = matches[n];
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
       if (!playlist_core_path_equal(real_core_path, playlist->entries[i].core_path))
          continue;
 
+      free(matches);
+
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
       if (i == 0)
@@ -597,10 +1199,13 @@ bool playlist_push_runtime(playlist_t *playlist,
       memmove(playlist->entries + 1, playlist->entries,
             i * sizeof(struct playlist_entry));
       playlist->entries[0] = tmp;
+      playlist_index_bump(playlist, i);
 
       goto success;
    }
 
+   free(matches);
+
    if (playlist->size == playlist->cap)
    {
       struct playlist_entry *last_entry = &playlist->entries[playlist->cap - 1];
@@ -608,6 +1213,8 @@ bool playlist_push_runtime(playlist_t *playlist,
       if (last_entry)
          playlist_free_entry(last_entry);
       playlist->size--;
+
+      playlist_index_drop(playlist, playlist->cap - 1, false);
    }
 
    if (playlist->entries)
@@ -633,11 +1240,16 @@ bool playlist_push_runtime(playlist_t *playlist,
       playlist->entries[0].last_played_hour = entry->last_played_hour;
       playlist->entries[0].last_played_minute = entry->last_played_minute;
       playlist->entries[0].last_played_second = entry->last_played_second;
+
+      playlist_index_bump(playlist, playlist->size);
+      playlist_index_add(playlist, 0);
    }
 
    playlist->size++;
 
 success:
+   /* Runtime playlists are not journalled */
+   playlist_journal_rewrite(playlist);
    playlist->modified = true;
 
    return true;
@@ -696,7 +1308,8 @@ void playlist_resolve_path(enum playlist_file_mode mode,
 bool playlist_push(playlist_t *playlist,
       const struct playlist_entry *entry)
 {
-   size_t i;
+   size_t i, n, count;
+   size_t *matches       = NULL;
    char real_path[PATH_MAX_LENGTH];
    char real_core_path[PATH_MAX_LENGTH];
    const char *core_name = entry->core_name;
@@ -745,19 +1358,16 @@ bool playlist_push(playlist_t *playlist,
       }
    }
 
-   for (i = 0; i < playlist->size; i++)
+   count = playlist_index_find(playlist, real_path, &matches);
+
+   for (n = 0; n < count; n++)
    {
       struct playlist_entry tmp;
-      const char *entry_path = playlist->entries[i].path;
-      bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path);
+
+      i = matches[n];
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
       if (!playlist_core_path_equal(real_core_path, playlist->entries[i].core_path))
          continue;
 
@@ -839,12 +1449,17 @@ bool playlist_push(playlist_t *playlist,
          entry_updated                = true;
       }
 
+      free(matches);
+
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
       if (i == 0)
       {
          if (entry_updated)
+         {
+            playlist_journal_add(playlist, 'U', 0, &playlist->entries[0]);
             goto success;
+         }
 
          return false;
       }
@@ -854,10 +1469,17 @@ bool playlist_push(playlist_t *playlist,
       memmove(playlist->entries + 1, playlist->entries,
             i * sizeof(struct playlist_entry));
       playlist->entries[0] = tmp;
+      playlist_index_bump(playlist, i);
+      playlist_journal_add(playlist, 'B', i, NULL);
+
+      if (entry_updated)
+         playlist_journal_add(playlist, 'U', 0, &playlist->entries[0]);
 
       goto success;
    }
 
+   free(matches);
+
    if (playlist->size == playlist->cap)
    {
       struct playlist_entry *last_entry =
@@ -866,6 +1488,8 @@ bool playlist_push(playlist_t *playlist,
       if (last_entry)
          playlist_free_entry(last_entry);
       playlist->size--;
+
+      playlist_index_drop(playlist, playlist->cap - 1, false);
    }
 
    if (playlist->entries)
@@ -918,9 +1542,13 @@ bool playlist_push(playlist_t *playlist,
          for (i = 0; i < entry->subsystem_roms->size; i++)
             string_list_append(playlist->entries[0].subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
       }
+
+      playlist_index_bump(playlist, playlist->size);
+      playlist_index_add(playlist, 0);
    }
 
    playlist->size++;
+   playlist_journal_add(playlist, 'P', 0, &playlist->entries[0]);
 
 success:
    playlist->modified = true;
@@ -928,12 +1556,320 @@ success:
    return true;
 }
 
+static void playlist_journal_path(playlist_t *playlist,
+      char *path, size_t size)
+{
+   strlcpy(path, playlist->conf_path, size);
+   strlcat(path, PLAYLIST_JOURNAL_EXTENSION, size);
+}
+
+/* Splits off the next tab separated field
+ * of a journal record, and unescapes it */
+static char *playlist_journal_field(char **str)
+{
+   char *field = *str;
+   char *in    = *str;
+   char *out   = *str;
+
+   for (; *in && *in != '\t'; in++)
+   {
+      if (*in == '\\' && in[1])
+      {
+         switch (*++in)
+         {
+            case 't':
+               *out++ = '\t';
+               break;
+            case 'n':
+               *out++ = '\n';
+               break;
+            case 'r':
+               *out++ = '\r';
+               break;
+            default:
+               *out++ = *in;
+               break;
+         }
+      }
+      else
+         *out++ = *in;
+   }
+
+   *str = *in ? in + 1 : in;
+   *out = '\0';
+
+   return field;
+}
+
+static char *playlist_journal_strdup(char **str)
+{
+   char *field = playlist_journal_field(str);
+   return string_is_empty(field) ? NULL : strdup(field);
+}
+
+static void playlist_journal_read_entry(char **str,
+      struct playlist_entry *entry)
+{
+   unsigned i, roms;
+
+   entry->path            = playlist_journal_strdup(str);
+   entry->label           = playlist_journal_strdup(str);
+   entry->core_path       = playlist_journal_strdup(str);
+   entry->core_name       = playlist_journal_strdup(str);
+   entry->db_name         = playlist_journal_strdup(str);
+   entry->crc32           = playlist_journal_strdup(str);
+   entry->subsystem_ident = playlist_journal_strdup(str);
+   entry->subsystem_name  = playlist_journal_strdup(str);
+
+   roms = (unsigned)strtoul(playlist_journal_field(str), NULL, 10);
+
+   for (i = 0; i < roms; i++)
+   {
+      union string_list_elem_attr attr = {0};
+      const char *rom                  = playlist_journal_field(str);
+
+      if (string_is_empty(rom))
+         continue;
+
+      if (!entry->subsystem_roms)
+         entry->subsystem_roms = string_list_new();
+
+      if (entry->subsystem_roms)
+         string_list_append(entry->subsystem_roms, rom, attr);
+   }
+}
+
+static bool playlist_journal_apply(playlist_t *playlist, char *record)
+{
+   struct playlist_entry entry = {0};
+   char type                   = *record++;
+   size_t idx                  = 0;
+
+   if (*record++ != '\t')
+      return false;
+
+   idx = strtoul(playlist_journal_field(&record), NULL, 10);
+
+   switch (type)
+   {
+      case 'P':
+         playlist_journal_read_entry(&record, &entry);
+
+         if (playlist->size == playlist->cap)
+         {
+            playlist_free_entry(&playlist->entries[playlist->cap - 1]);
+            playlist->size--;
+         }
+
+         memmove(playlist->entries + 1, playlist->entries,
+               playlist->size * sizeof(struct playlist_entry));
+         playlist->entries[0] = entry;
+         playlist->size++;
+         break;
+      case 'B':
+         if (idx >= playlist->size)
+            return false;
+
+         entry = playlist->entries[idx];
+         memmove(playlist->entries + 1, playlist->entries,
+               idx * sizeof(struct playlist_entry));
+         playlist->entries[0] = entry;
+         break;
+      case 'U':
+         if (idx >= playlist->size)
+            return false;
+
+         playlist_journal_read_entry(&record, &entry);
+         playlist_free_entry(&playlist->entries[idx]);
+         playlist->entries[idx] = entry;
+         break;
+      case 'D':
+         if (idx >= playlist->size)
+            return false;
+
+         playlist_delete_index(playlist, idx);
+         break;
+      case 'C':
+         playlist_clear(playlist);
+         break;
+      default:
+         return false;
+   }
+
+   return true;
+}
+
+/**
+ * playlist_journal_replay:
+ * @playlist            : Playlist handle.
+ *
+ * Applies the changes recorded in the journal
+ * of a freshly loaded playlist.
+ **/
+static void playlist_journal_replay(playlist_t *playlist)
+{
+   char path[PATH_MAX_LENGTH];
+   char header[64];
+   struct playlist_journal *journal = &playlist->journal;
+   bool enabled                     = journal->enabled;
+   void *data                       = NULL;
+   int64_t len                      = 0;
+   char *record                     = NULL;
+   char *end                        = NULL;
+
+   path[0] = '\0';
+
+   playlist_journal_path(playlist, path, sizeof(path));
+
+   if (!filestream_exists(path))
+      return;
+
+   if (!filestream_read_file(path, &data, &len))
+      return;
+
+   snprintf(header, sizeof(header), "%s\t%08x\n",
+         PLAYLIST_JOURNAL_HEADER, (unsigned)journal->base_crc);
+
+   if (    !journal->base_valid
+         || (size_t)len < strlen(header)
+         || memcmp(data, header, strlen(header)))
+   {
+      RARCH_WARN("Ignoring playlist journal that does not match playlist file: %s\n",
+            path);
+      /* Have the next write remove it */
+      playlist_journal_rewrite(playlist);
+      goto end;
+   }
+
+   /* Replay without recording the changes again */
+   journal->enabled = false;
+
+   for (record = (char*)data + strlen(header);
+         (end = strchr(record, '\n')); record = end + 1)
+   {
+      *end = '\0';
+
+      if (!playlist_journal_apply(playlist, record))
+      {
+         RARCH_WARN("Stopped replaying invalid playlist journal: %s\n", path);
+         playlist_journal_rewrite(playlist);
+         break;
+      }
+
+      journal->records++;
+   }
+
+   /* A record without a newline was cut
+    * short while appending, and is dropped */
+
+   journal->enabled   = enabled;
+   playlist->modified = false;
+
+   RARCH_LOG("Replayed %u changes from playlist journal: %s\n",
+         (unsigned)journal->records, path);
+
+end:
+   free(data);
+}
+
+/**
+ * playlist_journal_append:
+ * @playlist            : Playlist handle.
+ *
+ * Appends the queued records to the journal.
+ *
+ * Returns: true if the playlist file and journal
+ * now hold every change, false if the playlist
+ * file has to be rewritten.
+ **/
+static bool playlist_journal_append(playlist_t *playlist)
+{
+   char path[PATH_MAX_LENGTH];
+   char header[64];
+   size_t header_len                = 0;
+   RFILE *file                      = NULL;
+   struct playlist_journal *journal = &playlist->journal;
+
+   path[0] = '\0';
+
+   if (    !journal->enabled
+         || journal->rewrite
+         || !journal->base_valid
+         || !journal->pending)
+      return false;
+
+   playlist_journal_path(playlist, path, sizeof(path));
+
+   header_len = snprintf(header, sizeof(header), "%s\t%08x\n",
+         PLAYLIST_JOURNAL_HEADER, (unsigned)journal->base_crc);
+
+   if (journal->records)
+   {
+      char existing[64];
+
+      file = filestream_open(path,
+            RETRO_VFS_FILE_ACCESS_READ_WRITE | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+      if (!file)
+         return false;
+
+      /* Something else may have merged the journal
+       * since, in which case it is no longer ours */
+      if (     filestream_read(file, existing, header_len) != (int64_t)header_len
+            || memcmp(existing, header, header_len)
+            || filestream_seek(file, 0, RETRO_VFS_SEEK_POSITION_END) < 0)
+      {
+         filestream_close(file);
+         return false;
+      }
+   }
+   else
+   {
+      file = filestream_open(path,
+            RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+      if (!file)
+         return false;
+
+      if (filestream_write(file, header, header_len) != (int64_t)header_len)
+      {
+         filestream_close(file);
+         return false;
+      }
+   }
+
+   if (     filestream_write(file, journal->buf, journal->len) != (int64_t)journal->len
+         || filestream_flush(file) != 0)
+   {
+      filestream_close(file);
+      return false;
+   }
+
+   filestream_close(file);
+
+   journal->records += journal->pending;
+   journal->pending  = 0;
+   journal->len      = 0;
+   journal->appended = true;
+
+   return true;
+}
+
 static JSON_Writer_HandlerResult JSONOutputHandler(JSON_Writer writer, const char *pBytes, size_t length)
 {
    JSONContext *context = (JSONContext*)JSON_Writer_GetUserData(writer);
 
    (void)writer; /* unused */
-   return filestream_write(context->file, pBytes, length) == length ? JSON_Writer_Continue : JSON_Writer_Abort;
+   context->crc = encoding_crc32(context->crc, (const uint8_t*)pBytes, length);
+
+   if (filestream_write(context->file, pBytes, length) != length)
+   {
+      context->write_failed = true;
+      return JSON_Writer_Abort;
+   }
+
+   return JSON_Writer_Continue;
 }
 
 static void JSONLogError(JSONContext *pCtx)
@@ -1184,20 +2120,46 @@ end:
 void playlist_write_file(playlist_t *playlist)
 {
    size_t i;
+   char journal_path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   const char *path     = NULL;
    RFILE          *file = NULL;
+   bool written         = false;
+   bool base_valid      = false;
+   uint32_t base_crc    = 0;
 #ifdef RARCH_INTERNAL
    settings_t *settings = config_get_ptr();
 #endif
 
+   journal_path[0] = tmp_path[0] = '\0';
+
    if (!playlist || !playlist->modified)
       return;
 
-   file = filestream_open(playlist->conf_path,
+   if (playlist_journal_append(playlist))
+   {
+      playlist->modified = false;
+      RARCH_LOG("Written to playlist journal: %s\n", playlist->conf_path);
+      return;
+   }
+
+   /* When journalling, write to a temporary file and
+    * rename it over the playlist once complete, so a
+    * crash never leaves a partial playlist behind */
+   path = playlist->conf_path;
+   if (playlist->journal.enabled)
+   {
+      strlcpy(tmp_path, playlist->conf_path, sizeof(tmp_path));
+      strlcat(tmp_path, PLAYLIST_TMP_EXTENSION, sizeof(tmp_path));
+      path = tmp_path;
+   }
+
+   file = filestream_open(path,
          RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
    if (!file)
    {
-      RARCH_ERR("Failed to write to playlist file: %s\n", playlist->conf_path);
+      RARCH_ERR("Failed to write to playlist file: %s\n", path);
       return;
    }
 
@@ -1514,13 +2476,66 @@ void playlist_write_file(playlist_t *playlist)
       JSON_Writer_WriteEndObject(context.writer);
       JSON_Writer_WriteNewLine(context.writer);
       JSON_Writer_Free(context.writer);
+
+      if (context.write_failed)
+         goto end;
+
+      base_crc   = context.crc;
+      base_valid = true;
    }
 
+   written = true;
+
+end:
+   if (filestream_close(file) != 0)
+      written = false;
+
+   if (!written)
+   {
+      RARCH_ERR("Failed to write to playlist file: %s\n", path);
+      if (path == tmp_path)
+         filestream_delete(tmp_path);
+      return;
+   }
+
+   if (path == tmp_path)
+   {
+      /* Renaming over an existing file fails on some platforms.
+       * Should we crash between deleting and renaming, the
+       * complete temporary file is picked up on the next load. */
+      if (filestream_rename(tmp_path, playlist->conf_path) != 0)
+      {
+         filestream_delete(playlist->conf_path);
+
+         if (filestream_rename(tmp_path, playlist->conf_path) != 0)
+         {
+            RARCH_ERR("Failed to write to playlist file: %s\n",
+                  playlist->conf_path);
+            return;
+         }
+      }
+   }
+
+   /* The playlist file now holds every change,
+    * any journal is merged */
+   playlist_journal_path(playlist, journal_path, sizeof(journal_path));
+   if (filestream_exists(journal_path))
+      filestream_delete(journal_path);
+
+   free(playlist->journal.buf);
+   playlist->journal.buf        = NULL;
+   playlist->journal.len        = 0;
+   playlist->journal.cap        = 0;
+   playlist->journal.pending    = 0;
+   playlist->journal.records    = 0;
+   playlist->journal.appended   = false;
+   playlist->journal.rewrite    = false;
+   playlist->journal.base_crc   = base_crc;
+   playlist->journal.base_valid = base_valid;
+
    playlist->modified = false;
 
    RARCH_LOG("Written to playlist file: %s\n", playlist->conf_path);
-end:
-   filestream_close(file);
 }
 
 /**
@@ -1536,6 +2551,18 @@ void playlist_free(playlist_t *playlist)
    if (!playlist)
       return;
 
+   /* Merge what was journalled through this handle back
+    * into the playlist file. Unsaved changes stay unsaved. */
+   if (playlist->journal.appended && !playlist->modified)
+   {
+      playlist->journal.rewrite = true;
+      playlist->modified        = true;
+      playlist_write_file(playlist);
+   }
+
+   free(playlist->journal.buf);
+   playlist->journal.buf = NULL;
+
    if (playlist->conf_path != NULL)
       free(playlist->conf_path);
    playlist->conf_path = NULL;
@@ -1559,6 +2586,8 @@ void playlist_free(playlist_t *playlist)
    free(playlist->entries);
    playlist->entries = NULL;
 
+   playlist_index_free(playlist);
+
    free(playlist);
 }
 
@@ -1582,6 +2611,9 @@ void playlist_clear(playlist_t *playlist)
          playlist_free_entry(entry);
    }
    playlist->size = 0;
+
+   playlist_index_free(playlist);
+   playlist_journal_add(playlist, 'C', 0, NULL);
 }
 
 /**
@@ -1962,6 +2994,36 @@ static void get_old_format_metadata_value(
    strlcpy(value, start, len);
 }
 
+/* A temporary file is only ever renamed over the playlist
+ * once it is complete, so if it is left behind with the
+ * playlist gone, a write was interrupted just before the
+ * rename and it holds the latest contents. Next to the
+ * playlist, it is what remains of a write that never
+ * finished, and is dropped. */
+static void playlist_recover_tmp_file(const char *path)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+
+   tmp_path[0] = '\0';
+
+   strlcpy(tmp_path, path, sizeof(tmp_path));
+   strlcat(tmp_path, PLAYLIST_TMP_EXTENSION, sizeof(tmp_path));
+
+   if (!filestream_exists(tmp_path))
+      return;
+
+   if (filestream_exists(path))
+   {
+      filestream_delete(tmp_path);
+      return;
+   }
+
+   if (filestream_rename(tmp_path, path) == 0)
+      RARCH_WARN("Recovered playlist file from %s\n", tmp_path);
+   else
+      RARCH_ERR("Failed to recover playlist file from %s\n", tmp_path);
+}
+
 static bool playlist_read_file(
       playlist_t *playlist, const char *path)
 {
@@ -2058,6 +3120,9 @@ static bool playlist_read_file(
             goto json_cleanup;
          }
 
+         context.crc = encoding_crc32(context.crc,
+               (const uint8_t*)chunk, (size_t)length);
+
          if (!JSON_Parser_Parse(context.parser, chunk, length, JSON_False))
          {
             /* Note: Chunk may not be null-terminated.
@@ -2080,6 +3145,10 @@ static bool playlist_read_file(
          goto json_cleanup;
       }
 
+      /* Journal records apply to this exact file */
+      playlist->journal.base_crc   = context.crc;
+      playlist->journal.base_valid = true;
+
 json_cleanup:
 
       JSON_Parser_Free(context.parser);
@@ -2310,6 +3379,9 @@ bool playlist_init_cached(const char *path, size_t size)
 playlist_t *playlist_init(const char *path, size_t size)
 {
    struct playlist_entry *entries = NULL;
+#ifdef RARCH_INTERNAL
+   settings_t            *settings = config_get_ptr();
+#endif
    playlist_t           *playlist = (playlist_t*)malloc(sizeof(*playlist));
    if (!playlist)
       return NULL;
@@ -2331,9 +3403,26 @@ playlist_t *playlist_init(const char *path, size_t size)
    playlist->label_display_mode   = LABEL_DISPLAY_MODE_DEFAULT;
    playlist->right_thumbnail_mode = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
    playlist->left_thumbnail_mode  = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
+   playlist->index                = NULL;
+   playlist->index_buckets        = 0;
+   playlist->index_count          = 0;
 
+   memset(&playlist->journal, 0, sizeof(playlist->journal));
+#ifdef RARCH_INTERNAL
+   playlist->journal.enabled      = settings
+      && settings->bools.playlist_use_journal
+      && !settings->bools.playlist_use_old_format;
+#endif
+
+   playlist_recover_tmp_file(path);
    playlist_read_file(playlist, path);
 
+   /* Changes journalled since the playlist file was
+    * last written are replayed even with journalling
+    * disabled, the next write merges them */
+   if (playlist->journal.base_valid)
+      playlist_journal_replay(playlist);
+
    return playlist;
 }
 
@@ -2419,6 +3508,10 @@ void playlist_qsort(playlist_t *playlist)
    qsort(playlist->entries, playlist->size,
          sizeof(struct playlist_entry),
          (int (*)(const void *, const void *))playlist_qsort_func);
+
+   /* Every entry may have moved, rebuild on next lookup */
+   playlist_index_free(playlist);
+   playlist_journal_rewrite(playlist);
 }
 
 void command_playlist_push_write(
@@ -2562,6 +3655,7 @@ void playlist_set_default_core_path(playlist_t *playlist, const char *core_path)
          free(playlist->default_core_path);
       playlist->default_core_path = strdup(real_core_path);
       playlist->modified = true;
+      playlist_journal_rewrite(playlist);
    }
 }
 
@@ -2576,6 +3670,7 @@ void playlist_set_default_core_name(playlist_t *playlist, const char *core_name)
          free(playlist->default_core_name);
       playlist->default_core_name = strdup(core_name);
       playlist->modified = true;
+      playlist_journal_rewrite(playlist);
    }
 }
 
@@ -2587,6 +3682,7 @@ void playlist_set_label_display_mode(playlist_t *playlist, enum playlist_label_d
    if (playlist->label_display_mode != label_display_mode) {
       playlist->label_display_mode = label_display_mode;
       playlist->modified = true;
+      playlist_journal_rewrite(playlist);
    }
 }
 
@@ -2600,10 +3696,12 @@ void playlist_set_thumbnail_mode(
    {
       playlist->right_thumbnail_mode = thumbnail_mode;
       playlist->modified = true;
+      playlist_journal_rewrite(playlist);
    }
    else if (thumbnail_id == PLAYLIST_THUMBNAIL_LEFT)
    {
       playlist->left_thumbnail_mode = thumbnail_mode;
       playlist->modified = true;
+      playlist_journal_rewrite(playlist);
    }
 }
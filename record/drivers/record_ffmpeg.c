@@ -26,6 +26,7 @@
 #include <boolean.h>
 #include <queues/fifo_queue.h>
 #include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
 #include <gfx/scaler/scaler.h>
 #include <gfx/video_frame.h>
 #include <file/config_file.h>
@@ -131,8 +132,6 @@ struct ff_video_info
    AVCodecContext *codec;
    AVCodec *encoder;
 
-   AVFrame *conv_frame;
-   uint8_t *conv_frame_buf;
    int64_t frame_cnt;
 
    uint8_t *outbuf;
@@ -227,6 +226,57 @@ struct ff_config_param
    AVDictionary *audio_opts;
 };
 
+/* Frames in flight between the emulator and the encoder. */
+#define FF_POOL_FRAMES 8
+/* Dupes and drops don't take a pool frame, so leave room for them. */
+#define FF_ENCODE_QUEUE_SIZE 32
+#define FF_MAX_CONVERT_THREADS 4
+/* Encoded frames between two queue depth reports. */
+#define FF_STATS_INTERVAL 600
+
+/* A video frame on its way through the recording pipeline.
+ *
+ * ffmpeg_push_video() copies the input into a free frame once,
+ * unless the frontend read it back into the frame it was lent
+ * (see ffmpeg_get_video_buffer()). A conversion thread then scales
+ * it into conv_frame, and the encoder thread encodes it. Dupes
+ * queue the frame they repeat again, so frames are reference
+ * counted and only go back to the pool when nothing refers to
+ * them anymore. */
+struct ff_frame
+{
+   struct record_video_data attr;
+   uint8_t *input;
+
+   AVFrame *conv_frame;
+   uint8_t *conv_frame_buf;
+
+   unsigned refs;
+   bool converted;
+
+   /* Next frame in the free list or the conversion queue. */
+   struct ff_frame *next;
+};
+
+/* Queue depths and drops since the last report. */
+struct ff_queue_stats
+{
+   unsigned convert_peak;
+   unsigned encode_peak;
+   unsigned dropped;
+};
+
+struct ff_convert_thread
+{
+   struct ffmpeg *handle;
+   sthread_t *thread;
+
+   /* Scalers keep state between frames, so every
+    * thread has its own. */
+   struct scaler_ctx scaler;
+   struct SwsContext *sws;
+};
+
 typedef struct ffmpeg
 {
    struct ff_video_info video;
@@ -236,16 +286,48 @@ typedef struct ffmpeg
 
    struct record_params params;
 
-   scond_t *cond;
-   slock_t *cond_lock;
+   /* Protects everything below. Nothing is converted, copied
+    * or encoded while holding it. */
    slock_t *lock;
+   /* A frame was queued for conversion. */
+   scond_t *cond_convert;
+   /* The encoder thread may have something to do. */
+   scond_t *cond_encode;
+   /* A pool frame, encode queue slot or audio FIFO space was freed. */
+   scond_t *cond_free;
+
    fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
+
+   struct ff_frame frames[FF_POOL_FRAMES];
+   struct ff_frame *free_frames;
+   /* The frame dupes repeat. Holds a reference. */
+   struct ff_frame *last_frame;
+   /* Taken out of the pool for the frontend to read back into. */
+   struct ff_frame *lent_frame;
+   size_t input_size;
+
+   struct ff_frame *convert_first;
+   struct ff_frame *convert_last;
+   unsigned convert_count;
+
+   /* Frames in the order they are encoded, each holding
+    * a reference. NULL stands for a dropped frame. */
+   struct ff_frame *encode_queue[FF_ENCODE_QUEUE_SIZE];
+   unsigned encode_first;
+   unsigned encode_count;
+
+   struct ff_convert_thread convert_threads[FF_MAX_CONVERT_THREADS];
+   unsigned convert_thread_count;
+   /* Encodes and muxes */
    sthread_t *thread;
 
-   volatile bool alive;
-   volatile bool can_sleep;
+   /* Logged every FF_STATS_INTERVAL encoded frames, and
+    * in total when recording ends. */
+   struct ff_queue_stats stats;
+   struct ff_queue_stats stats_total;
+   unsigned stats_frames;
+
+   bool alive;
 } ffmpeg_t;
 
 AVFormatContext *ctx;
@@ -423,7 +505,6 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
 
 static bool ffmpeg_init_video(ffmpeg_t *handle)
 {
-   size_t size;
    struct ff_config_param *params  = &handle->config;
    struct ff_video_info *video     = &handle->video;
    struct record_params *param     = &handle->params;
@@ -545,18 +626,6 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
 
    video->frame_drop_ratio = params->frame_drop_ratio;
 
-   size = avpicture_get_size(video->pix_fmt, param->out_width,
-         param->out_height);
-   video->conv_frame_buf = (uint8_t*)av_malloc(size);
-   video->conv_frame = av_frame_alloc();
-
-   avpicture_fill((AVPicture*)video->conv_frame, video->conv_frame_buf,
-         video->pix_fmt, param->out_width, param->out_height);
-
-   video->conv_frame->width  = param->out_width;
-   video->conv_frame->height = param->out_height;
-   video->conv_frame->format = video->pix_fmt;
-
    return true;
 }
 
@@ -913,71 +982,181 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
    return avformat_write_header(handle->muxer.ctx, NULL) >= 0;
 }
 
-#define MAX_FRAMES 32
-
 static void ffmpeg_thread(void *data);
+static void ffmpeg_convert_thread(void *data);
+
+static bool init_frames(ffmpeg_t *handle)
+{
+   unsigned i;
+   size_t conv_size  = avpicture_get_size(handle->video.pix_fmt,
+         handle->params.out_width, handle->params.out_height);
+
+   handle->input_size = handle->params.fb_width * handle->params.fb_height *
+      handle->video.pix_size;
+
+   for (i = 0; i < FF_POOL_FRAMES; i++)
+   {
+      struct ff_frame *frame = &handle->frames[i];
+
+      frame->input           = (uint8_t*)av_malloc(handle->input_size);
+      frame->conv_frame_buf  = (uint8_t*)av_malloc(conv_size);
+      frame->conv_frame      = av_frame_alloc();
+
+      if (!frame->input || !frame->conv_frame_buf || !frame->conv_frame)
+         return false;
+
+      avpicture_fill((AVPicture*)frame->conv_frame, frame->conv_frame_buf,
+            handle->video.pix_fmt, handle->params.out_width,
+            handle->params.out_height);
+
+      frame->conv_frame->width  = handle->params.out_width;
+      frame->conv_frame->height = handle->params.out_height;
+      frame->conv_frame->format = handle->video.pix_fmt;
+
+      frame->next               = handle->free_frames;
+      handle->free_frames       = frame;
+   }
+
+   return true;
+}
+
+/* Enough audio for as much video as the encode queue holds, so
+ * audio never blocks the emulator before video does. The encoder
+ * takes whole codec frames, which must fit as well. */
+static size_t ffmpeg_audio_fifo_size(ffmpeg_t *handle)
+{
+   double fps     = handle->params.fps > 0.0 ? handle->params.fps : 60.0;
+   size_t frames  = (size_t)(handle->params.samplerate *
+         FF_ENCODE_QUEUE_SIZE * handle->video.frame_drop_ratio / fps);
+
+   if (handle->config.audio_enable &&
+         frames < 2 * (size_t)handle->audio.codec->frame_size)
+      frames = 2 * (size_t)handle->audio.codec->frame_size;
+
+   return frames * handle->params.channels * sizeof(int16_t);
+}
 
 static bool init_thread(ffmpeg_t *handle)
 {
-   handle->lock = slock_new();
-   handle->cond_lock = slock_new();
-   handle->cond = scond_new();
-   handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
-         handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct record_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
+   unsigned i;
+   unsigned threads = cpu_features_get_core_amount();
+
+   if (!init_frames(handle))
+      return false;
+
+   handle->audio_fifo = fifo_new(ffmpeg_audio_fifo_size(handle));
+   if (!handle->audio_fifo)
+      return false;
+
+   handle->lock         = slock_new();
+   handle->cond_convert = scond_new();
+   handle->cond_encode  = scond_new();
+   handle->cond_free    = scond_new();
+
+   if (!handle->lock || !handle->cond_convert ||
+         !handle->cond_encode || !handle->cond_free)
+      return false;
 
    handle->alive = true;
-   handle->can_sleep = true;
-   handle->thread = sthread_create(ffmpeg_thread, handle);
 
-   retro_assert(handle->lock && handle->cond_lock &&
-      handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+   /* Leave a core for the emulator and one for the encoder. */
+   threads = threads > 2 ? threads - 2 : 1;
+   if (threads > FF_MAX_CONVERT_THREADS)
+      threads = FF_MAX_CONVERT_THREADS;
 
-   return true;
+   for (i = 0; i < threads; i++)
+   {
+      struct ff_convert_thread *thr = &handle->convert_threads[i];
+
+      thr->handle         = handle;
+      thr->scaler.in_fmt  = handle->video.scaler.in_fmt;
+      thr->scaler.out_fmt = handle->video.scaler.out_fmt;
+      thr->thread         = sthread_create(ffmpeg_convert_thread, thr);
+
+      handle->convert_thread_count++;
+
+      if (!thr->thread)
+         return false;
+   }
+
+   handle->thread = sthread_create(ffmpeg_thread, handle);
+
+   return handle->thread != NULL;
 }
 
 static void deinit_thread(ffmpeg_t *handle)
 {
-   if (!handle->thread)
+   unsigned i;
+
+   if (!handle->lock)
       return;
 
-   slock_lock(handle->cond_lock);
+   slock_lock(handle->lock);
    handle->alive = false;
-   handle->can_sleep = false;
-   slock_unlock(handle->cond_lock);
+   if (handle->cond_convert)
+      scond_broadcast(handle->cond_convert);
+   if (handle->cond_encode)
+      scond_signal(handle->cond_encode);
+   slock_unlock(handle->lock);
+
+   for (i = 0; i < handle->convert_thread_count; i++)
+   {
+      struct ff_convert_thread *thr = &handle->convert_threads[i];
 
-   scond_signal(handle->cond);
-   sthread_join(handle->thread);
+      if (thr->thread)
+         sthread_join(thr->thread);
 
-   slock_free(handle->lock);
-   slock_free(handle->cond_lock);
-   scond_free(handle->cond);
+      scaler_ctx_gen_reset(&thr->scaler);
+      if (thr->sws)
+         sws_freeContext(thr->sws);
+   }
+
+   handle->convert_thread_count = 0;
 
-   handle->thread = NULL;
+   if (handle->thread)
+      sthread_join(handle->thread);
+
+   slock_free(handle->lock);
+   scond_free(handle->cond_convert);
+   scond_free(handle->cond_encode);
+   scond_free(handle->cond_free);
+
+   handle->lock         = NULL;
+   handle->cond_convert = NULL;
+   handle->cond_encode  = NULL;
+   handle->cond_free    = NULL;
+   handle->thread       = NULL;
 }
 
 static void deinit_thread_buf(ffmpeg_t *handle)
 {
+   unsigned i;
+
    if (handle->audio_fifo)
    {
       fifo_free(handle->audio_fifo);
       handle->audio_fifo = NULL;
    }
 
-   if (handle->attr_fifo)
+   for (i = 0; i < FF_POOL_FRAMES; i++)
    {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
-   }
+      struct ff_frame *frame = &handle->frames[i];
 
-   if (handle->video_fifo)
-   {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
+      av_frame_free(&frame->conv_frame);
+      av_free(frame->conv_frame_buf);
+      av_free(frame->input);
+
+      frame->conv_frame_buf  = NULL;
+      frame->input           = NULL;
    }
+
+   handle->free_frames   = NULL;
+   handle->last_frame    = NULL;
+   handle->lent_frame    = NULL;
+   handle->convert_first = NULL;
+   handle->convert_last  = NULL;
+   handle->convert_count = 0;
+   handle->encode_count  = 0;
 }
 
 static void ffmpeg_free(void *data)
@@ -1003,9 +1182,6 @@ static void ffmpeg_free(void *data)
       av_free(handle->video.codec);
    }
 
-   av_frame_free(&handle->video.conv_frame);
-   av_free(handle->video.conv_frame_buf);
-
    scaler_ctx_gen_reset(&handle->video.scaler);
 
    if (handle->video.sws)
@@ -1073,14 +1249,127 @@ error:
    return NULL;
 }
 
+/* Must be called with handle->lock held. */
+static void ffmpeg_frame_release(ffmpeg_t *handle, struct ff_frame *frame)
+{
+   if (--frame->refs)
+      return;
+
+   frame->next         = handle->free_frames;
+   handle->free_frames = frame;
+   scond_signal(handle->cond_free);
+}
+
+/* Must be called with handle->lock held and a free slot
+ * in the encode queue. A NULL frame is a dropped one. */
+static void ffmpeg_queue_encode(ffmpeg_t *handle, struct ff_frame *frame)
+{
+   unsigned index = (handle->encode_first + handle->encode_count)
+      % FF_ENCODE_QUEUE_SIZE;
+
+   if (frame)
+      frame->refs++;
+   handle->encode_queue[index] = frame;
+   handle->encode_count++;
+
+   if (handle->encode_count > handle->stats.encode_peak)
+      handle->stats.encode_peak = handle->encode_count;
+
+   scond_signal(handle->cond_encode);
+}
+
+/* Must be called with handle->lock held. */
+static void ffmpeg_queue_convert(ffmpeg_t *handle, struct ff_frame *frame)
+{
+   frame->next = NULL;
+
+   if (handle->convert_last)
+      handle->convert_last->next = frame;
+   else
+      handle->convert_first      = frame;
+   handle->convert_last          = frame;
+   handle->convert_count++;
+
+   if (handle->convert_count > handle->stats.convert_peak)
+      handle->stats.convert_peak = handle->convert_count;
+
+   scond_signal(handle->cond_convert);
+}
+
+/* Must be called with handle->lock held. Returns the stats
+ * since the last call, and adds them to the totals. */
+static struct ff_queue_stats ffmpeg_take_stats(ffmpeg_t *handle)
+{
+   struct ff_queue_stats stats = handle->stats;
+   struct ff_queue_stats *total = &handle->stats_total;
+
+   if (stats.convert_peak > total->convert_peak)
+      total->convert_peak = stats.convert_peak;
+   if (stats.encode_peak > total->encode_peak)
+      total->encode_peak  = stats.encode_peak;
+   total->dropped        += stats.dropped;
+
+   memset(&handle->stats, 0, sizeof(handle->stats));
+   handle->stats_frames = 0;
+
+   return stats;
+}
+
+static void ffmpeg_log_stats(const struct ff_queue_stats *stats,
+      const char *when)
+{
+   if (stats->dropped)
+      RARCH_WARN("[FFmpeg]: Dropped %u frames %s, every pool frame "
+            "was in use. Peak queue depths: conversion %u, encoding %u/%u.\n",
+            stats->dropped, when, stats->convert_peak,
+            stats->encode_peak, FF_ENCODE_QUEUE_SIZE);
+   else
+      RARCH_LOG("[FFmpeg]: Peak queue depths %s: conversion %u, "
+            "encoding %u/%u.\n",
+            when, stats->convert_peak,
+            stats->encode_peak, FF_ENCODE_QUEUE_SIZE);
+}
+
+/* Lends a pool frame's input buffer to the frontend, which reads the
+ * next frame back into it instead of into its own buffer. Passing that
+ * frame to ffmpeg_push_video() then hands it over without a copy. The
+ * frame stays lent until it is pushed, so asking again returns the
+ * same buffer. Returns NULL if every pool frame is in use. */
+static void *ffmpeg_get_video_buffer(void *data, size_t size)
+{
+   uint8_t *buf     = NULL;
+   ffmpeg_t *handle = (ffmpeg_t*)data;
+
+   if (!handle || size > handle->input_size)
+      return NULL;
+
+   slock_lock(handle->lock);
+
+   if (!handle->lent_frame && handle->free_frames)
+   {
+      handle->lent_frame  = handle->free_frames;
+      handle->free_frames = handle->lent_frame->next;
+   }
+
+   if (handle->lent_frame)
+      buf = handle->lent_frame->input;
+
+   slock_unlock(handle->lock);
+
+   return buf;
+}
+
 static bool ffmpeg_push_video(void *data,
       const struct record_video_data *vid)
 {
    unsigned y;
    bool drop_frame;
-   struct record_video_data attr_data;
-   ffmpeg_t *handle = (ffmpeg_t*)data;
-   int       offset = 0;
+   size_t pitch;
+   const uint8_t *src     = NULL;
+   uint8_t *dst           = NULL;
+   struct ff_frame *frame = NULL;
+   bool lent              = false;
+   ffmpeg_t *handle       = (ffmpeg_t*)data;
 
    if (!handle || !vid)
       return false;
@@ -1093,52 +1382,85 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
-   for (;;)
+   slock_lock(handle->lock);
+
+   /* Only block if the encoder is a whole queue behind. */
+   while (handle->alive && handle->encode_count == FF_ENCODE_QUEUE_SIZE)
+      scond_wait(handle->cond_free, handle->lock);
+
+   if (!handle->alive)
    {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
       slock_unlock(handle->lock);
+      return false;
+   }
 
-      if (!handle->alive)
-         return false;
-
-      if (avail >= sizeof(*vid))
-         break;
+   if (vid->is_dupe)
+   {
+      if (handle->last_frame)
+         ffmpeg_queue_encode(handle, handle->last_frame);
+      slock_unlock(handle->lock);
+      return true;
+   }
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
+   src = (const uint8_t*)vid->data;
 
-      slock_unlock(handle->cond_lock);
+   if (     handle->lent_frame
+         && src >= handle->lent_frame->input
+         && src <  handle->lent_frame->input + handle->input_size)
+   {
+      frame              = handle->lent_frame;
+      handle->lent_frame = NULL;
+      lent               = true;
+   }
+   else if (handle->free_frames)
+   {
+      frame               = handle->free_frames;
+      handle->free_frames = frame->next;
+   }
+   else
+   {
+      /* Every pool frame is in use. Rather than stalling the
+       * emulator, drop this one. The encoder skips its timestamp,
+       * so A/V sync holds. */
+      ffmpeg_queue_encode(handle, NULL);
+      handle->stats.dropped++;
+      slock_unlock(handle->lock);
+      return true;
    }
 
-   slock_lock(handle->lock);
+   slock_unlock(handle->lock);
 
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
-   attr_data = *vid;
+   frame->attr = *vid;
 
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
-   else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
+   /* The frame is ours until it is queued, so fill it in without
+    * the lock. Tightly pack it, libretro tends to use a very
+    * large pitch. */
+   if (!lent)
+   {
+      pitch = vid->width * handle->video.pix_size;
+      dst   = frame->input;
+
+      for (y = 0; y < vid->height; y++, src += vid->pitch, dst += pitch)
+         memcpy(dst, src, pitch);
+
+      frame->attr.data  = frame->input;
+      frame->attr.pitch = (int)pitch;
+   }
+
+   frame->converted  = false;
+   /* Held as last_frame */
+   frame->refs       = 1;
 
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   slock_lock(handle->lock);
+
+   if (handle->last_frame)
+      ffmpeg_frame_release(handle, handle->last_frame);
+   handle->last_frame = frame;
 
-   for (y = 0; y < attr_data.height; y++, offset += vid->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)vid->data + offset, attr_data.pitch);
+   ffmpeg_queue_encode(handle, frame);
+   ffmpeg_queue_convert(handle, frame);
 
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -1146,6 +1468,7 @@ static bool ffmpeg_push_video(void *data,
 static bool ffmpeg_push_audio(void *data,
       const struct record_audio_data *audio_data)
 {
+   size_t size;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !audio_data)
@@ -1154,38 +1477,23 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
-
-      if (!handle->alive)
-         return false;
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
 
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
-         break;
+   slock_lock(handle->lock);
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
+   while (handle->alive && fifo_write_avail(handle->audio_fifo) < size)
+      scond_wait(handle->cond_free, handle->lock);
 
-      slock_unlock(handle->cond_lock);
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
    }
 
-   slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
+   fifo_write(handle->audio_fifo, audio_data->data, size);
+   scond_signal(handle->cond_encode);
+
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -1226,35 +1534,44 @@ static bool encode_video(ffmpeg_t *handle, AVPacket *pkt, AVFrame *frame)
 }
 
 static void ffmpeg_scale_input(ffmpeg_t *handle,
-      const struct record_video_data *vid)
+      struct scaler_ctx *scaler, struct SwsContext **sws,
+      struct ff_frame *frame)
 {
+   const struct record_video_data *vid = &frame->attr;
+   AVFrame *conv_frame                 = frame->conv_frame;
    /* Attempt to preserve more information if we scale down. */
    bool shrunk = handle->params.out_width < vid->width
       || handle->params.out_height < vid->height;
 
+   /* Frames read back into a lent buffer are bottom-up, with a
+    * negative pitch. The scaler only picks up a new pitch along
+    * with a new size. */
+   if (scaler->in_stride != vid->pitch)
+      scaler->in_width = 0;
+
    if (handle->video.use_sws)
    {
       int linesize = vid->pitch;
 
-      handle->video.sws = sws_getCachedContext(handle->video.sws,
+      *sws = sws_getCachedContext(*sws,
             vid->width, vid->height, handle->video.in_pix_fmt,
             handle->params.out_width, handle->params.out_height,
             handle->video.pix_fmt,
             shrunk ? SWS_BILINEAR : SWS_POINT, NULL, NULL, NULL);
 
-      sws_scale(handle->video.sws, (const uint8_t* const*)&vid->data,
-            &linesize, 0, vid->height, handle->video.conv_frame->data,
-            handle->video.conv_frame->linesize);
+      sws_scale(*sws, (const uint8_t* const*)&vid->data,
+            &linesize, 0, vid->height, conv_frame->data,
+            conv_frame->linesize);
    }
    else
    {
       video_frame_record_scale(
-            &handle->video.scaler,
-            handle->video.conv_frame->data[0],
+            scaler,
+            conv_frame->data[0],
             vid->data,
             handle->params.out_width,
             handle->params.out_height,
-            handle->video.conv_frame->linesize[0],
+            conv_frame->linesize[0],
             vid->width,
             vid->height,
             vid->pitch,
@@ -1263,16 +1580,13 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
 }
 
 static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
-      const struct record_video_data *vid)
+      struct ff_frame *frame)
 {
    AVPacket pkt;
 
-   if (!vid->is_dupe)
-      ffmpeg_scale_input(handle, vid);
+   frame->conv_frame->pts = handle->video.frame_cnt;
 
-   handle->video.conv_frame->pts = handle->video.frame_cnt;
-
-   if (!encode_video(handle, &pkt, handle->video.conv_frame))
+   if (!encode_video(handle, &pkt, frame->conv_frame))
       return false;
 
    if (pkt.size)
@@ -1554,8 +1868,6 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
    bool did_work;
-   void *video_buf = av_malloc(2 * handle->params.fb_width *
-         handle->params.fb_height * handle->video.pix_size);
    size_t audio_buf_size = handle->config.audio_enable ?
       (handle->audio.codec->frame_size *
        handle->params.channels * sizeof(int16_t)) : 0;
@@ -1568,8 +1880,6 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 
    do
    {
-      struct record_video_data attr_buf;
-
       did_work = false;
 
       if (handle->config.audio_enable)
@@ -1588,13 +1898,30 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
          }
       }
 
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
+      if (handle->encode_count)
       {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
+         struct ff_frame *frame =
+            handle->encode_queue[handle->encode_first];
+
+         handle->encode_first = (handle->encode_first + 1)
+            % FF_ENCODE_QUEUE_SIZE;
+         handle->encode_count--;
+
+         if (!frame)
+            handle->video.frame_cnt++;
+         else
+         {
+            /* The conversion threads are gone, so convert
+             * whatever they didn't get to here. */
+            if (!frame->converted)
+            {
+               ffmpeg_scale_input(handle, &handle->video.scaler,
+                     &handle->video.sws, frame);
+               frame->converted = true;
+            }
+
+            ffmpeg_push_video_thread(handle, frame);
+         }
 
          did_work = true;
       }
@@ -1607,7 +1934,6 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
@@ -1619,6 +1945,9 @@ static bool ffmpeg_finalize(void *data)
 
    deinit_thread(handle);
 
+   ffmpeg_take_stats(handle);
+   ffmpeg_log_stats(&handle->stats_total, "while recording");
+
    /* Flush out data still in buffers (internal, and FFmpeg internal). */
    ffmpeg_flush_buffers(handle);
 
@@ -1632,83 +1961,137 @@ static bool ffmpeg_finalize(void *data)
    return true;
 }
 
+static void ffmpeg_convert_thread(void *data)
+{
+   struct ff_convert_thread *thr = (struct ff_convert_thread*)data;
+   ffmpeg_t *ff                  = thr->handle;
+
+   slock_lock(ff->lock);
+
+   for (;;)
+   {
+      struct ff_frame *frame = NULL;
+
+      while (ff->alive && !ff->convert_first)
+         scond_wait(ff->cond_convert, ff->lock);
+
+      if (!ff->alive)
+         break;
+
+      frame             = ff->convert_first;
+      ff->convert_first = frame->next;
+      if (!ff->convert_first)
+         ff->convert_last = NULL;
+      ff->convert_count--;
+
+      slock_unlock(ff->lock);
+
+      ffmpeg_scale_input(ff, &thr->scaler, &thr->sws, frame);
+
+      slock_lock(ff->lock);
+
+      frame->converted = true;
+      scond_signal(ff->cond_encode);
+   }
+
+   slock_unlock(ff->lock);
+}
+
+/* Must be called with ff->lock held. */
+static bool ffmpeg_video_ready(ffmpeg_t *ff)
+{
+   struct ff_frame *frame;
+
+   if (!ff->encode_count)
+      return false;
+
+   frame = ff->encode_queue[ff->encode_first];
+   return !frame || frame->converted;
+}
+
 static void ffmpeg_thread(void *data)
 {
    size_t audio_buf_size;
    void *audio_buf = NULL;
    ffmpeg_t *ff    = (ffmpeg_t*)data;
-   /* For some reason, FFmpeg has a tendency to crash
-    * if we don't overallocate a bit. */
-   void *video_buf = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-
-   retro_assert(video_buf);
 
    audio_buf_size = ff->config.audio_enable ?
       (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
    audio_buf      = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
 
-   while (ff->alive)
-   {
-      struct record_video_data attr_buf;
+   slock_lock(ff->lock);
 
-      bool avail_video = false;
-      bool avail_audio = false;
+   for (;;)
+   {
+      struct ff_queue_stats stats;
+      struct ff_frame *frame = NULL;
+      bool avail_video       = false;
+      bool avail_audio       = false;
+      bool report            = false;
 
-      slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
+      while (ff->alive && !ffmpeg_video_ready(ff) &&
+            !(audio_buf && fifo_read_avail(ff->audio_fifo) >= audio_buf_size))
+         scond_wait(ff->cond_encode, ff->lock);
 
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
+      if (!ff->alive)
+         break;
 
-      if (!avail_video && !avail_audio)
+      /* Frames are encoded in the order they were pushed, no
+       * matter which conversion thread finishes first. */
+      if (ffmpeg_video_ready(ff))
       {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
+         frame            = ff->encode_queue[ff->encode_first];
+         ff->encode_first = (ff->encode_first + 1) % FF_ENCODE_QUEUE_SIZE;
+         ff->encode_count--;
+         avail_video      = true;
+
+         if (++ff->stats_frames == FF_STATS_INTERVAL)
          {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
+            stats  = ffmpeg_take_stats(ff);
+            report = true;
          }
-         else
-            scond_signal(ff->cond);
+      }
 
-         slock_unlock(ff->cond_lock);
+      if (audio_buf && fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
+      {
+         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
+         avail_audio = true;
       }
 
-      if (avail_video && video_buf)
+      scond_signal(ff->cond_free);
+      slock_unlock(ff->lock);
+
+      if (report)
       {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
+         char when[32];
+         snprintf(when, sizeof(when), "in the last %u frames",
+               FF_STATS_INTERVAL);
+         ffmpeg_log_stats(&stats, when);
       }
 
-      if (avail_audio && audio_buf)
+      if (frame)
+         ffmpeg_push_video_thread(ff, frame);
+      else if (avail_video)
+         ff->video.frame_cnt++;
+
+      if (avail_audio)
       {
          struct record_audio_data aud = {0};
 
-         slock_lock(ff->lock);
-         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
          aud.frames = ff->audio.codec->frame_size;
-         aud.data = audio_buf;
+         aud.data   = audio_buf;
 
          ffmpeg_push_audio_thread(ff, &aud, true);
       }
+
+      slock_lock(ff->lock);
+
+      if (frame)
+         ffmpeg_frame_release(ff, frame);
    }
 
-   av_free(video_buf);
+   slock_unlock(ff->lock);
+
    av_free(audio_buf);
 }
 
@@ -1718,5 +2101,6 @@ const record_driver_t record_ffmpeg = {
    ffmpeg_push_video,
    ffmpeg_push_audio,
    ffmpeg_finalize,
+   ffmpeg_get_video_buffer,
    "ffmpeg",
 };
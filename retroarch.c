@@ -1535,6 +1535,10 @@ static struct retro_system_av_info video_driver_av_info;
 /* AUDIO GLOBAL VARIABLES */
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 
+/* audio_driver_flush() takes this many frames at a time through
+ * every stage, so a block stays in L1 from conversion to output. */
+#define AUDIO_FLUSH_BLOCK_FRAMES        256
+
 #define MENU_SOUND_FORMATS "ogg|mod|xm|s3m|mp3|flac"
 
 /**
@@ -1576,6 +1580,7 @@ static size_t audio_driver_data_ptr                      = 0;
 static bool audio_driver_control                         = false;
 static bool audio_driver_mute_enable                     = false;
 static bool audio_driver_use_float                       = false;
+static bool audio_driver_write_direct                    = false;
 static bool audio_driver_active                          = false;
 
 static float audio_driver_rate_control_delta             = 0.0f;
@@ -1584,6 +1589,7 @@ static float audio_driver_volume_gain                    = 0.0f;
 
 static float *audio_driver_input_data                    = NULL;
 static float *audio_driver_output_samples_buf            = NULL;
+static float *audio_driver_block_buf                     = NULL;
 
 static double audio_source_ratio_original                = 0.0f;
 static double audio_source_ratio_current                 = 0.0f;
@@ -1640,6 +1646,14 @@ static bool runahead_available                  = true;
 static bool runahead_secondary_core_available   = true;
 static bool runahead_force_input_dirty          = true;
 static uint64_t runahead_last_frame_count       = 0;
+
+/* Single instance mode keeps the states of the frames it ran ahead in
+ * runahead_save_state_list[1..N], after the real state in [0].
+ * They were all run with the same input, and stay valid for as long
+ * as that input does. */
+static int runahead_snapshot_count              = 0;
+static uint64_t runahead_snapshot_frame         = 0;
+static uint32_t runahead_snapshot_input_hash    = 0;
 #endif
 
 /* INPUT REMOTE GLOBAL VARIABLES */
@@ -2151,6 +2165,27 @@ static bool command_version(const char* arg)
    return true;
 }
 
+/* Goes back the given number of frames in the rewind history,
+ * or as far as it reaches. */
+static bool command_rewind_seek(const char *arg)
+{
+   unsigned oldest = 0;
+   unsigned newest = 0;
+   unsigned frames = 0;
+
+   if (string_is_empty(arg))
+      return false;
+
+   if (!state_manager_frame_range(&oldest, &newest))
+      return false;
+
+   frames = (unsigned)strtoul(arg, NULL, 0);
+   if (frames > newest - oldest)
+      frames = newest - oldest;
+
+   return state_manager_seek(newest - frames);
+}
+
 #if defined(HAVE_CHEEVOS)
 static bool command_read_ram(const char *arg);
 static bool command_write_ram(const char *arg);
@@ -2159,6 +2194,7 @@ static bool command_write_ram(const char *arg);
 static const struct cmd_action_map action_map[] = {
    { "SET_SHADER",      command_set_shader,  "<shader path>" },
    { "VERSION",         command_version,     "No argument"},
+   { "REWIND_SEEK",     command_rewind_seek, "<number of frames back>" },
 #if defined(HAVE_CHEEVOS)
    { "READ_CORE_RAM",   command_read_ram,    "<address> <number of bytes>" },
    { "WRITE_CORE_RAM",  command_write_ram,   "<address> <byte1> <byte2> ..." },
@@ -5113,18 +5149,31 @@ TODO: Add a setting for these tweaks */
       case CMD_EVENT_CORE_INFO_INIT:
          {
             char ext_name[255];
+            char cache_dir[PATH_MAX_LENGTH];
             settings_t *settings      = configuration_settings;
 
             ext_name[0]               = '\0';
+            cache_dir[0]              = '\0';
 
             command_event(CMD_EVENT_CORE_INFO_DEINIT, NULL);
 
             if (!frontend_driver_get_core_extension(ext_name, sizeof(ext_name)))
                return false;
 
+            /* The info directory is often read-only, so the parsed
+             * info files are cached next to the config without
+             * a cache directory */
+            if (!string_is_empty(settings->paths.directory_cache))
+               strlcpy(cache_dir, settings->paths.directory_cache,
+                     sizeof(cache_dir));
+            else if (!path_is_empty(RARCH_PATH_CONFIG))
+               fill_pathname_basedir(cache_dir,
+                     path_get(RARCH_PATH_CONFIG), sizeof(cache_dir));
+
             if (!string_is_empty(settings->paths.directory_libretro))
                core_info_init_list(settings->paths.path_libretro_info,
                      settings->paths.directory_libretro,
+                     cache_dir,
                      ext_name,
                      settings->bools.show_hidden_files
                      );
@@ -6609,6 +6658,11 @@ void core_option_manager_set_val(core_option_manager_t *opt,
    option->index = val_idx % option->vals->size;
 
    opt->updated  = true;
+
+#ifdef HAVE_RUNAHEAD
+   /* The frames run ahead used the old value */
+   runahead_snapshot_count = 0;
+#endif
 }
 
 /**
@@ -6627,6 +6681,10 @@ void core_option_manager_set_default(core_option_manager_t *opt, size_t idx)
 
    opt->opts[idx].index = opt->opts[idx].default_index;
    opt->updated         = true;
+
+#ifdef HAVE_RUNAHEAD
+   runahead_snapshot_count = 0;
+#endif
 }
 
 static struct retro_core_option_definition *core_option_manager_get_definitions(
@@ -7190,6 +7248,13 @@ static void rarch_log_libretro(enum retro_log_level level,
    va_end(vp);
 }
 
+/* FMA and AVX512 are frontend-only bits, cores only get RETRO_SIMD_* */
+static uint64_t core_get_cpu_features(void)
+{
+   return cpu_features_get() & ~(uint64_t)(CPU_FEATURES_FMA
+         | CPU_FEATURES_AVX512);
+}
+
 static void core_performance_counter_start(struct retro_perf_counter *perf)
 {
    if (runloop_perfcnt_enable)
@@ -7880,7 +7945,7 @@ static bool rarch_environment_cb(unsigned cmd, void *data)
 
          RARCH_LOG("Environ GET_PERF_INTERFACE.\n");
          cb->get_time_usec    = cpu_features_get_time_usec;
-         cb->get_cpu_features = cpu_features_get;
+         cb->get_cpu_features = core_get_cpu_features;
          cb->get_perf_counter = cpu_features_get_perf_counter;
 
          cb->perf_register    = performance_counter_register;
@@ -9726,6 +9791,7 @@ static void recording_dump_frame(const void *data, unsigned width,
    if (video_driver_record_gpu_buffer)
    {
       struct video_viewport vp;
+      uint8_t *gpu_buffer         = video_driver_record_gpu_buffer;
 
       vp.x                        = 0;
       vp.y                        = 0;
@@ -9759,16 +9825,27 @@ static void recording_dump_frame(const void *data, unsigned width,
          return;
       }
 
+      /* Read straight into the driver's own frame if it
+       * lends one, so pushing it needs no copy. */
+      if (recording_driver->get_video_buffer)
+      {
+         uint8_t *lent = (uint8_t*)recording_driver->get_video_buffer(
+               recording_data,
+               recording_gpu_width * recording_gpu_height * 3);
+         if (lent)
+            gpu_buffer = lent;
+      }
+
       /* Big bottleneck.
        * Since we might need to do read-backs asynchronously,
        * it might take 3-4 times before this returns true. */
-      if (!video_driver_read_viewport(video_driver_record_gpu_buffer, is_idle))
+      if (!video_driver_read_viewport(gpu_buffer, is_idle))
          return;
 
       ffemu_data.pitch  = (int)(recording_gpu_width * 3);
       ffemu_data.width  = (unsigned)recording_gpu_width;
       ffemu_data.height = (unsigned)recording_gpu_height;
-      ffemu_data.data   = video_driver_record_gpu_buffer + (ffemu_data.height - 1) * ffemu_data.pitch;
+      ffemu_data.data   = gpu_buffer + (ffemu_data.height - 1) * ffemu_data.pitch;
 
       ffemu_data.pitch  = -ffemu_data.pitch;
    }
@@ -15859,6 +15936,10 @@ static bool audio_driver_deinit_internal(void)
       free(audio_driver_output_samples_buf);
    audio_driver_output_samples_buf = NULL;
 
+   if (audio_driver_block_buf)
+      free(audio_driver_block_buf);
+   audio_driver_block_buf          = NULL;
+
    audio_driver_dsp_filter_free();
    report_audio_buffer_statistics();
 
@@ -15930,12 +16011,15 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
    unsigned new_rate     = 0;
    float   *aud_inp_data = NULL;
    float *samples_buf    = NULL;
+   float *block_buf      = NULL;
    int16_t *rewind_buf   = NULL;
    size_t max_bufsamples = AUDIO_CHUNK_SIZE_NONBLOCKING * 2;
    settings_t *settings  = configuration_settings;
    /* Accomodate rewind since at some point we might have two full buffers. */
    size_t outsamples_max = AUDIO_CHUNK_SIZE_NONBLOCKING * 2 * AUDIO_MAX_RATIO *
       settings->floats.slowmotion_ratio;
+   size_t blocksamples_max = AUDIO_FLUSH_BLOCK_FRAMES * 2 * AUDIO_MAX_RATIO *
+      settings->floats.slowmotion_ratio;
    int16_t *conv_buf     = (int16_t*)malloc(outsamples_max
          * sizeof(int16_t));
 
@@ -16017,6 +16101,9 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
          && current_audio->use_float(audio_driver_context_audio_data))
       audio_driver_use_float = true;
 
+   audio_driver_write_direct = audio_driver_active
+      && current_audio->write_begin && current_audio->write_end;
+
    if (!settings->bools.audio_sync && audio_driver_active)
    {
       if (audio_driver_active && audio_driver_context_audio_data)
@@ -16047,7 +16134,8 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
       audio_driver_active = false;
    }
 
-   aud_inp_data = (float*)malloc(max_bufsamples * sizeof(float));
+   aud_inp_data = (float*)malloc(AUDIO_FLUSH_BLOCK_FRAMES * 2
+         * sizeof(float));
    retro_assert(aud_inp_data != NULL);
 
    if (!aud_inp_data)
@@ -16067,6 +16155,15 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
       goto error;
 
    audio_driver_output_samples_buf = samples_buf;
+
+   block_buf = (float*)malloc(blocksamples_max * sizeof(float));
+
+   retro_assert(block_buf != NULL);
+
+   if (!block_buf)
+      goto error;
+
+   audio_driver_block_buf          = block_buf;
    audio_driver_control            = false;
 
    if (
@@ -16109,51 +16206,128 @@ error:
 }
 
 /**
- * audio_driver_flush:
- * @data                 : pointer to audio buffer.
- * @right                : amount of samples to write.
+ * audio_driver_flush_output:
+ * @samples              : resampled and mixed float samples.
+ * @frames               : amount of frames in @samples.
+ * @staged               : amount of frames staged for write() so far.
  *
- * Writes audio samples to audio driver. Will first
- * perform DSP processing (if enabled) and resampling.
+ * Converts a block into the driver's own buffer when it lets us
+ * write there, and otherwise only stages it for write().
+ * Returns: amount of frames staged for write().
  **/
-static void audio_driver_flush(const int16_t *data, size_t samples,
-      bool is_slowmotion)
+static size_t audio_driver_flush_output(const float *samples, size_t frames,
+      size_t staged)
 {
-   struct resampler_data src_data;
-   float audio_volume_gain           = !audio_driver_mute_enable ?
-      audio_driver_volume_gain : 0.0f;
+   size_t frame_size = audio_driver_use_float
+      ? 2 * sizeof(float) : 2 * sizeof(int16_t);
 
-   src_data.data_out                 = NULL;
-   src_data.output_frames            = 0;
+   if (!audio_driver_write_direct)
+   {
+      /* Float output was resampled straight into the staging buffer */
+      if (!audio_driver_use_float)
+         convert_float_to_s16((int16_t*)audio_driver_output_samples_buf
+               + staged * 2, samples, frames * 2);
+      return staged + frames;
+   }
 
-   convert_s16_to_float(audio_driver_input_data, data, samples,
-         audio_volume_gain);
+   while (frames)
+   {
+      void *buf     = NULL;
+      ssize_t size  = current_audio->write_begin(
+            audio_driver_context_audio_data, &buf, frames * frame_size);
+      size_t  count = size > 0 ? (size_t)size / frame_size : 0;
 
-   src_data.data_in                  = audio_driver_input_data;
-   src_data.input_frames             = samples >> 1;
+      if (size < 0)
+      {
+         audio_driver_active = false;
+         break;
+      }
 
-   if (audio_driver_dsp)
-   {
-      struct retro_dsp_data dsp_data;
+      /* Nonblocking and full, drop the rest like write() would */
+      if (!count)
+         break;
 
-      dsp_data.input                 = NULL;
-      dsp_data.input_frames          = 0;
-      dsp_data.output                = NULL;
-      dsp_data.output_frames         = 0;
+      if (audio_driver_use_float)
+         memcpy(buf, samples, count * frame_size);
+      else
+         convert_float_to_s16((int16_t*)buf, samples, count * 2);
 
-      dsp_data.input                 = audio_driver_input_data;
-      dsp_data.input_frames          = (unsigned)(samples >> 1);
+      current_audio->write_end(audio_driver_context_audio_data,
+            count * frame_size);
 
-      retro_dsp_filter_process(audio_driver_dsp, &dsp_data);
+      samples += count * 2;
+      frames  -= count;
+   }
 
-      if (dsp_data.output)
-      {
-         src_data.data_in            = dsp_data.output;
-         src_data.input_frames       = dsp_data.output_frames;
-      }
+   return staged;
+}
+
+/**
+ * audio_driver_flush_block:
+ * @data                 : DSP filtered float samples.
+ * @frames               : amount of frames, at most AUDIO_FLUSH_BLOCK_FRAMES.
+ * @ratio                : resampling ratio.
+ * @staged               : amount of frames staged for write() so far.
+ *
+ * Resamples one block, mixes in the audio mixer and outputs it.
+ * Returns: amount of frames staged for write().
+ **/
+static size_t audio_driver_flush_block(const float *data, size_t frames,
+      double ratio, size_t staged)
+{
+   struct resampler_data src_data;
+
+   src_data.data_in       = data;
+   src_data.input_frames  = frames;
+   src_data.data_out      = audio_driver_block_buf;
+   src_data.output_frames = 0;
+   src_data.ratio         = ratio;
+
+   if (!audio_driver_write_direct && audio_driver_use_float)
+      src_data.data_out   = audio_driver_output_samples_buf + staged * 2;
+
+   audio_driver_resampler->process(audio_driver_resampler_data, &src_data);
+
+   if (!src_data.output_frames)
+      return staged;
+
+#ifdef HAVE_AUDIOMIXER
+   if (audio_mixer_active)
+   {
+      bool override     = audio_driver_mixer_mute_enable ? true :
+         (audio_driver_mixer_volume_gain != 1.0f) ? true : false;
+      float mixer_gain  = !audio_driver_mixer_mute_enable ?
+         audio_driver_mixer_volume_gain : 0.0f;
+      audio_mixer_mix(src_data.data_out,
+            src_data.output_frames, mixer_gain, override);
    }
+#endif
 
-   src_data.data_out = audio_driver_output_samples_buf;
+   return audio_driver_flush_output(src_data.data_out,
+         src_data.output_frames, staged);
+}
+
+/**
+ * audio_driver_flush:
+ * @data                 : pointer to audio buffer.
+ * @right                : amount of samples to write.
+ *
+ * Writes audio samples to audio driver. Will first
+ * perform DSP processing (if enabled) and resampling.
+ *
+ * Every stage runs on blocks of AUDIO_FLUSH_BLOCK_FRAMES
+ * frames rather than on the whole batch, so the samples
+ * are still in cache when the next stage reads them.
+ **/
+static void audio_driver_flush(const int16_t *data, size_t samples,
+      bool is_slowmotion)
+{
+   size_t i;
+   double ratio;
+   size_t frames                     = samples >> 1;
+   size_t staged                     = 0;
+   float audio_volume_gain           = !audio_driver_mute_enable ?
+      audio_driver_volume_gain : 0.0f;
 
    if (audio_driver_control)
    {
@@ -16184,42 +16358,64 @@ static void audio_driver_flush(const int16_t *data, size_t samples,
 #endif
    }
 
-   src_data.ratio           = audio_source_ratio_current;
+   ratio                    = audio_source_ratio_current;
 
    if (is_slowmotion)
-      src_data.ratio       *= configuration_settings->floats.slowmotion_ratio;
-
-   audio_driver_resampler->process(audio_driver_resampler_data, &src_data);
+      ratio                *= configuration_settings->floats.slowmotion_ratio;
 
-#ifdef HAVE_AUDIOMIXER
-   if (audio_mixer_active)
+   for (i = 0; i < frames && audio_driver_active;
+         i += AUDIO_FLUSH_BLOCK_FRAMES)
    {
-      bool override     = audio_driver_mixer_mute_enable ? true :
-         (audio_driver_mixer_volume_gain != 1.0f) ? true : false;
-      float mixer_gain  = !audio_driver_mixer_mute_enable ?
-         audio_driver_mixer_volume_gain : 0.0f;
-      audio_mixer_mix(audio_driver_output_samples_buf,
-            src_data.output_frames, mixer_gain, override);
-   }
-#endif
+      const float *block  = audio_driver_input_data;
+      size_t block_frames = frames - i;
 
-   {
-      const void *output_data = audio_driver_output_samples_buf;
-      unsigned output_frames  = (unsigned)src_data.output_frames;
+      if (block_frames > AUDIO_FLUSH_BLOCK_FRAMES)
+         block_frames     = AUDIO_FLUSH_BLOCK_FRAMES;
 
-      if (audio_driver_use_float)
-         output_frames  *= sizeof(float);
-      else
+      convert_s16_to_float(audio_driver_input_data, data + i * 2,
+            block_frames * 2, audio_volume_gain);
+
+      if (audio_driver_dsp)
       {
-         convert_float_to_s16(audio_driver_output_samples_conv_buf,
-               (const float*)output_data, output_frames * 2);
+         struct retro_dsp_data dsp_data;
+
+         dsp_data.input             = audio_driver_input_data;
+         dsp_data.input_frames      = (unsigned)block_frames;
+         dsp_data.output            = NULL;
+         dsp_data.output_frames     = 0;
 
-         output_data     = audio_driver_output_samples_conv_buf;
-         output_frames  *= sizeof(int16_t);
+         retro_dsp_filter_process(audio_driver_dsp, &dsp_data);
+
+         if (dsp_data.output)
+         {
+            block                   = dsp_data.output;
+            block_frames            = dsp_data.output_frames;
+         }
       }
 
+      /* Filters that work on blocks of their own, like the
+       * equalizer, can hand back more than they were given. */
+      while (block_frames)
+      {
+         size_t count = block_frames;
+
+         if (count > AUDIO_FLUSH_BLOCK_FRAMES)
+            count     = AUDIO_FLUSH_BLOCK_FRAMES;
+
+         staged        = audio_driver_flush_block(block, count,
+               ratio, staged);
+         block        += count * 2;
+         block_frames -= count;
+      }
+   }
+
+   if (staged)
+   {
+      size_t size = staged * 2 * (audio_driver_use_float
+            ? sizeof(float) : sizeof(int16_t));
+
       if (current_audio->write(audio_driver_context_audio_data,
-               output_data, output_frames * 2) < 0)
+               audio_driver_output_samples_buf, size) < 0)
          audio_driver_active = false;
    }
 }
@@ -16975,7 +17171,15 @@ void audio_driver_mixer_stop_stream(unsigned i)
       audio_mixer_voice_t *voice     = audio_mixer_streams[i].voice;
 
       if (voice)
+      {
+         unsigned underruns = audio_mixer_voice_get_underruns(voice);
+
+         if (underruns)
+            RARCH_LOG("[Audio]: Mixer stream %u ran out of decoded audio %u times.\n",
+                  i, underruns);
+
          audio_mixer_stop(voice);
+      }
       audio_mixer_streams[i].state   = AUDIO_STREAM_STATE_STOPPED;
       audio_mixer_streams[i].volume  = 1.0f;
    }
@@ -20934,16 +21138,19 @@ static int16_t input_state_with_logging(unsigned port,
    return 0;
 }
 
+/* A reset or a loaded state invalidates the frames run ahead */
 static void reset_hook(void)
 {
-   input_is_dirty = true;
+   input_is_dirty          = true;
+   runahead_snapshot_count = 0;
    if (retro_reset_callback_original)
       retro_reset_callback_original();
 }
 
 static bool unserialize_hook(const void *buf, size_t size)
 {
-   input_is_dirty = true;
+   input_is_dirty          = true;
+   runahead_snapshot_count = 0;
    if (retro_unserialize_callback_original)
       return retro_unserialize_callback_original(buf, size);
    return false;
@@ -21034,7 +21241,6 @@ static void runahead_save_state_list_init(size_t saveStateSize)
          runahead_save_state_alloc, runahead_save_state_free);
 }
 
-#if 0
 static void runahead_save_state_list_rotate(void)
 {
    unsigned i;
@@ -21047,7 +21253,6 @@ static void runahead_save_state_list_rotate(void)
    runahead_save_state_list->data[runahead_save_state_list->size - 1] =
       firstElement;
 }
-#endif
 
 /* Hooks - Hooks to cleanup, and add dirty input hooks */
 static void runahead_remove_hooks(void)
@@ -21075,6 +21280,7 @@ static void runahead_clear_variables(void)
    runahead_secondary_core_available = true;
    runahead_force_input_dirty        = true;
    runahead_last_frame_count         = 0;
+   runahead_snapshot_count           = 0;
 }
 
 static void runahead_destroy(void)
@@ -21128,6 +21334,7 @@ static void runahead_error(void)
    runahead_remove_hooks();
    runahead_save_state_size       = 0;
    runahead_save_state_size_known = true;
+   runahead_snapshot_count        = 0;
 }
 
 static bool runahead_create(void)
@@ -21153,7 +21360,7 @@ static bool runahead_create(void)
    return true;
 }
 
-static bool runahead_save_state(void)
+static bool runahead_save_state(int index)
 {
    retro_ctx_serialize_info_t *serialize_info;
    bool okay                                  = false;
@@ -21162,7 +21369,7 @@ static bool runahead_save_state(void)
       return false;
 
    serialize_info         =
-      (retro_ctx_serialize_info_t*)runahead_save_state_list->data[0];
+      (retro_ctx_serialize_info_t*)runahead_save_state_list->data[index];
 
    request_fast_savestate = true;
    okay                   = core_serialize(serialize_info);
@@ -21175,12 +21382,13 @@ static bool runahead_save_state(void)
    return false;
 }
 
-static bool runahead_load_state(void)
+static bool runahead_load_state(int index)
 {
    bool okay                                  = false;
    retro_ctx_serialize_info_t *serialize_info = (retro_ctx_serialize_info_t*)
-      runahead_save_state_list->data[0];
+      runahead_save_state_list->data[index];
    bool last_dirty                            = input_is_dirty;
+   int last_snapshot_count                    = runahead_snapshot_count;
 
    request_fast_savestate                     = true;
    /* calling core_unserialize has side effects with
@@ -21189,8 +21397,9 @@ static bool runahead_load_state(void)
    okay = current_core.retro_unserialize(
          serialize_info->data_const, serialize_info->size);
 
-   request_fast_savestate = false;
-   input_is_dirty         = last_dirty;
+   request_fast_savestate  = false;
+   input_is_dirty          = last_dirty;
+   runahead_snapshot_count = last_snapshot_count;
 
    if (!okay)
       runahead_error();
@@ -21254,11 +21463,143 @@ static bool runahead_core_run_use_last_input(void)
    return true;
 }
 
+/* Hashes the last input the core has read. */
+static uint32_t runahead_input_hash(void)
+{
+   int i;
+   uint32_t hash = 5381;
+
+   if (!input_state_list)
+      return hash;
+
+   for (i = 0; i < input_state_list->size; i++)
+   {
+      unsigned j;
+      input_list_element *element =
+         (input_list_element*)input_state_list->data[i];
+
+      hash = hash * 33 + element->port;
+      hash = hash * 33 + element->device;
+      hash = hash * 33 + element->index;
+
+      for (j = 0; j < element->state_size; j++)
+         hash = hash * 33 + (uint16_t)element->state[j];
+   }
+
+   return hash;
+}
+
+/* Runs frames ahead with the last input, saving each one to
+ * runahead_save_state_list[first..runahead_count]; only the
+ * last frame is presented. */
+static bool runahead_run_ahead(int first, int runahead_count)
+{
+   int frame_number;
+
+   for (frame_number = first; frame_number <= runahead_count; frame_number++)
+   {
+      bool suspended_frame = frame_number != runahead_count;
+
+      if (suspended_frame)
+      {
+         audio_suspended     = true;
+         video_driver_active = false;
+      }
+
+      runahead_core_run_use_last_input();
+
+      if (suspended_frame)
+      {
+         runahead_resume_video();
+         audio_suspended = false;
+      }
+
+      if (!runahead_save_state(frame_number))
+         return false;
+   }
+
+   return true;
+}
+
+/* Single instance runahead.
+ *
+ * The real frame always runs first, with audio and video suspended;
+ * it is what tells us whether the input changed. If it didn't, the frames
+ * run ahead last time are still what they would be now, so only one new
+ * frame has to be run past them. Otherwise they are all run again from
+ * the new real state. */
+static bool runahead_run_single(int runahead_count)
+{
+   uint32_t input_hash;
+   uint64_t frame_count = video_driver_frame_count;
+   /* Set by a reset or state load since the last frame */
+   bool was_dirty       = input_is_dirty;
+   bool reuse           = false;
+
+   if (runahead_save_state_list->size != runahead_count + 1)
+   {
+      mylist_resize(runahead_save_state_list, runahead_count + 1, true);
+      runahead_snapshot_count = 0;
+   }
+
+   input_is_dirty      = false;
+
+   audio_suspended     = true;
+   video_driver_active = false;
+   core_run();
+   runahead_resume_video();
+   audio_suspended     = false;
+
+   input_hash          = runahead_input_hash();
+
+   if (     runahead_snapshot_count == runahead_count
+         && runahead_snapshot_frame + 1 == frame_count
+         && runahead_snapshot_input_hash == input_hash
+         && !was_dirty
+         && !input_is_dirty
+         && !runahead_force_input_dirty)
+      reuse = true;
+
+   if (reuse)
+   {
+      /* The old [1] is the real state we are in now,
+       * and the old [0] is free to hold the new frame. */
+      runahead_save_state_list_rotate();
+
+      if (runahead_count > 1 && !runahead_load_state(runahead_count - 1))
+         goto load_error;
+
+      if (!runahead_run_ahead(runahead_count, runahead_count))
+         goto save_error;
+   }
+   else
+   {
+      if (!runahead_save_state(0))
+         goto save_error;
+
+      if (!runahead_run_ahead(1, runahead_count))
+         goto save_error;
+   }
+
+   if (!runahead_load_state(0))
+      goto load_error;
+
+   runahead_snapshot_count      = runahead_count;
+   runahead_snapshot_frame      = frame_count;
+   runahead_snapshot_input_hash = input_hash;
+   return true;
+
+save_error:
+   runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+   return false;
+
+load_error:
+   runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+   return false;
+}
+
 static void do_runahead(int runahead_count, bool use_secondary)
 {
-   int frame_number        = 0;
-   bool last_frame         = false;
-   bool suspended_frame    = false;
 #if defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)
    const bool have_dynamic = true;
 #else
@@ -21289,52 +21630,17 @@ static void do_runahead(int runahead_count, bool use_secondary)
 
    if (!use_secondary || !have_dynamic || !runahead_secondary_core_available)
    {
-      /* TODO: multiple savestates for higher performance
-       * when not using secondary core */
-      for (frame_number = 0; frame_number <= runahead_count; frame_number++)
-      {
-         last_frame      = frame_number == runahead_count;
-         suspended_frame = !last_frame;
-
-         if (suspended_frame)
-         {
-            audio_suspended     = true;
-            video_driver_active = false;
-         }
-
-         if (frame_number == 0)
-            core_run();
-         else
-            runahead_core_run_use_last_input();
-
-         if (suspended_frame)
-         {
-            runahead_resume_video();
-            audio_suspended = false;
-         }
-
-         if (frame_number == 0)
-         {
-            if (!runahead_save_state())
-            {
-               runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
-               return;
-            }
-         }
-
-         if (last_frame)
-         {
-            if (!runahead_load_state())
-            {
-               runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
-               return;
-            }
-         }
-      }
+      if (!runahead_run_single(runahead_count))
+         return;
    }
    else
    {
 #if HAVE_DYNAMIC
+      int frame_number        = 0;
+
+      /* The secondary core overwrites the single instance state. */
+      runahead_snapshot_count = 0;
+
       if (!secondary_core_ensure_exists())
       {
          runahead_secondary_core_available = false;
@@ -21351,7 +21657,7 @@ static void do_runahead(int runahead_count, bool use_secondary)
       {
          input_is_dirty       = false;
 
-         if (!runahead_save_state())
+         if (!runahead_save_state(0))
          {
             runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
             return;
@@ -22841,6 +23147,21 @@ static void runloop_task_msg_queue_push(
       runloop_msg_queue_push(msg, prio, duration, flush, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
 }
 
+static void runloop_task_metrics_log(retro_task_t *task,
+      const retro_task_metrics_t *metrics)
+{
+   if (!verbosity_is_enabled())
+      return;
+
+   RARCH_LOG("[Task]: \"%s\" waited %u us, ran %u us over %u steps, "
+         "gathered %u us after finishing.\n",
+         task->title ? task->title : "",
+         (unsigned)(metrics->start_time  - metrics->enqueue_time),
+         (unsigned)metrics->handler_time,
+         metrics->iterations,
+         (unsigned)(metrics->gather_time - metrics->finish_time));
+}
+
 /* Fetches core options path for current core/content
  * - path: path from which options should be read
  *   from/saved to
@@ -23168,6 +23489,7 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
 #endif
             task_queue_deinit();
             task_queue_init(threaded_enable, runloop_task_msg_queue_push);
+            task_queue_set_metrics_log(runloop_task_metrics_log);
          }
          break;
       case RARCH_CTL_SET_SHUTDOWN:
@@ -23597,6 +23919,10 @@ int retroarch_get_capabilities(enum rarch_capabilities type,
                strlcat(s, "AVX ", len);
             if (cpu & RETRO_SIMD_AVX2)
                strlcat(s, "AVX2 ", len);
+            if (cpu & CPU_FEATURES_FMA)
+               strlcat(s, "FMA ", len);
+            if (cpu & CPU_FEATURES_AVX512)
+               strlcat(s, "AVX512 ", len);
             if (cpu & RETRO_SIMD_VFPU)
                strlcat(s, "VFPU ", len);
             if (cpu & RETRO_SIMD_NEON)
@@ -26161,12 +26487,19 @@ bool core_unset_netplay_callbacks(void)
 bool core_set_cheat(retro_ctx_cheat_info_t *info)
 {
    current_core.retro_cheat_set(info->index, info->enabled, info->code);
+#ifdef HAVE_RUNAHEAD
+   /* The frames run ahead were run without it */
+   runahead_snapshot_count = 0;
+#endif
    return true;
 }
 
 bool core_reset_cheat(void)
 {
    current_core.retro_cheat_reset();
+#ifdef HAVE_RUNAHEAD
+   runahead_snapshot_count = 0;
+#endif
    return true;
 }
 
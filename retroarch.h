@@ -511,6 +511,20 @@ typedef struct audio_driver
    size_t (*write_avail)(void *data);
 
    size_t (*buffer_size)(void *data);
+
+   /* Optional. Lets the frontend write samples straight into the
+    * driver's own buffer instead of handing them to write().
+    *
+    * Points *buf at contiguous space for up to size bytes and
+    * returns how many bytes it holds. Like write(), this blocks until
+    * there is room unless nonblocking operation was set, in which
+    * case 0 may be returned. -1 terminates the driver.
+    *
+    * Nothing is played until write_end() queues the bytes that
+    * were filled in. */
+   ssize_t (*write_begin)(void *data, void **buf, size_t size);
+
+   void (*write_end)(void *data, size_t size);
 } audio_driver_t;
 
 bool audio_driver_enable_callback(void);
@@ -725,6 +739,10 @@ typedef struct record_driver
    bool  (*push_video)(void *data, const struct record_video_data *video_data);
    bool  (*push_audio)(void *data, const struct record_audio_data *audio_data);
    bool  (*finalize)(void *data);
+   /* Optional. Returns a buffer of at least size bytes which the
+    * next video frame can be read into and then pushed without
+    * a copy, or NULL if none is free right now. */
+   void *(*get_video_buffer)(void *data, size_t size);
    const char *ident;
 } record_driver_t;
 
@@ -27,6 +27,10 @@
 #include <streams/file_stream.h>
 #include <streams/chd_stream.h>
 #include <streams/interface_stream.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
 #include "tasks_internal.h"
 
 #include "../core_info.h"
@@ -56,6 +60,42 @@ typedef struct database_state_handle
    struct string_list *list;
 } database_state_handle_t;
 
+#ifdef HAVE_THREADS
+/* Files are read and checksummed ahead of the matcher by a pool of
+ * worker threads. Each list index owns the slot (index % num_slots),
+ * so workers may run at most num_slots files ahead of the matcher,
+ * which still consumes the results strictly in list order. */
+#define DATABASE_HASH_SLOTS_PER_THREAD 4
+#define DATABASE_HASH_MAX_THREADS      32
+#define DATABASE_HASH_WAIT_USEC        100000
+
+typedef struct database_hash_slot
+{
+   bool busy;
+   bool done;
+   int ret;
+   enum database_type type;
+   uint32_t crc;
+   uint32_t archive_crc;
+   size_t index;
+   char serial[4096];
+} database_hash_slot_t;
+
+typedef struct database_hash_pool
+{
+   bool quit;
+   unsigned num_threads;
+   size_t num_slots;
+   size_t next;
+   size_t consumed;
+   database_hash_slot_t *slots;
+   database_info_handle_t *handle;
+   sthread_t **threads;
+   slock_t *lock;
+   scond_t *cond;
+} database_hash_pool_t;
+#endif
+
 typedef struct db_handle
 {
    bool is_directory;
@@ -63,10 +103,15 @@ typedef struct db_handle
    bool scan_without_core_match;
    bool show_hidden_files;
    unsigned status;
+   unsigned worker_threads;
+#ifdef HAVE_THREADS
+   database_hash_pool_t *pool;
+#endif
    char *playlist_directory;
    char *content_database_path;
    char *fullpath;
    database_info_handle_t *handle;
+   database_info_index_t *index;
    database_state_handle_t state;
 } db_handle_t;
 
@@ -345,15 +390,24 @@ static int task_database_chd_get_serial(const char *name, char* serial)
    return result;
 }
 
+/* Large reads keep the CRC (which is much faster than the disk now)
+ * from being bounded by per-read overhead. */
+#define CRC_READ_BUFFER_SIZE (1024 * 1024)
+
 static int intfstream_get_crc(intfstream_t *fd, uint32_t *crc)
 {
-   int64_t read = 0;
-   uint32_t acc = 0;
-   uint8_t buffer[4096];
+   int64_t read    = 0;
+   uint32_t acc    = 0;
+   uint8_t *buffer = (uint8_t*)malloc(CRC_READ_BUFFER_SIZE);
+
+   if (!buffer)
+      return 0;
 
-   while ((read = intfstream_read(fd, buffer, sizeof(buffer))) > 0)
+   while ((read = intfstream_read(fd, buffer, CRC_READ_BUFFER_SIZE)) > 0)
       acc = encoding_crc32(acc, buffer, (size_t)read);
 
+   free(buffer);
+
    if (read < 0)
       return 0;
 
@@ -509,30 +563,30 @@ static bool task_database_chd_get_crc(const char *name, uint32_t *crc)
    return rv;
 }
 
-static void task_database_cue_prune(database_info_handle_t *db,
-      const char *name)
+/* Collects the files referenced by a cue or gdi sheet. */
+static struct string_list *task_database_sheet_files(const char *name,
+      enum msg_file_type type)
 {
-   size_t i;
-   char       *path = (char *)malloc(PATH_MAX_LENGTH + 1);
-   intfstream_t *fd = intfstream_open_file(name,
+   union string_list_elem_attr attr;
+   struct string_list *files = NULL;
+   char       *path          = (char *)malloc(PATH_MAX_LENGTH + 1);
+   intfstream_t *fd          = intfstream_open_file(name,
          RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
+   attr.i = 0;
+
    if (!fd)
       goto end;
 
-   while (cue_next_file(fd, name, path, PATH_MAX_LENGTH))
-   {
-      for (i = db->list_ptr; i < db->list->size; ++i)
-      {
-         if (db->list->elems[i].data
-               && string_is_equal(path, db->list->elems[i].data))
-         {
-            RARCH_LOG("Pruning file referenced by cue: %s\n", path);
-            free(db->list->elems[i].data);
-            db->list->elems[i].data = NULL;
-         }
-      }
-   }
+   files = string_list_new();
+
+   if (!files)
+      goto end;
+
+   while (type == FILE_TYPE_CUE
+         ? cue_next_file(fd, name, path, PATH_MAX_LENGTH)
+         : gdi_next_file(fd, name, path, PATH_MAX_LENGTH))
+      string_list_append(files, path, attr);
 
 end:
    if (fd)
@@ -541,35 +595,43 @@ end:
       free(fd);
    }
    free(path);
+   return files;
 }
 
-static void gdi_prune(database_info_handle_t *db, const char *name)
+/* Removes the files referenced by a cue or gdi sheet from the
+ * scan list, so that the tracks are not matched on their own. */
+static void task_database_prune(struct string_list *list, size_t start,
+      const struct string_list *files, const char *sheet)
 {
-   size_t i;
-   char       *path = (char *)malloc(PATH_MAX_LENGTH + 1);
-   intfstream_t *fd = intfstream_open_file(name,
-         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
-
-   if (!fd)
-      goto end;
+   size_t i, j;
 
-   while (gdi_next_file(fd, name, path, PATH_MAX_LENGTH))
+   for (j = 0; j < files->size; j++)
    {
-      for (i = db->list_ptr; i < db->list->size; ++i)
+      for (i = start; i < list->size; ++i)
       {
-         if (db->list->elems[i].data
-               && string_is_equal(path, db->list->elems[i].data))
+         if (list->elems[i].data
+               && string_is_equal(files->elems[j].data, list->elems[i].data))
          {
-            RARCH_LOG("Pruning file referenced by gdi: %s\n", path);
-            free(db->list->elems[i].data);
-            db->list->elems[i].data = NULL;
+            RARCH_LOG("Pruning file referenced by %s: %s\n",
+                  sheet, files->elems[j].data);
+            free(list->elems[i].data);
+            list->elems[i].data = NULL;
          }
       }
    }
+}
 
-end:
-   free(fd);
-   free(path);
+static void task_database_sheet_prune(database_info_handle_t *db,
+      const char *name, enum msg_file_type type)
+{
+   struct string_list *files = task_database_sheet_files(name, type);
+
+   if (!files)
+      return;
+
+   task_database_prune(db->list, db->list_ptr, files,
+         type == FILE_TYPE_CUE ? "cue" : "gdi");
+   string_list_free(files);
 }
 
 static enum msg_file_type extension_to_file_type(const char *ext)
@@ -616,74 +678,308 @@ static enum msg_file_type extension_to_file_type(const char *ext)
    return FILE_TYPE_NONE;
 }
 
-static int task_database_iterate_playlist(
-      database_state_handle_t *db_state,
-      database_info_handle_t *db, const char *name)
+/* Reads the file and extracts what it will be matched by:
+ * either a serial or the CRC of its data (track). */
+static int task_database_hash_file(const char *name,
+      enum database_type *type, uint32_t *crc, uint32_t *archive_crc,
+      char *serial)
 {
    switch (extension_to_file_type(path_get_extension(name)))
    {
       case FILE_TYPE_COMPRESSED:
 #ifdef HAVE_COMPRESSION
-         database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
+         *type = DATABASE_TYPE_CRC_LOOKUP;
          /* first check crc of archive itself */
          return intfstream_file_get_crc(name,
-               0, SIZE_MAX, &db_state->archive_crc);
+               0, SIZE_MAX, archive_crc);
 #else
          break;
 #endif
       case FILE_TYPE_CUE:
-         task_database_cue_prune(db, name);
-         db_state->serial[0] = '\0';
-         if (task_database_cue_get_serial(name, db_state->serial))
-            database_info_set_type(db, DATABASE_TYPE_SERIAL_LOOKUP);
+         serial[0] = '\0';
+         if (task_database_cue_get_serial(name, serial))
+            *type = DATABASE_TYPE_SERIAL_LOOKUP;
          else
          {
-            database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
-            return task_database_cue_get_crc(name, &db_state->crc);
+            *type = DATABASE_TYPE_CRC_LOOKUP;
+            return task_database_cue_get_crc(name, crc);
          }
          break;
       case FILE_TYPE_GDI:
-         gdi_prune(db, name);
-         db_state->serial[0] = '\0';
+         serial[0] = '\0';
          /* There are no serial databases, so don't bother with
             serials at the moment */
-         if (0 && task_database_gdi_get_serial(name, db_state->serial))
-            database_info_set_type(db, DATABASE_TYPE_SERIAL_LOOKUP);
+         if (0 && task_database_gdi_get_serial(name, serial))
+            *type = DATABASE_TYPE_SERIAL_LOOKUP;
          else
          {
-            database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
-            return task_database_gdi_get_crc(name, &db_state->crc);
+            *type = DATABASE_TYPE_CRC_LOOKUP;
+            return task_database_gdi_get_crc(name, crc);
          }
          break;
       /* Consider Wii WBFS files similar to ISO files. */
       case FILE_TYPE_WBFS:
       case FILE_TYPE_ISO:
-         db_state->serial[0] = '\0';
-         intfstream_file_get_serial(name, 0, SIZE_MAX, db_state->serial);
-         database_info_set_type(db, DATABASE_TYPE_SERIAL_LOOKUP);
+         serial[0] = '\0';
+         intfstream_file_get_serial(name, 0, SIZE_MAX, serial);
+         *type = DATABASE_TYPE_SERIAL_LOOKUP;
          break;
       case FILE_TYPE_CHD:
-         db_state->serial[0] = '\0';
-         if (task_database_chd_get_serial(name, db_state->serial))
-            database_info_set_type(db, DATABASE_TYPE_SERIAL_LOOKUP);
+         serial[0] = '\0';
+         if (task_database_chd_get_serial(name, serial))
+            *type = DATABASE_TYPE_SERIAL_LOOKUP;
          else
          {
-            database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
-            return task_database_chd_get_crc(name, &db_state->crc);
+            *type = DATABASE_TYPE_CRC_LOOKUP;
+            return task_database_chd_get_crc(name, crc);
          }
          break;
       case FILE_TYPE_LUTRO:
-         database_info_set_type(db, DATABASE_TYPE_ITERATE_LUTRO);
+         *type = DATABASE_TYPE_ITERATE_LUTRO;
          break;
       default:
-         database_info_set_type(db, DATABASE_TYPE_CRC_LOOKUP);
-         return intfstream_file_get_crc(name, 0, SIZE_MAX, &db_state->crc);
+         *type = DATABASE_TYPE_CRC_LOOKUP;
+         return intfstream_file_get_crc(name, 0, SIZE_MAX, crc);
    }
 
    return 1;
 }
 
+static int task_database_iterate_playlist(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db, const char *name)
+{
+   int ret;
+   enum database_type type      = database_info_get_type(db);
+   enum msg_file_type file_type = extension_to_file_type(
+         path_get_extension(name));
+
+   if (file_type == FILE_TYPE_CUE || file_type == FILE_TYPE_GDI)
+      task_database_sheet_prune(db, name, file_type);
+
+   ret = task_database_hash_file(name, &type,
+         &db_state->crc, &db_state->archive_crc, db_state->serial);
+   database_info_set_type(db, type);
+
+   return ret;
+}
+
+#ifdef HAVE_THREADS
+static void task_database_hash_thread(void *data)
+{
+   database_hash_pool_t *pool = (database_hash_pool_t*)data;
+   struct string_list   *list = pool->handle->list;
+
+   slock_lock(pool->lock);
+
+   while (!pool->quit)
+   {
+      enum msg_file_type file_type;
+      database_hash_slot_t *slot = NULL;
+      size_t index               = 0;
+      char *name                 = NULL;
+
+      /* Skip files pruned by a cue or gdi sheet. */
+      while (pool->next < list->size && !list->elems[pool->next].data)
+         pool->next++;
+
+      if (pool->next < list->size)
+         slot = &pool->slots[pool->next % pool->num_slots];
+
+      if (     !slot
+            || slot->busy
+            || pool->next >= pool->consumed + pool->num_slots)
+      {
+         scond_wait(pool->cond, pool->lock);
+         continue;
+      }
+
+      index       = pool->next++;
+      slot->busy  = true;
+      slot->done  = false;
+      slot->index = index;
+      name        = strdup(list->elems[index].data);
+
+      slock_unlock(pool->lock);
+
+      slot->ret   = 1;
+      slot->type  = DATABASE_TYPE_ITERATE;
+      slot->crc   = 0;
+      slot->archive_crc = 0;
+      slot->serial[0]   = '\0';
+      file_type   = extension_to_file_type(path_get_extension(name));
+
+      if (path_contains_compressed_file(name))
+      {
+         slot->type = DATABASE_TYPE_ITERATE_ARCHIVE;
+         slot->crc  = file_archive_get_file_crc32(name);
+      }
+      else
+      {
+         if (file_type == FILE_TYPE_CUE || file_type == FILE_TYPE_GDI)
+         {
+            struct string_list *files =
+               task_database_sheet_files(name, file_type);
+
+            if (files)
+            {
+               slock_lock(pool->lock);
+               /* A sheet that was itself pruned leaves the list alone. */
+               if (list->elems[index].data)
+                  task_database_prune(list, index + 1, files,
+                        file_type == FILE_TYPE_CUE ? "cue" : "gdi");
+               slock_unlock(pool->lock);
+               string_list_free(files);
+            }
+         }
+
+         slot->ret = task_database_hash_file(name, &slot->type,
+               &slot->crc, &slot->archive_crc, slot->serial);
+      }
+
+      free(name);
+
+      slock_lock(pool->lock);
+      slot->busy = false;
+      slot->done = true;
+      scond_broadcast(pool->cond);
+   }
+
+   slock_unlock(pool->lock);
+}
+
+static void task_database_pool_free(database_hash_pool_t *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   if (pool->lock)
+   {
+      slock_lock(pool->lock);
+      pool->quit = true;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+   }
+
+   for (i = 0; i < pool->num_threads; i++)
+      sthread_join(pool->threads[i]);
+
+   if (pool->cond)
+      scond_free(pool->cond);
+   if (pool->lock)
+      slock_free(pool->lock);
+
+   free(pool->threads);
+   free(pool->slots);
+   free(pool);
+}
+
+static database_hash_pool_t *task_database_pool_new(
+      database_info_handle_t *handle, unsigned num_threads)
+{
+   unsigned i;
+   database_hash_pool_t *pool = NULL;
+
+   if (!handle || !handle->list)
+      return NULL;
+
+   if (num_threads == 0)
+      num_threads = cpu_features_get_core_amount();
+   if (num_threads > DATABASE_HASH_MAX_THREADS)
+      num_threads = DATABASE_HASH_MAX_THREADS;
+   if (num_threads == 0)
+      num_threads = 1;
+
+   pool = (database_hash_pool_t*)calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->handle    = handle;
+   pool->next      = handle->list_ptr;
+   pool->consumed  = handle->list_ptr;
+   pool->num_slots = num_threads * DATABASE_HASH_SLOTS_PER_THREAD;
+   pool->slots     = (database_hash_slot_t*)
+      calloc(pool->num_slots, sizeof(*pool->slots));
+   pool->threads   = (sthread_t**)calloc(num_threads, sizeof(*pool->threads));
+   pool->lock      = slock_new();
+   pool->cond      = scond_new();
+
+   if (!pool->slots || !pool->threads || !pool->lock || !pool->cond)
+      goto error;
+
+   for (i = 0; i < num_threads; i++)
+   {
+      pool->threads[i] = sthread_create(task_database_hash_thread, pool);
+      if (!pool->threads[i])
+         goto error;
+      pool->num_threads++;
+   }
+
+   RARCH_LOG("Scanning with %u hashing threads.\n", num_threads);
+
+   return pool;
+
+error:
+   task_database_pool_free(pool);
+   return NULL;
+}
+
+/* Tells the workers which file the matcher is on, so the slots of
+ * the files before it can be reused. */
+static const char *task_database_pool_current_element_name(
+      database_hash_pool_t *pool, database_info_handle_t *db)
+{
+   const char *name = NULL;
+
+   slock_lock(pool->lock);
+   name           = database_info_get_current_element_name(db);
+   pool->consumed = db->list_ptr;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+
+   return name;
+}
+
+static int task_database_iterate_pool(database_hash_pool_t *pool,
+      database_state_handle_t *db_state,
+      database_info_handle_t *db)
+{
+   int ret;
+   database_hash_slot_t *slot =
+      &pool->slots[db->list_ptr % pool->num_slots];
+
+   slock_lock(pool->lock);
+
+   if (!slot->done || slot->index != db->list_ptr)
+   {
+      /* Come back later rather than blocking, so that the task
+       * can still be cancelled while a large file is hashed. */
+      scond_wait_timeout(pool->cond, pool->lock, DATABASE_HASH_WAIT_USEC);
+
+      if (!slot->done || slot->index != db->list_ptr)
+      {
+         slock_unlock(pool->lock);
+         return 1;
+      }
+   }
+
+   slock_unlock(pool->lock);
+
+   ret                   = slot->ret;
+   db_state->crc         = slot->crc;
+   db_state->archive_crc = slot->archive_crc;
+   strlcpy(db_state->serial, slot->serial, sizeof(db_state->serial));
+   database_info_set_type(db, slot->type);
+
+   return ret;
+}
+#endif
+
 static int database_info_list_iterate_end_no_match(
+      db_handle_t *_db,
       database_info_handle_t *db,
       database_state_handle_t *db_state,
       const char *path)
@@ -703,6 +999,12 @@ static int database_info_list_iterate_end_no_match(
       {
          unsigned i;
 
+#ifdef HAVE_THREADS
+         /* The hashing workers read the list concurrently. */
+         if (_db->pool)
+            slock_lock(_db->pool->lock);
+#endif
+
          for (i = 0; i < archive_list->size; i++)
          {
             char *new_path   = (char*)malloc(
@@ -729,6 +1031,14 @@ static int database_info_list_iterate_end_no_match(
             free(new_path);
          }
 
+#ifdef HAVE_THREADS
+         if (_db->pool)
+         {
+            scond_broadcast(_db->pool->cond);
+            slock_unlock(_db->pool->lock);
+         }
+#endif
+
          string_list_free(archive_list);
       }
    }
@@ -932,7 +1242,7 @@ static int task_database_iterate_crc_lookup(
 
    if (!db_state->list ||
          (unsigned)db_state->list_index == (unsigned)db_state->list->size)
-      return database_info_list_iterate_end_no_match(db, db_state, name);
+      return database_info_list_iterate_end_no_match(_db, db, db_state, name);
 
    /* archive did not contain a CRC for this entry, or the file is empty */
    if (!db_state->crc)
@@ -968,11 +1278,23 @@ static int task_database_iterate_crc_lookup(
          }
       }
 
-      snprintf(query, sizeof(query),
-            "{crc:or(b\"%08X\",b\"%08X\")}",
-            db_state->crc, db_state->archive_crc);
+      if (_db->index)
+      {
+         db_state->info = database_info_index_find_crc(_db->index,
+               database_info_get_current_name(db_state),
+               db_state->crc, db_state->archive_crc);
 
-      database_info_list_iterate_new(db_state, query);
+         if (!db_state->info)
+            return database_info_list_iterate_next(db_state);
+      }
+      else
+      {
+         snprintf(query, sizeof(query),
+               "{crc:or(b\"%08X\",b\"%08X\")}",
+               db_state->crc, db_state->archive_crc);
+
+         database_info_list_iterate_new(db_state, query);
+      }
    }
 
    if (db_state->info)
@@ -1101,9 +1423,17 @@ static int task_database_iterate_serial_lookup(
 {
    if (!db_state->list ||
          (unsigned)db_state->list_index == (unsigned)db_state->list->size)
-      return database_info_list_iterate_end_no_match(db, db_state, name);
+      return database_info_list_iterate_end_no_match(_db, db, db_state, name);
 
-   if (db_state->entry_index == 0)
+   if (db_state->entry_index == 0 && _db->index)
+   {
+      db_state->info = database_info_index_find_serial(_db->index,
+            database_info_get_current_name(db_state), db_state->serial);
+
+      if (!db_state->info)
+         return database_info_list_iterate_next(db_state);
+   }
+   else if (db_state->entry_index == 0)
    {
       char query[50];
       char *serial_buf =
@@ -1166,6 +1496,11 @@ static int task_database_iterate(
    if (!name)
       return 0;
 
+#ifdef HAVE_THREADS
+   if (_db->pool && database_info_get_type(db) == DATABASE_TYPE_ITERATE)
+      return task_database_iterate_pool(_db->pool, db_state, db);
+#endif
+
    if (database_info_get_type(db) == DATABASE_TYPE_ITERATE)
       if (path_contains_compressed_file(name))
          database_info_set_type(db, DATABASE_TYPE_ITERATE_ARCHIVE);
@@ -1229,7 +1564,12 @@ static void task_database_handler(retro_task_t *task)
       }
 
       if (db->handle)
+      {
          db->handle->status = DATABASE_STATUS_ITERATE_BEGIN;
+#ifdef HAVE_THREADS
+         db->pool = task_database_pool_new(db->handle, db->worker_threads);
+#endif
+      }
    }
 
    dbinfo  = db->handle;
@@ -1290,10 +1630,21 @@ static void task_database_handler(retro_task_t *task)
                }
             }
          }
+
+         /* Look every file up in memory rather than querying
+          * each database in turn. */
+         if (dbstate->list && !db->index)
+            db->index = database_info_index_new(dbstate->list);
+
          dbinfo->status = DATABASE_STATUS_ITERATE_START;
          break;
       case DATABASE_STATUS_ITERATE_START:
-         name = database_info_get_current_element_name(dbinfo);
+#ifdef HAVE_THREADS
+         if (db->pool)
+            name = task_database_pool_current_element_name(db->pool, dbinfo);
+         else
+#endif
+            name = database_info_get_current_element_name(dbinfo);
          task_database_cleanup_state(dbstate);
          dbstate->list_index  = 0;
          dbstate->entry_index = 0;
@@ -1349,6 +1700,10 @@ task_finished:
 
    if (db)
    {
+#ifdef HAVE_THREADS
+      task_database_pool_free(db->pool);
+#endif
+      database_info_index_free(db->index);
       if (!string_is_empty(db->playlist_directory))
          free(db->playlist_directory);
       if (!string_is_empty(db->content_database_path))
@@ -1394,6 +1749,7 @@ bool task_push_dbscan(
       goto error;
 
    t->handler                = task_database_handler;
+   t->priority               = TASK_PRIORITY_LOW;
    t->state                  = db;
    t->callback               = cb;
    t->title                  = strdup(msg_hash_to_str(MSG_PREPARING_FOR_CONTENT_SCAN));
@@ -1402,6 +1758,7 @@ bool task_push_dbscan(
 #ifdef RARCH_INTERNAL
    t->progress_cb            = task_database_progress_cb;
    db->scan_without_core_match = settings->bools.scan_without_core_match;
+   db->worker_threads        = settings->uints.scan_worker_threads;
 #endif
    db->show_hidden_files     = db_dir_show_hidden_files;
    db->is_directory          = directory;
@@ -1421,3 +1778,55 @@ error:
       free(db);
    return false;
 }
+
+static void task_database_index_free(retro_task_t *task)
+{
+   struct string_list *list = (struct string_list*)task->state;
+
+   if (list)
+      string_list_free(list);
+}
+
+/* Indexes one database per step */
+static void task_database_index_handler(retro_task_t *task)
+{
+   struct string_list *list = (struct string_list*)task->state;
+   size_t pos               = (size_t)(uintptr_t)task->user_data;
+
+   if (task_get_cancelled(task) || pos >= list->size)
+   {
+      task_set_finished(task, true);
+      return;
+   }
+
+   database_info_create_indexes(list->elems[pos].data);
+
+   task->user_data = (void*)(uintptr_t)++pos;
+   task_set_progress(task, (int8_t)((pos * 100) / list->size));
+}
+
+bool task_push_database_index(const char *content_database)
+{
+   retro_task_t *t          = NULL;
+   struct string_list *list = dir_list_new(content_database, "rdb",
+         false, false, false, false);
+
+   if (!list)
+      return false;
+
+   if (!list->size || !(t = task_init()))
+   {
+      string_list_free(list);
+      return false;
+   }
+
+   t->handler  = task_database_index_handler;
+   t->cleanup  = task_database_index_free;
+   t->priority = TASK_PRIORITY_LOW;
+   t->state    = list;
+   t->mute     = true;
+
+   task_queue_push(t);
+
+   return true;
+}
@@ -465,6 +465,8 @@ bool task_push_image_load(const char *fullpath,
 
    t->state           = nbio;
    t->handler         = task_file_load_handler;
+   t->priority        = TASK_PRIORITY_HIGH;
+   t->thread_safe     = true;
    t->cleanup         = task_image_load_free;
    t->callback        = cb;
    t->user_data       = user_data;
@@ -420,6 +420,7 @@ bool task_push_pl_thumbnail_download(
    
    /* Configure task */
    task->handler                 = task_pl_thumbnail_download_handler;
+   task->priority                = TASK_PRIORITY_LOW;
    task->state                   = pl_thumb;
    task->title                   = strdup(system);
    task->alternative_look        = true;
@@ -718,6 +719,7 @@ bool task_push_pl_entry_thumbnail_download(
    
    /* Configure task */
    task->handler                 = task_pl_entry_thumbnail_download_handler;
+   task->priority                = TASK_PRIORITY_HIGH;
    task->state                   = pl_thumb;
    task->title                   = strdup(system);
    task->alternative_look        = true;
@@ -276,6 +276,7 @@ bool task_push_pl_manager_reset_cores(const char *playlist_path)
    strlcat(task_title, playlist_name, sizeof(task_title));
    
    task->handler                 = task_pl_manager_reset_cores_handler;
+   task->priority                = TASK_PRIORITY_LOW;
    task->state                   = pl_manager;
    task->title                   = strdup(task_title);
    task->alternative_look        = true;
@@ -707,6 +707,7 @@ static bool task_push_undo_save_state(const char *path, void *data, size_t size)
    task->type                    = TASK_TYPE_BLOCKING;
    task->state                   = state;
    task->handler                 = task_save_handler;
+   task->priority                = TASK_PRIORITY_HIGH;
    task->callback                = undo_save_state_cb;
    task->title                   = strdup(msg_hash_to_str(MSG_UNDOING_SAVE_STATE));
 
@@ -1086,6 +1087,7 @@ static void task_push_save_state(const char *path, void *data, size_t size, bool
    task->type              = TASK_TYPE_BLOCKING;
    task->state             = state;
    task->handler           = task_save_handler;
+   task->priority          = TASK_PRIORITY_HIGH;
    task->callback          = save_state_cb;
    task->title             = strdup(msg_hash_to_str(MSG_SAVING_STATE));
    task->mute              = state->mute;
@@ -1186,6 +1188,7 @@ static void task_push_load_and_save_state(const char *path, void *data,
    task->state       = state;
    task->type        = TASK_TYPE_BLOCKING;
    task->handler     = task_load_handler;
+   task->priority    = TASK_PRIORITY_HIGH;
    task->callback    = content_load_and_save_state_cb;
    task->title       = strdup(msg_hash_to_str(MSG_LOADING_STATE));
    task->mute        = state->mute;
@@ -1325,6 +1328,7 @@ bool content_load_state(const char *path,
    task->type                   = TASK_TYPE_BLOCKING;
    task->state                  = state;
    task->handler                = task_load_handler;
+   task->priority               = TASK_PRIORITY_HIGH;
    task->callback               = content_load_state_cb;
    task->title                  = strdup(msg_hash_to_str(MSG_LOADING_STATE));
 
@@ -93,6 +93,10 @@ bool task_push_dbscan(
       const char *fullpath,
       bool directory, bool show_hidden_files,
       retro_task_callback_t cb);
+
+/* Adds the indexes that lookups use to every database in
+ * @content_database that does not have them yet. */
+bool task_push_database_index(const char *content_database);
 #endif
 
 #ifdef HAVE_OVERLAY
@@ -118,6 +118,7 @@ uint32_t frame_offset_cmd(bool ntoh)
       case NETPLAY_CMD_NOINPUT:
       case NETPLAY_CMD_MODE:
       case NETPLAY_CMD_CRC:
+      case NETPLAY_CMD_BLOCK_HASH:
       case NETPLAY_CMD_LOAD_SAVESTATE:
       case NETPLAY_CMD_RESET:
          frame = ntohl(payload[0]);
@@ -297,7 +298,10 @@ int main(int argc, char **argv)
       return 1;
    }
 
-   /* Echo the connection header back */
+   /* Echo the connection header back, without savestate delta support.
+    * Deltas depend on states we never have, so recordings couldn't be
+    * played back. */
+   payload[2] &= ~htonl(NETPLAY_COMPRESSION_DELTA);
    socket_send_all_blocking(sock, payload, 6*sizeof(uint32_t), true);
 
    /* Send a nickname */